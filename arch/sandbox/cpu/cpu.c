@@ -12,6 +12,7 @@
 #include <linux/delay.h>
 #include <linux/libfdt.h>
 #include <os.h>
+#include <parallel.h>
 #include <asm/io.h>
 #include <asm/malloc.h>
 #include <asm/setjmp.h>
@@ -373,3 +374,10 @@ ulong timer_get_boot_us(void)
 
 	return (count - base_count) / 1000;
 }
+
+#if CONFIG_IS_ENABLED(PARALLEL)
+int arch_parallel_run(parallel_func_t func, void *ctx, int count, int cpus)
+{
+	return os_parallel_run(func, ctx, count, cpus);
+}
+#endif
@@ -9,6 +9,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <setjmp.h>
 #include <signal.h>
 #include <stdio.h>
@@ -283,6 +284,118 @@ int os_setup_signal_handlers(void)
 	return 0;
 }
 
+static void os_sample_handler(int sig, siginfo_t *info, void *con)
+{
+	ucontext_t __maybe_unused *context = con;
+	unsigned long pc, fp, sp;
+
+#if defined(__x86_64__)
+	pc = context->uc_mcontext.gregs[REG_RIP];
+	fp = context->uc_mcontext.gregs[REG_RBP];
+	sp = context->uc_mcontext.gregs[REG_RSP];
+#elif defined(__aarch64__)
+	pc = context->uc_mcontext.pc;
+	fp = context->uc_mcontext.regs[29];
+	sp = context->uc_mcontext.sp;
+#else
+	return;
+#endif
+
+	os_sample_action(pc, fp, sp);
+}
+
+int os_sample_timer(unsigned int hz)
+{
+	struct itimerval timer = {};
+	struct sigaction act = {};
+
+#if !defined(__x86_64__) && !defined(__aarch64__)
+	if (hz)
+		return -ENOSYS;
+#endif
+	if (hz > 1000000)
+		return -EINVAL;
+	if (hz) {
+		act.sa_sigaction = os_sample_handler;
+		sigemptyset(&act.sa_mask);
+		/* don't let the samples interrupt reading from the console */
+		act.sa_flags = SA_SIGINFO | SA_RESTART;
+		if (sigaction(SIGPROF, &act, NULL))
+			return -errno;
+		timer.it_interval.tv_usec = 1000000 / hz;
+		timer.it_value = timer.it_interval;
+	}
+	if (setitimer(ITIMER_PROF, &timer, NULL))
+		return -errno;
+
+	return 0;
+}
+
+/* Maximum number of extra threads started by os_parallel_run() */
+#define OS_MAX_THREADS	16
+
+/**
+ * struct os_parallel - work shared between the threads of os_parallel_run()
+ *
+ * @func: Function to call
+ * @ctx: Context to pass to @func
+ * @count: Number of calls to make
+ * @next: Next index to process
+ * @err: First error returned by @func, 0 if none
+ */
+struct os_parallel {
+	int (*func)(void *ctx, int idx);
+	void *ctx;
+	int count;
+	int next;
+	int err;
+};
+
+static void *os_parallel_thread(void *arg)
+{
+	struct os_parallel *par = arg;
+	int idx;
+
+	while (idx = __atomic_fetch_add(&par->next, 1, __ATOMIC_RELAXED),
+	       idx < par->count) {
+		int ret = par->func(par->ctx, idx);
+		int none = 0;
+
+		if (ret)
+			__atomic_compare_exchange_n(&par->err, &none, ret, false,
+						    __ATOMIC_RELAXED,
+						    __ATOMIC_RELAXED);
+	}
+
+	return NULL;
+}
+
+int os_parallel_run(int (*func)(void *ctx, int idx), void *ctx, int count,
+		    int threads)
+{
+	struct os_parallel par = {
+		.func	= func,
+		.ctx	= ctx,
+		.count	= count,
+	};
+	pthread_t tid[OS_MAX_THREADS];
+	int started, i;
+
+	if (threads > OS_MAX_THREADS + 1)
+		threads = OS_MAX_THREADS + 1;
+	for (started = 0; started < threads - 1; started++) {
+		/* if we cannot start a thread, do the work with fewer */
+		if (pthread_create(&tid[started], NULL, os_parallel_thread,
+				   &par))
+			break;
+	}
+	os_parallel_thread(&par);
+	for (i = 0; i < started; i++)
+		pthread_join(tid[i], NULL);
+
+	return par.err;
+}
+
 /* Put tty into raw mode so <tab> and <ctrl+c> work */
 void os_tty_raw(int fd, bool allow_sigs)
 {
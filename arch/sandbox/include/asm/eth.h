@@ -11,6 +11,9 @@
 
 #include <net.h>
 
+/* Largest MTU which the sandbox driver accepts */
+#define SANDBOX_ETH_MTU_MAX	4000
+
 void sandbox_eth_disable_response(int index, bool disable);
 
 void sandbox_eth_skip_timeout(void);
@@ -80,6 +83,9 @@ typedef int sandbox_eth_tx_hand_f(struct udevice *dev, void *pkt,
  * recv_packet_buffer - buffers of the packet returned as received
  * recv_packet_length - lengths of the packet returned as received
  * recv_packets - number of packets returned
+ * batch_count - number of packets given out by recv_batch() and not yet
+ *	handed back through free_batch()
+ * mtu - MTU set by set_mtu(); larger frames are refused
  * tx_handler - function to generate responses to sent packets
  * priv - a pointer to some structure a test may want to keep track of
  */
@@ -90,6 +96,8 @@ struct eth_sandbox_priv {
 	uchar * recv_packet_buffer[PKTBUFSRX];
 	int recv_packet_length[PKTBUFSRX];
 	int recv_packets;
+	int batch_count;
+	int mtu;
 	sandbox_eth_tx_hand_f *tx_handler;
 	void *priv;
 };
@@ -9,6 +9,7 @@
 #include <efi_loader.h>
 #include <irq_func.h>
 #include <os.h>
+#include <sample.h>
 #include <asm/global_data.h>
 #include <asm-generic/signal.h>
 #include <asm/u-boot-sandbox.h>
@@ -57,3 +58,20 @@ void os_signal_action(int sig, unsigned long pc)
 		sandbox_exit();
 	}
 }
+
+void os_sample_action(unsigned long pc, unsigned long fp, unsigned long sp)
+{
+	sample_record(pc, fp, sp);
+}
+
+#if CONFIG_IS_ENABLED(SAMPLE_PROF)
+int arch_sample_start(uint hz)
+{
+	return os_sample_timer(hz);
+}
+
+void arch_sample_stop(void)
+{
+	os_sample_timer(0);
+}
+#endif
@@ -14,7 +14,7 @@ extern char *strrchr(const char *s, int c);
 #undef __HAVE_ARCH_STRCHR
 extern char *strchr(const char *s, int c);
 
-#ifdef CONFIG_X86_64
+#if defined(CONFIG_X86_64) && defined(CONFIG_SPL_BUILD)
 
 #undef __HAVE_ARCH_MEMCPY
 extern void *memcpy(void *, const void *, __kernel_size_t);
@@ -36,7 +36,7 @@ extern void *memmove(void *, const void *, __kernel_size_t);
 #define __HAVE_ARCH_MEMSET
 extern void *memset(void *, int, __kernel_size_t);
 
-#endif /* CONFIG_X86_64 */
+#endif /* CONFIG_X86_64 && CONFIG_SPL_BUILD */
 
 #undef __HAVE_ARCH_MEMCHR
 extern void *memchr(const void *, int, __kernel_size_t);
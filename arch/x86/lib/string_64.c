@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * memcpy(), memmove() and memset() for 64-bit x86
+ *
+ * Small regions are handled a word at a time. Larger ones use the string
+ * instructions (rep movsq / rep stosq), which current CPUs run a cache line at
+ * a time once the destination is aligned.
+ *
+ * Regions of at least CONFIG_X86_NT_COPY_THRESHOLD bytes, such as when
+ * relocating U-Boot, loading an image or clearing a frame buffer, are
+ * normally larger than the L2 cache. For these, non-temporal stores are used,
+ * which write whole lines to memory without reading them first, and do not
+ * evict everything else from the cache.
+ *
+ * U-Boot is built with -mno-sse and does not enable SSE, so this uses movnti,
+ * which stores from a general-purpose register, rather than movntdq.
+ */
+
+#include <linux/types.h>
+#include <linux/compiler.h>
+#include <asm/string.h>
+
+enum {
+	/* Below this size the start-up time of the string instructions hurts */
+	STRING_REP_MIN	= 256,
+
+	/* Bytes handled in each loop of the non-temporal copy and fill */
+	STRING_NT_BLOCK	= 64,
+};
+
+struct una64 {
+	u64 val;
+} __packed;
+
+/*
+ * Copy @count blocks of STRING_NT_BLOCK bytes with non-temporal stores,
+ * updating @dstp and @srcp. The destination must be 8-byte aligned.
+ */
+static void copy_blocks_nt(char **dstp, const char **srcp, ulong count)
+{
+	asm volatile(
+		"1:\n\t"
+		"prefetchnta 512(%1)\n\t"
+		"mov 0x00(%1), %%rax\n\t"
+		"mov 0x08(%1), %%rdx\n\t"
+		"movnti %%rax, 0x00(%0)\n\t"
+		"movnti %%rdx, 0x08(%0)\n\t"
+		"mov 0x10(%1), %%rax\n\t"
+		"mov 0x18(%1), %%rdx\n\t"
+		"movnti %%rax, 0x10(%0)\n\t"
+		"movnti %%rdx, 0x18(%0)\n\t"
+		"mov 0x20(%1), %%rax\n\t"
+		"mov 0x28(%1), %%rdx\n\t"
+		"movnti %%rax, 0x20(%0)\n\t"
+		"movnti %%rdx, 0x28(%0)\n\t"
+		"mov 0x30(%1), %%rax\n\t"
+		"mov 0x38(%1), %%rdx\n\t"
+		"movnti %%rax, 0x30(%0)\n\t"
+		"movnti %%rdx, 0x38(%0)\n\t"
+		"lea 0x40(%1), %1\n\t"
+		"lea 0x40(%0), %0\n\t"
+		"dec %2\n\t"
+		"jnz 1b\n\t"
+		"sfence"
+		: "+r" (*dstp), "+r" (*srcp), "+r" (count)
+		:
+		: "rax", "rdx", "memory");
+}
+
+/*
+ * Fill @count blocks of STRING_NT_BLOCK bytes with @val using non-temporal
+ * stores, updating @dstp. The destination must be 8-byte aligned.
+ */
+static void fill_blocks_nt(char **dstp, u64 val, ulong count)
+{
+	asm volatile(
+		"1:\n\t"
+		"movnti %2, 0x00(%0)\n\t"
+		"movnti %2, 0x08(%0)\n\t"
+		"movnti %2, 0x10(%0)\n\t"
+		"movnti %2, 0x18(%0)\n\t"
+		"movnti %2, 0x20(%0)\n\t"
+		"movnti %2, 0x28(%0)\n\t"
+		"movnti %2, 0x30(%0)\n\t"
+		"movnti %2, 0x38(%0)\n\t"
+		"lea 0x40(%0), %0\n\t"
+		"dec %1\n\t"
+		"jnz 1b\n\t"
+		"sfence"
+		: "+r" (*dstp), "+r" (count)
+		: "r" (val)
+		: "memory");
+}
+
+/* Copy forwards, which is also safe for overlapping regions if dst < src */
+static void copy_fwd(char *dst, const char *src, size_t len)
+{
+	ulong head, d0;
+
+	if (len < STRING_REP_MIN) {
+		for (; len >= 8; len -= 8, dst += 8, src += 8)
+			((struct una64 *)dst)->val =
+				((const struct una64 *)src)->val;
+		while (len--)
+			*dst++ = *src++;
+		return;
+	}
+
+	/* align the destination, so the string instructions run quickly */
+	head = -(ulong)dst & 7;
+	len -= head;
+	asm volatile("rep movsb"
+		     : "+D" (dst), "+S" (src), "=c" (d0)
+		     : "2" (head)
+		     : "memory");
+
+	if (len >= CONFIG_X86_NT_COPY_THRESHOLD &&
+	    (src >= dst + len || src + len <= dst)) {
+		copy_blocks_nt(&dst, &src, len / STRING_NT_BLOCK);
+		len %= STRING_NT_BLOCK;
+	}
+
+	asm volatile("rep movsq\n\t"
+		     "mov %3, %%ecx\n\t"
+		     "rep movsb"
+		     : "+D" (dst), "+S" (src), "=&c" (d0)
+		     : "r" ((uint)len & 7), "2" (len / 8)
+		     : "memory");
+}
+
+void *memcpy(void *dstpp, const void *srcpp, size_t len)
+{
+	copy_fwd(dstpp, srcpp, len);
+
+	return dstpp;
+}
+
+void *memmove(void *dest, const void *src, size_t n)
+{
+	char *dst = dest + n;
+	const char *s = src + n;
+	ulong d0, d1, d2;
+
+	if (dest <= src || dest >= src + n) {
+		copy_fwd(dest, src, n);
+		return dest;
+	}
+
+	/* copy backwards: the odd bytes at the end, then whole words */
+	for (; n & 7; n--)
+		*--dst = *--s;
+	asm volatile("std\n\t"
+		     "rep movsq\n\t"
+		     "cld"
+		     : "=D" (d0), "=S" (d1), "=c" (d2)
+		     : "0" (dst - 8), "1" (s - 8), "2" (n / 8)
+		     : "memory");
+
+	return dest;
+}
+
+void *memset(void *dstpp, int c, size_t len)
+{
+	u64 val = (u8)c * 0x0101010101010101ULL;
+	char *dst = dstpp;
+	ulong head, d0;
+
+	if (len < STRING_REP_MIN) {
+		for (; len >= 8; len -= 8, dst += 8)
+			((struct una64 *)dst)->val = val;
+		while (len--)
+			*dst++ = c;
+		return dstpp;
+	}
+
+	head = -(ulong)dst & 7;
+	len -= head;
+	asm volatile("rep stosb"
+		     : "+D" (dst), "=c" (d0)
+		     : "1" (head), "a" (val)
+		     : "memory");
+
+	if (len >= CONFIG_X86_NT_COPY_THRESHOLD) {
+		fill_blocks_nt(&dst, val, len / STRING_NT_BLOCK);
+		len %= STRING_NT_BLOCK;
+	}
+
+	asm volatile("rep stosq\n\t"
+		     "mov %3, %%ecx\n\t"
+		     "rep stosb"
+		     : "+D" (dst), "=&c" (d0)
+		     : "a" (val), "r" ((uint)len & 7), "1" (len / 8)
+		     : "memory");
+
+	return dstpp;
+}
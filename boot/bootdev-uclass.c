@@ -445,6 +445,16 @@ int bootdev_get_bootflow(struct udevice *dev, struct bootflow_iter *iter,
 	return ops->get_bootflow(dev, iter, bflow);
 }
 
+int bootdev_start(struct udevice *dev)
+{
+	const struct bootdev_ops *ops = bootdev_get_ops(dev);
+
+	if (!ops->start)
+		return -ENOSYS;
+
+	return ops->start(dev);
+}
+
 void bootdev_clear_bootflows(struct udevice *dev)
 {
 	struct bootdev_uc_plat *ucp = dev_get_uclass_plat(dev);
@@ -563,6 +573,48 @@ static int build_order(struct udevice *bootstd, struct udevice **order,
 	return count;
 }
 
+/**
+ * start_all() - Start all bootdevs so their media can be prepared together
+ *
+ * There are no threads in U-Boot, but much of the time taken by a bootdev is
+ * spent waiting for hardware, e.g. for a card to power up. Starting every
+ * bootdev first means these waits overlap, rather than happening one after
+ * the other as the scan reaches each bootdev.
+ *
+ * Bootdevs which report that there is no media are dropped from the order.
+ * The scan still runs in priority order, so the first bootflow found is the
+ * one from the highest-priority bootdev which is ready.
+ *
+ * @order: List of bootdevs, updated to remove those with no media
+ * @count: Number of bootdevs in @order
+ * Return: new number of bootdevs in @order
+ */
+static int start_all(struct udevice **order, int count)
+{
+	int upto, i;
+
+	for (i = 0, upto = 0; i < count; i++) {
+		struct udevice *dev = order[i];
+		int ret;
+
+		/* leave probe failures to be reported by the scan */
+		if (!device_probe(dev)) {
+			ret = bootdev_start(dev);
+			if (ret == -ENOMEDIUM) {
+				log_debug("Dropping bootdev '%s': no media\n",
+					  dev->name);
+				continue;
+			}
+			if (ret && ret != -ENOSYS)
+				log_debug("Cannot start bootdev '%s' (err=%d)\n",
+					  dev->name, ret);
+		}
+		order[upto++] = dev;
+	}
+
+	return upto;
+}
+
 int bootdev_setup_iter_order(struct bootflow_iter *iter, struct udevice **devp)
 {
 	struct udevice *bootstd, *dev = *devp, **order;
@@ -610,6 +662,14 @@ int bootdev_setup_iter_order(struct bootflow_iter *iter, struct udevice **devp)
 		return log_msg_ret("build", count);
 	}
 
+	if (iter->flags & BOOTFLOWF_PARALLEL) {
+		count = start_all(order, count);
+		if (!count) {
+			free(order);
+			return log_msg_ret("start", -ENOMEDIUM);
+		}
+	}
+
 	iter->dev_order = order;
 	iter->num_devs = count;
 	iter->cur_dev = 0;
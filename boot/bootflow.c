@@ -12,7 +12,9 @@
 #include <bootmeth.h>
 #include <bootstd.h>
 #include <dm.h>
+#include <env.h>
 #include <malloc.h>
+#include <part.h>
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
 
@@ -22,6 +24,11 @@ enum {
 	BF_NO_MORE_DEVICES	= -ENODEV,
 };
 
+enum {
+	/* Maximum supported length of the "bootflow_cache" env string */
+	BOOTFLOW_CACHE_MAX_LEN	= 256,
+};
+
 /**
  * bootflow_state - name for each state
  *
@@ -226,6 +233,176 @@ static int bootflow_check(struct bootflow_iter *iter, struct bootflow *bflow)
 	return 0;
 }
 
+/**
+ * bootflow_part_uuid() - Get the UUID of the partition holding a bootflow
+ *
+ * @bflow: Bootflow to check
+ * @uuid: Returns the UUID, or "-" if there is none (e.g. a network bootflow)
+ * @size: Size of @uuid in bytes
+ */
+static void bootflow_part_uuid(const struct bootflow *bflow, char *uuid,
+			       int size)
+{
+#if CONFIG_IS_ENABLED(PARTITION_UUIDS)
+	struct disk_partition info;
+
+	if (bflow->blk && bflow->part &&
+	    !part_get_info(dev_get_uclass_plat(bflow->blk), bflow->part,
+			   &info) && *info.uuid) {
+		strlcpy(uuid, info.uuid, size);
+		return;
+	}
+#endif
+	strlcpy(uuid, "-", size);
+}
+
+/**
+ * bootflow_cache_str() - Get the cache string for a bootflow
+ *
+ * @bflow: Bootflow to describe
+ * @str: Returns the string, "<bootdev> <part> <bootmeth> <uuid> <fname>"
+ * @size: Size of @str in bytes
+ * Return: 0 if OK, -E2BIG if the string does not fit
+ */
+static int bootflow_cache_str(const struct bootflow *bflow, char *str,
+			      int size)
+{
+	char uuid[UUID_STR_LEN + 1];
+	int len;
+
+	bootflow_part_uuid(bflow, uuid, sizeof(uuid));
+	len = snprintf(str, size, "%s %x %s %s %s", bflow->dev->name,
+		       bflow->part, bflow->method->name, uuid, bflow->fname);
+	if (len >= size)
+		return log_msg_ret("len", -E2BIG);
+
+	return 0;
+}
+
+int bootflow_cache_set(const struct bootflow *bflow)
+{
+	char str[BOOTFLOW_CACHE_MAX_LEN];
+	const char *old;
+	int ret;
+
+	if (bflow->state != BOOTFLOWST_READY || !bflow->fname)
+		return log_msg_ret("state", -EPROTO);
+	ret = bootflow_cache_str(bflow, str, sizeof(str));
+	if (ret)
+		return ret;
+
+	old = env_get("bootflow_cache");
+	if (old && !strcmp(old, str))
+		return 0;
+	ret = env_set("bootflow_cache", str);
+	if (ret)
+		return log_msg_ret("env", -EIO);
+
+	return 1;
+}
+
+int bootflow_cache_save(const struct bootflow *bflow)
+{
+	int ret;
+
+	ret = bootflow_cache_set(bflow);
+	if (ret <= 0)
+		return ret;
+
+	return env_save_if_only("bootflow_cache");
+}
+
+/**
+ * bootflow_is_cached() - Check if the iterator is at the cached bootflow
+ *
+ * @iter: Iterator to check
+ * Return: true if the bootflow at this position was already returned from the
+ *	cache
+ */
+static bool bootflow_is_cached(const struct bootflow_iter *iter)
+{
+	return iter->cache_dev && iter->dev == iter->cache_dev &&
+		iter->part == iter->cache_part &&
+		iter->method == iter->cache_method;
+}
+
+/**
+ * bootflow_cache_check() - Try to get the bootflow recorded in the cache
+ *
+ * This looks up the bootdev and bootmeth recorded by bootflow_cache_set(). They
+ * must both still be part of the scan. If the bootmeth still finds a bootflow
+ * with the same filename on a partition with the same UUID, it is returned and
+ * the position is recorded in @iter so that the scan does not return it again.
+ *
+ * The current position of @iter is not changed.
+ *
+ * @iter: Iterator, with the bootdev and bootmeth order set up
+ * @bflow: Returns the bootflow if found
+ * Return: 0 if found, -ENOENT if there is no usable cache entry, -ESTALE if the
+ *	bootflow has changed, other -ve on other error
+ */
+static int bootflow_cache_check(struct bootflow_iter *iter,
+				struct bootflow *bflow)
+{
+	char str[BOOTFLOW_CACHE_MAX_LEN], cur[BOOTFLOW_CACHE_MAX_LEN];
+	struct udevice *dev = NULL, *method = NULL;
+	struct bootflow_iter save = *iter;
+	const char *val, *dev_name, *method_name;
+	char *part_str;
+	int ret, part, i;
+
+	val = env_get("bootflow_cache");
+	if (!val || strlen(val) >= sizeof(str))
+		return -ENOENT;
+
+	/* make a copy of the string, since strtok() will change it */
+	strcpy(str, val);
+	dev_name = strtok(str, " ");
+	part_str = strtok(NULL, " ");
+	method_name = strtok(NULL, " ");
+	if (!dev_name || !part_str || !method_name)
+		return log_msg_ret("fmt", -ENOENT);
+	part = hextoul(part_str, NULL);
+
+	for (i = 0; i < iter->num_devs; i++) {
+		if (!strcmp(iter->dev_order[i]->name, dev_name))
+			dev = iter->dev_order[i];
+	}
+	for (i = 0; i < iter->num_methods; i++) {
+		if (!strcmp(iter->method_order[i]->name, method_name))
+			method = iter->method_order[i];
+	}
+	if (!dev || !method)
+		return log_msg_ret("find", -ENOENT);
+	ret = device_probe(dev);
+	if (ret)
+		return log_msg_ret("probe", ret);
+
+	iter->dev = dev;
+	iter->part = part;
+	iter->method = method;
+	ret = bootflow_check(iter, bflow);
+	iter->dev = save.dev;
+	iter->part = save.part;
+	iter->method = save.method;
+	iter->max_part = save.max_part;
+	if (!ret)
+		ret = bootflow_cache_str(bflow, cur, sizeof(cur));
+	if (!ret && strcmp(cur, val))
+		ret = -ESTALE;
+	if (ret) {
+		bootflow_free(bflow);
+		log_debug("Cached bootflow '%s' not used (err=%d)\n", val, ret);
+		return log_msg_ret("check", ret);
+	}
+	log_debug("Using cached bootflow '%s'\n", val);
+	iter->cache_dev = dev;
+	iter->cache_part = part;
+	iter->cache_method = method;
+
+	return 0;
+}
+
 int bootflow_scan_bootdev(struct udevice *dev, struct bootflow_iter *iter,
 			  int flags, struct bootflow *bflow)
 {
@@ -245,6 +422,13 @@ int bootflow_scan_bootdev(struct udevice *dev, struct bootflow_iter *iter,
 	/* Find the first bootmeth (there must be at least one!) */
 	iter->method = iter->method_order[iter->cur_method];
 
+	/* The first position is checked on the next call instead */
+	if ((iter->flags & BOOTFLOWF_CACHE) &&
+	    !bootflow_cache_check(iter, bflow)) {
+		iter->pending = true;
+		return 0;
+	}
+
 	ret = bootflow_check(iter, bflow);
 	if (ret) {
 		if (ret != BF_NO_MORE_PARTS && ret != -ENOSYS) {
@@ -277,12 +461,23 @@ int bootflow_scan_next(struct bootflow_iter *iter, struct bootflow *bflow)
 	int ret;
 
 	do {
-		ret = iter_incr(iter);
+		if (iter->pending) {
+			iter->pending = false;
+			ret = 0;
+		} else {
+			ret = iter_incr(iter);
+		}
 		if (ret == BF_NO_MORE_DEVICES)
 			return log_msg_ret("done", ret);
 
 		if (!ret) {
 			ret = bootflow_check(iter, bflow);
+			if (!ret && bootflow_is_cached(iter)) {
+				/* This was returned first, so skip it */
+				bootflow_free(bflow);
+				iter->err = 0;
+				continue;
+			}
 			if (!ret)
 				return 0;
 			iter->err = ret;
@@ -94,18 +94,26 @@ static int distro_boot(struct udevice *dev, struct bootflow *bflow)
 	struct cmd_tbl cmdtp = {};	/* dummy */
 	struct pxe_context ctx;
 	struct distro_info info;
+	char source[40];
 	ulong addr;
 	int ret;
 
 	addr = map_to_sysmem(bflow->buf);
 	info.dev = dev;
 	info.bflow = bflow;
+	snprintf(source, sizeof(source), "%s:%d", bflow->dev->name,
+		 bflow->part);
 	ret = pxe_setup_ctx(&ctx, &cmdtp, disto_getfile, &info, true,
 			    bflow->subdir);
-	if (ret)
+	if (!ret)
+		ret = pxe_set_source(&ctx, source);
+	if (ret) {
+		pxe_destroy_ctx(&ctx);
 		return log_msg_ret("ctx", -EINVAL);
+	}
 
 	ret = pxe_process(&ctx, addr, false);
+	pxe_destroy_ctx(&ctx);
 	if (ret)
 		return log_msg_ret("bread", -EINVAL);
 
@@ -135,6 +135,7 @@ static int distro_pxe_boot(struct udevice *dev, struct bootflow *bflow)
 	struct pxe_context *ctx = dev_get_priv(dev);
 	struct cmd_tbl cmdtp = {};	/* dummy */
 	struct distro_info info;
+	char source[24];
 	ulong addr;
 	int ret;
 
@@ -142,12 +143,18 @@ static int distro_pxe_boot(struct udevice *dev, struct bootflow *bflow)
 	info.dev = dev;
 	info.bflow = bflow;
 	info.cmdtp = &cmdtp;
+	snprintf(source, sizeof(source), "tftp %pI4", &net_server_ip);
 	ret = pxe_setup_ctx(ctx, &cmdtp, disto_pxe_getfile, &info, false,
 			    bflow->subdir);
-	if (ret)
+	if (!ret)
+		ret = pxe_set_source(ctx, source);
+	if (ret) {
+		pxe_destroy_ctx(ctx);
 		return log_msg_ret("ctx", -EINVAL);
+	}
 
 	ret = pxe_process(ctx, addr, false);
+	pxe_destroy_ctx(ctx);
 	if (ret)
 		return log_msg_ret("bread", -EINVAL);
 
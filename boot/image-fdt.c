@@ -605,13 +605,54 @@ __weak int arch_fixup_fdt(void *blob)
 	return 0;
 }
 
+/**
+ * boot_get_initrd_frame_index() - Get the frame index of the ramdisk, if any
+ *
+ * A FIT ramdisk made up of independently compressed frames may have a frame
+ * index, which can be passed to the OS along with the compressed ramdisk.
+ *
+ * @images: Images being booted
+ * @indexp: Returns the frame index
+ * @compp: Returns the compression used by the ramdisk (IH_COMP_...)
+ * Return: number of frames, or 0 if there is no usable frame index
+ */
+static int boot_get_initrd_frame_index(bootm_headers_t *images,
+				       const fdt32_t **indexp, u8 *compp)
+{
+	const void *fit = images->fit_hdr_rd;
+	int noffset = images->fit_noffset_rd;
+	ulong total = 0;
+	int count, i;
+
+	if (!IS_ENABLED(CONFIG_FIT_RAMDISK_FRAME_INDEX) || !fit ||
+	    !images->initrd_start)
+		return 0;
+	if (fit_image_get_frame_index(fit, noffset, indexp, &count) ||
+	    fit_image_get_comp(fit, noffset, compp) || *compp == IH_COMP_NONE)
+		return 0;
+
+	/* the frames must cover the ramdisk exactly */
+	for (i = 0; i < count; i++)
+		total += fdt32_to_cpu((*indexp)[i * 2]);
+	if (total != images->initrd_end - images->initrd_start) {
+		printf("WARNING: ramdisk frame index does not match its size\n");
+		return 0;
+	}
+
+	return count;
+}
+
 int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		       int of_size, struct lmb *lmb)
 {
 	ulong *initrd_start = &images->initrd_start;
 	ulong *initrd_end = &images->initrd_end;
+	const fdt32_t *frame_index;
+	int frame_count;
+	ulong room;
 	int ret = -EPERM;
 	int fdt_ret;
+	u8 comp;
 
 	if (fdt_root(blob) < 0) {
 		printf("ERROR: root node setup failed\n");
@@ -670,17 +711,31 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	}
 
 	/* Delete the old LMB reservation */
+	room = fdt_totalsize(blob);
 	if (lmb)
 		lmb_free(lmb, (phys_addr_t)(u32)(uintptr_t)blob,
-			 (phys_size_t)fdt_totalsize(blob));
+			 (phys_size_t)room);
 
 	ret = fdt_shrink_to_minimum(blob, 0);
 	if (ret < 0)
 		goto err;
 	of_size = ret;
 
+	frame_count = boot_get_initrd_frame_index(images, &frame_index, &comp);
 	if (*initrd_start && *initrd_end) {
 		of_size += FDT_RAMDISK_OVERHEAD;
+		if (frame_count) {
+			int extra = FDT_RAMDISK_OVERHEAD +
+				frame_count * 2 * sizeof(fdt32_t);
+
+			/* The index must fit in the padding given to the FDT */
+			if (of_size + extra > room) {
+				printf("WARNING: no room for ramdisk frame index, increase CONFIG_SYS_FDT_PAD\n");
+				frame_count = 0;
+			} else {
+				of_size += extra;
+			}
+		}
 		fdt_set_totalsize(blob, of_size);
 	}
 	/* Create a new LMB reservation */
@@ -688,6 +743,9 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		lmb_reserve(lmb, (ulong)blob, of_size);
 
 	fdt_initrd(blob, *initrd_start, *initrd_end);
+	if (frame_count)
+		fdt_initrd_frame_index(blob, genimg_get_comp_short_name(comp),
+				       frame_index, frame_count);
 	if (!ft_verify_fdt(blob))
 		goto err;
 
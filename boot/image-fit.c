@@ -483,6 +483,7 @@ void fit_image_print(const void *fit, int image_noffset, const char *p)
 	const void *data;
 	int noffset;
 	int ndepth;
+	int count;
 	int ret;
 
 	if (!CONFIG_IS_ENABLED(FIT_PRINT))
@@ -512,6 +513,8 @@ void fit_image_print(const void *fit, int image_noffset, const char *p)
 
 	fit_image_get_comp(fit, image_noffset, &comp);
 	printf("%s  Compression:  %s\n", p, genimg_get_comp_name(comp));
+	if (!fit_image_get_frame_index(fit, image_noffset, NULL, &count))
+		printf("%s  Frame index:  %d frames\n", p, count);
 
 	ret = fit_image_get_data_and_size(fit, image_noffset, &data, &size);
 
@@ -1051,6 +1054,42 @@ int fit_image_get_data_and_size(const void *fit, int noffset,
 	return ret;
 }
 
+/**
+ * fit_image_get_frame_index - get the frame index of a compressed image
+ * @fit: pointer to the FIT format image header
+ * @noffset: component image node offset
+ * @index: double pointer to fdt32_t, will hold the address of the index,
+ *	or NULL if not needed
+ * @count: pointer to int, will hold the number of frames
+ *
+ * fit_image_get_frame_index() finds the frame index which mkimage adds to
+ * an image made up of independently compressed frames. The index holds a
+ * pair of cells for each frame: its compressed size and its decompressed
+ * size, in the order of the frames in the image data.
+ *
+ * returns:
+ *     0, on success
+ *     -ENOENT, if there is no index
+ *     -EINVAL, if the index is empty or malformed
+ */
+int fit_image_get_frame_index(const void *fit, int noffset,
+			      const fdt32_t **index, int *count)
+{
+	const fdt32_t *val;
+	int len;
+
+	val = fdt_getprop(fit, noffset, FIT_FRAME_INDEX_PROP, &len);
+	if (!val)
+		return -ENOENT;
+	if (!len || len % (2 * sizeof(fdt32_t)))
+		return -EINVAL;
+	if (index)
+		*index = val;
+	*count = len / (2 * sizeof(fdt32_t));
+
+	return 0;
+}
+
 /**
  * fit_image_hash_get_algo - get hash algorithm name
  * @fit: pointer to the FIT format image header
@@ -2013,6 +2052,7 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 	ulong load, load_end, data, len;
 	uint8_t os, comp;
 	const char *prop_name;
+	int frames;
 	int ret;
 
 	fit = map_sysmem(addr, 0);
@@ -2231,7 +2271,8 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 		memcpy(loadbuf, buf, len);
 	}
 
-	if (image_type == IH_TYPE_RAMDISK && comp != IH_COMP_NONE)
+	if (image_type == IH_TYPE_RAMDISK && comp != IH_COMP_NONE &&
+	    fit_image_get_frame_index(fit, noffset, NULL, &frames))
 		puts("WARNING: 'compression' nodes for ramdisks are deprecated,"
 		     " please fix your .its file!\n");
 
@@ -429,30 +429,13 @@ int image_decomp_type(const unsigned char *buf, ulong len)
 	return cmagic->comp_id;
 }
 
-int image_decomp(int comp, ulong load, ulong image_start, int type,
-		 void *load_buf, void *image_buf, ulong image_len,
-		 uint unc_len, ulong *load_end)
+int image_decomp_buf(int comp, void *load_buf, uint unc_len, void *image_buf,
+		     ulong *lenp)
 {
+	ulong image_len = *lenp;
 	int ret = -ENOSYS;
 
-	*load_end = load;
-	print_decomp_msg(comp, type, load == image_start);
-
-	/*
-	 * Load the image to the right place, decompressing if needed. After
-	 * this, image_len will be set to the number of uncompressed bytes
-	 * loaded, ret will be non-zero on error.
-	 */
 	switch (comp) {
-	case IH_COMP_NONE:
-		ret = 0;
-		if (load == image_start)
-			break;
-		if (image_len <= unc_len)
-			memmove_wd(load_buf, image_buf, image_len, CHUNKSZ);
-		else
-			ret = -ENOSPC;
-		break;
 	case IH_COMP_GZIP:
 		if (!tools_build() && CONFIG_IS_ENABLED(GZIP))
 			ret = gunzip(load_buf, unc_len, image_buf, &image_len);
@@ -510,6 +493,40 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 		}
 		break;
 	}
+	if (ret)
+		return ret;
+	*lenp = image_len;
+
+	return 0;
+}
+
+int image_decomp(int comp, ulong load, ulong image_start, int type,
+		 void *load_buf, void *image_buf, ulong image_len,
+		 uint unc_len, ulong *load_end)
+{
+	int ret;
+
+	*load_end = load;
+	print_decomp_msg(comp, type, load == image_start);
+
+	/*
+	 * Load the image to the right place, decompressing if needed. After
+	 * this, image_len will be set to the number of uncompressed bytes
+	 * loaded, ret will be non-zero on error.
+	 */
+	if (comp == IH_COMP_NONE) {
+		ret = 0;
+		if (load != image_start) {
+			if (image_len <= unc_len)
+				memmove_wd(load_buf, image_buf, image_len,
+					   CHUNKSZ);
+			else
+				ret = -ENOSPC;
+		}
+	} else {
+		ret = image_decomp_buf(comp, load_buf, unc_len, image_buf,
+				       &image_len);
+	}
 	if (ret == -ENOSYS) {
 		printf("Unimplemented compression type %d\n", comp);
 		return ret;
@@ -28,6 +28,7 @@
 
 #include <splash.h>
 #include <asm/io.h>
+#include <u-boot/crc.h>
 
 #include "menu.h"
 #include "cli.h"
@@ -163,8 +164,6 @@ int get_pxe_file(struct pxe_context *ctx, const char *file_path,
 	return 1;
 }
 
-#define PXELINUX_DIR "pxelinux.cfg/"
-
 /**
  * get_pxelinux_path() - Get a file in the pxelinux.cfg/ directory
  *
@@ -246,7 +245,7 @@ static struct pxe_label *label_create(void)
 /**
  * label_destroy() - free the memory used by a pxe_label
  *
- * This frees @label itself as well as memory used by its name,
+ * This frees @label itself as well as memory used by its name, menu,
  * kernel, config, append, initrd, fdt, fdtdir and fdtoverlay members, if
  * they're non-NULL.
  *
@@ -259,6 +258,7 @@ static struct pxe_label *label_create(void)
 static void label_destroy(struct pxe_label *label)
 {
 	free(label->name);
+	free(label->menu);
 	free(label->kernel);
 	free(label->config);
 	free(label->append);
@@ -1387,6 +1387,7 @@ void destroy_pxe_menu(struct pxe_menu *cfg)
 
 	free(cfg->title);
 	free(cfg->default_label);
+	free(cfg->bmp);
 
 	list_for_each_safe(pos, n, &cfg->labels) {
 		label = list_entry(pos, struct pxe_label, list);
@@ -1397,27 +1398,188 @@ void destroy_pxe_menu(struct pxe_menu *cfg)
 	free(cfg);
 }
 
+/*
+ * The last config file parsed, so that if the same file is processed again
+ * (e.g. by 'sysboot' in a script, or when booting a bootflow found by a scan)
+ * it need not be parsed again, nor its include files fetched.
+ *
+ * crc - CRC32 of the config file
+ * len - length of the config file in bytes
+ * bootdir - directory that the config file's include files were read from
+ * getfile - function which read the include files
+ * source - device or server that the include files were read from
+ * cfg - the parsed config, including its include files
+ */
+static struct {
+	u32 crc;
+	size_t len;
+	char *bootdir;
+	pxe_getfile_func getfile;
+	char *source;
+	struct pxe_menu *cfg;
+} pxe_last;
+
+/*
+ * Copy a string if it is not NULL.
+ *
+ * Returns 0 on success, -ENOMEM if out of memory.
+ */
+static int dup_str(char **dst, const char *src)
+{
+	if (!src)
+		return 0;
+	*dst = strdup(src);
+
+	return *dst ? 0 : -ENOMEM;
+}
+
+/*
+ * Make a copy of a label, ready to be booted.
+ *
+ * Returns the new label, or NULL if out of memory.
+ */
+static struct pxe_label *label_dup(const struct pxe_label *label)
+{
+	struct pxe_label *new;
+
+	new = label_create();
+	if (!new)
+		return NULL;
+
+	memcpy(new->num, label->num, sizeof(new->num));
+	new->ipappend = label->ipappend;
+	new->localboot = label->localboot;
+	new->localboot_val = label->localboot_val;
+	new->kaslrseed = label->kaslrseed;
+	if (dup_str(&new->name, label->name) ||
+	    dup_str(&new->menu, label->menu) ||
+	    dup_str(&new->kernel, label->kernel) ||
+	    dup_str(&new->config, label->config) ||
+	    dup_str(&new->append, label->append) ||
+	    dup_str(&new->initrd, label->initrd) ||
+	    dup_str(&new->fdt, label->fdt) ||
+	    dup_str(&new->fdtdir, label->fdtdir) ||
+	    dup_str(&new->fdtoverlays, label->fdtoverlays)) {
+		label_destroy(new);
+		return NULL;
+	}
+
+	return new;
+}
+
+/*
+ * Make a copy of a parsed config, with none of its labels attempted.
+ *
+ * Returns the new config, or NULL if out of memory.
+ */
+static struct pxe_menu *pxe_menu_dup(const struct pxe_menu *cfg)
+{
+	struct pxe_label *label, *new_label;
+	struct pxe_menu *new;
+
+	new = calloc(1, sizeof(struct pxe_menu));
+	if (!new)
+		return NULL;
+
+	INIT_LIST_HEAD(&new->labels);
+	new->timeout = cfg->timeout;
+	new->prompt = cfg->prompt;
+	if (dup_str(&new->title, cfg->title) ||
+	    dup_str(&new->default_label, cfg->default_label) ||
+	    dup_str(&new->bmp, cfg->bmp))
+		goto err;
+
+	list_for_each_entry(label, &cfg->labels, list) {
+		new_label = label_dup(label);
+		if (!new_label)
+			goto err;
+		list_add_tail(&new_label->list, &new->labels);
+	}
+
+	return new;
+err:
+	destroy_pxe_menu(new);
+
+	return NULL;
+}
+
+/*
+ * Remember a parsed config file, replacing the previous one.
+ */
+static void pxe_last_set(struct pxe_context *ctx, u32 crc, size_t len,
+			 struct pxe_menu *cfg)
+{
+	if (pxe_last.cfg)
+		destroy_pxe_menu(pxe_last.cfg);
+	free(pxe_last.bootdir);
+	free(pxe_last.source);
+
+	pxe_last.crc = crc;
+	pxe_last.len = len;
+	pxe_last.getfile = ctx->getfile;
+	pxe_last.bootdir = strdup(ctx->bootdir);
+	pxe_last.source = strdup(ctx->source);
+	pxe_last.cfg = NULL;
+	if (pxe_last.bootdir && pxe_last.source)
+		pxe_last.cfg = pxe_menu_dup(cfg);
+}
+
+/*
+ * Get a copy of the last config file parsed, if it is the same file and its
+ * include files were read from the same place.
+ *
+ * Returns the config, or NULL if it is a different file.
+ */
+static struct pxe_menu *pxe_last_get(struct pxe_context *ctx, u32 crc,
+				     size_t len)
+{
+	if (!pxe_last.cfg || pxe_last.crc != crc || pxe_last.len != len ||
+	    pxe_last.getfile != ctx->getfile ||
+	    strcmp(pxe_last.source, ctx->source) ||
+	    strcmp(pxe_last.bootdir, ctx->bootdir))
+		return NULL;
+	log_debug("Using parsed config file (crc %08x)\n", crc);
+
+	return pxe_menu_dup(pxe_last.cfg);
+}
+
 struct pxe_menu *parse_pxefile(struct pxe_context *ctx, unsigned long menucfg)
 {
 	struct pxe_menu *cfg;
+	size_t len = 0;
 	char *buf;
+	u32 crc = 0;
 	int r;
 
+	buf = map_sysmem(menucfg, 0);
+	if (IS_ENABLED(CONFIG_PXE_CACHE) && ctx->source) {
+		len = strlen(buf);
+		crc = crc32(0, (uchar *)buf, len);
+		cfg = pxe_last_get(ctx, crc, len);
+		if (cfg) {
+			unmap_sysmem(buf);
+			return cfg;
+		}
+	}
+
 	cfg = malloc(sizeof(struct pxe_menu));
-	if (!cfg)
+	if (!cfg) {
+		unmap_sysmem(buf);
 		return NULL;
+	}
 
 	memset(cfg, 0, sizeof(struct pxe_menu));
 
 	INIT_LIST_HEAD(&cfg->labels);
 
-	buf = map_sysmem(menucfg, 0);
 	r = parse_pxefile_top(ctx, buf, menucfg, cfg, 1);
 	unmap_sysmem(buf);
 	if (r < 0) {
 		destroy_pxe_menu(cfg);
 		return NULL;
 	}
+	if (IS_ENABLED(CONFIG_PXE_CACHE) && ctx->source)
+		pxe_last_set(ctx, crc, len, cfg);
 
 	return cfg;
 }
@@ -1592,9 +1754,20 @@ int pxe_setup_ctx(struct pxe_context *ctx, struct cmd_tbl *cmdtp,
 	return 0;
 }
 
+int pxe_set_source(struct pxe_context *ctx, const char *source)
+{
+	free(ctx->source);
+	ctx->source = strdup(source);
+	if (!ctx->source)
+		return -ENOMEM;
+
+	return 0;
+}
+
 void pxe_destroy_ctx(struct pxe_context *ctx)
 {
 	free(ctx->bootdir);
+	free(ctx->source);
 }
 
 int pxe_process(struct pxe_context *ctx, ulong pxefile_addr_r, bool prompt)
@@ -96,6 +96,7 @@ static int do_bootflow_scan(struct cmd_tbl *cmdtp, int flag, int argc,
 	struct udevice *dev;
 	struct bootflow bflow;
 	bool all = false, boot = false, errors = false, list = false;
+	bool cache = false, parallel = false;
 	int num_valid = 0;
 	bool has_args;
 	int ret, i;
@@ -111,8 +112,10 @@ static int do_bootflow_scan(struct cmd_tbl *cmdtp, int flag, int argc,
 		if (has_args) {
 			all = strchr(argv[1], 'a');
 			boot = strchr(argv[1], 'b');
+			cache = strchr(argv[1], 'c');
 			errors = strchr(argv[1], 'e');
 			list = strchr(argv[1], 'l');
+			parallel = strchr(argv[1], 'p');
 			argc--;
 			argv++;
 		}
@@ -137,6 +140,8 @@ static int do_bootflow_scan(struct cmd_tbl *cmdtp, int flag, int argc,
 		flags |= BOOTFLOWF_SHOW;
 	if (all)
 		flags |= BOOTFLOWF_ALL;
+	if (parallel || IS_ENABLED(CONFIG_BOOTSTD_PARALLEL))
+		flags |= BOOTFLOWF_PARALLEL;
 
 	/*
 	 * If we have a device, just scan for bootflows attached to that device
@@ -171,6 +176,9 @@ static int do_bootflow_scan(struct cmd_tbl *cmdtp, int flag, int argc,
 			show_header();
 		}
 		bootstd_clear_glob();
+		/* the cache records a position among all bootdevs */
+		if (boot && (cache || IS_ENABLED(CONFIG_BOOTSTD_CACHE)))
+			flags |= BOOTFLOWF_CACHE;
 
 		for (i = 0,
 		     ret = bootflow_scan_first(&iter, flags, &bflow);
@@ -186,8 +194,11 @@ static int do_bootflow_scan(struct cmd_tbl *cmdtp, int flag, int argc,
 			}
 			if (list)
 				show_bootflow(i, &bflow, errors);
-			if (boot && !bflow.err)
+			if (boot && !bflow.err) {
+				if (flags & BOOTFLOWF_CACHE)
+					bootflow_cache_save(&bflow);
 				bootflow_run_boot(&iter, &bflow);
+			}
 		}
 	}
 	bootflow_iter_uninit(&iter);
@@ -383,7 +394,8 @@ static int do_bootflow_boot(struct cmd_tbl *cmdtp, int flag, int argc,
 #ifdef CONFIG_SYS_LONGHELP
 static char bootflow_help_text[] =
 #ifdef CONFIG_CMD_BOOTFLOW_FULL
-	"scan [-abel] [bdev]   - scan for valid bootflows (-l list, -a all, -e errors, -b boot)\n"
+	"scan [-abcelp] [bdev] - scan for valid bootflows (-l list, -a all, -e errors, -b boot,\n"
+	"                                 -c use boot cache, -p start MMC bootdevs in parallel)\n"
 	"bootflow list [-e]             - list scanned bootflows (-e errors)\n"
 	"bootflow select [<num>|<name>] - select a bootflow\n"
 	"bootflow info [-d]             - show info on current bootflow (-d dump bootflow)\n"
@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Benchmark of the decompression algorithms used to boot images
+ *
+ * This decompresses real payloads, such as a kernel compressed in various
+ * ways, with image_decomp_buf() and reports the speed and memory used, to
+ * help choose an algorithm for a board.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <fs.h>
+#include <image.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <time.h>
+#include <linux/sizes.h>
+
+enum {
+	COMPBENCH_REPEAT	= 3,
+	COMPBENCH_OUT_SIZE	= SZ_16M,
+};
+
+/**
+ * struct compbench_result - Results from decompressing a payload
+ *
+ * @comp: Compression algorithm (IH_COMP_...)
+ * @in_size: Size of the compressed data in bytes
+ * @out_size: Size of the decompressed data in bytes
+ * @us: Shortest time taken to decompress, in microseconds
+ * @ticks: Shortest time taken to decompress, in timer ticks
+ * @peak: Peak heap usage while decompressing, in bytes
+ */
+struct compbench_result {
+	int comp;
+	ulong in_size;
+	ulong out_size;
+	ulong us;
+	u64 ticks;
+	ulong peak;
+};
+
+static int compbench_run(void *buf, ulong size, void *out, ulong out_max,
+			 int repeat, struct compbench_result *res)
+{
+	int i;
+
+	memset(res, '\0', sizeof(*res));
+	res->comp = image_decomp_type(buf, size);
+	if (res->comp <= IH_COMP_NONE)
+		return -EPROTONOSUPPORT;
+	res->in_size = size;
+	res->us = ULONG_MAX;
+	res->ticks = U64_MAX;
+
+	for (i = 0; i < repeat; i++) {
+		ulong len = size, start, us;
+		u64 start_ticks, ticks;
+		ulong peak;
+		int ret;
+
+		malloc_peak_start();
+		start_ticks = get_ticks();
+		start = timer_get_us();
+		ret = image_decomp_buf(res->comp, out, out_max, buf, &len);
+		us = timer_get_us() - start;
+		ticks = get_ticks() - start_ticks;
+		peak = malloc_peak_stop();
+		if (ret)
+			return ret;
+
+		res->out_size = len;
+		res->us = min(res->us, us);
+		res->ticks = min(res->ticks, ticks);
+		res->peak = max(res->peak, peak);
+	}
+
+	return 0;
+}
+
+static void compbench_show(const char *name, struct compbench_result *res,
+			   bool csv)
+{
+	ulong ratio, tpb;
+
+	if (csv) {
+		printf("%s,%s,%lu,%lu,%lu,%llu,%lu,%lu\n",
+		       genimg_get_comp_short_name(res->comp), name, res->in_size,
+		       res->out_size, res->us, res->ticks, get_tbclk(),
+		       res->peak);
+		return;
+	}
+
+	/* show the ratio and ticks per byte to two decimal places */
+	ratio = res->out_size * 100 / max(res->in_size, 1UL);
+	tpb = res->ticks * 100 / max(res->out_size, 1UL);
+	printf("%-6s %10lu %10lu %4lu.%02lu %8lu %8lu %5lu.%02lu  %s\n",
+	       genimg_get_comp_short_name(res->comp), res->in_size,
+	       res->out_size, ratio / 100, ratio % 100,
+	       res->out_size / max(res->us, 1UL), res->peak / 1024, tpb / 100,
+	       tpb % 100, name);
+}
+
+/* Read a whole file into a new buffer */
+static int compbench_load(const char *ifname, const char *dev_part,
+			  const char *fname, void **bufp, ulong *sizep)
+{
+	loff_t size, actread;
+	void *buf;
+
+	if (fs_set_blk_dev(ifname, dev_part, FS_TYPE_ANY))
+		return -ENODEV;
+	if (fs_size(fname, &size))
+		return -ENOENT;
+	buf = malloc(size);
+	if (!buf)
+		return -ENOMEM;
+	if (fs_set_blk_dev(ifname, dev_part, FS_TYPE_ANY) ||
+	    fs_read(fname, map_to_sysmem(buf), 0, size, &actread) ||
+	    actread != size) {
+		free(buf);
+		return -EIO;
+	}
+	*bufp = buf;
+	*sizep = size;
+
+	return 0;
+}
+
+static int do_compbench(struct cmd_tbl *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	ulong out_max = COMPBENCH_OUT_SIZE;
+	const char *ifname = NULL, *dev_part = NULL;
+	int repeat = COMPBENCH_REPEAT;
+	bool csv = false;
+	int ret = 0;
+	void *out;
+
+	for (argc--, argv++; argc && *argv[0] == '-'; argc--, argv++) {
+		const char *opt = argv[0] + 1;
+
+		if (*opt == 'c') {
+			csv = true;
+			continue;
+		}
+		if (argc < 2)
+			return CMD_RET_USAGE;
+		argc--;
+		argv++;
+		switch (*opt) {
+		case 'n':
+			repeat = dectoul(argv[0], NULL);
+			break;
+		case 'o':
+			out_max = hextoul(argv[0], NULL);
+			break;
+		case 'f':
+			if (argc < 2)
+				return CMD_RET_USAGE;
+			ifname = argv[0];
+			dev_part = argv[1];
+			argc--;
+			argv++;
+			break;
+		default:
+			return CMD_RET_USAGE;
+		}
+	}
+	if (!argc || repeat < 1 || (!ifname && argc % 2))
+		return CMD_RET_USAGE;
+
+	out = malloc(out_max);
+	if (!out) {
+		printf("Cannot allocate %#lx bytes for output (try -o)\n",
+		       out_max);
+		return CMD_RET_FAILURE;
+	}
+
+	if (csv)
+		printf("comp,payload,in_bytes,out_bytes,us,ticks,tbclk,peak_heap\n");
+	else
+		printf("%-6s %10s %10s %7s %8s %8s %8s  %s\n", "Comp", "In",
+		       "Out", "Ratio", "MB/s", "Heap KB", "Ticks/B", "Payload");
+	while (argc) {
+		struct compbench_result res;
+		const char *name = argv[0];
+		void *buf;
+		ulong size;
+		int err;
+
+		if (ifname) {
+			err = compbench_load(ifname, dev_part, name, &buf,
+					     &size);
+			argc--;
+			argv++;
+			if (err) {
+				printf("Cannot read '%s' (err=%d)\n", name, err);
+				ret = CMD_RET_FAILURE;
+				continue;
+			}
+		} else {
+			size = hextoul(argv[1], NULL);
+			buf = map_sysmem(hextoul(name, NULL), size);
+			argc -= 2;
+			argv += 2;
+		}
+
+		err = compbench_run(buf, size, out, out_max, repeat, &res);
+		if (err) {
+			printf("Cannot decompress '%s' (err=%d)\n", name, err);
+			ret = CMD_RET_FAILURE;
+		} else {
+			compbench_show(name, &res, csv);
+		}
+		if (ifname)
+			free(buf);
+		else
+			unmap_sysmem(buf);
+	}
+	free(out);
+
+	return ret;
+}
+
+U_BOOT_CMD(
+	compbench, CONFIG_SYS_MAXARGS, 0, do_compbench,
+	"benchmark decompression of compressed images",
+	"[-c] [-n <count>] [-o <size>] <addr> <size> [<addr> <size>...]\n"
+	"    - decompress images in memory\n"
+	"compbench [-c] [-n <count>] [-o <size>] -f <interface> <dev[:part]> <filename>...\n"
+	"    - decompress images from files\n"
+	"   -c   - show results as comma-separated values\n"
+	"   -n   - number of times to decompress each image, best time is shown\n"
+	"   -o   - size of the output buffer (hex)"
+);
@@ -17,40 +17,52 @@
 static int do_hash(struct cmd_tbl *cmdtp, int flag, int argc,
 		   char *const argv[])
 {
+	struct hash_opts opts = { 0 };
 	char *s;
 	int flags = HASH_FLAG_ENV;
 
-#ifdef CONFIG_HASH_VERIFY
-	if (argc < 4)
-		return CMD_RET_USAGE;
-	if (!strcmp(argv[1], "-v")) {
-		flags |= HASH_FLAG_VERIFY;
+	/* Move forward to the options or 'algorithm' parameter */
+	argc--;
+	argv++;
+	while (argc && *argv[0] == '-') {
+		if (IS_ENABLED(CONFIG_HASH_VERIFY) && !strcmp(*argv, "-v")) {
+			flags |= HASH_FLAG_VERIFY;
+		} else if (!strcmp(*argv, "-t") && argc > 1) {
+			opts.leaf_size = hextoul(argv[1], NULL);
+			if (!opts.leaf_size)
+				return CMD_RET_USAGE;
+			argc--;
+			argv++;
+		} else if (!strcmp(*argv, "-d") && argc > 2) {
+			opts.ifname = argv[1];
+			opts.dev_part = argv[2];
+			argc -= 2;
+			argv += 2;
+		} else {
+			return CMD_RET_USAGE;
+		}
 		argc--;
 		argv++;
 	}
-#endif
-	/* Move forward to 'algorithm' parameter */
-	argc--;
-	argv++;
+	if (argc < ((flags & HASH_FLAG_VERIFY) ? 4 : 3))
+		return CMD_RET_USAGE;
+
 	for (s = *argv; *s; s++)
 		*s = tolower(*s);
-	return hash_command(*argv, flags, cmdtp, flag, argc - 1, argv + 1);
+	return hash_command_opts(*argv, flags, &opts, argc - 1, argv + 1);
 }
 
-#ifdef CONFIG_HASH_VERIFY
-#define HARGS 6
-#else
-#define HARGS 5
-#endif
-
 U_BOOT_CMD(
-	hash,	HARGS,	1,	do_hash,
+	hash,	CONFIG_SYS_MAXARGS,	1,	do_hash,
 	"compute hash message digest",
-	"algorithm address count [[*]hash_dest]\n"
+	"[-t leaf_size] [-d interface dev[:part]] algorithm address count [[*]hash_dest]\n"
 		"    - compute message digest [save to env var / *address]"
 #ifdef CONFIG_HASH_VERIFY
-	"\nhash -v algorithm address count [*]hash\n"
+	"\nhash -v [-t leaf_size] [-d interface dev[:part]] algorithm address count [*]hash\n"
 		"    - verify message digest of memory area to immediate value, \n"
 		"      env var or *address"
 #endif
+	"\n  -t - hash each leaf_size bytes separately (in parallel if\n"
+	"       possible), then hash the concatenated digests\n"
+	"  -d - read from a block device, with address and count in blocks"
 );
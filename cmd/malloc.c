@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Command-line access to malloc() statistics
+ */
+
+#include <common.h>
+#include <command.h>
+#include <display_options.h>
+#include <malloc.h>
+
+static void show_bytes(const char *name, ulong bytes)
+{
+	printf("%-12s: %08lx (", name, bytes);
+	print_size(bytes, ")\n");
+}
+
+static int do_malloc_info(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	struct malloc_info info;
+	ulong start, size;
+	int cls;
+
+	malloc_get_info(&info);
+	printf("%-12s: %08lx\n", "heap start", info.start);
+	show_bytes("heap size", info.size);
+	show_bytes("high water", info.sbrked);
+	show_bytes("in use", info.in_use);
+
+	if (!CONFIG_IS_ENABLED(SYS_MALLOC_SLAB))
+		return 0;
+	slab_get_area(&start, &size);
+	printf("%-12s: %08lx\n", "slab start", start);
+	show_bytes("slab size", size);
+	show_bytes("slab in use", slab_in_use());
+	printf("\n%5s %6s %8s %8s %10s %9s\n", "Size", "Pages", "In use", "Peak",
+	       "Allocs", "Fallbacks");
+	for (cls = 0; cls < SLAB_CLASS_COUNT; cls++) {
+		struct slab_stats stats;
+
+		slab_get_stats(cls, &stats);
+		printf("%5u %6u %8u %8u %10lu %9lu\n", stats.size, stats.pages,
+		       stats.in_use, stats.peak, stats.allocs, stats.fallbacks);
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_SYS_LONGHELP
+static char malloc_help_text[] =
+	"info - show malloc() heap usage and slab statistics";
+#endif
+
+U_BOOT_CMD_WITH_SUBCMDS(malloc, "malloc() heap", malloc_help_text,
+	U_BOOT_SUBCMD_MKENT(info, 1, 1, do_malloc_info));
@@ -40,6 +40,9 @@ DECLARE_GLOBAL_DATA_PTR;
 #define HELP_Q ""
 #endif
 
+/* Number of bytes compared by 'cmp' between checks for Ctrl-C */
+#define MEM_CMP_CHUNK	(64 << 10)
+
 static int mod_mem(struct cmd_tbl *, int, int, int, char * const []);
 
 /* Display values from last command.
@@ -240,7 +243,7 @@ static int do_mem_mwc(struct cmd_tbl *cmdtp, int flag, int argc,
 static int do_mem_cmp(struct cmd_tbl *cmdtp, int flag, int argc,
 		      char *const argv[])
 {
-	ulong	addr1, addr2, count, ngood, bytes;
+	ulong	addr1, addr2, count, ngood, bytes, chunk;
 	int	size;
 	int     rcode = 0;
 	const char *type;
@@ -269,7 +272,26 @@ static int do_mem_cmp(struct cmd_tbl *cmdtp, int flag, int argc,
 	bytes = size * count;
 	base = buf1 = map_sysmem(addr1, bytes);
 	buf2 = map_sysmem(addr2, bytes);
-	for (ngood = 0; ngood < count; ++ngood) {
+
+	/* skip over equal chunks quickly, a word at a time */
+	for (ngood = 0; ngood < count; ngood += chunk) {
+		chunk = min(count - ngood, (ulong)MEM_CMP_CHUNK / size);
+		if (memcmp(buf1, buf2, chunk * size))
+			break;
+		buf1 += chunk * size;
+		buf2 += chunk * size;
+
+		WATCHDOG_RESET();
+		if (ctrlc()) {
+			puts("Abort\n");
+			ngood += chunk;
+			rcode = 1;
+			break;
+		}
+	}
+
+	/* find the element which differs, in the chunk holding it */
+	for (; !rcode && ngood < count; ++ngood) {
 		if (size == 4) {
 			word1 = *(u32 *)buf1;
 			word2 = *(u32 *)buf2;
@@ -294,10 +316,6 @@ static int do_mem_cmp(struct cmd_tbl *cmdtp, int flag, int argc,
 
 		buf1 += size;
 		buf2 += size;
-
-		/* reset watchdog from time to time */
-		if ((ngood % (64 << 10)) == 0)
-			WATCHDOG_RESET();
 	}
 	unmap_sysmem(buf1);
 	unmap_sysmem(buf2);
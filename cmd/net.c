@@ -16,8 +16,10 @@
 #include <net.h>
 #include <net/udp.h>
 #include <net/sntp.h>
+#include <net/tftp.h>
 
 static int netboot_common(enum proto_t, struct cmd_tbl *, int, char * const []);
+static void netboot_update_env(void);
 
 #ifdef CONFIG_CMD_BOOTP
 static int do_bootp(struct cmd_tbl *cmdtp, int flag, int argc,
@@ -34,20 +36,68 @@ U_BOOT_CMD(
 #endif
 
 #ifdef CONFIG_CMD_TFTPBOOT
+#ifdef CONFIG_TFTP_MULTI
+#define TFTPBOOT_MAXARGS	(2 + TFTP_MULTI_MAX)
+
+/* Fetch files given as addr:filename at once, setting filesize to the last */
+static int tftpb_multi(int argc, char *const argv[])
+{
+	struct tftp_file files[TFTP_MULTI_MAX];
+	char *end;
+	int ret, i;
+
+	if (!argc || argc > TFTP_MULTI_MAX)
+		return CMD_RET_USAGE;
+	for (i = 0; i < argc; i++) {
+		files[i].addr = hextoul(argv[i], &end);
+		if (end == argv[i] || *end != ':' || !end[1])
+			return CMD_RET_USAGE;
+		files[i].name = end + 1;
+	}
+
+	ret = tftp_multi(files, argc);
+	if (ret) {
+		if (ret == -ENAMETOOLONG)
+			printf("Filename too long\n");
+		return CMD_RET_FAILURE;
+	}
+	for (i = 0; i < argc; i++)
+		printf("Bytes transferred = %ld (%lx hex) to %lx for '%s'\n",
+		       files[i].size, files[i].size, files[i].addr,
+		       files[i].name);
+	env_set_hex("filesize", files[argc - 1].size);
+	env_set_hex("fileaddr", files[argc - 1].addr);
+	netboot_update_env();
+
+	return CMD_RET_SUCCESS;
+}
+#else
+#define TFTPBOOT_MAXARGS	3
+#endif
+
 int do_tftpb(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 {
 	int ret;
 
 	bootstage_mark_name(BOOTSTAGE_KERNELREAD_START, "tftp_start");
-	ret = netboot_common(TFTPGET, cmdtp, argc, argv);
+#ifdef CONFIG_TFTP_MULTI
+	if (argc > 1 && !strcmp(argv[1], "-m"))
+		ret = tftpb_multi(argc - 2, argv + 2);
+	else
+#endif
+		ret = netboot_common(TFTPGET, cmdtp, argc, argv);
 	bootstage_mark_name(BOOTSTAGE_KERNELREAD_STOP, "tftp_done");
 	return ret;
 }
 
 U_BOOT_CMD(
-	tftpboot,	3,	1,	do_tftpb,
+	tftpboot,	TFTPBOOT_MAXARGS,	1,	do_tftpb,
 	"boot image via network using TFTP protocol",
 	"[loadAddress] [[hostIPaddr:]bootfilename]"
+#ifdef CONFIG_TFTP_MULTI
+	"\ntftpboot -m addr:filename [addr:filename...]\n"
+	"    - load several files at once, e.g. kernel, initrd and fdt"
+#endif
 );
 #endif
 
@@ -496,8 +546,34 @@ static int do_net_list(struct cmd_tbl *cmdtp, int flag, int argc, char *const ar
 	return CMD_RET_SUCCESS;
 }
 
+static int do_net_stats(struct cmd_tbl *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	struct eth_stats stats;
+	struct udevice *dev;
+	struct uclass *uc;
+
+	uclass_id_foreach_dev(UCLASS_ETH, dev, uc) {
+		if (argc > 1 && strcmp(argv[1], dev->name))
+			continue;
+		printf("eth%d : %s\n", dev_seq(dev), dev->name);
+		if (eth_get_stats(dev, &stats)) {
+			printf("  not probed\n");
+			continue;
+		}
+		printf("  RX packets %lu errors %lu dropped %lu overruns %lu budget-full %lu\n",
+		       stats.rx_packets, stats.rx_errors, stats.rx_dropped,
+		       stats.rx_overruns, stats.rx_budget_full);
+		printf("  TX packets %lu errors %lu\n", stats.tx_packets,
+		       stats.tx_errors);
+	}
+
+	return CMD_RET_SUCCESS;
+}
+
 static struct cmd_tbl cmd_net[] = {
 	U_BOOT_CMD_MKENT(list, 1, 0, do_net_list, "", ""),
+	U_BOOT_CMD_MKENT(stats, 2, 0, do_net_stats, "", ""),
 };
 
 static int do_net(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
@@ -519,8 +595,9 @@ static int do_net(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 }
 
 U_BOOT_CMD(
-	net, 2, 1, do_net,
+	net, 3, 1, do_net,
 	"NET sub-system",
 	"list - list available devices\n"
+	"net stats [dev] - show packet counters of all or one device\n"
 );
 #endif // CONFIG_DM_ETH
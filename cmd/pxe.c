@@ -6,8 +6,11 @@
 
 #include <common.h>
 #include <command.h>
+#include <env.h>
 #include <fs.h>
+#include <malloc.h>
 #include <net.h>
+#include <net/tftp.h>
 
 #include "pxe_utils.h"
 
@@ -105,6 +108,81 @@ static int pxe_ipaddr_paths(struct pxe_context *ctx, unsigned long pxefile_addr_
 	return -ENOENT;
 }
 
+#ifdef CONFIG_TFTP_PROBE
+/**
+ * pxe_probe_add() - Add a config file to the list of those to probe for
+ *
+ * @ctx: PXE context
+ * @paths: List of paths, each allocated
+ * @countp: Number of paths in @paths, updated
+ * @file: Filename to add (relative to pxelinux.cfg/)
+ */
+static void pxe_probe_add(struct pxe_context *ctx, char **paths, int *countp,
+			  const char *file)
+{
+	char *path;
+
+	if (*countp == TFTP_PROBE_MAX)
+		return;
+	path = malloc(strlen(ctx->bootdir) + strlen(PXELINUX_DIR) +
+		      strlen(file) + 1);
+	if (!path)
+		return;
+	sprintf(path, "%s" PXELINUX_DIR "%s", ctx->bootdir, file);
+	paths[(*countp)++] = path;
+}
+
+/**
+ * pxe_probe_paths() - Look for all the config files at once
+ *
+ * This builds the same list of names as pxe_get() tries one by one, asks the
+ * server for all of them at once and then fetches the first one which exists
+ *
+ * @ctx: PXE context
+ * @pxefile_addr_r: Address to load file
+ * Returns 1 on success, -ENOENT if there is no config file, -EINTR if the user
+ * aborted, other value < 0 if the files could not be probed or fetched
+ */
+static int pxe_probe_paths(struct pxe_context *ctx, ulong pxefile_addr_r)
+{
+	char *paths[TFTP_PROBE_MAX];
+	char ip_addr[9], mac_str[21];
+	const char *uuid_str;
+	int count = 0;
+	int ret, i;
+
+	/* a server address in the bootfile is handled by tftp only */
+	if (strchr(ctx->bootdir, ':'))
+		return -ENOTSUPP;
+
+	uuid_str = env_get("pxeuuid");
+	if (uuid_str)
+		pxe_probe_add(ctx, paths, &count, uuid_str);
+	if (format_mac_pxe(mac_str, sizeof(mac_str)) > 0)
+		pxe_probe_add(ctx, paths, &count, mac_str);
+	sprintf(ip_addr, "%08X", ntohl(net_ip.s_addr));
+	for (i = 8; i > 0; i--) {
+		ip_addr[i] = '\0';
+		pxe_probe_add(ctx, paths, &count, ip_addr);
+	}
+	for (i = 0; pxe_default_paths[i]; i++)
+		pxe_probe_add(ctx, paths, &count, pxe_default_paths[i]);
+
+	ret = tftp_probe((const char *const *)paths, count);
+	if (ret >= 0) {
+		ret = get_pxelinux_path(ctx, paths[ret] + strlen(ctx->bootdir) +
+					strlen(PXELINUX_DIR), pxefile_addr_r);
+		/* let the caller try the files one at a time instead */
+		if (ret < 0)
+			ret = -EIO;
+	}
+	for (i = 0; i < count; i++)
+		free(paths[i]);
+
+	return ret;
+}
+#endif
+
 int pxe_get(ulong pxefile_addr_r, char **bootdirp, ulong *sizep)
 {
 	struct cmd_tbl cmdtp[] = {};	/* dummy */
@@ -114,6 +192,18 @@ int pxe_get(ulong pxefile_addr_r, char **bootdirp, ulong *sizep)
 	if (pxe_setup_ctx(&ctx, cmdtp, do_get_tftp, NULL, false,
 			  env_get("bootfile")))
 		return -ENOMEM;
+
+#ifdef CONFIG_TFTP_PROBE
+	i = pxe_probe_paths(&ctx, pxefile_addr_r);
+	if (i > 0)
+		goto done;
+	if (i == -ENOENT || i == -EINTR) {
+		pxe_destroy_ctx(&ctx);
+		return -ENOENT;
+	}
+	/* If probing did not work, fall back to trying one file at a time */
+#endif
+
 	/*
 	 * Keep trying paths until we successfully get a file we're looking
 	 * for.
@@ -210,6 +300,7 @@ do_pxe_boot(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 	unsigned long pxefile_addr_r;
 	char *pxefile_addr_str;
 	struct pxe_context ctx;
+	char source[24];
 	int ret;
 
 	if (argc == 1) {
@@ -228,9 +319,11 @@ do_pxe_boot(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 		return 1;
 	}
 
+	snprintf(source, sizeof(source), "tftp %pI4", &net_server_ip);
 	if (pxe_setup_ctx(&ctx, cmdtp, do_get_tftp, NULL, false,
-			  env_get("bootfile"))) {
+			  env_get("bootfile")) || pxe_set_source(&ctx, source)) {
 		printf("Out of memory\n");
+		pxe_destroy_ctx(&ctx);
 		return CMD_RET_FAILURE;
 	}
 	ret = pxe_process(&ctx, pxefile_addr_r, false);
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Control of the sampling profiler
+ */
+
+#include <common.h>
+#include <command.h>
+#include <env.h>
+#include <mapmem.h>
+#include <sample.h>
+
+static int do_sample_start(struct cmd_tbl *cmdtp, int flag, int argc,
+			   char *const argv[])
+{
+	uint hz = argc > 1 ? dectoul(argv[1], NULL) : 0;
+	int ret;
+
+	ret = sample_start(hz);
+	if (ret) {
+		printf("Cannot start sampling (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+
+static int do_sample_stop(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	sample_stop();
+
+	return 0;
+}
+
+static int do_sample_stats(struct cmd_tbl *cmdtp, int flag, int argc,
+			   char *const argv[])
+{
+	sample_print_stats();
+
+	return 0;
+}
+
+/* This uses the same environment variables as 'trace', to share a buffer */
+static int do_sample_dump(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	size_t buff_size, avail, buff_ptr, needed, used;
+	char *buff;
+	int err;
+
+	if (argc == 3) {
+		buff_size = hextoul(argv[2], NULL);
+		buff = map_sysmem(hextoul(argv[1], NULL), buff_size);
+		buff_ptr = 0;
+	} else if (argc == 1) {
+		buff_size = env_get_ulong("profsize", 16, 0);
+		buff = map_sysmem(env_get_ulong("profbase", 16, 0), buff_size);
+		buff_ptr = env_get_ulong("profoffset", 16, 0);
+	} else {
+		return CMD_RET_USAGE;
+	}
+
+	avail = buff_size - buff_ptr;
+	err = sample_list(buff + buff_ptr, avail, &needed);
+	if (err)
+		printf("Error: truncated (%#zx bytes needed)\n", needed);
+	used = min(avail, (size_t)needed);
+	printf("Samples dumped to %08lx, size %#zx\n",
+	       (ulong)map_to_sysmem(buff + buff_ptr), used);
+
+	env_set_hex("profbase", map_to_sysmem(buff));
+	env_set_hex("profsize", buff_size);
+	env_set_hex("profoffset", buff_ptr + used);
+
+	return 0;
+}
+
+#ifdef CONFIG_SYS_LONGHELP
+static char sample_help_text[] =
+	"start [<hz>]             - start taking samples\n"
+	"sample stop                     - stop taking samples\n"
+	"sample stats                    - display sampling statistics\n"
+	"sample dump [<addr> <size>]     - dump samples into buffer";
+#endif
+
+U_BOOT_CMD_WITH_SUBCMDS(sample, "sampling profiler", sample_help_text,
+	U_BOOT_SUBCMD_MKENT(start, 2, 1, do_sample_start),
+	U_BOOT_SUBCMD_MKENT(stop, 1, 1, do_sample_stop),
+	U_BOOT_SUBCMD_MKENT(stats, 1, 1, do_sample_stats),
+	U_BOOT_SUBCMD_MKENT(dump, 3, 1, do_sample_dump));
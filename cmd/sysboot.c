@@ -54,6 +54,7 @@ static int do_sysboot(struct cmd_tbl *cmdtp, int flag, int argc,
 	struct pxe_context ctx;
 	char *pxefile_addr_str;
 	struct sysboot_info info;
+	char source[40];
 	char *filename;
 	int prompt = 0;
 	int ret;
@@ -100,9 +101,12 @@ static int do_sysboot(struct cmd_tbl *cmdtp, int flag, int argc,
 		return 1;
 	}
 
+	snprintf(source, sizeof(source), "%s %s", info.ifname,
+		 info.dev_part_str);
 	if (pxe_setup_ctx(&ctx, cmdtp, sysboot_read_file, &info, true,
-			  filename)) {
+			  filename) || pxe_set_source(&ctx, source)) {
 		printf("Out of memory\n");
+		pxe_destroy_ctx(&ctx);
 		return CMD_RET_FAILURE;
 	}
 
@@ -26,6 +26,15 @@ DECLARE_GLOBAL_DATA_PTR;
 
 enum {
 	RECORD_COUNT = CONFIG_VAL(BOOTSTAGE_RECORD_COUNT),
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	SPAN_COUNT = CONFIG_VAL(BOOTSTAGE_SPAN_COUNT),
+	/* Spans which fit before the full malloc() is available */
+	SPAN_COUNT_F = CONFIG_BOOTSTAGE_SPAN_COUNT_F < SPAN_COUNT ?
+		CONFIG_BOOTSTAGE_SPAN_COUNT_F : SPAN_COUNT,
+#else
+	SPAN_COUNT = 0,
+	SPAN_COUNT_F = 0,
+#endif
 };
 
 struct bootstage_record {
@@ -40,22 +49,19 @@ struct bootstage_data {
 	uint rec_count;
 	uint next_id;
 	struct bootstage_record record[RECORD_COUNT];
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	uint span_count;
+	uint span_overflow;	/* Number of spans dropped as the table is full */
+	/* Table of SPAN_COUNT spans, NULL while @span_f is used */
+	struct bootstage_span *span;
+	struct bootstage_span span_f[SPAN_COUNT_F];
+#endif
 };
 
 enum {
-	BOOTSTAGE_VERSION	= 0,
-	BOOTSTAGE_MAGIC		= 0xb00757a3,
 	BOOTSTAGE_DIGITS	= 9,
 };
 
-struct bootstage_hdr {
-	u32 version;		/* BOOTSTAGE_VERSION */
-	u32 count;		/* Number of records */
-	u32 size;		/* Total data size (non-zero if valid) */
-	u32 magic;		/* Magic number */
-	u32 next_id;		/* Next ID to use for bootstage */
-};
-
 int bootstage_relocate(void)
 {
 	struct bootstage_data *data = gd->bootstage;
@@ -224,6 +230,96 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+static struct bootstage_span *get_spans(const struct bootstage_data *data)
+{
+	return data->span ? data->span : (struct bootstage_span *)data->span_f;
+}
+
+/*
+ * Get a free entry in the span table, or NULL if it is full
+ *
+ * Before relocation only the small table inside struct bootstage_data is
+ * available, since the pre-relocation malloc() area is often tiny. Once the
+ * full malloc() is ready, the spans are moved to a table of SPAN_COUNT.
+ */
+static struct bootstage_span *new_span(struct bootstage_data *data)
+{
+	struct bootstage_span *span;
+
+	if (!data->span && data->span_count == SPAN_COUNT_F &&
+	    SPAN_COUNT > SPAN_COUNT_F &&
+	    (gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		span = malloc(SPAN_COUNT * sizeof(*span));
+		if (span) {
+			memcpy(span, data->span_f, sizeof(data->span_f));
+			data->span = span;
+		}
+	}
+	if (data->span_count == (data->span ? SPAN_COUNT : SPAN_COUNT_F)) {
+		data->span_overflow++;
+		return NULL;
+	}
+
+	return &get_spans(data)[data->span_count++];
+}
+
+void bootstage_span_end(enum bootstage_span_type type, const char *name,
+			ulong start_us, ulong bytes)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_span *span;
+
+	if (!data)
+		return;
+	span = new_span(data);
+	if (!span)
+		return;
+	span->start_us = start_us;
+	span->duration_us = timer_get_boot_us() - start_us;
+	span->bytes = bytes;
+	span->type = type;
+	strlcpy(span->name, name ? name : "", sizeof(span->name));
+}
+
+static const char *const span_type_name[BOOTSTAGE_SPAN_TYPE_COUNT] = {
+	[BOOTSTAGE_SPAN_MARK]		= "mark",
+	[BOOTSTAGE_SPAN_PROBE]		= "probe",
+	[BOOTSTAGE_SPAN_BLK_READ]	= "blk_read",
+	[BOOTSTAGE_SPAN_NET]		= "net",
+	[BOOTSTAGE_SPAN_PROBE_FAIL]	= "probe_fail",
+};
+
+static void print_spans(struct bootstage_data *data)
+{
+	struct bootstage_span *span;
+	int i;
+
+	if (!data->span_count)
+		return;
+	printf("\nSpans (%d):\n", data->span_count);
+	printf("%11s%11s  %-10s%11s  %s\n", "Start", "Duration", "Type",
+	       "Bytes", "Name");
+	span = get_spans(data);
+	for (i = 0; i < data->span_count; i++, span++) {
+		print_grouped_ull(span->start_us, BOOTSTAGE_DIGITS);
+		print_grouped_ull(span->duration_us, BOOTSTAGE_DIGITS);
+		printf("  %-10s", span->type < BOOTSTAGE_SPAN_TYPE_COUNT ?
+		       span_type_name[span->type] : "?");
+		print_grouped_ull(span->bytes, BOOTSTAGE_DIGITS);
+		printf("  %s\n", span->name);
+	}
+	if (data->span_overflow)
+		printf("Overflowed span table by %d entries\n"
+		       "Please increase CONFIG_(SPL_)BOOTSTAGE_SPAN_COUNT\n",
+		       data->span_overflow);
+}
+#else
+static void print_spans(struct bootstage_data *data)
+{
+}
+#endif
+
 /**
  * Get a record name as a printable string
  *
@@ -363,6 +459,7 @@ void bootstage_report(void)
 		if (rec->start_us)
 			prev = print_time_record(rec, -1);
 	}
+	print_spans(data);
 }
 
 /**
@@ -387,6 +484,89 @@ static void append_data(char **ptrp, char *end, const void *data, int size)
 	memcpy(ptr, data, size);
 }
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+/*
+ * Append the spans to the stash, preceded by a span for each mark so that
+ * tools can read everything from one portable table. Unlike the records,
+ * spans which do not fit are dropped, so that the stash still succeeds.
+ */
+static void stash_spans(const struct bootstage_data *data, char **ptrp,
+			char *end)
+{
+	const struct bootstage_record *rec;
+	struct bootstage_span_tail tail;
+	struct bootstage_span span;
+	char buf[20];
+	uint max;
+	int i;
+
+	*ptrp = PTR_ALIGN(*ptrp, sizeof(u32));
+	if (*ptrp + sizeof(tail) > end)
+		return;
+	max = (end - *ptrp - sizeof(tail)) / sizeof(span);
+	tail.count = 0;
+	for (rec = data->record, i = 0; i < data->rec_count; i++, rec++) {
+		if (rec->start_us || tail.count == max)
+			continue;
+		memset(&span, '\0', sizeof(span));
+		span.start_us = rec->time_us;
+		span.type = BOOTSTAGE_SPAN_MARK;
+		strlcpy(span.name, get_record_name(buf, sizeof(buf), rec),
+			sizeof(span.name));
+		append_data(ptrp, end, &span, sizeof(span));
+		tail.count++;
+	}
+	for (i = 0; i < data->span_count && tail.count < max; i++) {
+		append_data(ptrp, end, &get_spans(data)[i], sizeof(span));
+		tail.count++;
+	}
+	if (i < data->span_count)
+		debug("%s: Dropped %d spans\n", __func__, data->span_count - i);
+	tail.magic = BOOTSTAGE_SPAN_MAGIC;
+	append_data(ptrp, end, &tail, sizeof(tail));
+}
+
+/* Pick up any spans from the end of stashed data, ignoring the marks */
+static void unstash_spans(struct bootstage_data *data,
+			  const struct bootstage_hdr *hdr, const char *ptr)
+{
+	const char *end = (const char *)hdr + hdr->size;
+	struct bootstage_span_tail tail;
+	struct bootstage_span span, *to;
+	const char *spans;
+	int i;
+
+	if (ptr + sizeof(tail) > end)
+		return;
+	memcpy(&tail, end - sizeof(tail), sizeof(tail));
+	if (tail.magic != BOOTSTAGE_SPAN_MAGIC ||
+	    tail.count > (end - sizeof(tail) - ptr) / sizeof(span))
+		return;
+
+	spans = end - sizeof(tail) - tail.count * sizeof(span);
+	for (i = 0; i < tail.count; i++) {
+		memcpy(&span, spans + i * sizeof(span), sizeof(span));
+		if (span.type == BOOTSTAGE_SPAN_MARK)
+			continue;
+		to = new_span(data);
+		if (!to)
+			continue;
+		span.name[sizeof(span.name) - 1] = '\0';
+		*to = span;
+	}
+}
+#else
+static void stash_spans(const struct bootstage_data *data, char **ptrp,
+			char *end)
+{
+}
+
+static void unstash_spans(struct bootstage_data *data,
+			  const struct bootstage_hdr *hdr, const char *ptr)
+{
+}
+#endif
+
 int bootstage_stash(void *base, int size)
 {
 	const struct bootstage_data *data = gd->bootstage;
@@ -422,6 +602,8 @@ int bootstage_stash(void *base, int size)
 		append_data(&ptr, end, name, strlen(name) + 1);
 	}
 
+	stash_spans(data, &ptr, end);
+
 	/* Check for buffer overflow */
 	if (ptr > end) {
 		debug("%s: Not enough space for bootstage stash\n", __func__);
@@ -499,6 +681,7 @@ int bootstage_unstash(const void *base, int size)
 		/* Assume no data corruption here */
 		ptr += strlen(ptr) + 1;
 	}
+	unstash_spans(data, hdr, ptr);
 
 	/* Mark the records as read */
 	data->rec_count += hdr->count;
@@ -540,3 +723,14 @@ int bootstage_init(bool first)
 
 	return 0;
 }
+
+void bootstage_uninit(void)
+{
+	struct bootstage_data *data = gd->bootstage;
+
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	free(data->span);
+#endif
+	free(data);
+	gd->bootstage = NULL;
+}
@@ -618,6 +618,9 @@ void *sbrk(ptrdiff_t increment)
 
 void mem_malloc_init(ulong start, ulong size)
 {
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	size -= slab_init(start, size);
+#endif
 	mem_malloc_start = start;
 	mem_malloc_end = start + size;
 	mem_malloc_brk = start;
@@ -730,6 +733,74 @@ static unsigned int max_n_mmaps = 0;
 static unsigned long max_mmapped_mem = 0;
 #endif
 
+/* Peak heap usage, recorded between malloc_peak_start() and _stop() */
+static bool malloc_peak_on;
+static ulong malloc_peak_base;
+static ulong malloc_peak_used;
+static ulong malloc_peak;
+
+/* Work out the number of bytes allocated and not yet freed */
+static ulong malloc_in_use(void)
+{
+	INTERNAL_SIZE_T avail = chunksize(top);
+	mbinptr b;
+	mchunkptr p;
+	int i;
+
+	for (i = 1; i < NAV; ++i) {
+		b = bin_at(i);
+		for (p = last(b); p != b; p = p->bk)
+			avail += chunksize(p);
+	}
+
+	avail = sbrked_mem - avail;
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	avail += slab_in_use();
+#endif
+
+	return avail;
+}
+
+/*
+ * Account for @delta bytes being allocated, or freed if negative. This is
+ * called with the size of each chunk as it is handed out or given back, so
+ * that the heap does not need to be walked each time.
+ */
+static void malloc_peak_update(long delta)
+{
+	if (!malloc_peak_on)
+		return;
+	malloc_peak_used += delta;
+	if (malloc_peak_used > malloc_peak)
+		malloc_peak = malloc_peak_used;
+}
+
+void malloc_peak_start(void)
+{
+	malloc_peak_base = malloc_in_use();
+	malloc_peak_used = malloc_peak_base;
+	malloc_peak = malloc_peak_base;
+	malloc_peak_on = true;
+}
+
+ulong malloc_peak_stop(void)
+{
+	malloc_peak_on = false;
+
+	return malloc_peak - malloc_peak_base;
+}
+
+void malloc_get_info(struct malloc_info *info)
+{
+	info->start = mem_malloc_start;
+	info->size = mem_malloc_end - mem_malloc_start;
+	info->sbrked = sbrked_mem;
+	info->in_use = malloc_in_use();
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	info->in_use -= slab_in_use();
+#endif
+}
+
 #ifdef CONFIG_SYS_MALLOC_DEFAULT_TO_INIT
 static void malloc_init(void)
 {
@@ -1282,9 +1353,9 @@ static void malloc_extend_top(nb) INTERNAL_SIZE_T nb;
 */
 
 #if __STD_C
-Void_t* mALLOc(size_t bytes)
+static Void_t* malloc_heap_chunk(size_t bytes)
 #else
-Void_t* mALLOc(bytes) size_t bytes;
+static Void_t* malloc_heap_chunk(bytes) size_t bytes;
 #endif
 {
   mchunkptr victim;                  /* inspected/selected chunk */
@@ -1536,6 +1607,42 @@ Void_t* mALLOc(bytes) size_t bytes;
 
 }
 
+/* Allocate a chunk from the heap, recording it for malloc_peak_stop() */
+static Void_t* malloc_from_heap(size_t bytes)
+{
+  Void_t *mem = malloc_heap_chunk(bytes);
+
+  if (mem && malloc_peak_on)
+    malloc_peak_update(chunksize(mem2chunk(mem)));
+
+  return mem;
+}
+
+/*
+ * Small requests are served by the slab allocator where enabled, falling
+ * back to dlmalloc when the slab area is full. Code in this file which needs
+ * a real chunk calls malloc_from_heap() instead.
+ */
+#if __STD_C
+Void_t* mALLOc(size_t bytes)
+#else
+Void_t* mALLOc(bytes) size_t bytes;
+#endif
+{
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	if (bytes <= SLAB_MAX_SIZE && (gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		Void_t *mem;
+
+		mem = slab_alloc(bytes);
+		if (mem) {
+			malloc_peak_update(slab_usable_size(mem));
+			return mem;
+		}
+	}
+#endif
+	return malloc_from_heap(bytes);
+}
+
 
 
 
@@ -1589,8 +1696,17 @@ void fREe(mem) Void_t* mem;
   if (mem == NULL)                              /* free(0) has no effect */
     return;
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  if (slab_owns(mem)) {
+    malloc_peak_update(-(long)slab_usable_size(mem));
+    slab_free(mem);
+    return;
+  }
+#endif
+
   p = mem2chunk(mem);
   hd = p->size;
+  malloc_peak_update(-(long)chunksize(p));
 
 #if HAVE_MMAP
   if (hd & IS_MMAPPED)                       /* release mmapped memory. */
@@ -1748,6 +1864,21 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 	}
 #endif
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  if (slab_owns(oldmem)) {
+    oldsize = slab_usable_size(oldmem);
+    if (bytes <= oldsize)
+      return oldmem;
+    newmem = mALLOc(bytes);
+    if (newmem) {
+      memcpy(newmem, oldmem, oldsize);
+      malloc_peak_update(-(long)oldsize);
+      slab_free(oldmem);
+    }
+    return newmem;
+  }
+#endif
+
   newp    = oldp    = mem2chunk(oldmem);
   newsize = oldsize = chunksize(oldp);
 
@@ -1794,6 +1925,7 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 	  top = chunk_at_offset(oldp, nb);
 	  set_head(top, (newsize - nb) | PREV_INUSE);
 	  set_head_size(oldp, nb);
+	  malloc_peak_update(nb - oldsize);
 	  VALGRIND_RESIZEINPLACE_BLOCK(chunk2mem(oldp), 0, bytes, SIZE_SZ);
 	  VALGRIND_MAKE_MEM_DEFINED(chunk2mem(oldp), bytes);
 	  return chunk2mem(oldp);
@@ -1841,6 +1973,7 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 	    top = chunk_at_offset(newp, nb);
 	    set_head(top, (newsize - nb) | PREV_INUSE);
 	    set_head_size(newp, nb);
+	    malloc_peak_update(nb - oldsize);
 	    VALGRIND_FREELIKE_BLOCK(oldmem, SIZE_SZ);
 	    return newmem;
 	  }
@@ -1875,7 +2008,7 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 
     /* Must allocate */
 
-    newmem = mALLOc (bytes);
+    newmem = malloc_from_heap(bytes);
 
     if (newmem == NULL)  /* propagate failure */
       return NULL;
@@ -1885,6 +2018,8 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 
     if ( (newp = mem2chunk(newmem)) == next_chunk(oldp))
     {
+      /* this is counted below, as part of the expanded chunk */
+      malloc_peak_update(-(long)chunksize(newp));
       newsize += chunksize(newp);
       newp = oldp;
       goto split;
@@ -1902,6 +2037,8 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 
  split:  /* split off extra room in old or expanded chunk */
 
+  malloc_peak_update(newsize - oldsize);
+
   if (newsize - nb >= MINSIZE) /* split off remainder */
   {
     remainder = chunk_at_offset(newp, nb);
@@ -1980,7 +2117,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
   /* Call malloc with worst case padding to hit alignment. */
 
   nb = request2size(bytes);
-  m  = (char*)(mALLOc(nb + alignment + MINSIZE));
+  m  = (char*)(malloc_from_heap(nb + alignment + MINSIZE));
 
   /*
   * The attempt to over-allocate (with a size large enough to guarantee the
@@ -1996,7 +2133,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
      * Use bytes not nb, since mALLOc internally calls request2size too, and
      * each call increases the size to allocate, to account for the header.
      */
-    m  = (char*)(mALLOc(bytes));
+    m  = (char*)(malloc_from_heap(bytes));
     /* Aligned -> return it */
     if ((((unsigned long)(m)) % alignment) == 0)
       return m;
@@ -2007,7 +2144,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
     fREe(m);
     /* Add in extra bytes to match misalignment of unexpanded allocation */
     extra = alignment - (((unsigned long)(m)) % alignment);
-    m  = (char*)(mALLOc(bytes + extra));
+    m  = (char*)(malloc_from_heap(bytes + extra));
     /*
      * m might not be the same as before. Validate that the previous value of
      * extra still works for the current value of m.
@@ -2164,6 +2301,12 @@ Void_t* cALLOc(n, elem_size) size_t n; size_t elem_size;
 		memset(mem, 0, sz);
 		return mem;
 	}
+#endif
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+    if (slab_owns(mem)) {
+      memset(mem, '\0', sz);
+      return mem;
+    }
 #endif
     p = mem2chunk(mem);
 
@@ -2313,6 +2456,10 @@ size_t malloc_usable_size(mem) Void_t* mem;
   mchunkptr p;
   if (mem == NULL)
     return 0;
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  else if (slab_owns(mem))
+    return slab_usable_size(mem);
+#endif
   else
   {
     p = mem2chunk(mem);
@@ -2363,6 +2510,9 @@ static void malloc_update_mallinfo()
 
   current_mallinfo.ordblks = navail;
   current_mallinfo.uordblks = sbrked_mem - avail;
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  current_mallinfo.uordblks += slab_in_use();
+#endif
   current_mallinfo.fordblks = avail;
   current_mallinfo.hblks = n_mmaps;
   current_mallinfo.hblkhd = mmapped_mem;
@@ -267,6 +267,30 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
 	return 0;
 }
 
+int fdt_initrd_frame_index(void *fdt, const char *comp, const fdt32_t *index,
+			   int count)
+{
+	int nodeoffset;
+	int err;
+
+	nodeoffset = fdt_find_or_add_subnode(fdt, 0, "chosen");
+	if (nodeoffset < 0)
+		return nodeoffset;
+
+	err = fdt_setprop_string(fdt, nodeoffset, "u-boot,initrd-compression",
+				 comp);
+	if (!err)
+		err = fdt_setprop(fdt, nodeoffset, "u-boot,initrd-frame-index",
+				  index, count * 2 * sizeof(fdt32_t));
+	if (err < 0) {
+		printf("WARNING: could not set initrd frame index %s.\n",
+		       fdt_strerror(err));
+		return err;
+	}
+
+	return 0;
+}
+
 /**
  * board_fdt_chosen_bootargs - boards may override this function to use
  *                             alternative kernel command line arguments
@@ -11,12 +11,18 @@
 
 #ifndef USE_HOSTCC
 #include <common.h>
+#include <blk.h>
 #include <command.h>
+#include <console.h>
 #include <env.h>
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <memalign.h>
 #include <hw_sha.h>
+#include <parallel.h>
+#include <part.h>
+#include <watchdog.h>
 #include <asm/cache.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
@@ -435,6 +441,15 @@ int hash_block(const char *algo_name, const void *data, unsigned int len,
 
 #if !defined(CONFIG_SPL_BUILD) && (defined(CONFIG_CMD_HASH) || \
 	defined(CONFIG_CMD_SHA1SUM) || defined(CONFIG_CMD_CRC32))
+
+enum {
+	/* Bytes hashed between checks for Ctrl-C, also the block-read size */
+	HASH_CMD_CHUNK	= 4 << 20,
+
+	/* Smallest leaf for a tree hash, to limit the number of contexts */
+	HASH_LEAF_MIN	= 0x200,
+};
+
 /**
  * store_result: Store the resulting sum to an address or variable
  *
@@ -547,17 +562,235 @@ static int parse_verify_sum(struct hash_algo *algo, char *verify_str,
 	return 0;
 }
 
-static void hash_show(struct hash_algo *algo, ulong addr, ulong len, uint8_t *output)
+static void hash_show(struct hash_algo *algo, const struct hash_opts *opts,
+		      ulong addr, ulong len, uint8_t *output)
 {
 	int i;
 
-	printf("%s for %08lx ... %08lx ==> ", algo->name, addr, addr + len - 1);
+	printf("%s%s for ", algo->name,
+	       opts && opts->leaf_size ? " tree" : "");
+	if (opts && opts->ifname)
+		printf("%s %s blocks ", opts->ifname, opts->dev_part);
+	printf("%08lx ... %08lx ==> ", addr, addr + len - 1);
 	for (i = 0; i < algo->digest_size; i++)
 		printf("%02x", output[i]);
 }
 
-int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
-		 int flag, int argc, char *const argv[])
+/**
+ * struct hash_leaves - Leaves of a tree hash being processed in parallel
+ *
+ * @algo: Hash algorithm being used
+ * @data: Data for the first leaf
+ * @size: Size of the data for all leaves, in bytes
+ * @leaf_size: Size of each leaf, in bytes (the last may be shorter)
+ * @ctx: Hashing context for each leaf
+ */
+struct hash_leaves {
+	struct hash_algo *algo;
+	const u8 *data;
+	ulong size;
+	ulong leaf_size;
+	void **ctx;
+};
+
+/* Hash one leaf; this may run on any CPU */
+static int hash_leaf(void *ctx, int idx)
+{
+	struct hash_leaves *hl = ctx;
+	ulong offset = (ulong)idx * hl->leaf_size;
+
+	return hl->algo->hash_update(hl->algo, hl->ctx[idx], hl->data + offset,
+				     min(hl->leaf_size, hl->size - offset), 1);
+}
+
+/**
+ * hash_leaves() - Hash a chunk of data made up of whole leaves
+ *
+ * The contexts are set up and finished here, since that uses malloc(), but
+ * the hashing itself is shared between CPUs if possible.
+ *
+ * @algo: Hash algorithm to use
+ * @data: Data to hash
+ * @size: Size of data in bytes
+ * @leaf_size: Size of each leaf in bytes
+ * @digests: Returns the digest of each leaf
+ * Return: 0 if OK, -ENOMEM if out of memory, other -ve on error
+ */
+static int hash_leaves(struct hash_algo *algo, const void *data, ulong size,
+		       ulong leaf_size, u8 *digests)
+{
+	struct hash_leaves hl;
+	int count = DIV_ROUND_UP(size, leaf_size);
+	int ret, err, i;
+
+	hl.algo = algo;
+	hl.data = data;
+	hl.size = size;
+	hl.leaf_size = leaf_size;
+	hl.ctx = calloc(count, sizeof(void *));
+	if (!hl.ctx)
+		return -ENOMEM;
+	for (i = 0, ret = 0; i < count && !ret; i++)
+		ret = algo->hash_init(algo, &hl.ctx[i]) ? -ENOMEM : 0;
+
+	/* a hashing engine cannot be shared between CPUs */
+	if (!ret && !IS_ENABLED(CONFIG_SHA_PROG_HW_ACCEL)) {
+		ret = parallel_run(hash_leaf, &hl, count);
+	} else if (!ret) {
+		for (i = 0; i < count && !ret; i++)
+			ret = hash_leaf(&hl, i);
+	}
+
+	/* this frees each context */
+	for (i = 0; i < count && hl.ctx[i]; i++) {
+		err = algo->hash_finish(algo, hl.ctx[i],
+					digests + i * algo->digest_size,
+					algo->digest_size);
+		if (!ret)
+			ret = err;
+	}
+	free(hl.ctx);
+
+	return ret;
+}
+
+/**
+ * hash_range() - Hash a range of memory or a block device, in chunks
+ *
+ * @algo: Hash algorithm to use
+ * @desc: Block device to read from, or NULL to hash memory
+ * @start: Start address, or first block to read if @desc is not NULL
+ * @len: Number of bytes to hash
+ * @leaf_size: Size of each leaf for a tree hash, or 0 for a plain hash
+ * @output: Returns the digest
+ * Return: 0 if OK, -EINTR if interrupted, -EIO on read error, -ENOMEM if out
+ *	of memory, other -ve on error
+ */
+static int hash_range(struct hash_algo *algo, struct blk_desc *desc,
+		      ulong start, ulong len, ulong leaf_size, u8 *output)
+{
+	ulong chunk = HASH_CMD_CHUNK, offset, size;
+	int ds = algo->digest_size;
+	bool progress = len > HASH_CMD_CHUNK;
+	u8 *digests = NULL;
+	void *ctx = NULL;
+	void *buf = NULL;
+	const void *data;
+	int ret = 0;
+
+	if (leaf_size) {
+		chunk = max(rounddown(chunk, leaf_size), leaf_size);
+		digests = malloc(DIV_ROUND_UP(len, leaf_size) * ds);
+		if (!digests)
+			return -ENOMEM;
+	} else if (algo->hash_init(algo, &ctx)) {
+		return -ENOMEM;
+	}
+	if (desc) {
+		buf = memalign(ARCH_DMA_MINALIGN, min(chunk, len));
+		if (!buf)
+			ret = -ENOMEM;
+	}
+
+	for (offset = 0; !ret && offset < len; offset += size) {
+		size = min(chunk, len - offset);
+		if (desc) {
+			lbaint_t blks = size / desc->blksz;
+
+			if (blk_dread(desc, start + offset / desc->blksz, blks,
+				      buf) != blks) {
+				ret = -EIO;
+				break;
+			}
+			data = buf;
+		} else {
+			data = map_sysmem(start + offset, size);
+		}
+
+		if (leaf_size) {
+			ret = hash_leaves(algo, data, size, leaf_size,
+					  digests + offset / leaf_size * ds);
+		} else {
+			ret = algo->hash_update(algo, ctx, data, size,
+						offset + size == len);
+			if (ret)
+				ctx = NULL;	/* freed by hash_update() */
+		}
+		if (!desc)
+			unmap_sysmem(data);
+
+		WATCHDOG_RESET();
+		if (progress)
+			printf("\r%3lu%%", (offset + size) / DIV_ROUND_UP(len, 100));
+		if (ctrlc())
+			ret = -EINTR;
+	}
+	if (progress)
+		printf("\r    \r");
+
+	if (ctx) {
+		int err = algo->hash_finish(algo, ctx, output, ds);
+
+		if (!ret)
+			ret = err;
+	} else if (leaf_size && !ret) {
+		algo->hash_func_ws(digests, DIV_ROUND_UP(len, leaf_size) * ds,
+				   output, algo->chunk_size);
+	}
+	free(buf);
+	free(digests);
+
+	return ret;
+}
+
+/**
+ * hash_opts_run() - Hash a range using the given options
+ *
+ * @algo: Hash algorithm to use
+ * @opts: Options to use
+ * @start: Start address, or first block if reading from a block device
+ * @count: Number of bytes, or blocks if reading from a block device
+ * @output: Returns the digest
+ * Return: 0 if OK, -ve on error
+ */
+static int hash_opts_run(struct hash_algo *algo, const struct hash_opts *opts,
+			 ulong start, ulong count, u8 *output)
+{
+	struct blk_desc *desc = NULL;
+	struct disk_partition info;
+	ulong len = count;
+	int ret;
+
+	if (!algo->hash_init) {
+		printf("%s does not support progressive hashing\n", algo->name);
+		return -EPROTONOSUPPORT;
+	}
+	if (opts->leaf_size && opts->leaf_size < HASH_LEAF_MIN)
+		return -EINVAL;
+	if (opts->ifname) {
+		if (!IS_ENABLED(CONFIG_PARTITIONS))
+			return -ENOSYS;
+		ret = blk_get_device_part_str(opts->ifname, opts->dev_part,
+					      &desc, &info, 1);
+		if (ret < 0)
+			return -ENODEV;
+		if (start + count < start || start + count > info.size) {
+			printf("Range exceeds device size %lx\n",
+			       (ulong)info.size);
+			return -ERANGE;
+		}
+		if (opts->leaf_size % info.blksz || count > ULONG_MAX / info.blksz)
+			return -EINVAL;
+		start += info.start;
+		len = count * info.blksz;
+	}
+
+	return hash_range(algo, desc, start, len, opts->leaf_size, output);
+}
+
+int hash_command_opts(const char *algo_name, int flags,
+		      const struct hash_opts *opts, int argc,
+		      char *const argv[])
 {
 	ulong addr, len;
 
@@ -569,7 +802,8 @@ int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 
 	if (multi_hash()) {
 		struct hash_algo *algo;
-		u8 *output;
+		ALLOC_CACHE_ALIGN_BUFFER(u8, output,
+					 sizeof(uint32_t) * HASH_MAX_DIGEST_SIZE);
 		uint8_t vsum[HASH_MAX_DIGEST_SIZE];
 		void *buf;
 
@@ -584,12 +818,21 @@ int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 			return 1;
 		}
 
-		output = memalign(ARCH_DMA_MINALIGN,
-				  sizeof(uint32_t) * HASH_MAX_DIGEST_SIZE);
+		if (opts && (opts->leaf_size || opts->ifname)) {
+			int ret;
 
-		buf = map_sysmem(addr, len);
-		algo->hash_func_ws(buf, len, output, algo->chunk_size);
-		unmap_sysmem(buf);
+			ret = hash_opts_run(algo, opts, addr, len, output);
+			if (ret == -EINVAL)
+				return CMD_RET_USAGE;
+			if (ret) {
+				printf("Cannot hash (err=%d)\n", ret);
+				return CMD_RET_FAILURE;
+			}
+		} else {
+			buf = map_sysmem(addr, len);
+			algo->hash_func_ws(buf, len, output, algo->chunk_size);
+			unmap_sysmem(buf);
+		}
 
 		/* Try to avoid code bloat when verify is not needed */
 #if defined(CONFIG_CRC32_VERIFY) || defined(CONFIG_SHA1SUM_VERIFY) || \
@@ -607,7 +850,7 @@ int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 			if (memcmp(output, vsum, algo->digest_size) != 0) {
 				int i;
 
-				hash_show(algo, addr, len, output);
+				hash_show(algo, opts, addr, len, output);
 				printf(" != ");
 				for (i = 0; i < algo->digest_size; i++)
 					printf("%02x", vsum[i]);
@@ -615,15 +858,13 @@ int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 				return 1;
 			}
 		} else {
-			hash_show(algo, addr, len, output);
+			hash_show(algo, opts, addr, len, output);
 			printf("\n");
 
 			if (argc) {
 				store_result(algo, output, *argv,
 					flags & HASH_FLAG_ENV);
 			}
-		unmap_sysmem(output);
-
 		}
 
 	/* Horrible code size hack for boards that just want crc32 */
@@ -644,5 +885,11 @@ int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 
 	return 0;
 }
+
+int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
+		 int flag, int argc, char *const argv[])
+{
+	return hash_command_opts(algo_name, flags, NULL, argc, argv);
+}
 #endif /* CONFIG_CMD_HASH || CONFIG_CMD_SHA1SUM || CONFIG_CMD_CRC32) */
 #endif /* !USE_HOSTCC */
@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Slab allocator for small malloc() requests
+ *
+ * Driver model and the live tree make a large number of small allocations,
+ * which fragment the dlmalloc heap and make its bin searches slower. This
+ * serves requests of up to SLAB_MAX_SIZE bytes from pages set aside for
+ * each of a few size classes, with a free list per class, so that allocation
+ * and free take constant time. Larger requests, and small ones which do not
+ * fit once the slab area is full, go to dlmalloc as before.
+ *
+ * The slab area is taken from the top of the malloc() region, so that
+ * free() can tell which allocator owns a pointer by its address. Once a page
+ * is given to a size class it stays there.
+ */
+
+#define LOG_CATEGORY LOGC_ALLOC
+
+#include <common.h>
+#include <log.h>
+#include <malloc.h>
+#include <valgrind/valgrind.h>
+
+enum {
+	SLAB_PAGE_SHIFT		= 12,
+	SLAB_PAGE_SIZE		= 1 << SLAB_PAGE_SHIFT,
+	SLAB_MAX_PAGES		= CONFIG_SYS_MALLOC_SLAB_LEN >> SLAB_PAGE_SHIFT,
+	SLAB_GRANULE		= 16,
+};
+
+/* Object size for each class; each is a multiple of SLAB_GRANULE */
+static const ushort slab_sizes[SLAB_CLASS_COUNT] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512
+};
+
+/**
+ * struct slab_class - Information about a size class
+ *
+ * @free: First free object, each of which points to the next
+ * @stats: Statistics for this class
+ */
+struct slab_class {
+	void *free;
+	struct slab_stats stats;
+};
+
+/**
+ * struct slab_info - Information about the slab area
+ *
+ * @start: Start address of the slab area, aligned to SLAB_PAGE_SIZE
+ * @end: End address of the slab area
+ * @next_page: Next page which has not yet been given to a class
+ * @class: Size classes
+ * @size_to_class: Class to use for each size, in units of SLAB_GRANULE
+ * @page_class: Class which owns each page in use
+ */
+struct slab_info {
+	ulong start;
+	ulong end;
+	uint next_page;
+	struct slab_class class[SLAB_CLASS_COUNT];
+	u8 size_to_class[SLAB_MAX_SIZE / SLAB_GRANULE + 1];
+	u8 page_class[SLAB_MAX_PAGES];
+};
+
+static struct slab_info slab;
+
+ulong slab_init(ulong start, ulong size)
+{
+	ulong end = start + size, len;
+	int cls, i;
+
+	memset(&slab, '\0', sizeof(slab));
+
+	/* don't take more than a quarter of a small malloc() region */
+	len = min((ulong)CONFIG_SYS_MALLOC_SLAB_LEN, size / 4);
+	slab.start = ALIGN(end - len, SLAB_PAGE_SIZE);
+	slab.end = ALIGN_DOWN(end, SLAB_PAGE_SIZE);
+	if (slab.start >= slab.end) {
+		slab.start = 0;
+		slab.end = 0;
+		return 0;
+	}
+
+	for (i = 0, cls = 0; i <= SLAB_MAX_SIZE / SLAB_GRANULE; i++) {
+		if (i * SLAB_GRANULE > slab_sizes[cls])
+			cls++;
+		slab.size_to_class[i] = cls;
+	}
+	for (cls = 0; cls < SLAB_CLASS_COUNT; cls++)
+		slab.class[cls].stats.size = slab_sizes[cls];
+	log_debug("slab area %lx-%lx\n", slab.start, slab.end);
+
+	return end - slab.start;
+}
+
+/* Give the next free page to a class, adding its objects to the free list */
+static bool slab_grow(int cls)
+{
+	struct slab_class *sc = &slab.class[cls];
+	uint size = slab_sizes[cls];
+	ulong page;
+	void **obj;
+	uint i, count;
+
+	page = slab.start + ((ulong)slab.next_page << SLAB_PAGE_SHIFT);
+	if (page >= slab.end)
+		return false;
+	slab.page_class[slab.next_page++] = cls;
+
+	count = SLAB_PAGE_SIZE / size;
+	for (i = 0; i < count; i++) {
+		obj = (void **)(page + i * size);
+		*obj = i + 1 < count ? (void *)obj + size : sc->free;
+	}
+	sc->free = (void *)page;
+	sc->stats.pages++;
+
+	return true;
+}
+
+void *slab_alloc(size_t bytes)
+{
+	struct slab_class *sc;
+	void **obj;
+	int cls;
+
+	if (!slab.start || bytes > SLAB_MAX_SIZE)
+		return NULL;
+	cls = slab.size_to_class[(bytes + SLAB_GRANULE - 1) / SLAB_GRANULE];
+	sc = &slab.class[cls];
+	if (!sc->free && !slab_grow(cls)) {
+		sc->stats.fallbacks++;
+		return NULL;
+	}
+	obj = sc->free;
+	sc->free = *obj;
+	sc->stats.allocs++;
+	if (++sc->stats.in_use > sc->stats.peak)
+		sc->stats.peak = sc->stats.in_use;
+	VALGRIND_MALLOCLIKE_BLOCK(obj, bytes, 0, false);
+
+	return obj;
+}
+
+bool slab_owns(const void *ptr)
+{
+	return (ulong)ptr >= slab.start && (ulong)ptr < slab.end;
+}
+
+static int slab_class_of(const void *ptr)
+{
+	return slab.page_class[((ulong)ptr - slab.start) >> SLAB_PAGE_SHIFT];
+}
+
+void slab_free(void *ptr)
+{
+	struct slab_class *sc = &slab.class[slab_class_of(ptr)];
+
+	*(void **)ptr = sc->free;
+	sc->free = ptr;
+	sc->stats.in_use--;
+	VALGRIND_FREELIKE_BLOCK(ptr, 0);
+}
+
+size_t slab_usable_size(const void *ptr)
+{
+	return slab_sizes[slab_class_of(ptr)];
+}
+
+ulong slab_in_use(void)
+{
+	ulong total = 0;
+	int cls;
+
+	for (cls = 0; cls < SLAB_CLASS_COUNT; cls++)
+		total += slab.class[cls].stats.in_use * slab_sizes[cls];
+
+	return total;
+}
+
+int slab_get_stats(int cls, struct slab_stats *stats)
+{
+	if (cls < 0 || cls >= SLAB_CLASS_COUNT)
+		return -ENOENT;
+	*stats = slab.class[cls].stats;
+
+	return 0;
+}
+
+void slab_get_area(ulong *startp, ulong *sizep)
+{
+	*startp = slab.start;
+	*sizep = slab.end - slab.start;
+}
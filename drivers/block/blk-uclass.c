@@ -8,6 +8,7 @@
 
 #include <common.h>
 #include <blk.h>
+#include <bootstage.h>
 #include <dm.h>
 #include <log.h>
 #include <malloc.h>
@@ -441,7 +442,7 @@ unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
-	ulong blks_read;
+	ulong blks_read, start_us;
 
 	if (!ops->read)
 		return -ENOSYS;
@@ -449,7 +450,10 @@ unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
 			  start, blkcnt, block_dev->blksz, buffer))
 		return blkcnt;
+	start_us = bootstage_span_start();
 	blks_read = ops->read(dev, start, blkcnt, buffer);
+	bootstage_span_end(BOOTSTAGE_SPAN_BLK_READ, dev->name, start_us,
+			   blks_read <= blkcnt ? blks_read * block_dev->blksz : 0);
 	if (blks_read == blkcnt)
 		blkcache_fill(block_dev->if_type, block_dev->devnum,
 			      start, blkcnt, block_dev->blksz, buffer);
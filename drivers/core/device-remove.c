@@ -99,15 +99,15 @@ int device_unbind(struct udevice *dev)
 	if (ret)
 		return log_msg_ret("uc", ret);
 	if (dev_get_flags(dev) & DM_FLAG_ALLOC_PDATA) {
-		free(dev_get_plat(dev));
+		device_free_data(dev_get_plat(dev));
 		dev_set_plat(dev, NULL);
 	}
 	if (dev_get_flags(dev) & DM_FLAG_ALLOC_UCLASS_PDATA) {
-		free(dev_get_uclass_plat(dev));
+		device_free_data(dev_get_uclass_plat(dev));
 		dev_set_uclass_plat(dev, NULL);
 	}
 	if (dev_get_flags(dev) & DM_FLAG_ALLOC_PARENT_PDATA) {
-		free(dev_get_parent_plat(dev));
+		device_free_data(dev_get_parent_plat(dev));
 		dev_set_parent_plat(dev, NULL);
 	}
 	ret = uclass_unbind_device(dev);
@@ -135,12 +135,12 @@ void device_free(struct udevice *dev)
 	int size;
 
 	if (dev->driver->priv_auto) {
-		free(dev_get_priv(dev));
+		device_free_data(dev_get_priv(dev));
 		dev_set_priv(dev, NULL);
 	}
 	size = dev->uclass->uc_drv->per_device_auto;
 	if (size) {
-		free(dev_get_uclass_priv(dev));
+		device_free_data(dev_get_uclass_priv(dev));
 		dev_set_uclass_priv(dev, NULL);
 	}
 	if (dev->parent) {
@@ -148,7 +148,7 @@ void device_free(struct udevice *dev)
 		if (!size)
 			size = dev->parent->uclass->uc_drv->per_child_auto;
 		if (size) {
-			free(dev_get_parent_priv(dev));
+			device_free_data(dev_get_parent_priv(dev));
 			dev_set_parent_priv(dev, NULL);
 		}
 	}
@@ -9,6 +9,8 @@
  */
 
 #include <common.h>
+#include <arena.h>
+#include <bootstage.h>
 #include <cpu_func.h>
 #include <event.h>
 #include <log.h>
@@ -36,6 +38,92 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#if CONFIG_IS_ENABLED(DM_ARENA)
+/* Holds the data of devices which are not removed before booting an OS */
+static struct arena dm_arena;
+
+/*
+ * Set while the devices present at start-up are bound. Devices bound or
+ * probed later may be unbound and bound again, so use malloc() for those
+ */
+static bool dm_arena_open;
+
+/* The arena is in BSS, so can only be used after relocation */
+static struct arena *dm_get_arena(void)
+{
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT) || !dm_arena.blocks)
+		return NULL;
+
+	return &dm_arena;
+}
+#endif
+
+void dm_arena_enable(bool enable)
+{
+#if CONFIG_IS_ENABLED(DM_ARENA)
+	dm_arena_open = enable;
+#endif
+}
+
+ulong dm_arena_used(void)
+{
+#if CONFIG_IS_ENABLED(DM_ARENA)
+	struct arena *arena = dm_get_arena();
+
+	if (arena)
+		return arena->used;
+#endif
+
+	return 0;
+}
+
+int dm_arena_init(void)
+{
+#if CONFIG_IS_ENABLED(DM_ARENA)
+	if ((gd->flags & GD_FLG_FULL_MALLOC_INIT) && !dm_arena.blocks)
+		return arena_init(&dm_arena, CONFIG_DM_ARENA_SIZE,
+				  CONFIG_DM_ARENA_SIZE);
+#endif
+
+	return 0;
+}
+
+void dm_arena_uninit(void)
+{
+#if CONFIG_IS_ENABLED(DM_ARENA)
+	if (dm_get_arena())
+		arena_uninit(&dm_arena);
+#endif
+}
+
+void *device_alloc_data(struct udevice *dev, int size)
+{
+#if CONFIG_IS_ENABLED(DM_ARENA)
+	struct arena *arena = dm_get_arena();
+
+	if (arena && dm_arena_open &&
+	    !(dev->driver->flags & (DM_FLAG_ACTIVE_DMA | DM_FLAG_OS_PREPARE))) {
+		void *ptr = arena_alloc(arena, size);
+
+		if (ptr)
+			return ptr;
+	}
+#endif
+
+	return calloc(1, size);
+}
+
+void device_free_data(void *ptr)
+{
+#if CONFIG_IS_ENABLED(DM_ARENA)
+	struct arena *arena = dm_get_arena();
+
+	if (arena && arena_owns(arena, ptr))
+		return;
+#endif
+	free(ptr);
+}
+
 static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			      const char *name, void *plat,
 			      ulong driver_data, ofnode node,
@@ -115,7 +203,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		}
 		if (alloc) {
 			dev_or_flags(dev, DM_FLAG_ALLOC_PDATA);
-			ptr = calloc(1, drv->plat_auto);
+			ptr = device_alloc_data(dev, drv->plat_auto);
 			if (!ptr) {
 				ret = -ENOMEM;
 				goto fail_alloc1;
@@ -134,7 +222,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	size = uc->uc_drv->per_device_plat_auto;
 	if (size) {
 		dev_or_flags(dev, DM_FLAG_ALLOC_UCLASS_PDATA);
-		ptr = calloc(1, size);
+		ptr = device_alloc_data(dev, size);
 		if (!ptr) {
 			ret = -ENOMEM;
 			goto fail_alloc2;
@@ -148,7 +236,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			size = parent->uclass->uc_drv->per_child_plat_auto;
 		if (size) {
 			dev_or_flags(dev, DM_FLAG_ALLOC_PARENT_PDATA);
-			ptr = calloc(1, size);
+			ptr = device_alloc_data(dev, size);
 			if (!ptr) {
 				ret = -ENOMEM;
 				goto fail_alloc3;
@@ -210,21 +298,21 @@ fail_uclass_bind:
 	if (CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)) {
 		list_del(&dev->sibling_node);
 		if (dev_get_flags(dev) & DM_FLAG_ALLOC_PARENT_PDATA) {
-			free(dev_get_parent_plat(dev));
+			device_free_data(dev_get_parent_plat(dev));
 			dev_set_parent_plat(dev, NULL);
 		}
 	}
 fail_alloc3:
 	if (CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)) {
 		if (dev_get_flags(dev) & DM_FLAG_ALLOC_UCLASS_PDATA) {
-			free(dev_get_uclass_plat(dev));
+			device_free_data(dev_get_uclass_plat(dev));
 			dev_set_uclass_plat(dev, NULL);
 		}
 	}
 fail_alloc2:
 	if (CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)) {
 		if (dev_get_flags(dev) & DM_FLAG_ALLOC_PDATA) {
-			free(dev_get_plat(dev));
+			device_free_data(dev_get_plat(dev));
 			dev_set_plat(dev, NULL);
 		}
 	}
@@ -299,7 +387,7 @@ int device_reparent(struct udevice *dev, struct udevice *new_parent)
 	return 0;
 }
 
-static void *alloc_priv(int size, uint flags)
+static void *alloc_priv(struct udevice *dev, int size, uint flags)
 {
 	void *priv;
 
@@ -337,7 +425,7 @@ static void *alloc_priv(int size, uint flags)
 #endif
 		}
 	} else {
-		priv = calloc(1, size);
+		priv = device_alloc_data(dev, size);
 	}
 
 	return priv;
@@ -360,7 +448,7 @@ static int device_alloc_priv(struct udevice *dev)
 
 	/* Allocate private data if requested and not reentered */
 	if (drv->priv_auto && !dev_get_priv(dev)) {
-		ptr = alloc_priv(drv->priv_auto, drv->flags);
+		ptr = alloc_priv(dev, drv->priv_auto, drv->flags);
 		if (!ptr)
 			return -ENOMEM;
 		dev_set_priv(dev, ptr);
@@ -369,7 +457,7 @@ static int device_alloc_priv(struct udevice *dev)
 	/* Allocate private data if requested and not reentered */
 	size = dev->uclass->uc_drv->per_device_auto;
 	if (size && !dev_get_uclass_priv(dev)) {
-		ptr = alloc_priv(size, dev->uclass->uc_drv->flags);
+		ptr = alloc_priv(dev, size, dev->uclass->uc_drv->flags);
 		if (!ptr)
 			return -ENOMEM;
 		dev_set_uclass_priv(dev, ptr);
@@ -381,7 +469,7 @@ static int device_alloc_priv(struct udevice *dev)
 		if (!size)
 			size = dev->parent->uclass->uc_drv->per_child_auto;
 		if (size && !dev_get_parent_priv(dev)) {
-			ptr = alloc_priv(size, drv->flags);
+			ptr = alloc_priv(dev, size, drv->flags);
 			if (!ptr)
 				return -ENOMEM;
 			dev_set_parent_priv(dev, ptr);
@@ -483,9 +571,29 @@ static int device_get_dma_constraints(struct udevice *dev)
 	return 0;
 }
 
+/*
+ * Check whether the probe of @dev can be timed. Reading the time may set up
+ * the DM timer, which probes it. So the timer itself is not timed, nor is
+ * anything probed before the timer is ready, such as the timer's clock.
+ */
+static bool device_probe_timed(struct udevice *dev)
+{
+	if (!CONFIG_IS_ENABLED(BOOTSTAGE_SPANS) ||
+	    device_get_uclass_id(dev) == UCLASS_TIMER)
+		return false;
+#if CONFIG_IS_ENABLED(TIMER)
+	if (!gd->timer)
+		return false;
+#endif
+
+	return true;
+}
+
 int device_probe(struct udevice *dev)
 {
 	const struct driver *drv;
+	ulong start_us = 0;
+	bool timed = false;
 	int ret;
 
 	if (!dev)
@@ -523,6 +631,14 @@ int device_probe(struct udevice *dev)
 
 	dev_or_flags(dev, DM_FLAG_ACTIVATED);
 
+	/*
+	 * Parents have their own spans, so start timing here, once the flag
+	 * stops the timer set-up from probing this device again
+	 */
+	timed = device_probe_timed(dev);
+	if (timed)
+		start_us = bootstage_span_start();
+
 	if (CONFIG_IS_ENABLED(POWER_DOMAIN) && dev->parent &&
 	    (device_get_uclass_id(dev) != UCLASS_POWER_DOMAIN) &&
 	    !(drv->flags & DM_FLAG_DEFAULT_PD_CTRL_OFF)) {
@@ -602,6 +718,9 @@ int device_probe(struct udevice *dev)
 				  dev->name, ret, errno_str(ret));
 	}
 
+	if (timed)
+		bootstage_span_end(BOOTSTAGE_SPAN_PROBE, dev->name, start_us, 0);
+
 	ret = device_notify(dev, EVT_DM_POST_PROBE);
 	if (ret)
 		return ret;
@@ -613,6 +732,9 @@ fail_uclass:
 			__func__, dev->name);
 	}
 fail:
+	if (timed)
+		bootstage_span_end(BOOTSTAGE_SPAN_PROBE_FAIL, dev->name,
+				   start_us, 0);
 	dev_bic_flags(dev, DM_FLAG_ACTIVATED);
 
 	device_free(dev);
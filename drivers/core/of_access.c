@@ -21,7 +21,7 @@
 
 #include <common.h>
 #include <log.h>
-#include <malloc.h>
+#include <of_live.h>
 #include <asm/global_data.h>
 #include <linux/bug.h>
 #include <linux/libfdt.h>
@@ -828,10 +828,9 @@ int of_alias_scan(void)
 			continue;
 
 		/* Allocate an alias_prop with enough space for the stem */
-		ap = malloc(sizeof(*ap) + len + 1);
+		ap = of_live_alloc(sizeof(*ap) + len + 1);
 		if (!ap)
 			return -ENOMEM;
-		memset(ap, 0, sizeof(*ap) + len + 1);
 		ap->alias = start;
 		of_alias_add(ap, np, id, start, len);
 	}
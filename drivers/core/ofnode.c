@@ -10,6 +10,7 @@
 #include <fdt_support.h>
 #include <log.h>
 #include <malloc.h>
+#include <of_live.h>
 #include <linux/libfdt.h>
 #include <dm/of_access.h>
 #include <dm/of_addr.h>
@@ -1122,15 +1123,12 @@ int ofnode_write_prop(ofnode node, const char *propname, int len,
 		return -ENOENT;
 
 	/* Property does not exist -> append new property */
-	new = malloc(sizeof(struct property));
+	new = of_live_alloc(sizeof(struct property) + strlen(propname) + 1);
 	if (!new)
 		return -ENOMEM;
 
-	new->name = strdup(propname);
-	if (!new->name) {
-		free(new);
-		return -ENOMEM;
-	}
+	new->name = (char *)(new + 1);
+	strcpy(new->name, propname);
 
 	new->value = (void *)value;
 	new->length = len;
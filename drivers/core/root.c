@@ -181,6 +181,10 @@ int dm_init(bool of_live)
 		INIT_LIST_HEAD(DM_UCLASS_ROOT_NON_CONST);
 	}
 
+	ret = dm_arena_init();
+	if (ret)
+		return ret;
+
 	if (IS_ENABLED(CONFIG_NEEDS_MANUAL_RELOC)) {
 		fix_drivers();
 		fix_uclass();
@@ -217,6 +221,7 @@ int dm_uninit(void)
 	device_remove(dm_root(), DM_REMOVE_NORMAL);
 	device_unbind(dm_root());
 	gd->dm_root = NULL;
+	dm_arena_uninit();
 
 	return 0;
 }
@@ -428,7 +433,9 @@ int dm_init_and_scan(bool pre_reloc_only)
 		return ret;
 	}
 	if (!CONFIG_IS_ENABLED(OF_PLATDATA_INST)) {
+		dm_arena_enable(true);
 		ret = dm_scan(pre_reloc_only);
+		dm_arena_enable(false);
 		if (ret) {
 			log_debug("dm_scan() failed: %d\n", ret);
 			return ret;
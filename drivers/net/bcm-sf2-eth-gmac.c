@@ -888,7 +888,7 @@ int gmac_mac_init(struct eth_device *dev)
 	gmac_clear_reset();
 
 	/* set max frame lengths; account for possible vlan tag */
-	writel(PKTSIZE + 32, UNIMAC0_FRM_LENGTH_ADDR);
+	writel(PKTSIZE_STD + 32, UNIMAC0_FRM_LENGTH_ADDR);
 
 	return 0;
 
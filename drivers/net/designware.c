@@ -345,6 +345,11 @@ static int dw_adjust_link(struct dw_eth_dev *priv, struct eth_mac_regs *mac_p,
 	if (phydev->duplex)
 		conf |= FULLDPLXMODE;
 
+	if (priv->mtu > ETH_DATA_LEN)
+		conf |= JUMBOENABLE;
+	else
+		conf &= ~JUMBOENABLE;
+
 	writel(conf, &mac_p->conf);
 
 	printf("Speed: %d, %s duplex%s\n", phydev->speed,
@@ -514,10 +519,12 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 	return 0;
 }
 
-static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
+/* Check the receive descriptor @desc_num for a packet */
+static int _dw_eth_recv_desc(struct dw_eth_dev *priv, u32 desc_num,
+			     uchar **packetp)
 {
-	u32 status, desc_num = priv->rx_currdescnum;
 	struct dmamacdescr *desc_p = &priv->rx_mac_descrtable[desc_num];
+	u32 status;
 	int length = -EAGAIN;
 	ulong desc_start = (ulong)desc_p;
 	ulong desc_end = desc_start +
@@ -545,6 +552,11 @@ static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
 	return length;
 }
 
+static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
+{
+	return _dw_eth_recv_desc(priv, priv->rx_currdescnum, packetp);
+}
+
 static int _dw_free_pkt(struct dw_eth_dev *priv)
 {
 	u32 desc_num = priv->rx_currdescnum;
@@ -739,6 +751,76 @@ int designware_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
 	return _dw_free_pkt(priv);
 }
 
+static int designware_eth_recv_batch(struct udevice *dev, int flags,
+				     uchar **packets, int *lengths, int budget)
+{
+	struct dw_eth_dev *priv = dev_get_priv(dev);
+	u32 desc_num = priv->rx_currdescnum;
+	int count, length;
+
+	budget = min(budget, CONFIG_RX_DESCR_NUM);
+	for (count = 0; count < budget; count++) {
+		length = _dw_eth_recv_desc(priv, desc_num, &packets[count]);
+		if (length < 0)
+			break;
+		lengths[count] = length;
+		if (++desc_num >= CONFIG_RX_DESCR_NUM)
+			desc_num = 0;
+	}
+
+	return count;
+}
+
+static int designware_eth_free_batch(struct udevice *dev, uchar **packets,
+				     int count)
+{
+	struct dw_eth_dev *priv = dev_get_priv(dev);
+	struct eth_dma_regs *dma_p = priv->dma_regs_p;
+	u32 first = priv->rx_currdescnum;
+	u32 desc_num = first;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		priv->rx_mac_descrtable[desc_num].txrx_status |=
+			DESC_RXSTS_OWNBYDMA;
+		if (++desc_num >= CONFIG_RX_DESCR_NUM)
+			desc_num = 0;
+	}
+
+	/* Flush the descriptors at once, in two parts if the ring wrapped */
+	if (desc_num <= first && count) {
+		flush_dcache_range((ulong)&priv->rx_mac_descrtable[first],
+				   (ulong)&priv->rx_mac_descrtable[
+					CONFIG_RX_DESCR_NUM]);
+		first = 0;
+	}
+	flush_dcache_range((ulong)&priv->rx_mac_descrtable[first],
+			   (ulong)&priv->rx_mac_descrtable[desc_num]);
+	priv->rx_currdescnum = desc_num;
+
+	/* Resume reception in case the DMA ran out of descriptors */
+	writel(POLL_DATA, &dma_p->rxpolldemand);
+
+	return 0;
+}
+
+static int designware_eth_get_stats(struct udevice *dev,
+				    struct eth_stats *stats)
+{
+	struct dw_eth_dev *priv = dev_get_priv(dev);
+	u32 missed;
+
+	/* The counters clear when read, so keep a running total */
+	missed = readl(&priv->dma_regs_p->missedframes);
+	priv->rx_dropped += missed & MISSED_BY_DMA_MASK;
+	priv->rx_overruns += (missed >> MISSED_BY_FIFO_SHIFT) &
+		MISSED_BY_FIFO_MASK;
+	stats->rx_dropped += priv->rx_dropped;
+	stats->rx_overruns += priv->rx_overruns;
+
+	return 0;
+}
+
 void designware_eth_stop(struct udevice *dev)
 {
 	struct dw_eth_dev *priv = dev_get_priv(dev);
@@ -754,6 +836,17 @@ int designware_eth_write_hwaddr(struct udevice *dev)
 	return _dw_write_hwaddr(priv, pdata->enetaddr);
 }
 
+static int designware_eth_set_mtu(struct udevice *dev, int mtu)
+{
+	struct dw_eth_dev *priv = dev_get_priv(dev);
+
+	if (mtu > DW_MAX_MTU)
+		return -EINVAL;
+	priv->mtu = mtu;
+
+	return 0;
+}
+
 static int designware_eth_bind(struct udevice *dev)
 {
 	if (IS_ENABLED(CONFIG_PCI)) {
@@ -903,8 +996,12 @@ const struct eth_ops designware_eth_ops = {
 	.send			= designware_eth_send,
 	.recv			= designware_eth_recv,
 	.free_pkt		= designware_eth_free_pkt,
+	.recv_batch		= designware_eth_recv_batch,
+	.free_batch		= designware_eth_free_batch,
+	.get_stats		= designware_eth_get_stats,
 	.stop			= designware_eth_stop,
 	.write_hwaddr		= designware_eth_write_hwaddr,
+	.set_mtu		= designware_eth_set_mtu,
 };
 
 int designware_eth_of_to_plat(struct udevice *dev)
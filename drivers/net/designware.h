@@ -16,7 +16,14 @@
 
 #define CONFIG_TX_DESCR_NUM	16
 #define CONFIG_RX_DESCR_NUM	16
+#if defined(CONFIG_DW_ALTDESCRIPTOR) && NET_MTU_MAX > ETH_DATA_LEN
+/* Enhanced descriptors take up to 8 KiB per buffer, enough for jumbo frames */
+#define DW_JUMBO_BUFS
+#define CONFIG_ETH_BUFSIZE	(PKTSIZE > 8192 ? 8192 : \
+				 ALIGN(PKTSIZE, ARCH_DMA_MINALIGN))
+#else
 #define CONFIG_ETH_BUFSIZE	2048
+#endif
 #define TX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_TX_DESCR_NUM)
 #define RX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_RX_DESCR_NUM)
 
@@ -42,6 +49,7 @@ struct eth_mac_regs {
 
 /* MAC configuration register definitions */
 #define FRAMEBURSTENABLE	(1 << 21)
+#define JUMBOENABLE		(1 << 20)
 #define MII_PORTSELECT		(1 << 15)
 #define FES_100			(1 << 14)
 #define DISABLERXOWN		(1 << 13)
@@ -74,7 +82,8 @@ struct eth_dma_regs {
 	u32 status;		/* 0x14 */
 	u32 opmode;		/* 0x18 */
 	u32 intenable;		/* 0x1c */
-	u32 reserved1[2];
+	u32 missedframes;	/* 0x20 */
+	u32 reserved1;
 	u32 axibus;		/* 0x28 */
 	u32 reserved2[7];
 	u32 currhosttxdesc;	/* 0x48 */
@@ -103,6 +112,11 @@ struct eth_dma_regs {
 /* Poll demand definitions */
 #define POLL_DATA		(0xFFFFFFFF)
 
+/* Missed frame counter definitions */
+#define MISSED_BY_DMA_MASK	0xffff
+#define MISSED_BY_FIFO_SHIFT	17
+#define MISSED_BY_FIFO_MASK	0x7ff
+
 /* Operation mode definitions */
 #define STOREFORWARD		(1 << 21)
 #define FLUSHTXFIFO		(1 << 20)
@@ -111,7 +125,13 @@ struct eth_dma_regs {
 #define RXSTART			(1 << 1)
 
 /* Descriptior related definitions */
+#ifdef DW_JUMBO_BUFS
+#define MAC_MAX_FRAME_SZ	(CONFIG_ETH_BUFSIZE - 4)
+#else
 #define MAC_MAX_FRAME_SZ	(1600)
+#endif
+/* Largest MTU whose frames fit a receive buffer */
+#define DW_MAX_MTU		(MAC_MAX_FRAME_SZ - VLAN_ETH_HLEN - ETH_FCS_LEN)
 
 struct dmamacdescr {
 	u32 txrx_status;
@@ -230,6 +250,9 @@ struct dw_eth_dev {
 
 	u32 interface;
 	u32 max_speed;
+	int mtu;
+	ulong rx_dropped;
+	ulong rx_overruns;
 	u32 tx_currdescnum;
 	u32 rx_currdescnum;
 
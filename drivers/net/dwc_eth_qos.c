@@ -150,7 +150,7 @@ struct eqos_mtl_regs {
 	uint32_t txq0_quantum_weight;			/* 0xd18 */
 	uint32_t unused_d1c[(0xd30 - 0xd1c) / 4];	/* 0xd1c */
 	uint32_t rxq0_operation_mode;			/* 0xd30 */
-	uint32_t unused_d34;				/* 0xd34 */
+	uint32_t rxq0_missed_packet_overflow_cnt;	/* 0xd34 */
 	uint32_t rxq0_debug;				/* 0xd38 */
 };
 
@@ -175,6 +175,10 @@ struct eqos_mtl_regs {
 #define EQOS_MTL_RXQ0_OPERATION_MODE_EHFC		BIT(7)
 #define EQOS_MTL_RXQ0_OPERATION_MODE_RSF		BIT(5)
 
+#define EQOS_MTL_RXQ0_MISSED_PACKET_CNT_SHIFT		16
+#define EQOS_MTL_RXQ0_MISSED_PACKET_CNT_MASK		0x7ff
+#define EQOS_MTL_RXQ0_OVERFLOW_PACKET_CNT_MASK		0x7ff
+
 #define EQOS_MTL_RXQ0_DEBUG_PRXQ_SHIFT			16
 #define EQOS_MTL_RXQ0_DEBUG_PRXQ_MASK			0x7fff
 #define EQOS_MTL_RXQ0_DEBUG_RXQSTS_SHIFT		4
@@ -241,10 +245,12 @@ struct eqos_tegra186_regs {
 
 /* Descriptors */
 #define EQOS_DESCRIPTORS_TX	4
-#define EQOS_DESCRIPTORS_RX	4
+#define EQOS_DESCRIPTORS_RX	16
 #define EQOS_DESCRIPTORS_NUM	(EQOS_DESCRIPTORS_TX + EQOS_DESCRIPTORS_RX)
 #define EQOS_BUFFER_ALIGN	ARCH_DMA_MINALIGN
-#define EQOS_MAX_PACKET_SIZE	ALIGN(1568, ARCH_DMA_MINALIGN)
+/* Large enough for a frame of NET_MTU_MAX, which JE allows up to 9000 */
+#define EQOS_MAX_PACKET_SIZE	ALIGN(PKTSIZE > 1568 ? PKTSIZE : 1568, \
+				      ARCH_DMA_MINALIGN)
 #define EQOS_RX_BUFFER_SIZE	(EQOS_DESCRIPTORS_RX * EQOS_MAX_PACKET_SIZE)
 
 struct eqos_desc {
@@ -310,6 +316,10 @@ struct eqos_priv {
 	struct mii_dev *mii;
 	struct phy_device *phy;
 	u32 max_speed;
+	int mtu;
+	u32 tx_fifo_size, rx_fifo_size;
+	ulong rx_dropped;
+	ulong rx_overruns;
 	void *descs;
 	int tx_desc_idx, rx_desc_idx;
 	unsigned int desc_size;
@@ -977,6 +987,74 @@ static int eqos_adjust_link(struct udevice *dev)
 	return 0;
 }
 
+/**
+ * eqos_read_fifo_sizes() - Find out the size of the MTL TX and RX FIFOs
+ *
+ * The registers cannot be read while the MAC is in reset, so the reset is
+ * briefly released if the MAC has not been started.
+ *
+ * @dev: Ethernet device
+ * Return: 0 if OK, -ve on error
+ */
+static int eqos_read_fifo_sizes(struct udevice *dev)
+{
+	struct eqos_priv *eqos = dev_get_priv(dev);
+	bool reset = !eqos->config->reg_access_always_ok &&
+		!eqos->reg_access_ok;
+	u32 val, tx_fifo_sz, rx_fifo_sz;
+	int ret;
+
+	if (reset) {
+		ret = eqos->config->ops->eqos_start_resets(dev);
+		if (ret < 0)
+			return ret;
+		udelay(10);
+	}
+	val = readl(&eqos->mac_regs->hw_feature1);
+	if (reset)
+		eqos->config->ops->eqos_stop_resets(dev);
+
+	tx_fifo_sz = (val >> EQOS_MAC_HW_FEATURE1_TXFIFOSIZE_SHIFT) &
+		EQOS_MAC_HW_FEATURE1_TXFIFOSIZE_MASK;
+	rx_fifo_sz = (val >> EQOS_MAC_HW_FEATURE1_RXFIFOSIZE_SHIFT) &
+		EQOS_MAC_HW_FEATURE1_RXFIFOSIZE_MASK;
+
+	/* r/tx_fifo_sz is encoded as log2(n / 128). Undo that by shifting */
+	eqos->tx_fifo_size = 128 << tx_fifo_sz;
+	eqos->rx_fifo_size = 128 << rx_fifo_sz;
+
+	return 0;
+}
+
+static int eqos_set_mtu(struct udevice *dev, int mtu)
+{
+	struct eqos_priv *eqos = dev_get_priv(dev);
+	int frame_size = mtu + VLAN_ETH_HLEN + ETH_FCS_LEN;
+	int ret;
+
+	/*
+	 * The buffers already hold a frame of NET_MTU_MAX, but with
+	 * store-and-forward a whole frame must also fit in each MTL FIFO
+	 */
+	if (mtu > ETH_DATA_LEN) {
+		if (!eqos->tx_fifo_size) {
+			ret = eqos_read_fifo_sizes(dev);
+			if (ret)
+				return ret;
+		}
+		if (frame_size > eqos->tx_fifo_size ||
+		    frame_size > eqos->rx_fifo_size) {
+			debug("%s: MTU %d too big for FIFOs (tx %u, rx %u)\n",
+			      dev->name, mtu, eqos->tx_fifo_size,
+			      eqos->rx_fifo_size);
+			return -EINVAL;
+		}
+	}
+	eqos->mtu = mtu;
+
+	return 0;
+}
+
 static int eqos_write_hwaddr(struct udevice *dev)
 {
 	struct eth_pdata *plat = dev_get_plat(dev);
@@ -1036,7 +1114,7 @@ static int eqos_start(struct udevice *dev)
 	struct eqos_priv *eqos = dev_get_priv(dev);
 	int ret, i;
 	ulong rate;
-	u32 val, tx_fifo_sz, rx_fifo_sz, tqs, rqs, pbl;
+	u32 val, tqs, rqs, pbl;
 	ulong last_rx_desc;
 	ulong desc_pad;
 
@@ -1141,18 +1219,13 @@ static int eqos_start(struct udevice *dev)
 		     EQOS_MTL_RXQ0_OPERATION_MODE_RSF);
 
 	/* Transmit/Receive queue fifo size; use all RAM for 1 queue */
-	val = readl(&eqos->mac_regs->hw_feature1);
-	tx_fifo_sz = (val >> EQOS_MAC_HW_FEATURE1_TXFIFOSIZE_SHIFT) &
-		EQOS_MAC_HW_FEATURE1_TXFIFOSIZE_MASK;
-	rx_fifo_sz = (val >> EQOS_MAC_HW_FEATURE1_RXFIFOSIZE_SHIFT) &
-		EQOS_MAC_HW_FEATURE1_RXFIFOSIZE_MASK;
+	ret = eqos_read_fifo_sizes(dev);
+	if (ret < 0)
+		goto err_shutdown_phy;
 
-	/*
-	 * r/tx_fifo_sz is encoded as log2(n / 128). Undo that by shifting.
-	 * r/tqs is encoded as (n / 256) - 1.
-	 */
-	tqs = (128 << tx_fifo_sz) / 256 - 1;
-	rqs = (128 << rx_fifo_sz) / 256 - 1;
+	/* r/tqs is encoded as (n / 256) - 1 */
+	tqs = eqos->tx_fifo_size / 256 - 1;
+	rqs = eqos->rx_fifo_size / 256 - 1;
 
 	clrsetbits_le32(&eqos->mtl_regs->txq0_operation_mode,
 			EQOS_MTL_TXQ0_OPERATION_MODE_TQS_MASK <<
@@ -1245,7 +1318,9 @@ static int eqos_start(struct udevice *dev)
 			EQOS_MAC_CONFIGURATION_JD |
 			EQOS_MAC_CONFIGURATION_JE,
 			EQOS_MAC_CONFIGURATION_CST |
-			EQOS_MAC_CONFIGURATION_ACS);
+			EQOS_MAC_CONFIGURATION_ACS |
+			(eqos->mtu > ETH_DATA_LEN ?
+			 EQOS_MAC_CONFIGURATION_JE : 0));
 
 	eqos_write_hwaddr(dev);
 
@@ -1454,23 +1529,20 @@ static int eqos_send(struct udevice *dev, void *packet, int length)
 	return -ETIMEDOUT;
 }
 
-static int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
+/* Check the receive descriptor @idx for a packet */
+static int eqos_recv_desc(struct eqos_priv *eqos, int idx, uchar **packetp)
 {
-	struct eqos_priv *eqos = dev_get_priv(dev);
 	struct eqos_desc *rx_desc;
 	int length;
 
-	debug("%s(dev=%p, flags=%x):\n", __func__, dev, flags);
-
-	rx_desc = eqos_get_desc(eqos, eqos->rx_desc_idx, true);
+	rx_desc = eqos_get_desc(eqos, idx, true);
 	eqos->config->ops->eqos_inval_desc(rx_desc);
 	if (rx_desc->des3 & EQOS_DESC3_OWN) {
 		debug("%s: RX packet not available\n", __func__);
 		return -EAGAIN;
 	}
 
-	*packetp = eqos->rx_dma_buf +
-		(eqos->rx_desc_idx * EQOS_MAX_PACKET_SIZE);
+	*packetp = eqos->rx_dma_buf + (idx * EQOS_MAX_PACKET_SIZE);
 	length = rx_desc->des3 & 0x7fff;
 	debug("%s: *packetp=%p, length=%d\n", __func__, *packetp, length);
 
@@ -1479,21 +1551,20 @@ static int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
 	return length;
 }
 
-static int eqos_free_pkt(struct udevice *dev, uchar *packet, int length)
+static int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
-	uchar *packet_expected;
-	struct eqos_desc *rx_desc;
 
-	debug("%s(packet=%p, length=%d)\n", __func__, packet, length);
+	debug("%s(dev=%p, flags=%x):\n", __func__, dev, flags);
 
-	packet_expected = eqos->rx_dma_buf +
-		(eqos->rx_desc_idx * EQOS_MAX_PACKET_SIZE);
-	if (packet != packet_expected) {
-		debug("%s: Unexpected packet (expected %p)\n", __func__,
-		      packet_expected);
-		return -EINVAL;
-	}
+	return eqos_recv_desc(eqos, eqos->rx_desc_idx, packetp);
+}
+
+/* Give the current receive descriptor back to the hardware */
+static struct eqos_desc *eqos_rearm_desc(struct eqos_priv *eqos,
+					 uchar *packet, int length)
+{
+	struct eqos_desc *rx_desc;
 
 	eqos->config->ops->eqos_inval_buffer(packet, length);
 
@@ -1514,11 +1585,89 @@ static int eqos_free_pkt(struct udevice *dev, uchar *packet, int length)
 	rx_desc->des3 = EQOS_DESC3_OWN | EQOS_DESC3_BUF1V;
 	eqos->config->ops->eqos_flush_desc(rx_desc);
 
-	writel((ulong)rx_desc, &eqos->dma_regs->ch0_rxdesc_tail_pointer);
-
 	eqos->rx_desc_idx++;
 	eqos->rx_desc_idx %= EQOS_DESCRIPTORS_RX;
 
+	return rx_desc;
+}
+
+static int eqos_free_pkt(struct udevice *dev, uchar *packet, int length)
+{
+	struct eqos_priv *eqos = dev_get_priv(dev);
+	uchar *packet_expected;
+	struct eqos_desc *rx_desc;
+
+	debug("%s(packet=%p, length=%d)\n", __func__, packet, length);
+
+	packet_expected = eqos->rx_dma_buf +
+		(eqos->rx_desc_idx * EQOS_MAX_PACKET_SIZE);
+	if (packet != packet_expected) {
+		debug("%s: Unexpected packet (expected %p)\n", __func__,
+		      packet_expected);
+		return -EINVAL;
+	}
+
+	rx_desc = eqos_rearm_desc(eqos, packet, length);
+	writel((ulong)rx_desc, &eqos->dma_regs->ch0_rxdesc_tail_pointer);
+
+	return 0;
+}
+
+static int eqos_recv_batch(struct udevice *dev, int flags, uchar **packets,
+			   int *lengths, int budget)
+{
+	struct eqos_priv *eqos = dev_get_priv(dev);
+	int idx = eqos->rx_desc_idx;
+	int count, length;
+
+	budget = min(budget, EQOS_DESCRIPTORS_RX);
+	for (count = 0; count < budget; count++) {
+		length = eqos_recv_desc(eqos, idx, &packets[count]);
+		if (length < 0)
+			break;
+		lengths[count] = length;
+		idx = (idx + 1) % EQOS_DESCRIPTORS_RX;
+	}
+
+	return count;
+}
+
+static int eqos_free_batch(struct udevice *dev, uchar **packets, int count)
+{
+	struct eqos_priv *eqos = dev_get_priv(dev);
+	struct eqos_desc *rx_desc = NULL;
+	int i;
+
+	for (i = 0; i < count; i++)
+		rx_desc = eqos_rearm_desc(eqos, packets[i],
+					  EQOS_MAX_PACKET_SIZE);
+
+	/* Move the tail pointer once for the whole batch */
+	if (rx_desc)
+		writel((ulong)rx_desc,
+		       &eqos->dma_regs->ch0_rxdesc_tail_pointer);
+
+	return 0;
+}
+
+static int eqos_get_stats(struct udevice *dev, struct eth_stats *stats)
+{
+	struct eqos_priv *eqos = dev_get_priv(dev);
+	u32 cnt;
+
+	/* Registers cannot be read while the clocks are stopped */
+	if (eqos->started) {
+		/* The counters clear when read, so keep a running total */
+		cnt = readl(&eqos->mtl_regs->rxq0_missed_packet_overflow_cnt);
+		eqos->rx_dropped += (cnt >>
+				     EQOS_MTL_RXQ0_MISSED_PACKET_CNT_SHIFT) &
+				    EQOS_MTL_RXQ0_MISSED_PACKET_CNT_MASK;
+		eqos->rx_overruns += cnt &
+				     EQOS_MTL_RXQ0_OVERFLOW_PACKET_CNT_MASK;
+	}
+	stats->rx_dropped += eqos->rx_dropped;
+	stats->rx_overruns += eqos->rx_overruns;
+
 	return 0;
 }
 
@@ -1901,8 +2050,12 @@ static const struct eth_ops eqos_ops = {
 	.send = eqos_send,
 	.recv = eqos_recv,
 	.free_pkt = eqos_free_pkt,
+	.recv_batch = eqos_recv_batch,
+	.free_batch = eqos_free_batch,
+	.get_stats = eqos_get_stats,
 	.write_hwaddr = eqos_write_hwaddr,
 	.read_rom_hwaddr	= eqos_read_rom_hwaddr,
+	.set_mtu = eqos_set_mtu,
 };
 
 static struct eqos_ops eqos_tegra186_ops = {
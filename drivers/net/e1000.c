@@ -53,6 +53,21 @@ tested on both gig copper and gig fiber boards
 /* Intel i210 needs the DMA descriptor rings aligned to 128b */
 #define E1000_BUFFER_ALIGN	128
 
+/* Receive buffer, large enough for a frame of NET_MTU_MAX */
+#if PKTSIZE > 8192
+#define E1000_RX_BUFSIZE	16384
+#define E1000_RCTL_BUFSIZE	(E1000_RCTL_SZ_16384 | E1000_RCTL_BSEX)
+#elif PKTSIZE > 4096
+#define E1000_RX_BUFSIZE	8192
+#define E1000_RCTL_BUFSIZE	(E1000_RCTL_SZ_8192 | E1000_RCTL_BSEX)
+#elif PKTSIZE > 2048
+#define E1000_RX_BUFSIZE	4096
+#define E1000_RCTL_BUFSIZE	(E1000_RCTL_SZ_4096 | E1000_RCTL_BSEX)
+#else
+#define E1000_RX_BUFSIZE	4096
+#define E1000_RCTL_BUFSIZE	E1000_RCTL_SZ_2048
+#endif
+
 /*
  * TODO(sjg@chromium.org): Even with driver model we share these buffers.
  * Concurrent receiving on multiple active Ethernet devices will not work.
@@ -61,7 +76,8 @@ tested on both gig copper and gig fiber boards
  */
 DEFINE_ALIGN_BUFFER(struct e1000_tx_desc, tx_base, 16, E1000_BUFFER_ALIGN);
 DEFINE_ALIGN_BUFFER(struct e1000_rx_desc, rx_base, 16, E1000_BUFFER_ALIGN);
-DEFINE_ALIGN_BUFFER(unsigned char, packet, 4096, E1000_BUFFER_ALIGN);
+DEFINE_ALIGN_BUFFER(unsigned char, packet, E1000_RX_BUFSIZE,
+		    E1000_BUFFER_ALIGN);
 
 static int tx_tail;
 static int rx_tail, rx_last;
@@ -5149,7 +5165,7 @@ fill_rx(struct e1000_hw *hw)
 	 * into the same memory area.
 	 */
 	invalidate_dcache_range((unsigned long)packet,
-				(unsigned long)packet + 4096);
+				(unsigned long)packet + E1000_RX_BUFSIZE);
 	/* Dump the DMA descriptor into RAM. */
 	flush_start = ((unsigned long)rd) & ~(ARCH_DMA_MINALIGN - 1);
 	flush_end = flush_start + roundup(sizeof(*rd), ARCH_DMA_MINALIGN);
@@ -5276,9 +5292,10 @@ e1000_setup_rctl(struct e1000_hw *hw)
 	else
 		rctl &= ~E1000_RCTL_SBP;
 
-	rctl &= ~(E1000_RCTL_SZ_4096);
-		rctl |= E1000_RCTL_SZ_2048;
-		rctl &= ~(E1000_RCTL_BSEX | E1000_RCTL_LPE);
+	rctl &= ~(E1000_RCTL_SZ_4096 | E1000_RCTL_BSEX | E1000_RCTL_LPE);
+	rctl |= E1000_RCTL_BUFSIZE;
+	if (hw->mtu > ETH_DATA_LEN)
+		rctl |= E1000_RCTL_LPE;
 	E1000_WRITE_REG(hw, RCTL, rctl);
 }
 
@@ -5890,6 +5907,19 @@ static int e1000_free_pkt(struct udevice *dev, uchar *packet, int length)
 	return 0;
 }
 
+static int e1000_set_mtu(struct udevice *dev, int mtu)
+{
+	struct e1000_hw *hw = dev_get_priv(dev);
+
+	/* The 82542 does not support long packets */
+	if (mtu > ETH_DATA_LEN && (hw->mac_type == e1000_82542_rev2_0 ||
+				   hw->mac_type == e1000_82542_rev2_1))
+		return -EINVAL;
+	hw->mtu = mtu;
+
+	return 0;
+}
+
 static int e1000_eth_probe(struct udevice *dev)
 {
 	struct eth_pdata *plat = dev_get_plat(dev);
@@ -5929,6 +5959,7 @@ static const struct eth_ops e1000_eth_ops = {
 	.stop	= e1000_eth_stop,
 	.free_pkt = e1000_free_pkt,
 	.write_hwaddr = e1000_write_hwaddr,
+	.set_mtu = e1000_set_mtu,
 };
 
 static const struct udevice_id e1000_eth_ids[] = {
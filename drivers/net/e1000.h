@@ -1091,6 +1091,7 @@ struct e1000_hw {
 	pci_dev_t pdev;
 #endif
 	uint8_t *hw_addr;
+	int mtu;			/* 0 for ETH_DATA_LEN */
 	e1000_mac_type mac_type;
 	e1000_phy_type phy_type;
 	uint32_t phy_init_script;
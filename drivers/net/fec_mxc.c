@@ -436,8 +436,8 @@ static void fec_reg_setup(struct fec_priv *fec)
 
 	/* Set FEC-Lite receive control register(R_CNTRL): */
 
-	/* Start with frame length = 1518, common for all modes. */
-	rcntrl = PKTSIZE << FEC_RCNTRL_MAX_FL_SHIFT;
+	/* Standard frames with a VLAN tag only, common for all modes. */
+	rcntrl = PKTSIZE_STD << FEC_RCNTRL_MAX_FL_SHIFT;
 	if (fec->xcv_type != SEVENWIRE)		/* xMII modes */
 		rcntrl |= FEC_RCNTRL_FCE | FEC_RCNTRL_MII_MODE;
 	if (fec->xcv_type == RGMII)
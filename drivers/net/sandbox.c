@@ -327,6 +327,7 @@ static int sb_eth_start(struct udevice *dev)
 	debug("eth_sandbox: Start\n");
 
 	priv->recv_packets = 0;
+	priv->batch_count = 0;
 	for (int i = 0; i < PKTBUFSRX; i++) {
 		priv->recv_packet_buffer[i] = net_rx_packets[i];
 		priv->recv_packet_length[i] = 0;
@@ -343,18 +344,43 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 
 	if (priv->disabled)
 		return 0;
+	if (priv->mtu && length > VLAN_ETH_HLEN + priv->mtu)
+		return -EMSGSIZE;
 
 	return priv->tx_handler(dev, packet, length);
 }
 
-static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
+/* Fast-forward time if sandbox_eth_skip_timeout() asked for it */
+static void sb_eth_check_skip_timeout(void)
 {
-	struct eth_sandbox_priv *priv = dev_get_priv(dev);
-
 	if (skip_timeout) {
 		timer_test_add_offset(11000UL);
 		skip_timeout = false;
 	}
+}
+
+/* Remove packets from the front of the receive queue */
+static void sb_eth_drop_packets(struct eth_sandbox_priv *priv, int count)
+{
+	int i;
+
+	priv->recv_packets -= count;
+	for (i = 0; i < priv->recv_packets; i++) {
+		priv->recv_packet_length[i] =
+			priv->recv_packet_length[i + count];
+		memcpy(priv->recv_packet_buffer[i],
+		       priv->recv_packet_buffer[i + count],
+		       priv->recv_packet_length[i + count]);
+	}
+	for (; i < priv->recv_packets + count; i++)
+		priv->recv_packet_length[i] = 0;
+}
+
+static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+
+	sb_eth_check_skip_timeout();
 
 	if (priv->recv_packets) {
 		int lcl_recv_packet_length = priv->recv_packet_length[0];
@@ -370,19 +396,60 @@ static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 static int sb_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
-	int i;
 
-	if (!priv->recv_packets)
-		return 0;
+	if (priv->recv_packets)
+		sb_eth_drop_packets(priv, 1);
 
-	--priv->recv_packets;
-	for (i = 0; i < priv->recv_packets; i++) {
-		priv->recv_packet_length[i] = priv->recv_packet_length[i + 1];
-		memcpy(priv->recv_packet_buffer[i],
-		       priv->recv_packet_buffer[i + 1],
-		       priv->recv_packet_length[i + 1]);
+	return 0;
+}
+
+static int sb_eth_recv_batch(struct udevice *dev, int flags, uchar **packets,
+			     int *lengths, int budget)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	int i, count;
+
+	/* As with a real ring, the last batch must be handed back first */
+	if (priv->batch_count)
+		return -EBUSY;
+
+	sb_eth_check_skip_timeout();
+
+	count = min(priv->recv_packets, budget);
+	for (i = 0; i < count; i++) {
+		packets[i] = priv->recv_packet_buffer[i];
+		lengths[i] = priv->recv_packet_length[i];
 	}
-	priv->recv_packet_length[priv->recv_packets] = 0;
+	priv->batch_count = count;
+	debug("eth_sandbox: received %d packets, %d waiting\n", count,
+	      priv->recv_packets - count);
+
+	return count;
+}
+
+static int sb_eth_free_batch(struct udevice *dev, uchar **packets, int count)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+
+	if (count != priv->batch_count ||
+	    (count && packets[0] != priv->recv_packet_buffer[0]))
+		return -EINVAL;
+	sb_eth_drop_packets(priv, count);
+	priv->batch_count = 0;
+
+	return 0;
+}
+
+static int sb_eth_set_mtu(struct udevice *dev, int mtu)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+
+	debug("eth_sandbox: Set MTU %d\n", mtu);
+
+	/* Pretend to have a MAC with a small FIFO */
+	if (mtu > SANDBOX_ETH_MTU_MAX)
+		return -EINVAL;
+	priv->mtu = mtu;
 
 	return 0;
 }
@@ -406,6 +473,9 @@ static const struct eth_ops sb_eth_ops = {
 	.send			= sb_eth_send,
 	.recv			= sb_eth_recv,
 	.free_pkt		= sb_eth_free_pkt,
+	.recv_batch		= sb_eth_recv_batch,
+	.free_batch		= sb_eth_free_batch,
+	.set_mtu		= sb_eth_set_mtu,
 	.stop			= sb_eth_stop,
 	.write_hwaddr		= sb_eth_write_hwaddr,
 };
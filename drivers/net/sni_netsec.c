@@ -418,7 +418,7 @@ static void netsec_set_rx_de(struct netsec_priv *priv, u16 idx, void *addr)
 
 	de->data_buf_addr_up = upper_32_bits((dma_addr_t)addr);
 	de->data_buf_addr_lw = lower_32_bits((dma_addr_t)addr);
-	de->buf_len_info = PKTSIZE;
+	de->buf_len_info = PKTSIZE_STD;
 	de->attr = attr;
 	dmb();
 	netsec_cache_flush((uintptr_t)de, sizeof(*de));
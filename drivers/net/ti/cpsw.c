@@ -755,7 +755,7 @@ static int _cpsw_init(struct cpsw_priv *priv, u8 *enetaddr)
 	/* submit rx descs */
 	for (i = 0; i < PKTBUFSRX; i++) {
 		ret = cpdma_submit(priv, &priv->rx_chan, net_rx_packets[i],
-				   PKTSIZE);
+				   PKT_MAX);
 		if (ret < 0) {
 			printf("error %d submitting rx desc\n", ret);
 			break;
@@ -966,7 +966,7 @@ static int cpsw_recv(struct eth_device *dev)
 
 	if (len > 0) {
 		net_process_received_packet(pkt, len);
-		cpdma_submit(priv, &priv->rx_chan, pkt, PKTSIZE);
+		cpdma_submit(priv, &priv->rx_chan, pkt, PKT_MAX);
 	}
 
 	return len;
@@ -1039,7 +1039,7 @@ static int cpsw_eth_free_pkt(struct udevice *dev, uchar *packet,
 {
 	struct cpsw_priv *priv = dev_get_priv(dev);
 
-	return cpdma_submit(priv, &priv->rx_chan, packet, PKTSIZE);
+	return cpdma_submit(priv, &priv->rx_chan, packet, PKT_MAX);
 }
 
 static void cpsw_eth_stop(struct udevice *dev)
@@ -399,8 +399,8 @@ static int emaclite_send(struct udevice *dev, void *ptr, int len)
 
 	u32 maxtry = 1000;
 
-	if (len > PKTSIZE)
-		len = PKTSIZE;
+	if (len > PKTSIZE_STD)
+		len = PKTSIZE_STD;
 
 	while (xemaclite_txbufferavailable(emaclite) && maxtry) {
 		udelay(10);
@@ -521,9 +521,11 @@ try_again:
 		break;
 	default:
 		debug("Other Packet\n");
-		length = PKTSIZE;
+		length = PKTSIZE_STD;
 		break;
 	}
+	/* The core only handles standard frames */
+	length = min_t(u32, length, PKTSIZE_STD);
 
 	/* Read the rest of the packet which is longer then first read */
 	if (length != first_read)
@@ -18,8 +18,9 @@
 /*
  * This value comes from the VirtIO spec: 1500 for maximum packet size,
  * 14 for the Ethernet header, 12 for virtio_net_hdr. In total 1526 bytes.
+ * The buffers are made larger if jumbo frames are enabled.
  */
-#define VIRTIO_NET_RX_BUF_SIZE	1526
+#define VIRTIO_NET_RX_BUF_SIZE	(NET_MTU_MAX + ETH_HLEN + 12)
 
 struct virtio_net_priv {
 	union {
@@ -36,12 +37,14 @@ struct virtio_net_priv {
 };
 
 /*
- * For simplicity, the driver only negotiates the VIRTIO_NET_F_MAC feature.
+ * For simplicity, the driver only negotiates the VIRTIO_NET_F_MAC feature,
+ * plus VIRTIO_NET_F_MTU to learn the largest MTU the device handles.
  * For the VIRTIO_NET_F_STATUS feature, we don't negotiate it, hence per spec
  * we should assume the link is always active.
  */
 static const u32 feature[] = {
-	VIRTIO_NET_F_MAC
+	VIRTIO_NET_F_MAC,
+	VIRTIO_NET_F_MTU
 };
 
 static const u32 feature_legacy[] = {
@@ -56,7 +59,7 @@ static int virtio_net_start(struct udevice *dev)
 	int i;
 
 	if (!priv->rx_running) {
-		/* receive buffer length is always 1526 */
+		/* receive buffers always take a frame of NET_MTU_MAX */
 		sg.length = VIRTIO_NET_RX_BUF_SIZE;
 
 		/* setup the receive buffer address */
@@ -133,6 +136,43 @@ static int virtio_net_free_pkt(struct udevice *dev, uchar *packet, int length)
 	return 0;
 }
 
+static int virtio_net_recv_batch(struct udevice *dev, int flags,
+				 uchar **packets, int *lengths, int budget)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	unsigned int len;
+	void *buf;
+	int count;
+
+	for (count = 0; count < budget; count++) {
+		buf = virtqueue_get_buf(priv->rx_vq, &len);
+		if (!buf)
+			break;
+		packets[count] = buf + priv->net_hdr_len;
+		lengths[count] = len - priv->net_hdr_len;
+	}
+
+	return count;
+}
+
+static int virtio_net_free_batch(struct udevice *dev, uchar **packets,
+				 int count)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	struct virtio_sg sg = { NULL, VIRTIO_NET_RX_BUF_SIZE };
+	struct virtio_sg *sgs[] = { &sg };
+	int i;
+
+	/* Put the buffers back to the rx ring and tell the device once */
+	for (i = 0; i < count; i++) {
+		sg.addr = packets[i] - priv->net_hdr_len;
+		virtqueue_add(priv->rx_vq, sgs, 0, 1);
+	}
+	virtqueue_kick(priv->rx_vq);
+
+	return 0;
+}
+
 static void virtio_net_stop(struct udevice *dev)
 {
 	/*
@@ -142,6 +182,20 @@ static void virtio_net_stop(struct udevice *dev)
 	 */
 }
 
+static int virtio_net_set_mtu(struct udevice *dev, int mtu)
+{
+	u16 max_mtu;
+
+	/* The receive buffers hold NET_MTU_MAX, but the device may not */
+	if (mtu > ETH_DATA_LEN && virtio_has_feature(dev, VIRTIO_NET_F_MTU)) {
+		virtio_cread(dev, struct virtio_net_config, mtu, &max_mtu);
+		if (mtu > max_mtu)
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
 static int virtio_net_write_hwaddr(struct udevice *dev)
 {
 	struct virtio_dev_priv *uc_priv = dev_get_uclass_priv(dev->parent);
@@ -221,9 +275,12 @@ static const struct eth_ops virtio_net_ops = {
 	.send = virtio_net_send,
 	.recv = virtio_net_recv,
 	.free_pkt = virtio_net_free_pkt,
+	.recv_batch = virtio_net_recv_batch,
+	.free_batch = virtio_net_free_batch,
 	.stop = virtio_net_stop,
 	.write_hwaddr = virtio_net_write_hwaddr,
 	.read_rom_hwaddr = virtio_net_read_rom_hwaddr,
+	.set_mtu = virtio_net_set_mtu,
 };
 
 U_BOOT_DRIVER(virtio_net) = {
@@ -277,6 +277,15 @@ void env_set_default(const char *s, int flags)
 
 	gd->flags |= GD_FLG_ENV_READY;
 	gd->flags |= GD_FLG_ENV_DEFAULT;
+
+	/*
+	 * Unless the user asked for it, nothing has been changed yet, although
+	 * this environment is not stored and must be written out in full
+	 */
+	if (!(flags & H_INTERACTIVE)) {
+		hclear_dirty_r(&env_htab);
+		env_htab.dirty_all = true;
+	}
 }
 
 
@@ -315,6 +324,8 @@ int env_import(const char *buf, int check, int flags)
 	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', flags, 0,
 			0, NULL)) {
 		gd->flags |= GD_FLG_ENV_READY;
+		/* The table now matches what is stored */
+		hclear_dirty_r(&env_htab);
 		return 0;
 	}
 
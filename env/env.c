@@ -290,19 +290,58 @@ int env_save(void)
 			return -ENODEV;
 		}
 
+		if (CONFIG_IS_ENABLED(ENV_SAVE_SKIP_UNCHANGED) &&
+		    !env_htab.dirty && !env_htab.dirty_all) {
+			printf("unchanged\n");
+			return 0;
+		}
+
 		ret = drv->save();
 		if (ret)
 			printf("Failed (%d)\n", ret);
 		else
 			printf("OK\n");
 
-		if (!ret)
+		if (!ret) {
+			hclear_dirty_r(&env_htab);
 			return 0;
+		}
 	}
 
 	return -ENODEV;
 }
 
+/* Variables set by U-Boot itself when it loads a file */
+static const char *const env_load_vars[] = {
+	"filesize",
+	"fileaddr",
+};
+
+/* Check whether a changed variable is something other than @priv */
+static int env_other_change(struct env_entry *entry, void *priv)
+{
+	int i;
+
+	if (!strcmp(entry->key, priv))
+		return 0;
+	for (i = 0; i < ARRAY_SIZE(env_load_vars); i++) {
+		if (!strcmp(entry->key, env_load_vars[i]))
+			return 0;
+	}
+
+	return 1;
+}
+
+int env_save_if_only(const char *var)
+{
+	if (hwalk_dirty_r(&env_htab, env_other_change, (void *)var)) {
+		log_debug("Environment has other changes; not saving\n");
+		return -EBUSY;
+	}
+
+	return env_save();
+}
+
 int env_erase(void)
 {
 	struct env_driver *drv;
@@ -324,8 +363,11 @@ int env_erase(void)
 		else
 			printf("OK\n");
 
-		if (!ret)
+		if (!ret) {
+			/* nothing is stored any more */
+			env_htab.dirty_all = true;
 			return 0;
+		}
 	}
 
 	return -ENODEV;
@@ -395,6 +437,8 @@ int env_select(const char *name)
 				gd->env_load_prio = prio;
 				gd->env_valid = ENV_INVALID;
 				gd->flags &= ~GD_FLG_ENV_DEFAULT;
+				/* the new location holds something else */
+				env_htab.dirty_all = true;
 			}
 			printf("OK\n");
 			return 0;
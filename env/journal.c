@@ -0,0 +1,307 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Append-only journal for storing the environment on flash
+ *
+ * Instead of erasing and rewriting the whole environment on each save, only
+ * the variables changed since the last save are appended to pre-erased space.
+ * The area is only erased (and a full snapshot written to the other area)
+ * once it is full. See include/env_journal.h for the layout.
+ */
+
+#include <common.h>
+#include <env_journal.h>
+#include <errno.h>
+#include <log.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <search.h>
+#include <u-boot/crc.h>
+
+/* Offset of the first record in an area */
+static ulong journal_start(struct env_journal *jnl)
+{
+	return ALIGN(sizeof(struct env_journal_hdr), jnl->align);
+}
+
+/* Space taken up by a record with a payload of @len bytes */
+static ulong journal_rec_size(struct env_journal *jnl, size_t len)
+{
+	return ALIGN(sizeof(struct env_journal_rec) + len, jnl->align);
+}
+
+static u32 journal_rec_crc(const struct env_journal_rec *rec)
+{
+	return crc32(crc32(0, (uchar *)rec, offsetof(struct env_journal_rec,
+						     crc)),
+		     (uchar *)(rec + 1), rec->len);
+}
+
+/*
+ * Check the record at @pos in the area read into @buf
+ *
+ * Return: 1 if valid, 0 if erased (end of journal), -EBADMSG if damaged
+ */
+static int journal_rec_check(struct env_journal *jnl, const char *buf,
+			     ulong pos)
+{
+	const struct env_journal_rec *rec = (void *)buf + pos;
+
+	if (pos + sizeof(*rec) > jnl->size || rec->type == ~0U)
+		return 0;
+	if (rec->len > jnl->size - pos - sizeof(*rec) ||
+	    journal_rec_crc(rec) != rec->crc)
+		return -EBADMSG;
+
+	return 1;
+}
+
+/* Check that @buf holds a valid area and return its sequence number */
+static int journal_check(struct env_journal *jnl, const char *buf, u32 *seqp)
+{
+	const struct env_journal_hdr *hdr = (void *)buf;
+	const struct env_journal_rec *rec;
+	ulong pos = journal_start(jnl);
+
+	if (hdr->magic != ENV_JOURNAL_MAGIC ||
+	    hdr->crc != crc32(0, (uchar *)hdr,
+			      offsetof(struct env_journal_hdr, crc)))
+		return -ENOMSG;
+
+	/* a torn snapshot means the area was never completed */
+	rec = (void *)buf + pos;
+	if (journal_rec_check(jnl, buf, pos) != 1 ||
+	    rec->type != ENV_JOURNAL_SNAPSHOT)
+		return -ENOMSG;
+	*seqp = hdr->seq;
+
+	return 0;
+}
+
+static int journal_replay(struct env_journal *jnl, const char *buf,
+			  struct hsearch_data *htab, int flag)
+{
+	const struct env_journal_rec *rec;
+	ulong pos = journal_start(jnl);
+	int ret;
+
+	while ((ret = journal_rec_check(jnl, buf, pos)) == 1) {
+		rec = (void *)buf + pos;
+
+		/*
+		 * The snapshot replaces the table, deltas update it. The
+		 * changes were checked when they were saved, so write-once
+		 * variables such as ethaddr must not stop the replay.
+		 */
+		if (rec->type == ENV_JOURNAL_DELTA)
+			flag |= H_NOCLEAR | H_FORCE;
+		if (!himport_r(htab, (char *)(rec + 1), rec->len, '\0', flag,
+			       0, 0, NULL))
+			return -EIO;
+		pos += journal_rec_size(jnl, rec->len);
+	}
+	if (ret) {
+		/*
+		 * A write was interrupted. Do not append after the damaged
+		 * record, the next save writes a new snapshot instead.
+		 */
+		printf("Environment journal damaged at %lx, ignoring the rest\n",
+		       pos);
+		pos = jnl->size;
+	}
+	jnl->pos = pos;
+	hclear_dirty_r(htab);
+
+	return 0;
+}
+
+int env_journal_load(struct env_journal *jnl, struct hsearch_data *htab,
+		     int flag)
+{
+	char *buf[2];
+	bool valid[2];
+	u32 seq[2];
+	int i, cur;
+	int ret;
+
+	jnl->cur = -1;
+	buf[0] = memalign(ARCH_DMA_MINALIGN, jnl->size);
+	buf[1] = memalign(ARCH_DMA_MINALIGN, jnl->size);
+	if (!buf[0] || !buf[1]) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < 2; i++) {
+		valid[i] = !jnl->ops->read(jnl, jnl->offset[i], jnl->size,
+					   buf[i]) &&
+			   !journal_check(jnl, buf[i], &seq[i]);
+	}
+	if (!valid[0] && !valid[1]) {
+		ret = -ENOMSG;
+		goto out;
+	}
+	if (valid[0] && valid[1])
+		cur = (s32)(seq[1] - seq[0]) > 0;
+	else
+		cur = valid[1];
+
+	ret = journal_replay(jnl, buf[cur], htab, flag);
+	if (!ret) {
+		jnl->cur = cur;
+		jnl->seq = seq[cur];
+	}
+	debug("Environment journal: area %d, seq %u, %lu bytes used\n", cur,
+	      seq[cur], jnl->pos);
+out:
+	free(buf[0]);
+	free(buf[1]);
+
+	return ret;
+}
+
+struct journal_delta {
+	char *buf;	/* NULL to only compute the length */
+	size_t len;
+};
+
+static int journal_add_delta(struct env_entry *entry, void *priv)
+{
+	struct journal_delta *delta = priv;
+	size_t key_len = strlen(entry->key);
+	size_t len;
+
+	len = key_len + 1;
+	if (entry->data)
+		len += strlen(entry->data) + 1;
+	if (delta->buf) {
+		char *p = delta->buf + delta->len;
+
+		memcpy(p, entry->key, key_len);
+		p += key_len;
+		if (entry->data) {
+			*p++ = '=';
+			strcpy(p, entry->data);
+		} else {
+			*p = '\0';
+		}
+	}
+	delta->len += len;
+
+	return 0;
+}
+
+/*
+ * Write a record to area @area at @pos
+ *
+ * If @hdr is provided, the area is erased first and @hdr is written before
+ * the record.
+ */
+static int journal_write(struct env_journal *jnl, int area, ulong pos,
+			 const struct env_journal_hdr *hdr, uint type,
+			 const char *payload, size_t len)
+{
+	struct env_journal_rec *rec;
+	ulong size = journal_rec_size(jnl, len);
+	ulong start = hdr ? 0 : pos;
+	char *buf;
+	int ret;
+
+	buf = memalign(ARCH_DMA_MINALIGN, pos + size - start);
+	if (!buf)
+		return -ENOMEM;
+	memset(buf, 0xff, pos + size - start);
+	if (hdr)
+		memcpy(buf, hdr, sizeof(*hdr));
+
+	rec = (void *)buf + pos - start;
+	rec->type = type;
+	rec->len = len;
+	memcpy(rec + 1, payload, len);
+	rec->crc = journal_rec_crc(rec);
+
+	if (hdr) {
+		ret = jnl->ops->erase(jnl, jnl->offset[area], jnl->size);
+		if (ret)
+			goto out;
+	}
+	ret = jnl->ops->write(jnl, jnl->offset[area] + start,
+			      pos + size - start, buf);
+	if (!ret)
+		jnl->pos = pos + size;
+out:
+	free(buf);
+
+	return ret;
+}
+
+static int journal_append(struct env_journal *jnl, struct hsearch_data *htab)
+{
+	struct journal_delta delta = { };
+	int ret;
+
+	hwalk_dirty_r(htab, journal_add_delta, &delta);
+	if (!delta.len)
+		return 0;
+	if (jnl->pos + journal_rec_size(jnl, delta.len) > jnl->size)
+		return -ENOSPC;
+
+	delta.buf = malloc(delta.len);
+	if (!delta.buf)
+		return -ENOMEM;
+	delta.len = 0;
+	hwalk_dirty_r(htab, journal_add_delta, &delta);
+
+	ret = journal_write(jnl, jnl->cur, jnl->pos, NULL, ENV_JOURNAL_DELTA,
+			    delta.buf, delta.len);
+	free(delta.buf);
+
+	return ret;
+}
+
+/* Write a snapshot of the whole environment to the other area */
+static int journal_compact(struct env_journal *jnl, struct hsearch_data *htab)
+{
+	struct env_journal_hdr hdr;
+	int next = jnl->cur < 0 ? 0 : !jnl->cur;
+	char *res = NULL;
+	ssize_t len;
+	int ret;
+
+	len = hexport_r(htab, '\0', 0, &res, 0, 0, NULL);
+	if (len < 0)
+		return -ENOMEM;
+	if (journal_start(jnl) + journal_rec_size(jnl, len) > jnl->size) {
+		ret = -ENOSPC;
+		goto out;
+	}
+
+	hdr.magic = ENV_JOURNAL_MAGIC;
+	hdr.seq = jnl->seq + 1;
+	hdr.crc = crc32(0, (uchar *)&hdr,
+			offsetof(struct env_journal_hdr, crc));
+
+	ret = journal_write(jnl, next, journal_start(jnl), &hdr,
+			    ENV_JOURNAL_SNAPSHOT, res, len);
+	/* on failure the current area, if any, is still intact */
+	if (ret)
+		goto out;
+	jnl->cur = next;
+	jnl->seq = hdr.seq;
+out:
+	free(res);
+
+	return ret;
+}
+
+int env_journal_save(struct env_journal *jnl, struct hsearch_data *htab)
+{
+	int ret;
+
+	if (jnl->cur >= 0 && !htab->dirty_all) {
+		ret = journal_append(jnl, htab);
+		if (ret != -ENOSPC)
+			return ret;
+	}
+
+	return journal_compact(jnl, htab);
+}
@@ -12,6 +12,7 @@
 #include <dm.h>
 #include <env.h>
 #include <env_internal.h>
+#include <env_journal.h>
 #include <flash.h>
 #include <malloc.h>
 #include <spi.h>
@@ -29,8 +30,10 @@
 #ifdef CONFIG_ENV_OFFSET_REDUND
 #define ENV_OFFSET_REDUND	CONFIG_ENV_OFFSET_REDUND
 
+#ifndef CONFIG_ENV_SF_JOURNAL
 static ulong env_offset		= CONFIG_ENV_OFFSET;
 static ulong env_new_offset	= CONFIG_ENV_OFFSET_REDUND;
+#endif
 
 #else
 
@@ -67,7 +70,115 @@ static int setup_flash_device(struct spi_flash **env_flash)
 	return 0;
 }
 
-#if defined(CONFIG_ENV_OFFSET_REDUND)
+#if defined(CONFIG_ENV_SF_JOURNAL)
+static int env_sf_journal_read(struct env_journal *jnl, ulong offset,
+			       size_t len, void *buf)
+{
+	return spi_flash_read(jnl->priv, offset, len, buf);
+}
+
+static int env_sf_journal_write(struct env_journal *jnl, ulong offset,
+				size_t len, const void *buf)
+{
+	return spi_flash_write(jnl->priv, offset, len, buf);
+}
+
+static int env_sf_journal_erase(struct env_journal *jnl, ulong offset,
+				size_t len)
+{
+	struct spi_flash *env_flash = jnl->priv;
+	u32 sect_size = CONFIG_ENV_SECT_SIZE;
+
+	if (IS_ENABLED(CONFIG_ENV_SECT_SIZE_AUTO))
+		sect_size = env_flash->mtd.erasesize;
+
+	return spi_flash_erase(env_flash, offset, roundup(len, sect_size));
+}
+
+static const struct env_journal_ops env_sf_journal_ops = {
+	.read	= env_sf_journal_read,
+	.write	= env_sf_journal_write,
+	.erase	= env_sf_journal_erase,
+};
+
+static struct env_journal env_sf_journal = {
+	.ops	= &env_sf_journal_ops,
+	.offset	= { CONFIG_ENV_OFFSET, CONFIG_ENV_OFFSET_REDUND },
+	.size	= CONFIG_ENV_SIZE,
+	.cur	= -1,
+};
+
+static void env_sf_journal_setup(struct spi_flash *env_flash)
+{
+	env_sf_journal.priv = env_flash;
+	env_sf_journal.align = max_t(uint, 4, env_flash->mtd.writesize);
+}
+
+static int env_sf_save(void)
+{
+	int ret;
+	struct spi_flash *env_flash;
+
+	ret = setup_flash_device(&env_flash);
+	if (ret)
+		return ret;
+
+	env_sf_journal_setup(env_flash);
+	puts("Writing to SPI flash...");
+	ret = env_journal_save(&env_sf_journal, &env_htab);
+	if (!ret)
+		puts("done\n");
+
+	spi_flash_free(env_flash);
+
+	return ret;
+}
+
+static int env_sf_load(void)
+{
+	int ret;
+	int read1_fail, read2_fail;
+	env_t *tmp_env1, *tmp_env2;
+	struct spi_flash *env_flash;
+
+	ret = setup_flash_device(&env_flash);
+	if (ret)
+		return ret;
+
+	env_sf_journal_setup(env_flash);
+	ret = env_journal_load(&env_sf_journal, &env_htab, H_EXTERNAL);
+	if (!ret) {
+		gd->flags |= GD_FLG_ENV_READY;
+		gd->env_valid = ENV_VALID;
+		goto out;
+	}
+
+	/*
+	 * Fall back to a redundant environment written before the journal
+	 * was enabled; the next save converts it.
+	 */
+	tmp_env1 = (env_t *)memalign(ARCH_DMA_MINALIGN, CONFIG_ENV_SIZE);
+	tmp_env2 = (env_t *)memalign(ARCH_DMA_MINALIGN, CONFIG_ENV_SIZE);
+	if (!tmp_env1 || !tmp_env2) {
+		env_set_default("malloc() failed", 0);
+		ret = -EIO;
+	} else {
+		read1_fail = spi_flash_read(env_flash, CONFIG_ENV_OFFSET,
+					    CONFIG_ENV_SIZE, tmp_env1);
+		read2_fail = spi_flash_read(env_flash, CONFIG_ENV_OFFSET_REDUND,
+					    CONFIG_ENV_SIZE, tmp_env2);
+		ret = env_import_redund((char *)tmp_env1, read1_fail,
+					(char *)tmp_env2, read2_fail,
+					H_EXTERNAL);
+	}
+	free(tmp_env1);
+	free(tmp_env2);
+out:
+	spi_flash_free(env_flash);
+
+	return ret;
+}
+#elif defined(CONFIG_ENV_OFFSET_REDUND)
 static int env_sf_save(void)
 {
 	env_t	env_new;
@@ -312,6 +423,11 @@ static int env_sf_erase(void)
 	if (ENV_OFFSET_REDUND != OFFSET_INVALID)
 		ret = spi_flash_write(env_flash, ENV_OFFSET_REDUND, CONFIG_ENV_SIZE, &env);
 
+#if defined(CONFIG_ENV_SF_JOURNAL)
+	/* the zeroed areas are no valid journal, write a snapshot next */
+	env_sf_journal.cur = -1;
+#endif
+
 done:
 	spi_flash_free(env_flash);
 
@@ -431,7 +547,13 @@ out:
 
 static int env_sf_init(void)
 {
-	int ret = env_sf_init_addr();
+	int ret;
+
+	/* the journal can only be replayed once the heap is available */
+	if (IS_ENABLED(CONFIG_ENV_SF_JOURNAL))
+		return -ENOENT;
+
+	ret = env_sf_init_addr();
 	if (ret != -ENOENT)
 		return ret;
 #ifdef CONFIG_ENV_SPI_EARLY
@@ -6,6 +6,7 @@
  */
 
 #include <config.h>
+#include <fs.h>
 #include <malloc.h>
 #include <uuid.h>
 #include <linux/time.h>
@@ -122,7 +123,6 @@ int btrfs_probe(struct blk_desc *fs_dev_desc,
 	struct btrfs_fs_info *fs_info;
 	int ret = -1;
 
-	btrfs_hash_init();
 	fs_info = open_ctree_fs_info(fs_dev_desc, fs_partition);
 	if (fs_info) {
 		current_fs_info = fs_info;
@@ -179,27 +179,14 @@ int btrfs_exists(const char *file)
 	return 0;
 }
 
-int btrfs_size(const char *file, loff_t *size)
+/* Get the size of an inode */
+static int btrfs_ino_size(struct btrfs_root *root, u64 ino, loff_t *size)
 {
-	struct btrfs_fs_info *fs_info = current_fs_info;
 	struct btrfs_inode_item *ii;
-	struct btrfs_root *root;
 	struct btrfs_path path;
 	struct btrfs_key key;
-	u64 ino;
-	u8 type;
 	int ret;
 
-	ret = btrfs_lookup_path(fs_info->fs_root, BTRFS_FIRST_FREE_OBJECTID,
-				file, &root, &ino, &type, 40);
-	if (ret < 0) {
-		printf("Cannot lookup file %s\n", file);
-		return ret;
-	}
-	if (type != BTRFS_FT_REG_FILE) {
-		printf("Not a regular file: %s\n", file);
-		return -ENOENT;
-	}
 	btrfs_init_path(&path);
 	key.objectid = ino;
 	key.type = BTRFS_INODE_ITEM_KEY;
@@ -223,6 +210,28 @@ out:
 	return ret;
 }
 
+int btrfs_size(const char *file, loff_t *size)
+{
+	struct btrfs_fs_info *fs_info = current_fs_info;
+	struct btrfs_root *root;
+	u64 ino;
+	u8 type;
+	int ret;
+
+	ret = btrfs_lookup_path(fs_info->fs_root, BTRFS_FIRST_FREE_OBJECTID,
+				file, &root, &ino, &type, 40);
+	if (ret < 0) {
+		printf("Cannot lookup file %s\n", file);
+		return ret;
+	}
+	if (type != BTRFS_FT_REG_FILE) {
+		printf("Not a regular file: %s\n", file);
+		return -ENOENT;
+	}
+
+	return btrfs_ino_size(root, ino, size);
+}
+
 int btrfs_read(const char *file, void *buf, loff_t offset, loff_t len,
 	       loff_t *actread)
 {
@@ -268,6 +277,61 @@ int btrfs_read(const char *file, void *buf, loff_t offset, loff_t len,
 	return 0;
 }
 
+/* Information kept for a file opened with btrfs_file_open() */
+struct btrfs_open_file {
+	struct btrfs_root *root;
+	u64 ino;
+};
+
+int btrfs_file_open(struct fs_file *file, const char *filename)
+{
+	struct btrfs_fs_info *fs_info = current_fs_info;
+	struct btrfs_open_file *bf;
+	struct btrfs_root *root;
+	u64 ino;
+	u8 type;
+	int ret;
+
+	ASSERT(fs_info);
+	ret = btrfs_lookup_path(fs_info->fs_root, BTRFS_FIRST_FREE_OBJECTID,
+				filename, &root, &ino, &type, 40);
+	if (ret < 0)
+		return ret;
+	if (type != BTRFS_FT_REG_FILE)
+		return -EINVAL;
+	ret = btrfs_ino_size(root, ino, &file->size);
+	if (ret)
+		return ret;
+
+	bf = malloc(sizeof(*bf));
+	if (!bf)
+		return -ENOMEM;
+	bf->root = root;
+	bf->ino = ino;
+	file->priv = bf;
+
+	return 0;
+}
+
+int btrfs_file_pread(struct fs_file *file, void *buf, loff_t offset,
+		     loff_t len, loff_t *actread)
+{
+	struct btrfs_open_file *bf = file->priv;
+	int ret;
+
+	ret = btrfs_file_read(bf->root, bf->ino, offset, len, buf);
+	if (ret < 0)
+		return ret;
+	*actread = len;
+
+	return 0;
+}
+
+void btrfs_file_close(struct fs_file *file)
+{
+	free(file->priv);
+}
+
 void btrfs_close(void)
 {
 	if (current_fs_info) {
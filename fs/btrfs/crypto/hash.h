@@ -5,7 +5,6 @@
 
 #define CRYPTO_HASH_SIZE_MAX	32
 
-void btrfs_hash_init(void);
 int hash_crc32c(const u8 *buf, size_t length, u8 *out);
 int hash_xxhash(const u8 *buf, size_t length, u8 *out);
 int hash_sha256(const u8 *buf, size_t length, u8 *out);
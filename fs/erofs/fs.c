@@ -250,6 +250,47 @@ int erofs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 	return 0;
 }
 
+int erofs_file_open(struct fs_file *file, const char *filename)
+{
+	struct erofs_inode *vi;
+	int err;
+
+	vi = malloc(sizeof(*vi));
+	if (!vi)
+		return -ENOMEM;
+	err = erofs_ilookup(filename, vi);
+	if (!err && S_ISLNK(vi->i_mode))
+		err = erofs_readlink(vi);
+	if (!err && S_ISDIR(vi->i_mode))
+		err = -EISDIR;
+	if (err) {
+		free(vi);
+		return err;
+	}
+	file->priv = vi;
+	file->size = vi->i_size;
+
+	return 0;
+}
+
+int erofs_file_pread(struct fs_file *file, void *buf, loff_t offset,
+		     loff_t len, loff_t *actread)
+{
+	int err;
+
+	err = erofs_pread(file->priv, buf, len, offset);
+	if (err)
+		return err;
+	*actread = len;
+
+	return 0;
+}
+
+void erofs_file_close(struct fs_file *file)
+{
+	free(file->priv);
+}
+
 void erofs_close(void)
 {
 	ctxt.cur_dev = NULL;
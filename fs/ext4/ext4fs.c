@@ -24,6 +24,7 @@
 #include <blk.h>
 #include <ext_common.h>
 #include <ext4fs.h>
+#include <fs.h>
 #include "ext4_common.h"
 #include <div64.h>
 #include <malloc.h>
@@ -228,6 +229,37 @@ int ext4fs_read(char *buf, loff_t offset, loff_t len, loff_t *actread)
 	return ext4fs_read_file(ext4fs_file, offset, len, buf, actread);
 }
 
+int ext4fs_file_open(struct fs_file *file, const char *filename)
+{
+	loff_t len;
+
+	if (ext4fs_open(filename, &len))
+		return -ENOENT;
+
+	/* the node now belongs to @file, so ext4fs_close() must not free it */
+	file->priv = ext4fs_file;
+	file->size = len;
+	ext4fs_file = NULL;
+	if (file->priv == &ext4fs_root->diropen)
+		return -EISDIR;
+
+	return 0;
+}
+
+int ext4fs_file_pread(struct fs_file *file, void *buf, loff_t offset,
+		      loff_t len, loff_t *actread)
+{
+	if (ext4fs_read_file(file->priv, offset, len, buf, actread))
+		return -EIO;
+
+	return 0;
+}
+
+void ext4fs_file_close(struct fs_file *file)
+{
+	free(file->priv);
+}
+
 int ext4fs_probe(struct blk_desc *fs_dev_desc,
 		 struct disk_partition *fs_partition)
 {
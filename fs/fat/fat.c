@@ -1299,6 +1299,62 @@ int fat_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
 	return ret;
 }
 
+/* Information kept for a file opened with fat_file_open() */
+typedef struct {
+	fsdata fsdata;
+	dir_entry dent;
+} fat_file;
+
+int fat_file_open(struct fs_file *file, const char *filename)
+{
+	fat_file *ff;
+	fat_itr *itr;
+	int ret;
+
+	ff = malloc(sizeof(*ff));
+	itr = malloc_cache_aligned(sizeof(fat_itr));
+	if (!ff || !itr) {
+		ret = -ENOMEM;
+		goto out_free_itr;
+	}
+	ret = fat_itr_root(itr, &ff->fsdata);
+	if (ret)
+		goto out_free_itr;
+
+	ret = fat_itr_resolve(itr, filename, TYPE_FILE);
+	if (ret) {
+		free(ff->fsdata.fatbuf);
+		goto out_free_itr;
+	}
+	ff->dent = *itr->dent;
+	file->priv = ff;
+	file->size = FAT2CPU32(ff->dent.size);
+	free(itr);
+
+	return 0;
+
+out_free_itr:
+	free(itr);
+	free(ff);
+	return ret;
+}
+
+int fat_file_pread(struct fs_file *file, void *buf, loff_t offset, loff_t len,
+		   loff_t *actread)
+{
+	fat_file *ff = file->priv;
+
+	return get_contents(&ff->fsdata, &ff->dent, offset, buf, len, actread);
+}
+
+void fat_file_close(struct fs_file *file)
+{
+	fat_file *ff = file->priv;
+
+	free(ff->fsdata.fatbuf);
+	free(ff);
+}
+
 typedef struct {
 	struct fs_dir_stream parent;
 	struct fs_dirent dirent;
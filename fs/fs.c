@@ -12,6 +12,7 @@
 #include <env.h>
 #include <lmb.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <part.h>
 #include <ext4fs.h>
@@ -36,11 +37,52 @@ static int fs_dev_part;
 static struct disk_partition fs_partition;
 static int fs_type = FS_TYPE_ANY;
 
+enum {
+	FS_MAX_MOUNTS	= 8,
+};
+
+/**
+ * struct fs_mount - a filesystem kept mounted for reading open files
+ *
+ * The filesystems keep their state (superblock, root inode, etc.) in globals,
+ * so only one can be probed at a time. A mount remembers where its filesystem
+ * is, so that it can be probed again if another filesystem has been used in
+ * the meantime. Otherwise the state is kept between reads.
+ *
+ * @desc: block device, or NULL if this entry is not in use
+ * @part: partition number, 0 for the whole device
+ * @fstype: filesystem type (FS_TYPE_...)
+ * @refcount: number of fs_mount() calls without a matching fs_umount()
+ * @gen: incremented each time the filesystem is probed, so that files can
+ *	tell when the state they hold is stale
+ */
+struct fs_mount {
+	struct blk_desc *desc;
+	int part;
+	int fstype;
+	int refcount;
+	uint gen;
+};
+
+static struct fs_mount fs_mounts[FS_MAX_MOUNTS];
+
+/* Mount whose filesystem state is currently set up, if any */
+static struct fs_mount *fs_cur_mount;
+
+/* Close the filesystem held for a mount, before probing another */
+static void fs_mount_release(void)
+{
+	if (fs_cur_mount)
+		fs_close();
+}
+
 void fs_set_type(int type)
 {
 	fs_type = type;
 }
 
+static struct fstype_info *fs_get_info(int fstype);
+
 static inline int fs_probe_unsupported(struct blk_desc *fs_dev_desc,
 				      struct disk_partition *fs_partition)
 {
@@ -179,8 +221,45 @@ struct fstype_info {
 	int (*unlink)(const char *filename);
 	int (*mkdir)(const char *dirname);
 	int (*ln)(const char *filename, const char *target);
+	/*
+	 * Open a file for reading, setting up file->priv and file->size. See
+	 * fs_file_open().
+	 */
+	int (*file_open)(struct fs_file *file, const char *filename);
+	/*
+	 * Read from an open file. The fs layer has already limited the range
+	 * to the file's size. See fs_file_pread().
+	 */
+	int (*file_pread)(struct fs_file *file, void *buf, loff_t offset,
+			  loff_t len, loff_t *actread);
+	/*
+	 * Free file->priv. This must not use the filesystem's global state,
+	 * since another filesystem may have been probed since the file was
+	 * opened.
+	 */
+	void (*file_close)(struct fs_file *file);
 };
 
+/* generic implementation of open files, looking up the path on each read */
+static int fs_file_open_generic(struct fs_file *file, const char *filename)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+
+	return info->size(filename, &file->size) ? -ENOENT : 0;
+}
+
+static int fs_file_pread_generic(struct fs_file *file, void *buf,
+				 loff_t offset, loff_t len, loff_t *actread)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+
+	return info->read(file->path, buf, offset, len, actread) ? -EIO : 0;
+}
+
+static void fs_file_close_generic(struct fs_file *file)
+{
+}
+
 static struct fstype_info fstypes[] = {
 #if CONFIG_IS_ENABLED(FS_FAT)
 	{
@@ -207,6 +286,9 @@ static struct fstype_info fstypes[] = {
 		.readdir = fat_readdir,
 		.closedir = fat_closedir,
 		.ln = fs_ln_unsupported,
+		.file_open = fat_file_open,
+		.file_pread = fat_file_pread,
+		.file_close = fat_file_close,
 	},
 #endif
 
@@ -232,6 +314,9 @@ static struct fstype_info fstypes[] = {
 		.opendir = fs_opendir_unsupported,
 		.unlink = fs_unlink_unsupported,
 		.mkdir = fs_mkdir_unsupported,
+		.file_open = ext4fs_file_open,
+		.file_pread = ext4fs_file_pread,
+		.file_close = ext4fs_file_close,
 	},
 #endif
 #ifdef CONFIG_SANDBOX
@@ -251,6 +336,9 @@ static struct fstype_info fstypes[] = {
 		.unlink = fs_unlink_unsupported,
 		.mkdir = fs_mkdir_unsupported,
 		.ln = fs_ln_unsupported,
+		.file_open = fs_file_open_generic,
+		.file_pread = fs_file_pread_generic,
+		.file_close = fs_file_close_generic,
 	},
 #endif
 #ifdef CONFIG_SEMIHOSTING
@@ -270,6 +358,9 @@ static struct fstype_info fstypes[] = {
 		.unlink = fs_unlink_unsupported,
 		.mkdir = fs_mkdir_unsupported,
 		.ln = fs_ln_unsupported,
+		.file_open = fs_file_open_generic,
+		.file_pread = fs_file_pread_generic,
+		.file_close = fs_file_close_generic,
 	},
 #endif
 #ifndef CONFIG_SPL_BUILD
@@ -290,6 +381,9 @@ static struct fstype_info fstypes[] = {
 		.unlink = fs_unlink_unsupported,
 		.mkdir = fs_mkdir_unsupported,
 		.ln = fs_ln_unsupported,
+		.file_open = fs_file_open_generic,
+		.file_pread = fs_file_pread_generic,
+		.file_close = fs_file_close_generic,
 	},
 #endif
 #endif
@@ -311,6 +405,9 @@ static struct fstype_info fstypes[] = {
 		.unlink = fs_unlink_unsupported,
 		.mkdir = fs_mkdir_unsupported,
 		.ln = fs_ln_unsupported,
+		.file_open = btrfs_file_open,
+		.file_pread = btrfs_file_pread,
+		.file_close = btrfs_file_close,
 	},
 #endif
 #endif
@@ -333,6 +430,9 @@ static struct fstype_info fstypes[] = {
 		.ln = fs_ln_unsupported,
 		.unlink = fs_unlink_unsupported,
 		.mkdir = fs_mkdir_unsupported,
+		.file_open = sqfs_file_open,
+		.file_pread = sqfs_file_pread,
+		.file_close = sqfs_file_close,
 	},
 #endif
 #if IS_ENABLED(CONFIG_FS_EROFS)
@@ -354,6 +454,9 @@ static struct fstype_info fstypes[] = {
 		.ln = fs_ln_unsupported,
 		.unlink = fs_unlink_unsupported,
 		.mkdir = fs_mkdir_unsupported,
+		.file_open = erofs_file_open,
+		.file_pread = erofs_file_pread,
+		.file_close = erofs_file_close,
 	},
 #endif
 	{
@@ -372,6 +475,9 @@ static struct fstype_info fstypes[] = {
 		.unlink = fs_unlink_unsupported,
 		.mkdir = fs_mkdir_unsupported,
 		.ln = fs_ln_unsupported,
+		.file_open = fs_file_open_generic,
+		.file_pread = fs_file_pread_generic,
+		.file_close = fs_file_close_generic,
 	},
 };
 
@@ -436,6 +542,7 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 	}
 #endif
 
+	fs_mount_release();
 	part = part_get_info_by_dev_and_name_or_num(ifname, dev_part_str, &fs_dev_desc,
 						    &fs_partition, 1);
 	if (part < 0)
@@ -465,6 +572,7 @@ int fs_set_blk_dev_with_part(struct blk_desc *desc, int part)
 	struct fstype_info *info;
 	int ret, i;
 
+	fs_mount_release();
 	if (part >= 1)
 		ret = part_get_info(desc, part, &fs_partition);
 	else
@@ -491,6 +599,7 @@ void fs_close(void)
 	info->close();
 
 	fs_type = FS_TYPE_ANY;
+	fs_cur_mount = NULL;
 }
 
 int fs_uuid(char *uuid_str)
@@ -683,6 +792,161 @@ void fs_closedir(struct fs_dir_stream *dirs)
 	fs_close();
 }
 
+/* Set up the filesystem state for a mount, probing it again if needed */
+static int fs_mount_activate(struct fs_mount *mnt)
+{
+	if (fs_cur_mount == mnt)
+		return 0;
+	if (fs_set_blk_dev_with_part(mnt->desc, mnt->part))
+		return -ENODEV;
+	mnt->fstype = fs_type;
+	mnt->gen++;
+	fs_cur_mount = mnt;
+
+	return 0;
+}
+
+int fs_mount(struct blk_desc *desc, int part, struct fs_mount **mntp)
+{
+	struct fs_mount *mnt, *found = NULL;
+	int ret;
+
+	/* use the existing mount if there is one, else an unused entry */
+	for (mnt = fs_mounts; mnt < fs_mounts + FS_MAX_MOUNTS; mnt++) {
+		if (mnt->desc == desc && mnt->part == part) {
+			found = mnt;
+			break;
+		}
+		if (!mnt->refcount && (!found || found->desc))
+			found = mnt;
+	}
+	if (!found)
+		return -ENOSPC;
+	mnt = found;
+	if (mnt->desc != desc || mnt->part != part) {
+		if (fs_cur_mount == mnt)
+			fs_close();
+		mnt->desc = desc;
+		mnt->part = part;
+	}
+
+	ret = fs_mount_activate(mnt);
+	if (ret) {
+		if (!mnt->refcount)
+			mnt->desc = NULL;
+		return ret;
+	}
+	mnt->refcount++;
+	*mntp = mnt;
+
+	return 0;
+}
+
+void fs_umount(struct fs_mount *mnt)
+{
+	if (!mnt || --mnt->refcount)
+		return;
+
+	/*
+	 * Drop the filesystem state and the entry, since nothing stops the
+	 * block device going away once it is no longer mounted. The
+	 * generation is kept, so any stale file state is still detected.
+	 */
+	if (fs_cur_mount == mnt)
+		fs_close();
+	mnt->desc = NULL;
+}
+
+/* Make sure that the file's state matches the current filesystem state */
+static int fs_file_activate(struct fs_file *file)
+{
+	struct fs_mount *mnt = file->mnt;
+	struct fstype_info *info;
+	int ret;
+
+	ret = fs_mount_activate(mnt);
+	if (ret)
+		return ret;
+	if (file->gen == mnt->gen)
+		return 0;
+
+	info = fs_get_info(mnt->fstype);
+	if (file->gen) {
+		info->file_close(file);
+		file->priv = NULL;
+		file->gen = 0;
+	}
+	ret = info->file_open(file, file->path);
+	if (ret)
+		return ret;
+	file->gen = mnt->gen;
+
+	return 0;
+}
+
+int fs_file_open(struct fs_mount *mnt, const char *filename,
+		 struct fs_file **filep)
+{
+	struct fs_file *file;
+	int ret;
+
+	file = calloc(1, sizeof(*file) + strlen(filename) + 1);
+	if (!file)
+		return -ENOMEM;
+	strcpy(file->path, filename);
+	file->mnt = mnt;
+
+	ret = fs_file_activate(file);
+	if (ret) {
+		free(file);
+		return ret;
+	}
+	*filep = file;
+
+	return 0;
+}
+
+int fs_file_pread(struct fs_file *file, void *buf, loff_t offset, loff_t len,
+		  loff_t *actread)
+{
+	struct fstype_info *info;
+	int ret;
+
+	*actread = 0;
+	ret = fs_file_activate(file);
+	if (ret)
+		return ret;
+	if (offset >= file->size || !len)
+		return 0;
+	if (len > file->size - offset)
+		len = file->size - offset;
+
+	info = fs_get_info(file->mnt->fstype);
+
+	return info->file_pread(file, buf, offset, len, actread);
+}
+
+int fs_file_size(struct fs_file *file, loff_t *size)
+{
+	int ret;
+
+	ret = fs_file_activate(file);
+	if (ret)
+		return ret;
+	*size = file->size;
+
+	return 0;
+}
+
+void fs_file_close(struct fs_file *file)
+{
+	if (!file)
+		return;
+	if (file->gen)
+		fs_get_info(file->mnt->fstype)->file_close(file);
+	free(file);
+}
+
 int fs_unlink(const char *filename)
 {
 	int ret;
@@ -1307,35 +1307,38 @@ static int sqfs_get_lregfile_info(struct squashfs_lreg_inode *lreg,
 	return datablk_count;
 }
 
-int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
-	      loff_t *actread)
+/**
+ * struct sqfs_file - Information about a regular file, used to read it
+ *
+ * @finfo: File information, including the size of each data block
+ * @frag_entry: Fragment holding the end of the file, if finfo.frag is true
+ * @datablk_count: Number of data blocks (not including any fragment)
+ */
+struct sqfs_file {
+	struct squashfs_file_info finfo;
+	struct squashfs_fragment_block_entry frag_entry;
+	int datablk_count;
+};
+
+/*
+ * Look up a regular file, following symlinks. On success the caller must free
+ * sqf->finfo.blk_sizes
+ */
+static int sqfs_lookup_file(const char *filename, struct sqfs_file *sqf)
 {
-	char *dir = NULL, *fragment_block, *datablock = NULL;
-	char *fragment = NULL, *file = NULL, *resolved, *data;
-	u64 start, n_blks, table_size, data_offset, table_offset, sparse_size;
-	int ret, j, i_number, datablk_count = 0;
 	struct squashfs_super_block *sblk = ctxt.sblk;
-	struct squashfs_fragment_block_entry frag_entry;
-	struct squashfs_file_info finfo = {0};
 	struct squashfs_symlink_inode *symlink;
 	struct fs_dir_stream *dirsp = NULL;
 	struct squashfs_dir_stream *dirs;
 	struct squashfs_lreg_inode *lreg;
 	struct squashfs_base_inode *base;
 	struct squashfs_reg_inode *reg;
-	unsigned long dest_len;
+	char *dir = NULL, *file = NULL, *resolved;
 	struct fs_dirent *dent;
 	unsigned char *ipos;
+	int ret, i_number;
 
-	*actread = 0;
-
-	if (offset) {
-		/*
-		 * TODO: implement reading at an offset in file
-		 */
-		printf("Error: reading at a specific offset in a squashfs file is not supported yet.\n");
-		return -EINVAL;
-	}
+	memset(sqf, '\0', sizeof(*sqf));
 
 	/*
 	 * sqfs_opendir will uncompress inode and directory tables, and will
@@ -1361,7 +1364,6 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 
 	if (ret) {
 		printf("File not found.\n");
-		*actread = 0;
 		ret = -ENOENT;
 		goto out;
 	}
@@ -1374,34 +1376,36 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 	switch (get_unaligned_le16(&base->inode_type)) {
 	case SQFS_REG_TYPE:
 		reg = (struct squashfs_reg_inode *)ipos;
-		datablk_count = sqfs_get_regfile_info(reg, &finfo, &frag_entry,
-						      sblk->block_size);
-		if (datablk_count < 0) {
+		ret = sqfs_get_regfile_info(reg, &sqf->finfo, &sqf->frag_entry,
+					    sblk->block_size);
+		if (ret < 0) {
 			ret = -EINVAL;
 			goto out;
 		}
+		sqf->datablk_count = ret;
 
-		memcpy(finfo.blk_sizes, ipos + sizeof(*reg),
-		       datablk_count * sizeof(u32));
+		memcpy(sqf->finfo.blk_sizes, ipos + sizeof(*reg),
+		       sqf->datablk_count * sizeof(u32));
 		break;
 	case SQFS_LREG_TYPE:
 		lreg = (struct squashfs_lreg_inode *)ipos;
-		datablk_count = sqfs_get_lregfile_info(lreg, &finfo,
-						       &frag_entry,
-						       sblk->block_size);
-		if (datablk_count < 0) {
+		ret = sqfs_get_lregfile_info(lreg, &sqf->finfo,
+					     &sqf->frag_entry,
+					     sblk->block_size);
+		if (ret < 0) {
 			ret = -EINVAL;
 			goto out;
 		}
+		sqf->datablk_count = ret;
 
-		memcpy(finfo.blk_sizes, ipos + sizeof(*lreg),
-		       datablk_count * sizeof(u32));
+		memcpy(sqf->finfo.blk_sizes, ipos + sizeof(*lreg),
+		       sqf->datablk_count * sizeof(u32));
 		break;
 	case SQFS_SYMLINK_TYPE:
 	case SQFS_LSYMLINK_TYPE:
 		symlink = (struct squashfs_symlink_inode *)ipos;
 		resolved = sqfs_resolve_symlink(symlink, filename);
-		ret = sqfs_read(resolved, buf, offset, len, actread);
+		ret = sqfs_lookup_file(resolved, sqf);
 		free(resolved);
 		goto out;
 	case SQFS_BLKDEV_TYPE:
@@ -1417,46 +1421,61 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 		ret = -EINVAL;
 		goto out;
 	}
+	ret = 0;
 
-	/* If the user specifies a length, check its sanity */
-	if (len) {
-		if (len > finfo.size) {
-			ret = -EINVAL;
-			goto out;
-		}
+out:
+	free(file);
+	free(dir);
+	sqfs_closedir(dirsp);
 
-		finfo.size = len;
-	} else {
-		len = finfo.size;
-	}
+	return ret;
+}
+
+/* Read part of a file from the disk, given its location */
+static int sqfs_read_range(const struct sqfs_file *sqf, void *buf,
+			   loff_t offset, loff_t len, loff_t *actread)
+{
+	struct squashfs_super_block *sblk = ctxt.sblk;
+	const struct squashfs_file_info *finfo = &sqf->finfo;
+	const struct squashfs_fragment_block_entry *frag_entry;
+	u64 start, n_blks, table_size, data_offset, table_offset;
+	char *data_buffer = NULL, *datablock = NULL, *fragment = NULL;
+	char *fragment_block, *data;
+	u32 blksz = get_unaligned_le32(&sblk->block_size);
+	unsigned long dest_len;
+	loff_t pos = offset, end = offset + len, skip;
+	int ret = 0, j;
+
+	*actread = 0;
+
+	/* find the first data block needed */
+	data_offset = finfo->start;
+	for (j = 0; j < sqf->datablk_count && (u64)(j + 1) * blksz <= pos; j++)
+		data_offset += SQFS_BLOCK_SIZE(finfo->blk_sizes[j]);
 
-	if (datablk_count) {
-		data_offset = finfo.start;
-		datablock = malloc(get_unaligned_le32(&sblk->block_size));
+	if (j < sqf->datablk_count) {
+		datablock = malloc(blksz);
 		if (!datablock) {
 			ret = -ENOMEM;
 			goto out;
 		}
 	}
 
-	for (j = 0; j < datablk_count; j++) {
-		char *data_buffer;
+	for (; j < sqf->datablk_count && pos < end; j++) {
+		skip = pos - (loff_t)j * blksz;
+		table_size = SQFS_BLOCK_SIZE(finfo->blk_sizes[j]);
 
-		start = data_offset / ctxt.cur_dev->blksz;
-		table_size = SQFS_BLOCK_SIZE(finfo.blk_sizes[j]);
-		table_offset = data_offset - (start * ctxt.cur_dev->blksz);
-		n_blks = DIV_ROUND_UP(table_size + table_offset,
-				      ctxt.cur_dev->blksz);
-
-		/* Don't load any data for sparse blocks */
-		if (finfo.blk_sizes[j] == 0) {
-			n_blks = 0;
-			table_offset = 0;
-			data_buffer = NULL;
+		if (!finfo->blk_sizes[j]) {
+			/* This is a sparse block */
 			data = NULL;
+			dest_len = blksz;
 		} else {
-			data_buffer = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-
+			start = data_offset / ctxt.cur_dev->blksz;
+			table_offset = data_offset - (start * ctxt.cur_dev->blksz);
+			n_blks = DIV_ROUND_UP(table_size + table_offset,
+					      ctxt.cur_dev->blksz);
+			data_buffer = malloc_cache_aligned(n_blks *
+							   ctxt.cur_dev->blksz);
 			if (!data_buffer) {
 				ret = -ENOMEM;
 				goto out;
@@ -1472,53 +1491,50 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 				printf("Error: too many data blocks to be read.\n");
 				goto out;
 			}
-
 			data = data_buffer + table_offset;
-		}
 
-		/* Load the data */
-		if (finfo.blk_sizes[j] == 0) {
-			/* This is a sparse block */
-			sparse_size = get_unaligned_le32(&sblk->block_size);
-			if ((*actread + sparse_size) > len)
-				sparse_size = len - *actread;
-			memset(buf + *actread, 0, sparse_size);
-			*actread += sparse_size;
-		} else if (SQFS_COMPRESSED_BLOCK(finfo.blk_sizes[j])) {
-			dest_len = get_unaligned_le32(&sblk->block_size);
-			ret = sqfs_decompress(&ctxt, datablock, &dest_len,
-					      data, table_size);
-			if (ret)
-				goto out;
+			if (SQFS_COMPRESSED_BLOCK(finfo->blk_sizes[j])) {
+				dest_len = blksz;
+				ret = sqfs_decompress(&ctxt, datablock, &dest_len,
+						      data, table_size);
+				if (ret)
+					goto out;
+				data = datablock;
+			} else {
+				dest_len = table_size;
+			}
+		}
 
-			if ((*actread + dest_len) > len)
-				dest_len = len - *actread;
-			memcpy(buf + *actread, datablock, dest_len);
-			*actread += dest_len;
-		} else {
-			if ((*actread + table_size) > len)
-				table_size = len - *actread;
-			memcpy(buf + *actread, data, table_size);
-			*actread += table_size;
+		/* Copy the part of the block which was asked for */
+		if (skip >= dest_len) {
+			ret = -EINVAL;
+			goto out;
 		}
+		dest_len = min_t(loff_t, dest_len - skip, end - pos);
+		if (data)
+			memcpy(buf + *actread, data + skip, dest_len);
+		else
+			memset(buf + *actread, 0, dest_len);
+		*actread += dest_len;
+		pos += dest_len;
 
 		data_offset += table_size;
 		free(data_buffer);
-		if (*actread >= len)
-			break;
+		data_buffer = NULL;
 	}
 
 	/*
-	 * There is no need to continue if the file is not fragmented.
+	 * There is no need to continue if the file is not fragmented, or the
+	 * fragment is not needed.
 	 */
-	if (!finfo.frag) {
-		ret = 0;
+	ret = 0;
+	if (!finfo->frag || pos >= end)
 		goto out;
-	}
 
-	start = frag_entry.start / ctxt.cur_dev->blksz;
-	table_size = SQFS_BLOCK_SIZE(frag_entry.size);
-	table_offset = frag_entry.start - (start * ctxt.cur_dev->blksz);
+	frag_entry = &sqf->frag_entry;
+	start = frag_entry->start / ctxt.cur_dev->blksz;
+	table_size = SQFS_BLOCK_SIZE(frag_entry->size);
+	table_offset = frag_entry->start - (start * ctxt.cur_dev->blksz);
 	n_blks = DIV_ROUND_UP(table_size + table_offset, ctxt.cur_dev->blksz);
 
 	fragment = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
@@ -1531,10 +1547,13 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 	ret = sqfs_disk_read(start, n_blks, fragment);
 	if (ret < 0)
 		goto out;
+	ret = 0;
 
-	/* File compressed and fragmented */
-	if (finfo.frag && finfo.comp) {
-		dest_len = get_unaligned_le32(&sblk->block_size);
+	/* the fragment holds the data after the last whole block */
+	skip = finfo->offset + pos - (loff_t)sqf->datablk_count * blksz;
+	if (finfo->comp) {
+		/* File compressed and fragmented */
+		dest_len = blksz;
 		fragment_block = malloc(dest_len);
 		if (!fragment_block) {
 			ret = -ENOMEM;
@@ -1543,35 +1562,89 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 
 		ret = sqfs_decompress(&ctxt, fragment_block, &dest_len,
 				      (void *)fragment  + table_offset,
-				      frag_entry.size);
+				      frag_entry->size);
 		if (ret) {
 			free(fragment_block);
 			goto out;
 		}
 
-		memcpy(buf + *actread, &fragment_block[finfo.offset], finfo.size - *actread);
-		*actread = finfo.size;
-
+		memcpy(buf + *actread, &fragment_block[skip], end - pos);
 		free(fragment_block);
-
-	} else if (finfo.frag && !finfo.comp) {
+	} else {
 		fragment_block = (void *)fragment + table_offset;
-
-		memcpy(buf + *actread, &fragment_block[finfo.offset], finfo.size - *actread);
-		*actread = finfo.size;
+		memcpy(buf + *actread, &fragment_block[skip], end - pos);
 	}
+	*actread += end - pos;
 
 out:
+	free(data_buffer);
 	free(fragment);
 	free(datablock);
-	free(file);
-	free(dir);
-	free(finfo.blk_sizes);
-	sqfs_closedir(dirsp);
 
 	return ret;
 }
 
+int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
+	      loff_t *actread)
+{
+	struct sqfs_file sqf;
+	int ret;
+
+	*actread = 0;
+	ret = sqfs_lookup_file(filename, &sqf);
+	if (ret)
+		goto out;
+
+	/* If the user specifies a length, check its sanity */
+	if (offset > sqf.finfo.size || len > sqf.finfo.size - offset) {
+		ret = -EINVAL;
+		goto out;
+	}
+	if (!len)
+		len = sqf.finfo.size - offset;
+
+	ret = sqfs_read_range(&sqf, buf, offset, len, actread);
+
+out:
+	free(sqf.finfo.blk_sizes);
+
+	return ret;
+}
+
+int sqfs_file_open(struct fs_file *file, const char *filename)
+{
+	struct sqfs_file *sqf;
+	int ret;
+
+	sqf = malloc(sizeof(*sqf));
+	if (!sqf)
+		return -ENOMEM;
+	ret = sqfs_lookup_file(filename, sqf);
+	if (ret) {
+		free(sqf->finfo.blk_sizes);
+		free(sqf);
+		return ret;
+	}
+	file->priv = sqf;
+	file->size = sqf->finfo.size;
+
+	return 0;
+}
+
+int sqfs_file_pread(struct fs_file *file, void *buf, loff_t offset,
+		    loff_t len, loff_t *actread)
+{
+	return sqfs_read_range(file->priv, buf, offset, len, actread);
+}
+
+void sqfs_file_close(struct fs_file *file)
+{
+	struct sqfs_file *sqf = file->priv;
+
+	free(sqf->finfo.blk_sizes);
+	free(sqf);
+}
+
 int sqfs_size(const char *filename, loff_t *size)
 {
 	struct squashfs_super_block *sblk = ctxt.sblk;
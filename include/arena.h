@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Bump-pointer allocator for objects which are freed all at once
+ */
+
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <linux/types.h>
+
+struct arena_block;
+
+/**
+ * struct arena - memory which is handed out in order and freed all at once
+ *
+ * This suits many small objects which live as long as each other, such as
+ * the nodes of a live tree. It avoids the space and time taken by a malloc()
+ * header for each object. The memory is taken from malloc() in blocks.
+ *
+ * Individual objects cannot be freed. Use arena_owns() to check whether a
+ * pointer came from an arena before passing it to free().
+ *
+ * @blocks: Blocks allocated so far, most recent first
+ * @ptr: Next free byte in the most recent block
+ * @end: End of the most recent block
+ * @block_size: Size of each block to allocate, in bytes
+ * @limit: Maximum number of bytes to take from malloc(), or 0 for no limit
+ * @total: Number of bytes taken from malloc() so far
+ * @used: Number of bytes handed out, including alignment padding
+ * @count: Number of objects handed out
+ */
+struct arena {
+	struct arena_block *blocks;
+	char *ptr;
+	char *end;
+	ulong block_size;
+	ulong limit;
+	ulong total;
+	ulong used;
+	uint count;
+};
+
+/* Alignment of each object, as with malloc() */
+#define ARENA_ALIGN	(2 * sizeof(long))
+
+/**
+ * arena_init() - Set up an arena and allocate its first block
+ *
+ * @arena: Arena to set up
+ * @block_size: Size of each block in bytes
+ * @limit: Maximum number of bytes to take from malloc(), or 0 for no limit
+ * Return: 0 if OK, -ENOMEM if the first block could not be allocated
+ */
+int arena_init(struct arena *arena, ulong block_size, ulong limit);
+
+/**
+ * arena_uninit() - Free all the memory used by an arena
+ *
+ * All objects allocated from the arena become invalid.
+ *
+ * @arena: Arena to free
+ */
+void arena_uninit(struct arena *arena);
+
+/**
+ * arena_alloc() - Allocate a zeroed object from an arena
+ *
+ * If the object does not fit in the current block, a new block is started and
+ * the space left in the old one is not used. An object which is larger than
+ * a block is given a block of its own.
+ *
+ * @arena: Arena to allocate from
+ * @size: Size of the object in bytes
+ * Return: pointer to the object, aligned to ARENA_ALIGN, or NULL if there is
+ *	no memory or the limit has been reached
+ */
+void *arena_alloc(struct arena *arena, size_t size);
+
+/**
+ * arena_owns() - Check whether an object was allocated from an arena
+ *
+ * @arena: Arena to check
+ * @ptr: Pointer to check
+ * Return: true if @ptr is within one of the arena's blocks
+ */
+bool arena_owns(const struct arena *arena, const void *ptr);
+
+#endif
@@ -63,6 +63,19 @@ struct bootdev_ops {
 	 */
 	int (*get_bootflow)(struct udevice *dev, struct bootflow_iter *iter,
 			    struct bootflow *bflow);
+
+	/**
+	 * start() - start preparing the media, without waiting (optional)
+	 *
+	 * This kicks off any slow hardware setup (e.g. card identification)
+	 * so that it can proceed while other bootdevs are being scanned. It
+	 * must not wait for the setup to complete; get_bootflow() does that.
+	 *
+	 * @dev:	Bootflow device to start
+	 * Return: 0 if OK, -ENOMEDIUM if there is no media present, other
+	 *	-ve value on other error
+	 */
+	int (*start)(struct udevice *dev);
 };
 
 #define bootdev_get_ops(dev)  ((struct bootdev_ops *)(dev)->driver->ops)
@@ -80,6 +93,17 @@ struct bootdev_ops {
 int bootdev_get_bootflow(struct udevice *dev, struct bootflow_iter *iter,
 			 struct bootflow *bflow);
 
+/**
+ * bootdev_start() - start preparing the media for a bootdev
+ *
+ * See struct bootdev_ops for details.
+ *
+ * @dev:	Bootflow device to start (must be probed)
+ * Return: 0 if OK, -ENOSYS if the bootdev does not support this, -ENOMEDIUM
+ *	if there is no media present, other -ve value on other error
+ */
+int bootdev_start(struct udevice *dev);
+
 /**
  * bootdev_bind() - Bind a new named bootdev device
  *
@@ -77,12 +77,19 @@ struct bootflow {
  * @BOOTFLOWF_SHOW: Show each bootdev before scanning it
  * @BOOTFLOWF_ALL: Return bootflows with errors as well
  * @BOOTFLOWF_SINGLE_DEV: Just scan one bootmeth
+ * @BOOTFLOWF_PARALLEL: Start all bootdevs before scanning, so that their media
+ *	is prepared at the same time, and skip those with no media. Only
+ *	bootdevs with a start() method (currently MMC) are affected
+ * @BOOTFLOWF_CACHE: Try the bootflow recorded by bootflow_cache_set() before
+ *	scanning, and return it first if it is still there
  */
 enum bootflow_flags_t {
 	BOOTFLOWF_FIXED		= 1 << 0,
 	BOOTFLOWF_SHOW		= 1 << 1,
 	BOOTFLOWF_ALL		= 1 << 2,
 	BOOTFLOWF_SINGLE_DEV	= 1 << 3,
+	BOOTFLOWF_PARALLEL	= 1 << 4,
+	BOOTFLOWF_CACHE		= 1 << 5,
 };
 
 /**
@@ -118,6 +125,11 @@ enum bootflow_flags_t {
  * @num_methods: Number of bootmeth devices in @method_order
  * @cur_method: Current method number, an index into @method_order
  * @method_order: List of bootmeth devices to use, in order
+ * @pending: true if the current item has not been checked yet, because the
+ *	cached bootflow was returned in its place (see BOOTFLOWF_CACHE)
+ * @cache_dev: Bootdev of the cached bootflow returned by the scan, NULL if none
+ * @cache_part: Partition number of the cached bootflow
+ * @cache_method: Bootmeth of the cached bootflow
  */
 struct bootflow_iter {
 	int flags;
@@ -132,6 +144,10 @@ struct bootflow_iter {
 	int num_methods;
 	int cur_method;
 	struct udevice **method_order;
+	bool pending;
+	struct udevice *cache_dev;
+	int cache_part;
+	struct udevice *cache_method;
 };
 
 /**
@@ -209,6 +225,36 @@ int bootflow_scan_first(struct bootflow_iter *iter, int flags,
  */
 int bootflow_scan_next(struct bootflow_iter *iter, struct bootflow *bflow);
 
+/**
+ * bootflow_cache_set() - Record a bootflow so the next scan can try it first
+ *
+ * This stores the bootdev, partition, bootmeth and filename of the bootflow in
+ * the "bootflow_cache" environment variable, along with the UUID of the
+ * partition. A later scan with BOOTFLOWF_CACHE checks this bootflow before any
+ * others and returns it if the partition UUID and filename still match, so the
+ * scan of everything before it is skipped.
+ *
+ * The environment is not saved; the caller should do that if needed.
+ *
+ * @bflow:	Bootflow to record, which must be valid
+ * Return: 1 if the cache was updated, 0 if it already held this bootflow,
+ *	-ve on error
+ */
+int bootflow_cache_set(const struct bootflow *bflow);
+
+/**
+ * bootflow_cache_save() - Record a bootflow and save it for the next boot
+ *
+ * This calls bootflow_cache_set() and saves the environment if the cache
+ * changed, using env_save_if_only(). If other variables have unsaved changes,
+ * the cache is only updated in memory.
+ *
+ * @bflow:	Bootflow to record, which must be valid
+ * Return: 0 if OK, -EBUSY if the environment has other unsaved changes,
+ *	other -ve on error
+ */
+int bootflow_cache_save(const struct bootflow *bflow);
+
 /**
  * bootflow_first_glob() - Get the first bootflow from the global list
  *
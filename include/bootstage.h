@@ -234,12 +234,120 @@ ulong timer_get_boot_us(void);
 void show_boot_progress(int val);
 #endif
 
+/**
+ * enum bootstage_span_type - Type of a bootstage span
+ *
+ * @BOOTSTAGE_SPAN_MARK: A bootstage mark (only used in the stash, with a zero
+ *	duration)
+ * @BOOTSTAGE_SPAN_PROBE: Probing a device, see device_probe()
+ * @BOOTSTAGE_SPAN_BLK_READ: Reading from a block device, see blk_dread()
+ * @BOOTSTAGE_SPAN_NET: Running a network operation, see net_loop()
+ * @BOOTSTAGE_SPAN_PROBE_FAIL: Probing a device which failed
+ */
+enum bootstage_span_type {
+	BOOTSTAGE_SPAN_MARK,
+	BOOTSTAGE_SPAN_PROBE,
+	BOOTSTAGE_SPAN_BLK_READ,
+	BOOTSTAGE_SPAN_NET,
+	BOOTSTAGE_SPAN_PROBE_FAIL,
+
+	BOOTSTAGE_SPAN_TYPE_COUNT,
+};
+
+enum {
+	BOOTSTAGE_VERSION	= 0,
+	BOOTSTAGE_MAGIC		= 0xb00757a3,
+	BOOTSTAGE_SPAN_MAGIC	= 0xb0075a45,
+
+	BOOTSTAGE_SPAN_NAME_LEN	= 24,
+};
+
+/**
+ * struct bootstage_hdr - Header of stashed bootstage data
+ *
+ * This is followed by the records and their names. If spans are enabled,
+ * the data ends with an array of struct bootstage_span (aligned to 4 bytes)
+ * and a struct bootstage_span_tail, so that the span array can be found by
+ * looking at the end of the data (@size bytes from the start).
+ */
+struct bootstage_hdr {
+	uint32_t version;	/* BOOTSTAGE_VERSION */
+	uint32_t count;		/* Number of records */
+	uint32_t size;		/* Total data size (non-zero if valid) */
+	uint32_t magic;		/* Magic number */
+	uint32_t next_id;	/* Next ID to use for bootstage */
+};
+
+/**
+ * struct bootstage_span - A timed operation, such as probing a device
+ *
+ * This has the same layout on all architectures so that it can be read by
+ * tools such as proftool.
+ *
+ * @start_us: Start time in microseconds
+ * @duration_us: Duration in microseconds
+ * @bytes: Number of bytes transferred, 0 if not applicable
+ * @type: Type of span (enum bootstage_span_type)
+ * @name: Name, e.g. of the device, nul-terminated (truncated if needed)
+ */
+struct bootstage_span {
+	uint32_t start_us;
+	uint32_t duration_us;
+	uint32_t bytes;
+	uint32_t type;
+	char name[BOOTSTAGE_SPAN_NAME_LEN];
+};
+
+/** struct bootstage_span_tail - End of stashed bootstage data with spans */
+struct bootstage_span_tail {
+	uint32_t count;		/* Number of spans before this tail */
+	uint32_t magic;		/* BOOTSTAGE_SPAN_MAGIC */
+};
+
 #if !defined(USE_HOSTCC)
 #if CONFIG_IS_ENABLED(BOOTSTAGE)
 #define ENABLE_BOOTSTAGE
 #endif
 #endif
 
+#if defined(ENABLE_BOOTSTAGE) && CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+
+/**
+ * bootstage_span_start() - Get the start time for a span
+ *
+ * Return: current time in microseconds, to pass to bootstage_span_end()
+ */
+static inline ulong bootstage_span_start(void)
+{
+	return timer_get_boot_us();
+}
+
+/**
+ * bootstage_span_end() - Record a span which finishes now
+ *
+ * If the span table is full, the span is dropped and counted as overflowed.
+ *
+ * @type: Type of span (enum bootstage_span_type)
+ * @name: Name of the span, e.g. the device name (copied, may be NULL)
+ * @start_us: Start time, as returned by bootstage_span_start()
+ * @bytes: Number of bytes transferred, 0 if not applicable
+ */
+void bootstage_span_end(enum bootstage_span_type type, const char *name,
+			ulong start_us, ulong bytes);
+
+#else
+static inline ulong bootstage_span_start(void)
+{
+	return 0;
+}
+
+static inline void bootstage_span_end(enum bootstage_span_type type,
+				      const char *name, ulong start_us,
+				      ulong bytes)
+{
+}
+#endif
+
 #ifdef ENABLE_BOOTSTAGE
 
 /* This is the full bootstage implementation */
@@ -362,6 +470,14 @@ int bootstage_get_size(void);
  */
 int bootstage_init(bool first);
 
+/**
+ * bootstage_uninit() - Free the bootstage data
+ *
+ * This frees the data set up by bootstage_init(), including any spans, e.g.
+ * so that a test can record into a clean table and then put back the old one.
+ */
+void bootstage_uninit(void);
+
 #else
 static inline ulong bootstage_add_record(enum bootstage_id id,
 		const char *name, int flags, ulong mark)
@@ -433,6 +549,10 @@ static inline int bootstage_init(bool first)
 	return 0;
 }
 
+static inline void bootstage_uninit(void)
+{
+}
+
 #endif /* ENABLE_BOOTSTAGE */
 
 /* Helper macro for adding a bootstage to a line of code */
@@ -10,6 +10,7 @@
 
 struct blk_desc;
 struct disk_partition;
+struct fs_file;
 
 int btrfs_probe(struct blk_desc *fs_dev_desc,
 		struct disk_partition *fs_partition);
@@ -18,6 +19,10 @@ int btrfs_exists(const char *);
 int btrfs_size(const char *, loff_t *);
 int btrfs_read(const char *, void *, loff_t, loff_t, loff_t *);
 void btrfs_close(void);
+int btrfs_file_open(struct fs_file *file, const char *filename);
+int btrfs_file_pread(struct fs_file *file, void *buf, loff_t offset,
+		     loff_t len, loff_t *actread);
+void btrfs_file_close(struct fs_file *file);
 int btrfs_uuid(char *);
 void btrfs_list_subvols(void);
 
@@ -230,6 +230,63 @@ void device_free(struct udevice *dev);
 static inline void device_free(struct udevice *dev) {}
 #endif
 
+/**
+ * device_alloc_data() - Allocate zeroed platform or private data for a device
+ *
+ * If CONFIG_DM_ARENA is enabled, the arena is enabled (see dm_arena_enable())
+ * and the device is not removed before booting an OS, this uses the
+ * driver-model arena, else calloc()
+ *
+ * @dev: Device which needs the data (only its driver is used)
+ * @size: Number of bytes to allocate
+ * Return: pointer to the data, or NULL if out of memory
+ */
+void *device_alloc_data(struct udevice *dev, int size);
+
+/**
+ * device_free_data() - Free data allocated by device_alloc_data()
+ *
+ * Data from the arena is not freed, since it cannot be reused
+ *
+ * @ptr: Data to free
+ */
+void device_free_data(void *ptr);
+
+/**
+ * dm_arena_init() - Set up the arena for device data
+ *
+ * This does nothing before relocation or if CONFIG_DM_ARENA is not enabled.
+ *
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+int dm_arena_init(void);
+
+/**
+ * dm_arena_uninit() - Free the arena for device data
+ *
+ * This must only be called once all devices have been unbound.
+ */
+void dm_arena_uninit(void);
+
+/**
+ * dm_arena_enable() - Select whether device data comes from the arena
+ *
+ * Space in the arena is not reclaimed when a device is unbound, so this is
+ * only enabled while the devices present at start-up are bound. Devices bound
+ * or probed after that use calloc(), so they can be unbound and bound again
+ * without using up the arena.
+ *
+ * @enable: true to use the arena, false to use calloc()
+ */
+void dm_arena_enable(bool enable);
+
+/**
+ * dm_arena_used() - Get the number of bytes used in the arena
+ *
+ * Return: bytes handed out from the arena, or 0 if there is no arena
+ */
+ulong dm_arena_used(void);
+
 /**
  * device_chld_unbind() - Unbind all device's children from the device if bound
  *			  to drv
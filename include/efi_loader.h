@@ -257,6 +257,8 @@ extern const efi_guid_t efi_guid_host_dev;
 #endif
 /* GUID of the EFI_BLOCK_IO_PROTOCOL */
 extern const efi_guid_t efi_block_io_guid;
+/* GUID of the EFI_BLOCK_IO2_PROTOCOL */
+extern const efi_guid_t efi_block_io2_guid;
 extern const efi_guid_t efi_global_variable_guid;
 extern const efi_guid_t efi_guid_console_control;
 extern const efi_guid_t efi_guid_device_path;
@@ -735,6 +737,8 @@ efi_status_t efi_setup_loaded_image(struct efi_device_path *device_path,
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 extern void *efi_bounce_buffer;
 #define EFI_LOADER_BOUNCE_BUFFER_SIZE (64 * 1024 * 1024)
+/* Highest address which devices needing the bounce buffer can access */
+#define EFI_LOADER_BOUNCE_BUFFER_LIMIT 0xffffffffULL
 #endif
 
 /* shorten device path */
@@ -276,6 +276,20 @@ int env_reload(void);
  */
 int env_save(void);
 
+/**
+ * env_save_if_only() - Save the environment if only one variable has changed
+ *
+ * Saving writes out every variable, so this only saves if no variable other
+ * than @var has been changed since the environment was loaded or last saved,
+ * so that changes the user has not chosen to keep are not made permanent.
+ * Variables which U-Boot sets itself when loading a file (filesize and
+ * fileaddr) do not count.
+ *
+ * @var: Name of the variable which may have changed
+ * Return: 0 if OK, -EBUSY if other variables have changed, other -ve on error
+ */
+int env_save_if_only(const char *var);
+
 /**
  * env_erase() - Erase the environment on storage
  *
@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Append-only journal for storing the environment on flash
+ */
+
+#ifndef __ENV_JOURNAL_H__
+#define __ENV_JOURNAL_H__
+
+#include <linux/types.h>
+
+struct hsearch_data;
+struct env_journal;
+
+/*
+ * The journal uses two areas of equal size which are erased alternately.
+ * Each area starts with a header, followed by a snapshot record holding the
+ * complete environment and any number of delta records, each holding the
+ * variables changed by one 'saveenv':
+ *
+ *	header | snapshot | delta | delta | ... | erased
+ *
+ * Every record (header and payload) is protected by a CRC32, so a record
+ * torn by a power failure is detected and replay stops before it. When a
+ * delta does not fit any more, a new snapshot is written to the other area
+ * with an incremented sequence number; the older area stays valid until then.
+ *
+ * Record payloads use the usual "name=value\0" format; a deleted variable is
+ * stored as "name\0". Records are padded to the write alignment with 0xff.
+ */
+#define ENV_JOURNAL_MAGIC	0x4c4e4a45	/* "EJNL" */
+
+enum env_journal_rec_type {
+	ENV_JOURNAL_SNAPSHOT	= 1,
+	ENV_JOURNAL_DELTA,
+};
+
+/** struct env_journal_hdr - Header at the start of each area */
+struct env_journal_hdr {
+	u32 magic;
+	u32 seq;	/* incremented each time an area is rewritten */
+	u32 crc;	/* CRC32 of the fields above */
+};
+
+/** struct env_journal_rec - Header of each record */
+struct env_journal_rec {
+	u32 type;	/* enum env_journal_rec_type, ~0 if erased */
+	u32 len;	/* length of the payload following this header */
+	u32 crc;	/* CRC32 of type, len and the payload */
+};
+
+/**
+ * struct env_journal_ops - Access to the underlying storage
+ *
+ * All methods return 0 if OK, -ve on error. Offsets are absolute.
+ */
+struct env_journal_ops {
+	int (*read)(struct env_journal *jnl, ulong offset, size_t len,
+		    void *buf);
+	int (*write)(struct env_journal *jnl, ulong offset, size_t len,
+		     const void *buf);
+	int (*erase)(struct env_journal *jnl, ulong offset, size_t len);
+};
+
+/**
+ * struct env_journal - State of an environment journal
+ *
+ * @ops: Storage operations
+ * @priv: Private data for @ops
+ * @offset: Offset of the two areas
+ * @size: Size of each area, a multiple of the erase size
+ * @align: Write alignment of records, at least 4
+ * @cur: Index of the area currently in use, -1 if none
+ * @seq: Sequence number of the current area
+ * @pos: Offset of the first free byte in the current area
+ */
+struct env_journal {
+	const struct env_journal_ops *ops;
+	void *priv;
+	ulong offset[2];
+	size_t size;
+	uint align;
+	int cur;
+	u32 seq;
+	ulong pos;
+};
+
+/**
+ * env_journal_load() - Replay the journal into a hash table
+ *
+ * The most recent valid area is replayed, stopping at the first damaged
+ * record. On success all entries of @htab are marked clean.
+ *
+ * @jnl: Journal to load
+ * @htab: Hash table to import into
+ * @flag: Flags for himport_r(), e.g. H_EXTERNAL
+ * Return: 0 if OK, -ENOMSG if no valid area was found, -ENOMEM if out of
+ *	memory, -EIO on import or read error
+ */
+int env_journal_load(struct env_journal *jnl, struct hsearch_data *htab,
+		     int flag);
+
+/**
+ * env_journal_save() - Save changes of a hash table to the journal
+ *
+ * If possible only the entries marked dirty in @htab are appended. A new
+ * snapshot is written to the other area if there is no current area, the
+ * current area is full or @htab->dirty_all is set.
+ *
+ * @jnl: Journal to write to
+ * @htab: Hash table to save
+ * Return: 0 if OK, -ENOSPC if the environment does not fit into an area,
+ *	-ENOMEM if out of memory, other -ve on storage error
+ */
+int env_journal_save(struct env_journal *jnl, struct hsearch_data *htab);
+
+#endif /* __ENV_JOURNAL_H__ */
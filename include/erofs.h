@@ -3,6 +3,7 @@
 #define _EROFS_H_
 
 struct disk_partition;
+struct fs_file;
 
 int erofs_opendir(const char *filename, struct fs_dir_stream **dirsp);
 int erofs_readdir(struct fs_dir_stream *dirs, struct fs_dirent **dentp);
@@ -13,6 +14,10 @@ int erofs_read(const char *filename, void *buf, loff_t offset,
 int erofs_size(const char *filename, loff_t *size);
 int erofs_exists(const char *filename);
 void erofs_close(void);
+int erofs_file_open(struct fs_file *file, const char *filename);
+int erofs_file_pread(struct fs_file *file, void *buf, loff_t offset,
+		     loff_t len, loff_t *actread);
+void erofs_file_close(struct fs_file *file);
 void erofs_closedir(struct fs_dir_stream *dirs);
 int erofs_uuid(char *uuid_str);
 
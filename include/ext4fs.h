@@ -29,6 +29,7 @@
 #include <ext_common.h>
 
 struct disk_partition;
+struct fs_file;
 
 #define EXT4_INDEX_FL		0x00001000 /* Inode uses hash tree index */
 #define EXT4_EXTENTS_FL		0x00080000 /* Inode uses extents */
@@ -146,6 +147,10 @@ int ext4fs_create_link(const char *target, const char *fname);
 struct ext_filesystem *get_fs(void);
 int ext4fs_open(const char *filename, loff_t *len);
 int ext4fs_read(char *buf, loff_t offset, loff_t len, loff_t *actread);
+int ext4fs_file_open(struct fs_file *file, const char *filename);
+int ext4fs_file_pread(struct fs_file *file, void *buf, loff_t offset,
+		      loff_t len, loff_t *actread);
+void ext4fs_file_close(struct fs_file *file);
 int ext4fs_mount(unsigned part_length);
 void ext4fs_close(void);
 void ext4fs_reinit_global(void);
@@ -59,6 +59,23 @@ int fdt_chosen(void *fdt);
  */
 int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end);
 
+/**
+ * fdt_initrd_frame_index() - Tell the OS how to read a compressed initrd
+ *
+ * This adds the frame index of an initrd made up of independently compressed
+ * frames to the /chosen node, so that the OS can decompress the files it needs
+ * instead of the whole initrd. The offsets of the frames within the initrd
+ * follow from their compressed sizes.
+ *
+ * @fdt: FDT address in memory
+ * @comp: Compression used by the initrd, e.g. "zstd"
+ * @index: Frame index, with a compressed and a decompressed size for each frame
+ * @count: Number of frames in @index
+ * Return: 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_initrd_frame_index(void *fdt, const char *comp, const fdt32_t *index,
+			   int count);
+
 void do_fixup_by_path(void *fdt, const char *path, const char *prop,
 		      const void *val, int len, int create);
 void do_fixup_by_path_u32(void *fdt, const char *path, const char *prop,
@@ -235,6 +235,92 @@ struct fs_dirent *fs_readdir(struct fs_dir_stream *dirs);
  */
 void fs_closedir(struct fs_dir_stream *dirs);
 
+struct fs_mount;
+
+/*
+ * Note: fs_file should be treated as opaque to the user of fs layer. The
+ * filesystem looks up the file once, when it is opened, then keeps what it
+ * needs to read it (inode, directory entry, block list, etc.) in @priv.
+ */
+struct fs_file {
+	/* private to fs layer: */
+	loff_t size;
+	struct fs_mount *mnt;
+	uint gen;
+	void *priv;
+	char path[];
+};
+
+/**
+ * fs_mount() - Mount the filesystem in a partition
+ *
+ * This finds the filesystem in a partition, or the mount already created for
+ * it, and keeps the mount until the last matching fs_umount(). The state read
+ * from the superblock is kept until another filesystem is used, so reading
+ * files with fs_file_pread() does not need to probe the filesystem again.
+ *
+ * @desc:	block device
+ * @part:	partition number, or 0 for the whole device
+ * @mntp:	returns the mount
+ * Return:	0 if OK, -ENODEV if no filesystem was found, -ENOSPC if there
+ *		are too many mounts
+ */
+int fs_mount(struct blk_desc *desc, int part, struct fs_mount **mntp);
+
+/**
+ * fs_umount() - Release a mount obtained from fs_mount()
+ *
+ * Any files opened on the mount must be closed first. When the last user
+ * releases the mount, the filesystem is closed and the mount is freed.
+ *
+ * @mnt:	mount to release
+ */
+void fs_umount(struct fs_mount *mnt);
+
+/**
+ * fs_file_open() - Open a file for reading
+ *
+ * @mnt:	mount containing the file
+ * @filename:	full path of the file
+ * @filep:	returns the open file, to be closed with fs_file_close()
+ * Return:	0 if OK, -ve on error (e.g. -ENOENT if the file does not exist)
+ */
+int fs_file_open(struct fs_mount *mnt, const char *filename,
+		 struct fs_file **filep);
+
+/**
+ * fs_file_pread() - Read from part of an open file
+ *
+ * This reads from the file without looking up its path again, unless
+ * another filesystem has been used since it was last read.
+ *
+ * @file:	file to read
+ * @buf:	buffer for the data
+ * @offset:	offset in the file to read from
+ * @len:	number of bytes to read
+ * @actread:	returns the number of bytes read, which is less than @len
+ *		only at the end of the file
+ * Return:	0 if OK, -ve on error
+ */
+int fs_file_pread(struct fs_file *file, void *buf, loff_t offset, loff_t len,
+		  loff_t *actread);
+
+/**
+ * fs_file_size() - Get the size of an open file
+ *
+ * @file:	open file
+ * @size:	returns the size of the file in bytes
+ * Return:	0 if OK, -ve on error
+ */
+int fs_file_size(struct fs_file *file, loff_t *size);
+
+/**
+ * fs_file_close() - Close a file opened with fs_file_open()
+ *
+ * @file:	file to close, or NULL
+ */
+void fs_file_close(struct fs_file *file);
+
 /*
  * fs_unlink - delete a file or directory
  *
@@ -83,6 +83,43 @@ struct hash_algo {
 };
 
 #ifndef USE_HOSTCC
+/**
+ * struct hash_opts - Options for hash_command_opts()
+ *
+ * @leaf_size: Size of each leaf in bytes for a tree hash, or 0 for a plain
+ *	hash. A tree hash is the hash of the concatenated hashes of each leaf
+ *	(the last one may be shorter), so that leaves can be hashed on several
+ *	CPUs at once
+ * @ifname: Interface of the block device to read from (e.g. "mmc"), or NULL
+ *	to hash memory
+ * @dev_part: Device and optional partition to read from (e.g. "0:1"), if
+ *	@ifname is not NULL. The address and count are then in blocks
+ */
+struct hash_opts {
+	ulong leaf_size;
+	const char *ifname;
+	const char *dev_part;
+};
+
+/**
+ * hash_command_opts() - Process a hash command with options
+ *
+ * This is hash_command() with support for tree hashing and for reading the
+ * data from a block device. Large ranges are hashed in chunks, showing
+ * progress, and can be interrupted with Ctrl-C.
+ *
+ * @algo_name:		Hash algorithm being used (lower case!)
+ * @flags:		Flags value (HASH_FLAG_...)
+ * @opts:		Options, or NULL to hash memory in the normal way
+ * @argc:		Number of arguments
+ * @argv:		Arguments, starting with the address
+ * Return: CMD_RET_SUCCESS if OK, CMD_RET_USAGE for invalid arguments, else
+ *	CMD_RET_FAILURE
+ */
+int hash_command_opts(const char *algo_name, int flags,
+		      const struct hash_opts *opts, int argc,
+		      char *const argv[]);
+
 /**
  * hash_command: Process a hash command for a particular algorithm
  *
@@ -854,6 +854,23 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 		 void *load_buf, void *image_buf, ulong image_len,
 		 uint unc_len, ulong *load_end);
 
+/**
+ * image_decomp_buf() - decompress a buffer
+ *
+ * This is the part of image_decomp() which does the work, without any
+ * messages. It does not handle IH_COMP_NONE.
+ *
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @load_buf:	Place to decompress to
+ * @unc_len:	Available space for decompression
+ * @image_buf:	Address to decompress from
+ * @lenp:	On entry, number of bytes in @image_buf to decompress. On exit,
+ *		number of bytes decompressed
+ * Return: 0 if OK, -ENOSYS if @comp is not supported, other value on error
+ */
+int image_decomp_buf(int comp, void *load_buf, uint unc_len, void *image_buf,
+		     ulong *lenp);
+
 /**
  * Set up properties in the FDT
  *
@@ -934,6 +951,7 @@ int booti_setup(ulong image, ulong *relocated_addr, ulong *size,
 #define FIT_COMP_PROP		"compression"
 #define FIT_ENTRY_PROP		"entry"
 #define FIT_LOAD_PROP		"load"
+#define FIT_FRAME_INDEX_PROP	"frame-index"
 
 /* configuration node */
 #define FIT_KERNEL_PROP		"kernel"
@@ -1013,6 +1031,8 @@ int fit_image_get_data_size_unciphered(const void *fit, int noffset,
 				       size_t *data_size);
 int fit_image_get_data_and_size(const void *fit, int noffset,
 				const void **data, size_t *size);
+int fit_image_get_frame_index(const void *fit, int noffset,
+			      const fdt32_t **index, int *count);
 
 int fit_image_hash_get_algo(const void *fit, int noffset, const char **algo);
 int fit_image_hash_get_value(const void *fit, int noffset, uint8_t **value,
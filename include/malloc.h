@@ -987,6 +987,138 @@ extern ulong mem_malloc_brk;
 
 void mem_malloc_init(ulong start, ulong size);
 
+/**
+ * malloc_peak_start() - Start recording the peak heap usage
+ *
+ * This is used to measure the memory needed by an operation. The heap is
+ * walked once here, then each call to malloc() and free() adjusts the usage by
+ * the size of the chunk, until malloc_peak_stop() is called.
+ */
+void malloc_peak_start(void);
+
+/**
+ * malloc_peak_stop() - Stop recording the peak heap usage
+ *
+ * Return: largest number of bytes allocated at any one time since
+ *	malloc_peak_start(), over and above those allocated at the start
+ */
+ulong malloc_peak_stop(void);
+
+/**
+ * struct malloc_info - Information about the malloc() heap
+ *
+ * @start: Start address of the heap used by dlmalloc
+ * @size: Size of the heap used by dlmalloc, in bytes
+ * @sbrked: Bytes of the heap used so far, i.e. its high-water mark
+ * @in_use: Bytes currently allocated by dlmalloc, including chunk headers
+ */
+struct malloc_info {
+	ulong start;
+	ulong size;
+	ulong sbrked;
+	ulong in_use;
+};
+
+/**
+ * malloc_get_info() - Get information about the malloc() heap
+ *
+ * This does not include the slab area; see slab_get_stats()
+ *
+ * @info: Returns the information
+ */
+void malloc_get_info(struct malloc_info *info);
+
+/* Largest request served by the slab allocator, and number of size classes */
+#define SLAB_MAX_SIZE		512
+#define SLAB_CLASS_COUNT	10
+
+/**
+ * struct slab_stats - Statistics for a slab size class
+ *
+ * @size: Size of each object in this class, in bytes
+ * @pages: Number of pages which hold objects of this class
+ * @in_use: Number of objects currently allocated
+ * @peak: Largest value of @in_use so far
+ * @allocs: Total number of allocations
+ * @fallbacks: Number of allocations passed to dlmalloc since the slab area
+ *	was full
+ */
+struct slab_stats {
+	uint size;
+	uint pages;
+	uint in_use;
+	uint peak;
+	ulong allocs;
+	ulong fallbacks;
+};
+
+/**
+ * slab_init() - Set up the slab allocator
+ *
+ * This takes space for the slab area from the top of the malloc() region.
+ *
+ * @start: Start address of the malloc() region
+ * @size: Size of the malloc() region in bytes
+ * Return: number of bytes taken from the top of the region
+ */
+ulong slab_init(ulong start, ulong size);
+
+/**
+ * slab_alloc() - Allocate a small object
+ *
+ * @bytes: Number of bytes to allocate
+ * Return: pointer to the object, or NULL if @bytes is larger than
+ *	SLAB_MAX_SIZE or there is no space
+ */
+void *slab_alloc(size_t bytes);
+
+/**
+ * slab_owns() - Check if a pointer was allocated by slab_alloc()
+ *
+ * @ptr: Pointer to check
+ * Return: true if @ptr is in the slab area
+ */
+bool slab_owns(const void *ptr);
+
+/**
+ * slab_free() - Free an object allocated by slab_alloc()
+ *
+ * @ptr: Object to free
+ */
+void slab_free(void *ptr);
+
+/**
+ * slab_usable_size() - Get the number of bytes available in an object
+ *
+ * @ptr: Object allocated by slab_alloc()
+ * Return: size of the object's size class
+ */
+size_t slab_usable_size(const void *ptr);
+
+/**
+ * slab_in_use() - Get the number of bytes allocated by the slab allocator
+ *
+ * Return: bytes allocated, counting each object as the size of its class
+ */
+ulong slab_in_use(void);
+
+/**
+ * slab_get_stats() - Get statistics for a size class
+ *
+ * @cls: Size class (0 to SLAB_CLASS_COUNT - 1)
+ * @stats: Returns the statistics
+ * Return: 0 if OK, -ENOENT if @cls is out of range
+ */
+int slab_get_stats(int cls, struct slab_stats *stats);
+
+/**
+ * slab_get_area() - Get the position of the slab area
+ *
+ * @startp: Returns the start address, or 0 if there is no slab area
+ * @sizep: Returns the size in bytes
+ */
+void slab_get_area(ulong *startp, ulong *sizep);
+
 #ifdef __cplusplus
 };  /* end of extern "C" */
 #endif
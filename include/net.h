@@ -109,6 +109,7 @@ enum eth_state_t {
  * @enetaddr: The Ethernet MAC address that is loaded from EEPROM or env
  * @phy_interface: PHY interface to use - see PHY_INTERFACE_MODE_...
  * @max_speed: Maximum speed of Ethernet connection supported by MAC
+ * @mtu: MTU to use, from the 'max-frame-size' property; 0 for ETH_DATA_LEN
  * @priv_pdata: device specific plat
  */
 struct eth_pdata {
@@ -116,9 +117,31 @@ struct eth_pdata {
 	unsigned char enetaddr[ARP_HLEN];
 	int phy_interface;
 	int max_speed;
+	int mtu;
 	void *priv_pdata;
 };
 
+/**
+ * struct eth_stats - Packet counts for an Ethernet device
+ *
+ * @rx_packets: Packets received and passed to the network stack
+ * @rx_errors: Receive calls which failed
+ * @rx_dropped: Packets dropped by the hardware for lack of a receive buffer
+ * @rx_overruns: Packets lost through receive FIFO overflow
+ * @rx_budget_full: Times eth_rx() stopped with packets possibly still waiting
+ * @tx_packets: Packets sent
+ * @tx_errors: Send calls which failed
+ */
+struct eth_stats {
+	ulong rx_packets;
+	ulong rx_errors;
+	ulong rx_dropped;
+	ulong rx_overruns;
+	ulong rx_budget_full;
+	ulong tx_packets;
+	ulong tx_errors;
+};
+
 enum eth_recv_flags {
 	/*
 	 * Check hardware device for new packets (otherwise only return those
@@ -153,6 +176,20 @@ enum eth_recv_flags {
  *		    to the network stack. This function should fill in the
  *		    eth_pdata::enetaddr field - optional
  * set_promisc: Enable or Disable promiscuous mode
+ * set_mtu: Set the largest payload which the hardware should send and
+ *	    receive, called before start(). Return -EINVAL if the hardware
+ *	    cannot handle that size. Without this, only ETH_DATA_LEN is
+ *	    supported - optional
+ * recv_batch: Collect up to "budget" received packets at once, setting
+ *	       "packets" and "lengths" for each. Return the number collected,
+ *	       0 if there are none, or an error. The packets stay in the
+ *	       driver's buffers until free_batch() is called. If provided, this
+ *	       is used instead of recv() and free_pkt() - optional
+ * free_batch: Hand back all the packets from the last recv_batch() so the
+ *	       driver can refill its receive ring in one go - required with
+ *	       recv_batch
+ * get_stats: Add the hardware's counts of lost packets to the rx_dropped and
+ *	      rx_overruns fields of "stats" - optional
  */
 struct eth_ops {
 	int (*start)(struct udevice *dev);
@@ -164,6 +201,11 @@ struct eth_ops {
 	int (*write_hwaddr)(struct udevice *dev);
 	int (*read_rom_hwaddr)(struct udevice *dev);
 	int (*set_promisc)(struct udevice *dev, bool enable);
+	int (*set_mtu)(struct udevice *dev, int mtu);
+	int (*recv_batch)(struct udevice *dev, int flags, uchar **packets,
+			  int *lengths, int budget);
+	int (*free_batch)(struct udevice *dev, uchar **packets, int count);
+	int (*get_stats)(struct udevice *dev, struct eth_stats *stats);
 };
 
 #define eth_get_ops(dev) ((struct eth_ops *)(dev)->driver->ops)
@@ -178,6 +220,18 @@ unsigned char *eth_get_ethaddr(void); /* get the current device MAC */
 
 /* Used only when NetConsole is enabled */
 int eth_is_active(struct udevice *dev); /* Test device for active state */
+
+/**
+ * eth_get_stats() - Get the packet counts for a device
+ *
+ * The counts kept by the uclass are combined with those from the hardware,
+ * if the driver provides them
+ *
+ * @dev: Ethernet device
+ * @stats: Returns the counts
+ * Return: 0 if OK, -ve on error
+ */
+int eth_get_stats(struct udevice *dev, struct eth_stats *stats);
 int eth_init_state_only(void); /* Set active state */
 void eth_halt_state_only(void); /* Set passive state */
 #endif
@@ -257,6 +311,17 @@ void eth_set_current(void);		/* set nterface to ethcur var */
 
 int eth_get_dev_index(void);		/* get the device index */
 
+/**
+ * eth_get_mtu() - Get the MTU of the current device
+ *
+ * This is ETH_DATA_LEN unless the device has been set up for larger frames,
+ * through the 'eth<n>mtu' environment variable or the device tree, up to
+ * CONFIG_NET_MTU_MAX. It is only valid once eth_init() has been called.
+ *
+ * Return: MTU in bytes
+ */
+int eth_get_mtu(void);
+
 /**
  * eth_env_set_enetaddr_by_index() - set the MAC address environment variable
  *
@@ -487,20 +552,32 @@ struct icmp_hdr {
 #define ICMP_HDR_SIZE		(sizeof(struct icmp_hdr))
 #define IP_ICMP_HDR_SIZE	(IP_HDR_SIZE + ICMP_HDR_SIZE)
 
+/* Largest MTU any interface may use */
+#ifdef CONFIG_NET_MTU_MAX
+#define NET_MTU_MAX		CONFIG_NET_MTU_MAX
+#else
+#define NET_MTU_MAX		ETH_DATA_LEN
+#endif
+
 /*
  * Maximum packet size; used to allocate packet storage. Use
- * the maxium Ethernet frame size as specified by the Ethernet
- * standard including the 802.1Q tag (VLAN tagging).
- * maximum packet size =  1522
+ * the maxium Ethernet frame size for NET_MTU_MAX, including
+ * the 802.1Q tag (VLAN tagging) and the FCS.
+ * maximum packet size for the standard MTU =  1522
  * maximum packet size and multiple of 32 bytes =  1536
  */
-#define PKTSIZE			1522
+#define PKTSIZE			(NET_MTU_MAX + VLAN_ETH_HLEN + ETH_FCS_LEN)
+/*
+ * Maximum packet size for the standard MTU, for drivers which do not support
+ * a larger one and so must not program PKTSIZE into the hardware
+ */
+#define PKTSIZE_STD		(ETH_DATA_LEN + VLAN_ETH_HLEN + ETH_FCS_LEN)
 #ifndef CONFIG_DM_DSA
-#define PKTSIZE_ALIGN		1536
+#define PKTSIZE_ALIGN		ALIGN(PKTSIZE, 32)
 #else
 /* Maximum DSA tagging overhead (headroom and/or tailroom) */
 #define DSA_MAX_OVR		256
-#define PKTSIZE_ALIGN		(1536 + DSA_MAX_OVR)
+#define PKTSIZE_ALIGN		(ALIGN(PKTSIZE, 32) + DSA_MAX_OVR)
 #endif
 
 /*
@@ -556,7 +633,8 @@ extern int		net_restart_wrap;	/* Tried all network devices */
 
 enum proto_t {
 	BOOTP, RARP, ARP, TFTPGET, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP,
-	TFTPSRV, TFTPPUT, LINKLOCAL, FASTBOOT, WOL, UDP
+	TFTPSRV, TFTPPUT, LINKLOCAL, FASTBOOT, WOL, UDP, TFTPPROBE,
+	TFTPMULTI
 };
 
 extern char	net_boot_file_name[1024];/* Boot File name */
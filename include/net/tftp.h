@@ -22,6 +22,65 @@ void tftp_start(enum proto_t protocol);	/* Begin TFTP get/put */
 void tftp_start_server(void);	/* Wait for incoming TFTP put */
 #endif
 
+#ifdef CONFIG_TFTP_PROBE
+/* Maximum number of files which can be probed at once */
+#define TFTP_PROBE_MAX	16
+
+/**
+ * tftp_probe() - Find the first of several files which exists on the server
+ *
+ * This sends a read request for every file at once, each from its own UDP
+ * port, and stops each transfer as soon as the server replies. It returns
+ * as soon as the answer is known, i.e. when a file exists and every file
+ * before it in the list is known not to exist.
+ *
+ * Filenames must not include a server address; 'serverip' is used
+ *
+ * @names: List of filenames to look for, highest priority first
+ * @count: Number of filenames in @names, at most TFTP_PROBE_MAX
+ * Return: index of the first file in @names which exists, -ENOENT if none of
+ *	them exist, -E2BIG if @count is too large, other -ve on network error
+ */
+int tftp_probe(const char *const names[], int count);
+
+void tftp_probe_start(void);	/* Begin TFTP probe (for net_loop()) */
+#endif
+
+#ifdef CONFIG_TFTP_MULTI
+/* Maximum number of files which can be fetched at once */
+#define TFTP_MULTI_MAX	8
+
+/**
+ * struct tftp_file - A file to fetch with tftp_multi()
+ *
+ * @name: Filename on the server, without a server address
+ * @addr: Address to load the file to
+ * @size: Set to the size of the file once loaded
+ */
+struct tftp_file {
+	const char *name;
+	ulong addr;
+	ulong size;
+};
+
+/**
+ * tftp_multi() - Fetch several files from the server at once
+ *
+ * This sends a read request for every file at once, each from its own UDP
+ * port, and receives the files in parallel. Each file may use the memory
+ * from its load address up to the next file's load address. 'serverip' is
+ * used for all files.
+ *
+ * @files: List of files to fetch; the size of each is updated
+ * @count: Number of files in @files, 1 to TFTP_MULTI_MAX
+ * Return: 0 if all files were loaded, -E2BIG if @count is too large, other
+ *	-ve on error
+ */
+int tftp_multi(struct tftp_file *files, int count);
+
+void tftp_multi_start(void);	/* Begin TFTP multi-get (for net_loop()) */
+#endif
+
 extern ulong tftp_timeout_ms;
 extern int tftp_timeout_count_max;
 
@@ -20,4 +20,16 @@ struct device_node;
  */
 int of_live_build(const void *fdt_blob, struct device_node **rootp);
 
+/**
+ * of_live_alloc() - Allocate memory which lasts as long as the live tree
+ *
+ * This is for small objects added to the live tree, which are never freed.
+ * The memory must not be passed to free().
+ *
+ * @size: Number of bytes to allocate
+ * Return: pointer to zeroed memory, or NULL if out of memory or the live tree
+ *	has not been built
+ */
+void *of_live_alloc(size_t size);
+
 #endif
@@ -471,6 +471,43 @@ int os_setup_signal_handlers(void);
  */
 void os_signal_action(int sig, unsigned long pc);
 
+/**
+ * os_sample_timer() - start or stop the timer for the sampling profiler
+ *
+ * While running, a SIGPROF signal is raised periodically based on the CPU time
+ * used by U-Boot. The signal handler calls os_sample_action().
+ *
+ * @hz:		number of samples per second, 0 to stop
+ * Return:	0 if OK, -ENOSYS if the host architecture is not supported,
+ *		other -ve on error
+ */
+int os_sample_timer(unsigned int hz);
+
+/**
+ * os_sample_action() - take a sample for the sampling profiler
+ *
+ * @pc:		program counter of the interrupted code
+ * @fp:		frame pointer of the interrupted code
+ * @sp:		stack pointer of the interrupted code
+ */
+void os_sample_action(unsigned long pc, unsigned long fp, unsigned long sp);
+
+/**
+ * os_parallel_run() - run a function on several host threads
+ *
+ * This calls @func once for each index from 0 to @count - 1, spread across up
+ * to @threads threads including the calling one, and waits for all calls to
+ * complete.
+ *
+ * @func:	function to call
+ * @ctx:	context to pass to @func
+ * @count:	number of calls to make
+ * @threads:	maximum number of threads to use
+ * Return:	0 if OK, else the first error returned by @func
+ */
+int os_parallel_run(int (*func)(void *ctx, int idx), void *ctx, int count,
+		    int threads);
+
 /**
  * os_get_time_offset() - get time offset
  *
@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Running independent pieces of work on several CPUs
+ *
+ * U-Boot normally runs on a single CPU. Some work, such as decompressing
+ * independent blocks of an image, can be split into pieces which do not
+ * depend on each other. Architectures which can run code on other CPUs (or
+ * host threads, on sandbox) select ARCH_PARALLEL so that such work can be
+ * spread across them.
+ */
+
+#ifndef __PARALLEL_H
+#define __PARALLEL_H
+
+/**
+ * typedef parallel_func_t - Function to process one piece of work
+ *
+ * This may run on any CPU at the same time as other pieces, so it must only
+ * touch data belonging to its own piece. It must not call malloc(), printf()
+ * or anything else which uses U-Boot's global state.
+ *
+ * @ctx: Context passed to parallel_run()
+ * @idx: Index of the piece to process
+ * Return: 0 if OK, -ve on error
+ */
+typedef int (*parallel_func_t)(void *ctx, int idx);
+
+#if CONFIG_IS_ENABLED(PARALLEL)
+
+/**
+ * parallel_run() - Process pieces of work, using several CPUs if possible
+ *
+ * This calls @func once for each index from 0 to @count - 1, in no particular
+ * order, and returns when all calls have completed.
+ *
+ * @func: Function to call
+ * @ctx: Context to pass to @func
+ * @count: Number of pieces of work
+ * Return: 0 if OK, else an error returned by @func (all pieces are still
+ *	processed)
+ */
+int parallel_run(parallel_func_t func, void *ctx, int count);
+
+/**
+ * arch_parallel_run() - Process pieces of work on several CPUs
+ *
+ * This must be provided by architectures which select ARCH_PARALLEL. See
+ * parallel_run() for the arguments.
+ *
+ * @cpus: Maximum number of CPUs to use, including the current one
+ * Return: 0 if OK, -ENOSYS if other CPUs cannot be used at present, else an
+ *	error returned by @func
+ */
+int arch_parallel_run(parallel_func_t func, void *ctx, int count, int cpus);
+
+#else
+static inline int parallel_run(parallel_func_t func, void *ctx, int count)
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		int err = func(ctx, i);
+
+		if (err && !ret)
+			ret = err;
+	}
+
+	return ret;
+}
+#endif
+
+#endif
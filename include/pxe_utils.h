@@ -5,6 +5,9 @@
 
 #include <linux/list.h>
 
+/* Directory holding PXE config files, relative to the bootfile directory */
+#define PXELINUX_DIR "pxelinux.cfg/"
+
 /*
  * A note on the pxe file parser.
  *
@@ -91,6 +94,9 @@ typedef int (*pxe_getfile_func)(struct pxe_context *ctx, const char *file_path,
  * @bootdir: Directory that files are loaded from ("" if no directory). This is
  *	allocated
  * @pxe_file_size: Size of the PXE file
+ * @source: Where the files are read from, e.g. "mmc 1:2" or "tftp 10.0.0.1".
+ *	This is allocated, or NULL if not known, in which case the parsed
+ *	config file is not cached
  */
 struct pxe_context {
 	struct cmd_tbl *cmdtp;
@@ -110,6 +116,7 @@ struct pxe_context {
 	bool allow_abs_path;
 	char *bootdir;
 	ulong pxe_file_size;
+	char *source;
 };
 
 /**
@@ -214,6 +221,19 @@ int pxe_setup_ctx(struct pxe_context *ctx, struct cmd_tbl *cmdtp,
 		  pxe_getfile_func getfile, void *userdata,
 		  bool allow_abs_path, const char *bootfile);
 
+/**
+ * pxe_set_source() - Say where a PXE context reads its files from
+ *
+ * A config file is only taken from the cache (see CONFIG_PXE_CACHE) if it was
+ * read by the same getfile() function from the same source, since the files
+ * it includes may be different elsewhere.
+ *
+ * @ctx: Context to update
+ * @source: Description of the device or server, e.g. "mmc 1:2"
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+int pxe_set_source(struct pxe_context *ctx, const char *source);
+
 /**
  * pxe_destroy_ctx() - Destroy a PXE context
  *
@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Statistical sampling profiler
+ *
+ * Unlike function tracing (see trace.h) this does not need the code to be
+ * instrumented. A periodic timer interrupt records where the CPU is running
+ * and, optionally, the call stack found by following the frame pointers.
+ */
+
+#ifndef __SAMPLE_H
+#define __SAMPLE_H
+
+#include <linux/types.h>
+
+#if CONFIG_IS_ENABLED(SAMPLE_PROF)
+
+/**
+ * sample_start() - Start taking samples
+ *
+ * Any samples from an earlier run are discarded.
+ *
+ * @hz: Number of samples to take per second, 0 for the default
+ * Return: 0 if OK, -EALREADY if already running, -ENOMEM if the sample
+ *	buffer could not be allocated, other -ve on error from the timer
+ */
+int sample_start(uint hz);
+
+/**
+ * sample_stop() - Stop taking samples
+ *
+ * The samples taken so far are kept until the next sample_start().
+ */
+void sample_stop(void);
+
+/**
+ * sample_record() - Record a sample
+ *
+ * This is called from the timer interrupt, so must not take any locks,
+ * allocate memory or print anything.
+ *
+ * @pc: Program counter of the interrupted code
+ * @fp: Frame pointer of the interrupted code, 0 if not known
+ * @sp: Stack pointer of the interrupted code, used to check @fp
+ */
+void sample_record(ulong pc, ulong fp, ulong sp);
+
+/* Print statistics about the samples taken */
+void sample_print_stats(void);
+
+/**
+ * sample_list() - Dump the samples into a buffer
+ *
+ * This writes a struct trace_output_hdr of type TRACE_CHUNK_SAMPLES followed
+ * by one record per sample, oldest first. Each record is a u32 depth followed
+ * by that many u32 code offsets: the program counter and then the return
+ * addresses, innermost first. A depth of 0 means the sample was taken outside
+ * U-Boot.
+ *
+ * @buff: Buffer in which to place data, or NULL to count size
+ * @buff_size: Size of buffer
+ * @needed: Returns number of bytes used / needed
+ * Return: 0 if ok, -ENOSPC if the buffer is too small
+ */
+int sample_list(void *buff, size_t buff_size, size_t *needed);
+
+/**
+ * arch_sample_start() - Start a periodic timer interrupt for sampling
+ *
+ * This must be provided by architectures which select ARCH_SAMPLE_PROF. The
+ * interrupt handler should call sample_record().
+ *
+ * @hz: Interrupt frequency
+ * Return: 0 if OK, -ve on error
+ */
+int arch_sample_start(uint hz);
+
+/** arch_sample_stop() - Stop the timer interrupt used for sampling */
+void arch_sample_stop(void);
+
+#else
+static inline void sample_record(ulong pc, ulong fp, ulong sp)
+{
+}
+#endif
+
+#endif
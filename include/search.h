@@ -47,6 +47,16 @@ struct hsearch_data {
 	struct env_entry_node *table;
 	unsigned int size;
 	unsigned int filled;
+	/* Number of entries created, changed or deleted since hclear_dirty_r() */
+	unsigned int dirty;
+	/*
+	 * Set when the dirty set no longer describes every change (e.g. after
+	 * the table was destroyed); users must then treat all entries as dirty
+	 */
+	bool dirty_all;
+	/* Live entries sorted by key, dropped whenever the set of keys changes */
+	struct env_entry **sorted;
+	unsigned int nsorted;
 /*
  * Callback function which will check whether the given change for variable
  * "item" to "newval" may be applied or not, and possibly apply such change.
@@ -107,6 +117,33 @@ int himport_r(struct hsearch_data *htab, const char *env, size_t size,
 int hwalk_r(struct hsearch_data *htab,
 	    int (*callback)(struct env_entry *entry));
 
+/**
+ * hwalk_dirty_r() - Walk all entries changed since the last hclear_dirty_r()
+ *
+ * Entries which have been deleted are passed with @entry->data set to NULL.
+ * Note that the result is incomplete if @htab->dirty_all is set.
+ *
+ * @htab: Hash table
+ * @callback: Function to call for each dirty entry, a non-zero return value
+ *	stops the walk
+ * @priv: Private data passed to @callback
+ * Return: 0 on success, else the first non-zero value returned by @callback
+ */
+int hwalk_dirty_r(struct hsearch_data *htab,
+		  int (*callback)(struct env_entry *entry, void *priv),
+		  void *priv);
+
+/**
+ * hclear_dirty_r() - Mark all entries as clean
+ *
+ * This is called once the contents of the table have been written to (or read
+ * from) persistent storage, so that later exports only need to consider the
+ * entries changed afterwards.
+ *
+ * @htab: Hash table
+ */
+void hclear_dirty_r(struct hsearch_data *htab);
+
 /* Flags for himport_r(), hexport_r(), hdelete_r(), and hsearch_r() */
 #define H_NOCLEAR	(1 << 0) /* do not clear hash table before importing */
 #define H_FORCE		(1 << 1) /* overwrite read-only/write-once variables */
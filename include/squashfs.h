@@ -11,6 +11,7 @@
 #define _SQFS_H_
 
 struct disk_partition;
+struct fs_file;
 
 int sqfs_opendir(const char *filename, struct fs_dir_stream **dirsp);
 int sqfs_readdir(struct fs_dir_stream *dirs, struct fs_dirent **dentp);
@@ -21,6 +22,10 @@ int sqfs_read(const char *filename, void *buf, loff_t offset,
 int sqfs_size(const char *filename, loff_t *size);
 int sqfs_exists(const char *filename);
 void sqfs_close(void);
+int sqfs_file_open(struct fs_file *file, const char *filename);
+int sqfs_file_pread(struct fs_file *file, void *buf, loff_t offset,
+		    loff_t len, loff_t *actread);
+void sqfs_file_close(struct fs_file *file);
 void sqfs_closedir(struct fs_dir_stream *dirs);
 
 #endif /* SQFS_H  */
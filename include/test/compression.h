@@ -13,4 +13,8 @@
 #define COMPRESSION_TEST(_name, _flags) \
 		UNIT_TEST(_name, _flags, compression_test)
 
+/* Declare a new compression benchmark test */
+#define COMPRESSION_BENCH_TEST(_name, _flags) \
+		UNIT_TEST(_name, _flags, compression_bench_test)
+
 #endif /* __TEST_ENV_H__ */
@@ -99,28 +99,17 @@ void crc32_wd_buf(const uint8_t *input, uint ilen, uint8_t *output,
 /* lib/crc32c.c */
 
 /**
- * crc32c_init() - Set up a the CRC32 table
+ * crc32c_no_comp() - Perform CRC32C (Castagnoli) on a buffer
  *
- * This sets up 256-item table to aid in CRC32 calculation
+ * This uses the CPU's CRC32C instructions if available, otherwise slice-by-8
+ * tables. As with crc32_no_comp() no ones-complement is done; callers must do
+ * this themselves if needed.
  *
- * @crc32c_table: Place to put table
- * @pol: polynomial to use
- */
-void crc32c_init(uint32_t *crc32c_table, uint32_t pol);
-
-/**
- * crc32c_cal() - Perform CRC32 on a buffer given a table
- *
- * This algorithm uses the table (set up by crc32c_init() to speed up
- * processing.
- *
- * @crc: Previous crc (use 0 at start)
- * @data: Data bytes to checksum
- * @length: Number of bytes to process
- * @crc32c_table:: CRC table
+ * @crc: Previous crc (use ~0 to start a standard CRC32C calculation)
+ * @buf: Bytes to checksum
+ * @len: Number of bytes to checksum
  * Return: checksum value
  */
-uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
-		    uint32_t *crc32c_table);
+uint32_t crc32c_no_comp(uint32_t crc, const unsigned char *buf, uint len);
 
 #endif /* _UBOOT_CRC_H */
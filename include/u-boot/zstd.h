@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * U-Boot additions to the zstd API
+ */
+
+#ifndef __U_BOOT_ZSTD_H
+#define __U_BOOT_ZSTD_H
+
+#include <linux/errno.h>
+
+struct abuf;
+
+#if CONFIG_IS_ENABLED(PARALLEL)
+/**
+ * zstd_decompress_frames() - Decompress a multi-frame input in parallel
+ *
+ * Each frame in the input is independent. Provided that every frame header
+ * records the decompressed size, the place of each frame in the output is
+ * known before starting, so frames can be decompressed on several CPUs at
+ * once. zstd_decompress() uses this when it can.
+ *
+ * @in: Input buffer to decompress
+ * @out: Output buffer to hold the results, which must not overlap @in
+ * Return: size of the decompressed data, or -EAGAIN if the input must be
+ *	decompressed serially. This includes any error, so that the serial
+ *	code can report it.
+ */
+int zstd_decompress_frames(struct abuf *in, struct abuf *out);
+#else
+static inline int zstd_decompress_frames(struct abuf *in, struct abuf *out)
+{
+	return -EAGAIN;
+}
+#endif
+
+#endif
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Bump-pointer allocator for objects which are freed all at once
+ */
+
+#define LOG_CATEGORY	LOGC_ALLOC
+
+#include <common.h>
+#include <arena.h>
+#include <log.h>
+#include <malloc.h>
+
+/**
+ * struct arena_block - Header for a block of memory in an arena
+ *
+ * @next: Next (older) block
+ * @end: End of this block
+ */
+struct arena_block {
+	struct arena_block *next;
+	char *end;
+};
+
+/* Space taken by the header, keeping the data aligned */
+#define ARENA_HDR_SIZE	ALIGN(sizeof(struct arena_block), ARENA_ALIGN)
+
+/* Allocate a block with space for at least @size bytes of objects */
+static struct arena_block *arena_new_block(struct arena *arena, ulong size)
+{
+	struct arena_block *blk;
+
+	size = max(size + ARENA_HDR_SIZE, arena->block_size);
+	if (arena->limit && arena->total + size > arena->limit)
+		return NULL;
+	blk = malloc(size);
+	if (!blk)
+		return NULL;
+	blk->end = (char *)blk + size;
+	arena->total += size;
+	log_debug("block %p size %lx\n", blk, size);
+
+	return blk;
+}
+
+/* Start a new block for small objects, leaving the rest of the old one */
+static int arena_add_block(struct arena *arena)
+{
+	struct arena_block *blk;
+
+	blk = arena_new_block(arena, 0);
+	if (!blk)
+		return -ENOMEM;
+	blk->next = arena->blocks;
+	arena->blocks = blk;
+	arena->ptr = (char *)blk + ARENA_HDR_SIZE;
+	arena->end = blk->end;
+
+	return 0;
+}
+
+int arena_init(struct arena *arena, ulong block_size, ulong limit)
+{
+	memset(arena, '\0', sizeof(*arena));
+	arena->block_size = ALIGN(block_size, ARENA_ALIGN);
+	arena->limit = limit;
+
+	return arena_add_block(arena);
+}
+
+void arena_uninit(struct arena *arena)
+{
+	struct arena_block *blk, *next;
+
+	for (blk = arena->blocks; blk; blk = next) {
+		next = blk->next;
+		free(blk);
+	}
+	memset(arena, '\0', sizeof(*arena));
+}
+
+void *arena_alloc(struct arena *arena, size_t size)
+{
+	struct arena_block *blk;
+	char *ptr;
+
+	size = ALIGN(size, ARENA_ALIGN);
+	if (size > arena->block_size - ARENA_HDR_SIZE) {
+		/*
+		 * Too large for a normal block, so give it a block of its own,
+		 * behind the current one, which is still used for small objects
+		 */
+		blk = arena_new_block(arena, size);
+		if (!blk)
+			return NULL;
+		if (arena->blocks) {
+			blk->next = arena->blocks->next;
+			arena->blocks->next = blk;
+		} else {
+			blk->next = NULL;
+			arena->blocks = blk;
+		}
+		ptr = (char *)blk + ARENA_HDR_SIZE;
+	} else {
+		if ((size_t)(arena->end - arena->ptr) < size &&
+		    arena_add_block(arena))
+			return NULL;
+		ptr = arena->ptr;
+		arena->ptr += size;
+	}
+	arena->used += size;
+	arena->count++;
+	memset(ptr, '\0', size);
+
+	return ptr;
+}
+
+bool arena_owns(const struct arena *arena, const void *ptr)
+{
+	const struct arena_block *blk;
+
+	for (blk = arena->blocks; blk; blk = blk->next) {
+		if ((char *)ptr >= (char *)blk && (char *)ptr < blk->end)
+			return true;
+	}
+
+	return false;
+}
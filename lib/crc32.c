@@ -31,6 +31,14 @@
 
 #define tole(x) cpu_to_le32(x)
 
+/* Slice-by-8 is only implemented for little-endian; host tools always use it */
+#ifdef USE_HOSTCC
+#define CRC32_SLICE8	(__BYTE_ORDER == __LITTLE_ENDIAN)
+#else
+#define CRC32_SLICE8	(CONFIG_IS_ENABLED(CRC32_SLICE8) && \
+			 __BYTE_ORDER == __LITTLE_ENDIAN)
+#endif
+
 #ifdef CONFIG_DYNAMIC_CRC_TABLE
 
 static int __efi_runtime_data crc_table_empty = 1;
@@ -84,6 +92,9 @@ static void __efi_runtime make_crc_table(void)
   }
   crc_table_empty = 0;
 }
+#elif CRC32_SLICE8
+#include "crc_slice8.h"
+#include "crc32table.h"
 #elif !defined(CONFIG_ARM64_CRC32)
 /* ========================================================================
  * Table of CRC-32's of all single-byte values (made by make_crc_table)
@@ -185,10 +196,18 @@ const uint32_t * ZEXPORT get_crc_table()
 uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 {
 #ifdef CONFIG_ARM64_CRC32
-    crc = cpu_to_le32(crc);
+    /* Align so we can use the 64-bit instruction */
+    while (len && ((ulong)buf & 7)) {
+        crc = __builtin_aarch64_crc32b(crc, *buf++);
+        len--;
+    }
+    for (; len >= 8; len -= 8, buf += 8)
+        crc = __builtin_aarch64_crc32x(crc, *(const uint64_t *)buf);
     while (len--)
         crc = __builtin_aarch64_crc32b(crc, *buf++);
-    return le32_to_cpu(crc);
+    return crc;
+#elif CRC32_SLICE8
+    return crc_slice8(crc32_table8, crc, buf, len);
 #else
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
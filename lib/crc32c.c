@@ -1,38 +1,111 @@
 // SPDX-License-Identifier: GPL-2.0+
 /*
- * Copied from Linux kernel crypto/crc32c.c
- * Copyright (c) 2004 Cisco Systems, Inc.
- * Copyright (c) 2008 Herbert Xu <herbert@gondor.apana.org.au>
+ * CRC-32C (Castagnoli), as used by btrfs and iSCSI
  *
- * This program is free software; you can redistribute it and/or modify it
- * under the terms of the GNU General Public License as published by the Free
- * Software Foundation; either version 2 of the License, or (at your option)
- * any later version.
+ * This uses the CRC32C instructions where the CPU has them, else slice-by-8
+ * tables.
  */
 
 #include <common.h>
 #include <compiler.h>
+#include <efi_loader.h>
+#include <u-boot/crc.h>
+#include "crc_slice8.h"
+#include "crc32ctable.h"
 
-uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
-		    uint32_t *crc32c_table)
+#if defined(CONFIG_ARM64_CRC32)
+
+static uint32_t crc32c_hw(uint32_t crc, const uint8_t *p, uint len)
 {
-	while (length--)
-		crc = crc32c_table[(u8)(crc ^ *data++)] ^ (crc >> 8);
+	while (len && ((ulong)p & 7)) {
+		crc = __builtin_aarch64_crc32cb(crc, *p++);
+		len--;
+	}
+	for (; len >= 8; len -= 8, p += 8)
+		crc = __builtin_aarch64_crc32cx(crc, *(const uint64_t *)p);
+	while (len--)
+		crc = __builtin_aarch64_crc32cb(crc, *p++);
 
 	return crc;
 }
 
-void crc32c_init(uint32_t *crc32c_table, uint32_t pol)
+static bool crc32c_have_hw(void)
+{
+	return true;
+}
+
+#elif defined(__x86_64__) || defined(__i386__)
+
+/*
+ * The SSE4.2 crc32 instruction works on general-purpose registers, so this
+ * does not need the compiler to be allowed to use SSE
+ */
+static uint32_t crc32c_hw(uint32_t crc, const uint8_t *p, uint len)
 {
-	int i, j;
-	uint32_t v;
-	const uint32_t poly = pol; /* Bit-reflected CRC32C polynomial */
+	while (len && ((ulong)p & (sizeof(ulong) - 1))) {
+		asm ("crc32b %1, %0" : "+r" (crc) : "rm" (*p));
+		p++;
+		len--;
+	}
+	for (; len >= sizeof(ulong); len -= sizeof(ulong), p += sizeof(ulong)) {
+#ifdef __x86_64__
+		ulong val = crc;
+
+		asm ("crc32q %1, %0" : "+r" (val) : "rm" (*(const ulong *)p));
+		crc = val;
+#else
+		asm ("crc32l %1, %0" : "+r" (crc) : "rm" (*(const ulong *)p));
+#endif
+	}
+	while (len--) {
+		asm ("crc32b %1, %0" : "+r" (crc) : "rm" (*p));
+		p++;
+	}
 
-	for (i = 0; i < 256; i++) {
-		v = i;
-		for (j = 0; j < 8; j++)
-			v = (v >> 1) ^ ((v & 1) ? poly : 0);
+	return crc;
+}
+
+static bool crc32c_have_hw(void)
+{
+	static int have = -1;
+	uint eax, ebx, ecx, edx;
 
-		crc32c_table[i] = v;
+	if (have == -1) {
+		asm ("cpuid"
+		     : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+		     : "a" (1), "c" (0));
+		have = !!(ecx & (1 << 20));	/* SSE4.2 */
 	}
+
+	return have;
+}
+
+#else
+
+static uint32_t crc32c_hw(uint32_t crc, const uint8_t *p, uint len)
+{
+	return crc;
+}
+
+static bool crc32c_have_hw(void)
+{
+	return false;
+}
+
+#endif
+
+uint32_t crc32c_no_comp(uint32_t crc, const unsigned char *buf, uint len)
+{
+	if (crc32c_have_hw())
+		return crc32c_hw(crc, buf, len);
+
+	/* Slice-by-8 is only implemented for little-endian */
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+	return crc_slice8(crc32c_table8, crc, buf, len);
+#else
+	while (len--)
+		crc = crc32c_table8[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+
+	return crc;
+#endif
 }
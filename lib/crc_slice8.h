@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Slice-by-8 CRC calculation, shared by the CRC-32 and CRC-32C code
+ */
+
+#ifndef __CRC_SLICE8_H
+#define __CRC_SLICE8_H
+
+/**
+ * crc_slice8() - Update a reflected 32-bit CRC using slice-by-8 tables
+ *
+ * This handles eight bytes per loop iteration using eight table lookups which
+ * do not depend on each other, instead of one dependent lookup per byte. It is
+ * only suitable for little-endian machines.
+ *
+ * It is marked __efi_runtime since crc32_no_comp() uses it at EFI runtime, so
+ * the includer must define that (as efi_loader.h does).
+ *
+ * @tab: Tables for the polynomial, see crc32table.h
+ * @crc: CRC to update (no ones-complement is done)
+ * @p: Data to process
+ * @len: Number of bytes to process
+ * Return: updated CRC
+ */
+static inline uint32_t __efi_runtime crc_slice8(const uint32_t (*tab)[256],
+						uint32_t crc, const uint8_t *p,
+						size_t len)
+{
+	/* Align so we can read 32 bits at a time */
+	while (len && ((unsigned long)p & 3)) {
+		crc = tab[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+		len--;
+	}
+
+	for (; len >= 8; len -= 8, p += 8) {
+		uint32_t one = *(const uint32_t *)p ^ crc;
+		uint32_t two = *(const uint32_t *)(p + 4);
+
+		crc = tab[7][one & 0xff] ^ tab[6][(one >> 8) & 0xff] ^
+		      tab[5][(one >> 16) & 0xff] ^ tab[4][one >> 24] ^
+		      tab[3][two & 0xff] ^ tab[2][(two >> 8) & 0xff] ^
+		      tab[1][(two >> 16) & 0xff] ^ tab[0][two >> 24];
+	}
+
+	while (len--)
+		crc = tab[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+	return crc;
+}
+
+#endif
@@ -22,6 +22,7 @@
 struct efi_system_partition efi_system_partition;
 
 const efi_guid_t efi_block_io_guid = EFI_BLOCK_IO_PROTOCOL_GUID;
+const efi_guid_t efi_block_io2_guid = EFI_BLOCK_IO2_PROTOCOL_GUID;
 const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
 
 /**
@@ -29,6 +30,7 @@ const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
  *
  * @header:	EFI object header
  * @ops:	EFI disk I/O protocol interface
+ * @ops2:	EFI block I/O 2 protocol interface
  * @ifname:	interface name for block device
  * @dev_index:	device index of block device
  * @media:	block I/O media information
@@ -41,6 +43,7 @@ const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
 struct efi_disk_obj {
 	struct efi_object header;
 	struct efi_block_io ops;
+	struct efi_block_io2 ops2;
 	const char *ifname;
 	int dev_index;
 	struct efi_block_io_media media;
@@ -78,16 +81,14 @@ enum efi_disk_direction {
 	EFI_DISK_WRITE,
 };
 
-static efi_status_t efi_disk_rw_blocks(struct efi_block_io *this,
-			u32 media_id, u64 lba, unsigned long buffer_size,
+static efi_status_t efi_disk_rw_blocks(struct efi_disk_obj *diskobj,
+			u64 lba, unsigned long buffer_size,
 			void *buffer, enum efi_disk_direction direction)
 {
-	struct efi_disk_obj *diskobj;
 	int blksz;
 	int blocks;
 	unsigned long n;
 
-	diskobj = container_of(this, struct efi_disk_obj, ops);
 	blksz = diskobj->media.block_size;
 	blocks = buffer_size / blksz;
 	lba += diskobj->offset;
@@ -95,10 +96,6 @@ static efi_status_t efi_disk_rw_blocks(struct efi_block_io *this,
 	EFI_PRINT("blocks=%x lba=%llx blksz=%x dir=%d\n",
 		  blocks, lba, blksz, direction);
 
-	/* We only support full block access */
-	if (buffer_size & (blksz - 1))
-		return EFI_BAD_BUFFER_SIZE;
-
 	if (CONFIG_IS_ENABLED(PARTITIONS) &&
 	    device_get_uclass_id(diskobj->dev) == UCLASS_PARTITION) {
 		if (direction == EFI_DISK_READ)
@@ -127,6 +124,90 @@ static efi_status_t efi_disk_rw_blocks(struct efi_block_io *this,
 	return EFI_SUCCESS;
 }
 
+/**
+ * efi_disk_transfer() - read or write blocks, bouncing if needed
+ *
+ * The bounce buffer is only used if the buffer is outside the memory that the
+ * device can access. Otherwise the device transfers straight to or from the
+ * caller's buffer.
+ *
+ * @diskobj:		disk object
+ * @lba:		first logical block, relative to the partition
+ * @buffer_size:	number of bytes to transfer, a multiple of the block size
+ * @buffer:		caller's buffer
+ * @direction:		read or write
+ * Return:		status code
+ */
+static efi_status_t efi_disk_transfer(struct efi_disk_obj *diskobj, u64 lba,
+				      efi_uintn_t buffer_size, void *buffer,
+				      enum efi_disk_direction direction)
+{
+#ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
+	efi_uintn_t chunk;
+	efi_status_t r;
+
+	if ((u64)(uintptr_t)buffer + buffer_size <=
+	    EFI_LOADER_BOUNCE_BUFFER_LIMIT + 1)
+		return efi_disk_rw_blocks(diskobj, lba, buffer_size, buffer,
+					  direction);
+
+	for (; buffer_size; buffer_size -= chunk, buffer += chunk) {
+		chunk = min_t(efi_uintn_t, buffer_size,
+			      EFI_LOADER_BOUNCE_BUFFER_SIZE);
+		if (direction == EFI_DISK_WRITE)
+			memcpy(efi_bounce_buffer, buffer, chunk);
+		r = efi_disk_rw_blocks(diskobj, lba, chunk, efi_bounce_buffer,
+				       direction);
+		if (r != EFI_SUCCESS)
+			return r;
+		if (direction == EFI_DISK_READ)
+			memcpy(buffer, efi_bounce_buffer, chunk);
+		lba += chunk / diskobj->media.block_size;
+	}
+
+	return EFI_SUCCESS;
+#else
+	return efi_disk_rw_blocks(diskobj, lba, buffer_size, buffer, direction);
+#endif
+}
+
+/**
+ * efi_disk_check() - check the parameters of a read or write request
+ *
+ * @media:		media information of the block I/O protocol
+ * @media_id:		id of the medium as passed by the caller
+ * @lba:		first logical block
+ * @buffer_size:	size of the buffer
+ * @buffer:		buffer
+ * @direction:		read or write
+ * Return:		status code
+ */
+static efi_status_t efi_disk_check(struct efi_block_io_media *media,
+				   u32 media_id, u64 lba,
+				   efi_uintn_t buffer_size, void *buffer,
+				   enum efi_disk_direction direction)
+{
+	if (direction == EFI_DISK_WRITE && media->read_only)
+		return EFI_WRITE_PROTECTED;
+	/* TODO: check for media changes */
+	if (media_id != media->media_id)
+		return EFI_MEDIA_CHANGED;
+	if (!media->media_present)
+		return EFI_NO_MEDIA;
+	/* We only support full block access */
+	if (buffer_size & (media->block_size - 1))
+		return EFI_BAD_BUFFER_SIZE;
+	/* media->io_align is a power of 2 or 0 */
+	if (media->io_align &&
+	    (uintptr_t)buffer & (media->io_align - 1))
+		return EFI_INVALID_PARAMETER;
+	if (lba * media->block_size + buffer_size >
+	    (media->last_block + 1) * media->block_size)
+		return EFI_INVALID_PARAMETER;
+
+	return EFI_SUCCESS;
+}
+
 /**
  * efi_disk_read_blocks() - reads blocks from device
  *
@@ -146,48 +227,19 @@ static efi_status_t EFIAPI efi_disk_read_blocks(struct efi_block_io *this,
 			u32 media_id, u64 lba, efi_uintn_t buffer_size,
 			void *buffer)
 {
-	void *real_buffer = buffer;
 	efi_status_t r;
 
-	if (!this)
-		return EFI_INVALID_PARAMETER;
-	/* TODO: check for media changes */
-	if (media_id != this->media->media_id)
-		return EFI_MEDIA_CHANGED;
-	if (!this->media->media_present)
-		return EFI_NO_MEDIA;
-	/* media->io_align is a power of 2 or 0 */
-	if (this->media->io_align &&
-	    (uintptr_t)buffer & (this->media->io_align - 1))
-		return EFI_INVALID_PARAMETER;
-	if (lba * this->media->block_size + buffer_size >
-	    (this->media->last_block + 1) * this->media->block_size)
-		return EFI_INVALID_PARAMETER;
-
-#ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
-	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
-		r = efi_disk_read_blocks(this, media_id, lba,
-			EFI_LOADER_BOUNCE_BUFFER_SIZE, buffer);
-		if (r != EFI_SUCCESS)
-			return r;
-		return efi_disk_read_blocks(this, media_id, lba +
-			EFI_LOADER_BOUNCE_BUFFER_SIZE / this->media->block_size,
-			buffer_size - EFI_LOADER_BOUNCE_BUFFER_SIZE,
-			buffer + EFI_LOADER_BOUNCE_BUFFER_SIZE);
-	}
-
-	real_buffer = efi_bounce_buffer;
-#endif
-
 	EFI_ENTRY("%p, %x, %llx, %zx, %p", this, media_id, lba,
 		  buffer_size, buffer);
 
-	r = efi_disk_rw_blocks(this, media_id, lba, buffer_size, real_buffer,
-			       EFI_DISK_READ);
-
-	/* Copy from bounce buffer to real buffer if necessary */
-	if ((r == EFI_SUCCESS) && (real_buffer != buffer))
-		memcpy(buffer, real_buffer, buffer_size);
+	if (!this)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+	r = efi_disk_check(this->media, media_id, lba, buffer_size, buffer,
+			   EFI_DISK_READ);
+	if (r == EFI_SUCCESS)
+		r = efi_disk_transfer(container_of(this, struct efi_disk_obj,
+						   ops),
+				      lba, buffer_size, buffer, EFI_DISK_READ);
 
 	return EFI_EXIT(r);
 }
@@ -212,50 +264,19 @@ static efi_status_t EFIAPI efi_disk_write_blocks(struct efi_block_io *this,
 			u32 media_id, u64 lba, efi_uintn_t buffer_size,
 			void *buffer)
 {
-	void *real_buffer = buffer;
 	efi_status_t r;
 
-	if (!this)
-		return EFI_INVALID_PARAMETER;
-	if (this->media->read_only)
-		return EFI_WRITE_PROTECTED;
-	/* TODO: check for media changes */
-	if (media_id != this->media->media_id)
-		return EFI_MEDIA_CHANGED;
-	if (!this->media->media_present)
-		return EFI_NO_MEDIA;
-	/* media->io_align is a power of 2 or 0 */
-	if (this->media->io_align &&
-	    (uintptr_t)buffer & (this->media->io_align - 1))
-		return EFI_INVALID_PARAMETER;
-	if (lba * this->media->block_size + buffer_size >
-	    (this->media->last_block + 1) * this->media->block_size)
-		return EFI_INVALID_PARAMETER;
-
-#ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
-	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
-		r = efi_disk_write_blocks(this, media_id, lba,
-			EFI_LOADER_BOUNCE_BUFFER_SIZE, buffer);
-		if (r != EFI_SUCCESS)
-			return r;
-		return efi_disk_write_blocks(this, media_id, lba +
-			EFI_LOADER_BOUNCE_BUFFER_SIZE / this->media->block_size,
-			buffer_size - EFI_LOADER_BOUNCE_BUFFER_SIZE,
-			buffer + EFI_LOADER_BOUNCE_BUFFER_SIZE);
-	}
-
-	real_buffer = efi_bounce_buffer;
-#endif
-
 	EFI_ENTRY("%p, %x, %llx, %zx, %p", this, media_id, lba,
 		  buffer_size, buffer);
 
-	/* Populate bounce buffer if necessary */
-	if (real_buffer != buffer)
-		memcpy(real_buffer, buffer, buffer_size);
-
-	r = efi_disk_rw_blocks(this, media_id, lba, buffer_size, real_buffer,
-			       EFI_DISK_WRITE);
+	if (!this)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+	r = efi_disk_check(this->media, media_id, lba, buffer_size, buffer,
+			   EFI_DISK_WRITE);
+	if (r == EFI_SUCCESS)
+		r = efi_disk_transfer(container_of(this, struct efi_disk_obj,
+						   ops),
+				      lba, buffer_size, buffer, EFI_DISK_WRITE);
 
 	return EFI_EXIT(r);
 }
@@ -287,6 +308,174 @@ static const struct efi_block_io block_io_disk_template = {
 	.flush_blocks = &efi_disk_flush_blocks,
 };
 
+/**
+ * efi_disk_reset_ex() - reset block device
+ *
+ * This function implements the Reset service of the EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @extended_verification:	extended verification
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_reset_ex(struct efi_block_io2 *this,
+					     bool extended_verification)
+{
+	EFI_ENTRY("%p, %x", this, extended_verification);
+	return EFI_EXIT(EFI_SUCCESS);
+}
+
+/**
+ * efi_disk_complete() - complete a request of the EFI_BLOCK_IO2_PROTOCOL
+ *
+ * U-Boot's block devices are synchronous, so the transfer is already done.
+ * For a non-blocking request its status is stored in the token and the
+ * token's event is signaled.
+ *
+ * @token:	token passed by the caller, may be NULL
+ * @r:		status of the transfer
+ * Return:	status code to return to the caller
+ */
+static efi_status_t efi_disk_complete(struct efi_block_io2_token *token,
+				      efi_status_t r)
+{
+	if (!token || !token->event)
+		return r;
+
+	token->transaction_status = r;
+	efi_signal_event(token->event);
+
+	return EFI_SUCCESS;
+}
+
+/**
+ * efi_disk_rw_blocks_ex() - read or write blocks for the BLOCK_IO2_PROTOCOL
+ *
+ * @this:		pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:		id of the medium
+ * @lba:		starting logical block
+ * @token:		token for a non-blocking request, may be NULL
+ * @buffer_size:	size of the buffer
+ * @buffer:		buffer
+ * @direction:		read or write
+ * Return:		status code
+ */
+static efi_status_t efi_disk_rw_blocks_ex(struct efi_block_io2 *this,
+					  u32 media_id, u64 lba,
+					  struct efi_block_io2_token *token,
+					  efi_uintn_t buffer_size, void *buffer,
+					  enum efi_disk_direction direction)
+{
+	efi_status_t r;
+
+	if (!this)
+		return EFI_INVALID_PARAMETER;
+	r = efi_disk_check(this->media, media_id, lba, buffer_size, buffer,
+			   direction);
+	if (r != EFI_SUCCESS)
+		return r;
+	r = efi_disk_transfer(container_of(this, struct efi_disk_obj, ops2),
+			      lba, buffer_size, buffer, direction);
+
+	return efi_disk_complete(token, r);
+}
+
+/**
+ * efi_disk_read_blocks_ex() - reads blocks from device
+ *
+ * This function implements the ReadBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:			id of the medium to be read from
+ * @lba:			starting logical block for reading
+ * @token:			token for a non-blocking request, may be NULL
+ * @buffer_size:		size of the read buffer
+ * @buffer:			pointer to the destination buffer
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_read_blocks_ex(struct efi_block_io2 *this,
+			u32 media_id, u64 lba,
+			struct efi_block_io2_token *token,
+			efi_uintn_t buffer_size, void *buffer)
+{
+	EFI_ENTRY("%p, %x, %llx, %p, %zx, %p", this, media_id, lba, token,
+		  buffer_size, buffer);
+
+	return EFI_EXIT(efi_disk_rw_blocks_ex(this, media_id, lba, token,
+					      buffer_size, buffer,
+					      EFI_DISK_READ));
+}
+
+/**
+ * efi_disk_write_blocks_ex() - writes blocks to device
+ *
+ * This function implements the WriteBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:			id of the medium to be written to
+ * @lba:			starting logical block for writing
+ * @token:			token for a non-blocking request, may be NULL
+ * @buffer_size:		size of the write buffer
+ * @buffer:			pointer to the source buffer
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_write_blocks_ex(struct efi_block_io2 *this,
+			u32 media_id, u64 lba,
+			struct efi_block_io2_token *token,
+			efi_uintn_t buffer_size, void *buffer)
+{
+	EFI_ENTRY("%p, %x, %llx, %p, %zx, %p", this, media_id, lba, token,
+		  buffer_size, buffer);
+
+	return EFI_EXIT(efi_disk_rw_blocks_ex(this, media_id, lba, token,
+					      buffer_size, buffer,
+					      EFI_DISK_WRITE));
+}
+
+/**
+ * efi_disk_flush_blocks_ex() - flushes modified data to the device
+ *
+ * This function implements the FlushBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * As we always write synchronously nothing needs to be flushed.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @token:			token for a non-blocking request, may be NULL
+ * Return:			status code
+ */
+static efi_status_t EFIAPI
+efi_disk_flush_blocks_ex(struct efi_block_io2 *this,
+			 struct efi_block_io2_token *token)
+{
+	EFI_ENTRY("%p, %p", this, token);
+
+	if (!this)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+
+	return EFI_EXIT(efi_disk_complete(token, EFI_SUCCESS));
+}
+
+static const struct efi_block_io2 block_io2_disk_template = {
+	.reset = &efi_disk_reset_ex,
+	.read_blocks_ex = &efi_disk_read_blocks_ex,
+	.write_blocks_ex = &efi_disk_write_blocks_ex,
+	.flush_blocks_ex = &efi_disk_flush_blocks_ex,
+};
+
 /**
  * efi_fs_from_path() - retrieve simple file system protocol
  *
@@ -435,6 +624,7 @@ static efi_status_t efi_disk_add_dev(
 	ret = EFI_CALL(efi_install_multiple_protocol_interfaces(
 			&handle, &efi_guid_device_path, diskobj->dp,
 			&efi_block_io_guid, &diskobj->ops,
+			&efi_block_io2_guid, &diskobj->ops2,
 			guid, NULL, NULL));
 	if (ret != EFI_SUCCESS)
 		goto error;
@@ -470,6 +660,8 @@ static efi_status_t efi_disk_add_dev(
 	if (part)
 		diskobj->media.logical_partition = 1;
 	diskobj->ops.media = &diskobj->media;
+	diskobj->ops2 = block_io2_disk_template;
+	diskobj->ops2.media = &diskobj->media;
 	if (disk)
 		*disk = diskobj;
 
@@ -39,6 +39,10 @@ struct file_handle {
 	struct fs_dir_stream *dirs;
 	struct fs_dirent *dent;
 
+	/* for reading a file, opened on first use: */
+	struct fs_mount *mnt;
+	struct fs_file *file;
+
 	char path[0];
 };
 #define to_fh(x) container_of(x, struct file_handle, base)
@@ -58,6 +62,43 @@ static int set_blk_dev(struct file_handle *fh)
 	return fs_set_blk_dev_with_part(fh->fs->desc, fh->fs->part);
 }
 
+/**
+ * file_get() - open the file for reading, if not already done
+ *
+ * The filesystem is then kept mounted and the file's location is kept, so
+ * that each read does not need to probe the filesystem and look up the path.
+ *
+ * @fh:		file handle
+ * Return:	0 if OK, -ve on error
+ */
+static int file_get(struct file_handle *fh)
+{
+	int ret;
+
+	if (fh->file)
+		return 0;
+	if (!fh->mnt) {
+		ret = fs_mount(fh->fs->desc, fh->fs->part, &fh->mnt);
+		if (ret)
+			return ret;
+	}
+
+	return fs_file_open(fh->mnt, fh->path, &fh->file);
+}
+
+/**
+ * file_put() - close the file opened by file_get(), if any
+ *
+ * @fh:		file handle
+ */
+static void file_put(struct file_handle *fh)
+{
+	fs_file_close(fh->file);
+	fh->file = NULL;
+	fs_umount(fh->mnt);
+	fh->mnt = NULL;
+}
+
 /**
  * is_dir() - check if file handle points to directory
  *
@@ -365,6 +406,7 @@ out:
 static efi_status_t file_close(struct file_handle *fh)
 {
 	fs_closedir(fh->dirs);
+	file_put(fh);
 	free(fh);
 	return EFI_SUCCESS;
 }
@@ -400,6 +442,9 @@ static efi_status_t EFIAPI efi_file_delete(struct efi_file_handle *file)
 static efi_status_t efi_get_file_size(struct file_handle *fh,
 				      loff_t *file_size)
 {
+	if (!fh->isdir && !file_get(fh) && !fs_file_size(fh->file, file_size))
+		return EFI_SUCCESS;
+
 	if (set_blk_dev(fh))
 		return EFI_DEVICE_ERROR;
 
@@ -468,10 +513,10 @@ static efi_status_t file_read(struct file_handle *fh, u64 *buffer_size,
 		return ret;
 	}
 
-	if (set_blk_dev(fh))
+	if (file_get(fh))
 		return EFI_DEVICE_ERROR;
-	if (fs_read(fh->path, map_to_sysmem(buffer), fh->offset,
-		    *buffer_size, &actread))
+	if (fs_file_pread(fh->file, buffer, fh->offset, *buffer_size,
+			  &actread))
 		return EFI_DEVICE_ERROR;
 
 	*buffer_size = actread;
@@ -13,7 +13,9 @@
 #include <watchdog.h>
 #include <asm/cache.h>
 #include <asm/global_data.h>
-#include <linux/list_sort.h>
+#include <linux/bitops.h>
+#include <linux/log2.h>
+#include <linux/rbtree_augmented.h>
 #include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -23,17 +25,28 @@ DECLARE_GLOBAL_DATA_PTR;
 
 efi_uintn_t efi_memory_map_key;
 
+/**
+ * struct efi_mem_list - memory map item
+ *
+ * @node:	node in the memory map tree, which is ordered by address
+ * @desc:	memory descriptor
+ * @max_free:	largest number of pages of EFI_CONVENTIONAL_MEMORY in a single
+ *		item of the subtree rooted at this node
+ */
 struct efi_mem_list {
-	struct list_head link;
+	struct rb_node node;
 	struct efi_mem_desc desc;
+	u64 max_free;
 };
 
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
+/*
+ * This tree contains all memory map items. The items do not overlap and
+ * neighbouring items with the same type and attributes are merged.
+ */
+static struct rb_root efi_mem = RB_ROOT;
 
-/* This list contains all memory map items */
-LIST_HEAD(efi_mem);
+/* Number of items in the memory map */
+static efi_uintn_t efi_mem_count;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
@@ -46,9 +59,9 @@ void *efi_bounce_buffer;
  * @checksum:	checksum
  * @data:	allocated pool memory
  *
- * U-Boot services each UEFI AllocatePool() request as a separate
- * (multiple) page allocation. We have to track the number of pages
- * to be able to free the correct amount later.
+ * U-Boot services each UEFI AllocatePool() request larger than
+ * EFI_POOL_MAX_SLOT as a separate (multiple) page allocation. We have to track
+ * the number of pages to be able to free the correct amount later.
  *
  * The checksum calculated in function checksum() is used in FreePool() to avoid
  * freeing memory not allocated by AllocatePool() and duplicate freeing.
@@ -62,172 +75,282 @@ struct efi_pool_allocation {
 	char data[] __aligned(ARCH_DMA_MINALIGN);
 };
 
+/* Smallest and largest slot for pool allocations sharing a page */
+#define EFI_POOL_MIN_SLOT	64
+#define EFI_POOL_MAX_SLOT	1024
+#define EFI_POOL_CLASSES	5
+
+/**
+ * struct efi_pool_page - page holding small pool allocations
+ *
+ * @num_pages:		always 0, to tell this apart from a
+ *			struct efi_pool_allocation
+ * @checksum:		checksum
+ * @link:		entry in the list of pages with free slots, for this
+ *			memory type and size class
+ * @free:		bitmap of free slots
+ * @memory_type:	memory type of the page
+ * @size_class:		size class, the slot size being
+ *			EFI_POOL_MIN_SLOT << size_class
+ * @slots:		slots for allocations
+ *
+ * AllocatePool() requests up to EFI_POOL_MAX_SLOT bytes are rounded up to a
+ * power of two and served from a slot in a page of that memory type and size
+ * class. This avoids using a page and a memory map entry for each small
+ * allocation.
+ */
+struct efi_pool_page {
+	u64 num_pages;
+	u64 checksum;
+	struct list_head link;
+	u64 free;
+	u32 memory_type;
+	u32 size_class;
+	char slots[] __aligned(ARCH_DMA_MINALIGN);
+};
+
+/* Pages with free slots, for each memory type and size class */
+static struct list_head efi_pool_pages[EFI_MAX_MEMORY_TYPE][EFI_POOL_CLASSES];
+
 /**
  * checksum() - calculate checksum for memory allocated from pool
  *
  * @alloc:	allocation header
+ * @num_pages:	number of pages in the allocation, 0 for a struct efi_pool_page
  * Return:	checksum, always non-zero
  */
-static u64 checksum(struct efi_pool_allocation *alloc)
+static u64 checksum(void *alloc, u64 num_pages)
 {
 	u64 addr = (uintptr_t)alloc;
-	u64 ret = (addr >> 32) ^ (addr << 32) ^ alloc->num_pages ^
+	u64 ret = (addr >> 32) ^ (addr << 32) ^ num_pages ^
 		  EFI_ALLOC_POOL_MAGIC;
 	if (!ret)
 		++ret;
 	return ret;
 }
 
-/*
- * Sorts the memory list from highest address to lowest address
+static uint64_t desc_get_end(struct efi_mem_desc *desc)
+{
+	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
+}
+
+static u64 efi_mem_compute_max_free(struct efi_mem_list *item)
+{
+	u64 max = 0;
+	struct efi_mem_list *child;
+
+	if (item->desc.type == EFI_CONVENTIONAL_MEMORY)
+		max = item->desc.num_pages;
+	if (item->node.rb_left) {
+		child = rb_entry(item->node.rb_left, struct efi_mem_list, node);
+		max = max(max, child->max_free);
+	}
+	if (item->node.rb_right) {
+		child = rb_entry(item->node.rb_right, struct efi_mem_list,
+				 node);
+		max = max(max, child->max_free);
+	}
+
+	return max;
+}
+
+RB_DECLARE_CALLBACKS(static, efi_mem_augment, struct efi_mem_list, node, u64,
+		     max_free, efi_mem_compute_max_free)
+
+/**
+ * efi_mem_update() - update the tree after an item has been resized
  *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
+ * The start address may change, as long as the item stays in order.
+ *
+ * @item:	memory map item
  */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
+static void efi_mem_update(struct efi_mem_list *item)
 {
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
+	item->desc.virtual_start = item->desc.physical_start;
+	efi_mem_augment_propagate(&item->node, NULL);
+}
 
-	if (mema->desc.physical_start == memb->desc.physical_start)
-		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
+/**
+ * efi_mem_insert() - insert an item into the memory map
+ *
+ * @new:	memory map item, which must not overlap any other item
+ */
+static void efi_mem_insert(struct efi_mem_list *new)
+{
+	struct rb_node **link = &efi_mem.rb_node, *parent = NULL;
+	struct efi_mem_list *item;
+
+	while (*link) {
+		parent = *link;
+		item = rb_entry(parent, struct efi_mem_list, node);
+		if (new->desc.physical_start < item->desc.physical_start)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+	rb_link_node(&new->node, parent, link);
+	new->max_free = efi_mem_compute_max_free(new);
+	if (parent)
+		efi_mem_augment_propagate(parent, NULL);
+	rb_insert_augmented(&new->node, &efi_mem, &efi_mem_augment);
+	efi_mem_count++;
 }
 
-static uint64_t desc_get_end(struct efi_mem_desc *desc)
+/**
+ * efi_mem_remove() - remove an item from the memory map and free it
+ *
+ * @item:	memory map item
+ */
+static void efi_mem_remove(struct efi_mem_list *item)
 {
-	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
+	rb_erase_augmented(&item->node, &efi_mem, &efi_mem_augment);
+	efi_mem_count--;
+	free(item);
 }
 
-static void efi_mem_sort(void)
+/**
+ * efi_mem_search() - find the memory map item for an address
+ *
+ * @addr:	address
+ * Return:	node of the item containing @addr, or else of the first item
+ *		above @addr, or NULL if there is none
+ */
+static struct rb_node *efi_mem_search(u64 addr)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *prevmem = NULL;
-	bool merge_again = true;
-
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
-
-	/* Now merge entries that can be merged */
-	while (merge_again) {
-		merge_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			struct efi_mem_desc *prev = &prevmem->desc;
-			struct efi_mem_desc *cur;
-			uint64_t pages;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			if (!prevmem) {
-				prevmem = lmem;
-				continue;
-			}
-
-			cur = &lmem->desc;
-
-			if ((desc_get_end(cur) == prev->physical_start) &&
-			    (prev->type == cur->type) &&
-			    (prev->attribute == cur->attribute)) {
-				/* There is an existing map before, reuse it */
-				pages = cur->num_pages;
-				prev->num_pages += pages;
-				prev->physical_start -= pages << EFI_PAGE_SHIFT;
-				prev->virtual_start -= pages << EFI_PAGE_SHIFT;
-				list_del(&lmem->link);
-				free(lmem);
-
-				merge_again = true;
-				break;
-			}
-
-			prevmem = lmem;
+	struct rb_node *rb = efi_mem.rb_node, *found = NULL;
+	struct efi_mem_list *item;
+
+	while (rb) {
+		item = rb_entry(rb, struct efi_mem_list, node);
+		if (addr < item->desc.physical_start) {
+			found = rb;
+			rb = rb->rb_left;
+		} else if (addr >= desc_get_end(&item->desc)) {
+			rb = rb->rb_right;
+		} else {
+			return rb;
 		}
 	}
+
+	return found;
 }
 
-/** efi_mem_carve_out - unmap memory region
- *
- * @map:		memory map
- * @carve_desc:		memory region to unmap
- * @overlap_only_ram:	the carved out region may only overlap RAM
- * Return Value:	the number of overlapping pages which have been
- *			removed from the map,
- *			EFI_CARVE_NO_OVERLAP, if the regions don't overlap,
- *			EFI_CARVE_OVERLAPS_NONRAM, if the carve and map overlap,
- *			and the map contains anything but free ram
- *			(only when overlap_only_ram is true),
- *			EFI_CARVE_LOOP_AGAIN, if the mapping list should be
- *			traversed again, as it has been altered.
- *
- * Unmaps all memory occupied by the carve_desc region from the list entry
- * pointed to by map.
- *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to re-add the already carved out pages to the mapping.
+/**
+ * efi_mem_merge() - merge a memory map item with its neighbours
+ *
+ * @item:	memory map item
  */
-static s64 efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
+static void efi_mem_merge(struct efi_mem_list *item)
 {
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
-		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.virtual_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
+	struct efi_mem_list *other;
+	struct rb_node *rb;
+	u64 pages;
+
+	rb = rb_prev(&item->node);
+	if (rb) {
+		other = rb_entry(rb, struct efi_mem_list, node);
+		if (desc_get_end(&other->desc) == item->desc.physical_start &&
+		    other->desc.type == item->desc.type &&
+		    other->desc.attribute == item->desc.attribute) {
+			pages = item->desc.num_pages;
+			efi_mem_remove(item);
+			item = other;
+			item->desc.num_pages += pages;
+			efi_mem_update(item);
 		}
+	}
 
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
+	rb = rb_next(&item->node);
+	if (rb) {
+		other = rb_entry(rb, struct efi_mem_list, node);
+		if (desc_get_end(&item->desc) == other->desc.physical_start &&
+		    other->desc.type == item->desc.type &&
+		    other->desc.attribute == item->desc.attribute) {
+			pages = other->desc.num_pages;
+			efi_mem_remove(other);
+			item->desc.num_pages += pages;
+			efi_mem_update(item);
+		}
 	}
+}
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
+/**
+ * efi_mem_is_free() - check that a region is all free RAM
+ *
+ * @start:	start address of the region
+ * @end:	end address of the region (exclusive)
+ * Return:	true if the region is covered by EFI_CONVENTIONAL_MEMORY
+ */
+static bool efi_mem_is_free(u64 start, u64 end)
+{
+	struct efi_mem_list *item;
+	struct rb_node *rb;
+
+	for (rb = efi_mem_search(start); rb && start < end; rb = rb_next(rb)) {
+		item = rb_entry(rb, struct efi_mem_list, node);
+		if (item->desc.physical_start > start ||
+		    item->desc.type != EFI_CONVENTIONAL_MEMORY)
+			return false;
+		start = desc_get_end(&item->desc);
+	}
 
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.virtual_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
+	return start >= end;
+}
 
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+/**
+ * efi_mem_carve_out() - unmap memory region
+ *
+ * Removes the region from the memory map, shrinking or splitting the items
+ * which overlap it.
+ *
+ * @start:	start address of the region
+ * @end:	end address of the region (exclusive)
+ * Return:	status code
+ */
+static efi_status_t efi_mem_carve_out(u64 start, u64 end)
+{
+	struct efi_mem_list *item, *tail;
+	struct rb_node *rb, *next;
+	u64 item_start, item_end;
+
+	for (rb = efi_mem_search(start); rb; rb = next) {
+		item = rb_entry(rb, struct efi_mem_list, node);
+		item_start = item->desc.physical_start;
+		item_end = desc_get_end(&item->desc);
+		if (item_start >= end)
+			break;
+		next = rb_next(rb);
+
+		if (item_start < start && item_end > end) {
+			/* Split into [ item_start ... start ] [ end ... ] */
+			tail = calloc(1, sizeof(*tail));
+			if (!tail)
+				return EFI_OUT_OF_RESOURCES;
+			tail->desc = item->desc;
+			tail->desc.physical_start = end;
+			tail->desc.virtual_start = end;
+			tail->desc.num_pages = (item_end - end) >>
+					       EFI_PAGE_SHIFT;
+			item->desc.num_pages = (start - item_start) >>
+					       EFI_PAGE_SHIFT;
+			efi_mem_update(item);
+			efi_mem_insert(tail);
+			break;
+		} else if (item_start < start) {
+			item->desc.num_pages = (start - item_start) >>
+					       EFI_PAGE_SHIFT;
+			efi_mem_update(item);
+		} else if (item_end > end) {
+			item->desc.physical_start = end;
+			item->desc.num_pages = (item_end - end) >>
+					       EFI_PAGE_SHIFT;
+			efi_mem_update(item);
+		} else {
+			efi_mem_remove(item);
+		}
+	}
 
-	return EFI_CARVE_LOOP_AGAIN;
+	return EFI_SUCCESS;
 }
 
 /**
@@ -243,11 +366,10 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 					  int memory_type,
 					  bool overlap_only_ram)
 {
-	struct list_head *lhandle;
 	struct efi_mem_list *newlist;
-	bool carve_again;
-	uint64_t carved_pages = 0;
 	struct efi_event *evt;
+	u64 end = start + (pages << EFI_PAGE_SHIFT);
+	efi_status_t ret;
 
 	EFI_PRINT("%s: 0x%llx 0x%llx %d %s\n", __func__,
 		  start, pages, memory_type, overlap_only_ram ? "yes" : "no");
@@ -258,8 +380,17 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 	if (!pages)
 		return EFI_SUCCESS;
 
+	/*
+	 * The payload wanted to have RAM overlaps, but the region is not all
+	 * free RAM. Error out.
+	 */
+	if (overlap_only_ram && !efi_mem_is_free(start, end))
+		return EFI_NO_MAPPING;
+
 	++efi_memory_map_key;
 	newlist = calloc(1, sizeof(*newlist));
+	if (!newlist)
+		return EFI_OUT_OF_RESOURCES;
 	newlist->desc.type = memory_type;
 	newlist->desc.physical_start = start;
 	newlist->desc.virtual_start = start;
@@ -278,60 +409,16 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 		break;
 	}
 
-	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			s64 r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				return EFI_NO_MAPPING;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
-		}
-	} while (carve_again);
-
-	if (overlap_only_ram && (carved_pages != pages)) {
-		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
-		 */
-		return EFI_NO_MAPPING;
+	/* Remove whatever was mapped there before */
+	ret = efi_mem_carve_out(start, end);
+	if (ret != EFI_SUCCESS) {
+		free(newlist);
+		return ret;
 	}
 
 	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
-
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	efi_mem_insert(newlist);
+	efi_mem_merge(newlist);
 
 	/* Notify that the memory map was changed */
 	list_for_each_entry(evt, &efi_events, link) {
@@ -386,63 +473,66 @@ efi_status_t efi_add_memory_map(u64 start, u64 size, int memory_type)
 static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
 {
 	struct efi_mem_list *item;
+	struct rb_node *rb;
 
-	list_for_each_entry(item, &efi_mem, link) {
-		u64 start = item->desc.physical_start;
-		u64 end = start + (item->desc.num_pages << EFI_PAGE_SHIFT);
+	rb = efi_mem_search(addr);
+	if (!rb)
+		return EFI_NOT_FOUND;
+	item = rb_entry(rb, struct efi_mem_list, node);
+	if (addr < item->desc.physical_start)
+		return EFI_NOT_FOUND;
+	if (must_be_allocated ^ (item->desc.type == EFI_CONVENTIONAL_MEMORY))
+		return EFI_SUCCESS;
 
-		if (addr >= start && addr < end) {
-			if (must_be_allocated ^
-			    (item->desc.type == EFI_CONVENTIONAL_MEMORY))
-				return EFI_SUCCESS;
-			else
-				return EFI_NOT_FOUND;
-		}
+	return EFI_NOT_FOUND;
+}
+
+/**
+ * efi_mem_find_free() - find the highest free memory for an allocation
+ *
+ * Subtrees without a large enough item of free memory are skipped, so this
+ * normally only visits a path through the tree.
+ *
+ * @rb:		root of the subtree to search
+ * @len:	number of bytes to allocate, a multiple of EFI_PAGE_SIZE
+ * @max_addr:	end address for the allocation, aligned to EFI_PAGE_SIZE
+ * Return:	start address of the allocation, or 0 if none was found
+ */
+static u64 efi_mem_find_free(struct rb_node *rb, u64 len, u64 max_addr)
+{
+	struct efi_mem_list *item;
+	u64 ret, end;
+
+	if (!rb)
+		return 0;
+	item = rb_entry(rb, struct efi_mem_list, node);
+	if (item->max_free < (len >> EFI_PAGE_SHIFT))
+		return 0;
+
+	if (item->desc.physical_start < max_addr) {
+		/* Prefer the highest address */
+		ret = efi_mem_find_free(rb->rb_right, len, max_addr);
+		if (ret)
+			return ret;
+
+		end = min(max_addr, desc_get_end(&item->desc));
+		if (item->desc.type == EFI_CONVENTIONAL_MEMORY &&
+		    end - item->desc.physical_start >= len)
+			return end - len;
 	}
 
-	return EFI_NOT_FOUND;
+	return efi_mem_find_free(rb->rb_left, len, max_addr);
 }
 
 static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
 {
-	struct list_head *lhandle;
-
 	/*
 	 * Prealign input max address, so we simplify our matching
 	 * logic below and can just reuse it as return pointer.
 	 */
 	max_addr &= ~EFI_PAGE_MASK;
 
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
-		struct efi_mem_desc *desc = &lmem->desc;
-		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
-		uint64_t desc_end = desc->physical_start + desc_len;
-		uint64_t curmax = min(max_addr, desc_end);
-		uint64_t ret = curmax - len;
-
-		/* We only take memory from free RAM */
-		if (desc->type != EFI_CONVENTIONAL_MEMORY)
-			continue;
-
-		/* Out of bounds for max_addr */
-		if ((ret + len) > max_addr)
-			continue;
-
-		/* Out of bounds for upper map limit */
-		if ((ret + len) > desc_end)
-			continue;
-
-		/* Out of bounds for lower map limit */
-		if (ret < desc->physical_start)
-			continue;
-
-		/* Return the highest address in this map within bounds */
-		return ret;
-	}
-
-	return 0;
+	return efi_mem_find_free(efi_mem.rb_node, len, max_addr);
 }
 
 /*
@@ -601,6 +691,109 @@ void *efi_alloc_aligned_pages(u64 len, int memory_type, size_t align)
 	return (void *)(uintptr_t)aligned_mem;
 }
 
+/**
+ * efi_pool_full_map() - get the bitmap of a page with all slots free
+ *
+ * @size_class:	size class
+ * Return:	bitmap
+ */
+static u64 efi_pool_full_map(uint size_class)
+{
+	uint slots = (EFI_PAGE_SIZE - offsetof(struct efi_pool_page, slots)) /
+		     (EFI_POOL_MIN_SLOT << size_class);
+
+	return slots >= 64 ? ~0ULL : (1ULL << slots) - 1;
+}
+
+/**
+ * efi_pool_alloc_slot() - allocate a slot in a page shared with others
+ *
+ * @pool_type:	type of the pool, less than EFI_MAX_MEMORY_TYPE
+ * @size:	number of bytes to be allocated, at most EFI_POOL_MAX_SLOT
+ * @buffer:	allocated memory
+ * Return:	status code
+ */
+static efi_status_t efi_pool_alloc_slot(enum efi_memory_type pool_type,
+					efi_uintn_t size, void **buffer)
+{
+	struct efi_pool_page *page;
+	struct list_head *pages;
+	uint size_class, slot;
+	efi_status_t r;
+	u64 addr;
+
+	size = max_t(efi_uintn_t, size, EFI_POOL_MIN_SLOT);
+	size = max_t(efi_uintn_t, roundup_pow_of_two(size), ARCH_DMA_MINALIGN);
+	size_class = ilog2(size / EFI_POOL_MIN_SLOT);
+	pages = &efi_pool_pages[pool_type][size_class];
+
+	if (list_empty(pages)) {
+		r = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, pool_type, 1,
+				       &addr);
+		if (r != EFI_SUCCESS)
+			return r;
+		page = (struct efi_pool_page *)(uintptr_t)addr;
+		page->num_pages = 0;
+		page->checksum = checksum(page, 0);
+		page->free = efi_pool_full_map(size_class);
+		page->memory_type = pool_type;
+		page->size_class = size_class;
+		list_add(&page->link, pages);
+	}
+
+	page = list_first_entry(pages, struct efi_pool_page, link);
+	slot = __ffs64(page->free);
+	page->free &= ~(1ULL << slot);
+	if (!page->free)
+		list_del(&page->link);
+	*buffer = page->slots + (slot << (ilog2(EFI_POOL_MIN_SLOT) +
+					  page->size_class));
+
+	return EFI_SUCCESS;
+}
+
+/**
+ * efi_pool_free_slot() - free a slot allocated by efi_pool_alloc_slot()
+ *
+ * When none of its slots are in use, the page is freed unless it is the only
+ * page left for its size class. That one is kept so that allocating and
+ * freeing a single slot in a loop does not allocate and free a page each time.
+ *
+ * @page:	page holding the slot
+ * @buffer:	start of memory to be freed
+ * Return:	status code
+ */
+static efi_status_t efi_pool_free_slot(struct efi_pool_page *page,
+				       void *buffer)
+{
+	ulong offset = buffer - (void *)page->slots;
+	u64 full = efi_pool_full_map(page->size_class);
+	uint shift = ilog2(EFI_POOL_MIN_SLOT) + page->size_class;
+	struct list_head *pages;
+	u64 bit;
+
+	/* Check that this is an allocated slot */
+	if (buffer < (void *)page->slots || offset & ((1UL << shift) - 1) ||
+	    (offset >> shift) >= 64 ||
+	    !(full & ~page->free & (1ULL << (offset >> shift)))) {
+		printf("%s: illegal free 0x%p\n", __func__, buffer);
+		return EFI_INVALID_PARAMETER;
+	}
+	bit = 1ULL << (offset >> shift);
+	pages = &efi_pool_pages[page->memory_type][page->size_class];
+
+	if (!page->free)
+		list_add(&page->link, pages);
+	page->free |= bit;
+	if (page->free != full || list_is_singular(pages))
+		return EFI_SUCCESS;
+
+	list_del(&page->link);
+	page->checksum = 0;
+
+	return efi_free_pages((uintptr_t)page, 1);
+}
+
 /**
  * efi_allocate_pool - allocate memory from pool
  *
@@ -625,12 +818,16 @@ efi_status_t efi_allocate_pool(enum efi_memory_type pool_type, efi_uintn_t size,
 		return EFI_SUCCESS;
 	}
 
+	if (size <= EFI_POOL_MAX_SLOT && pool_type < EFI_MAX_MEMORY_TYPE &&
+	    pool_type != EFI_CONVENTIONAL_MEMORY)
+		return efi_pool_alloc_slot(pool_type, size, buffer);
+
 	r = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, pool_type, num_pages,
 			       &addr);
 	if (r == EFI_SUCCESS) {
 		alloc = (struct efi_pool_allocation *)(uintptr_t)addr;
 		alloc->num_pages = num_pages;
-		alloc->checksum = checksum(alloc);
+		alloc->checksum = checksum(alloc, num_pages);
 		*buffer = alloc->data;
 	}
 
@@ -647,6 +844,7 @@ efi_status_t efi_free_pool(void *buffer)
 {
 	efi_status_t ret;
 	struct efi_pool_allocation *alloc;
+	struct efi_pool_page *page;
 
 	if (!buffer)
 		return EFI_INVALID_PARAMETER;
@@ -655,11 +853,16 @@ efi_status_t efi_free_pool(void *buffer)
 	if (ret != EFI_SUCCESS)
 		return ret;
 
+	/* Small allocations share a page */
+	page = (struct efi_pool_page *)((uintptr_t)buffer & ~EFI_PAGE_MASK);
+	if (!page->num_pages && page->checksum == checksum(page, 0))
+		return efi_pool_free_slot(page, buffer);
+
 	alloc = container_of(buffer, struct efi_pool_allocation, data);
 
 	/* Check that this memory was allocated by efi_allocate_pool() */
 	if (((uintptr_t)alloc & EFI_PAGE_MASK) ||
-	    alloc->checksum != checksum(alloc)) {
+	    alloc->checksum != checksum(alloc, alloc->num_pages)) {
 		printf("%s: illegal free 0x%p\n", __func__, buffer);
 		return EFI_INVALID_PARAMETER;
 	}
@@ -689,8 +892,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 				uint32_t *descriptor_version)
 {
 	efi_uintn_t map_size = 0;
-	int map_entries = 0;
-	struct list_head *lhandle;
+	struct rb_node *rb;
 	efi_uintn_t provided_map_size;
 
 	if (!memory_map_size)
@@ -698,10 +900,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 
 	provided_map_size = *memory_map_size;
 
-	list_for_each(lhandle, &efi_mem)
-		map_entries++;
-
-	map_size = map_entries * sizeof(struct efi_mem_desc);
+	map_size = efi_mem_count * sizeof(struct efi_mem_desc);
 
 	*memory_map_size = map_size;
 
@@ -717,16 +916,9 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 	if (!memory_map)
 		return EFI_INVALID_PARAMETER;
 
-	/* Copy list into array */
-	/* Return the list in ascending order */
-	memory_map = &memory_map[map_entries - 1];
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem;
-
-		lmem = list_entry(lhandle, struct efi_mem_list, link);
-		*memory_map = lmem->desc;
-		memory_map--;
-	}
+	/* Copy the tree into the array, in ascending order */
+	for (rb = rb_first(&efi_mem); rb; rb = rb_next(rb))
+		*memory_map++ = rb_entry(rb, struct efi_mem_list, node)->desc;
 
 	if (map_key)
 		*map_key = efi_memory_map_key;
@@ -847,13 +1039,20 @@ static void add_u_boot_and_runtime(void)
 
 int efi_memory_init(void)
 {
+	int i, j;
+
+	for (i = 0; i < EFI_MAX_MEMORY_TYPE; i++) {
+		for (j = 0; j < EFI_POOL_CLASSES; j++)
+			INIT_LIST_HEAD(&efi_pool_pages[i][j]);
+	}
+
 	efi_add_known_memory();
 
 	add_u_boot_and_runtime();
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 	/* Request a 32bit 64MB bounce buffer region */
-	uint64_t efi_bounce_buffer_addr = 0xffffffff;
+	uint64_t efi_bounce_buffer_addr = EFI_LOADER_BOUNCE_BUFFER_LIMIT;
 
 	if (efi_allocate_pages(EFI_ALLOCATE_MAX_ADDRESS, EFI_LOADER_DATA,
 			       (64 * 1024 * 1024) >> EFI_PAGE_SHIFT,
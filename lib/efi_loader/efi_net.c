@@ -19,6 +19,7 @@
 #include <efi_loader.h>
 #include <malloc.h>
 #include <net.h>
+#include <linux/if_ether.h>
 
 static const efi_guid_t efi_net_guid = EFI_SIMPLE_NETWORK_PROTOCOL_GUID;
 static const efi_guid_t efi_pxe_base_code_protocol_guid =
@@ -30,6 +31,8 @@ static uchar **receive_buffer;
 static size_t *receive_lengths;
 static int rx_packet_idx;
 static int rx_packet_num;
+/* Number of packets in the receive ring */
+static int rx_ring_size;
 
 /*
  * The notification function of this event is called in every timer cycle
@@ -550,9 +553,17 @@ static efi_status_t EFIAPI efi_net_transmit
 		break;
 	}
 
-	/* Ethernet packets always fit, just bounce */
-	memcpy(transmit_buffer, buffer, buffer_size);
-	net_send_packet(transmit_buffer, buffer_size);
+	/*
+	 * Send straight from the caller's buffer if the driver can use it for
+	 * DMA. Some drivers pad short frames in place, so bounce those.
+	 */
+	if (IS_ALIGNED((uintptr_t)buffer, PKTALIGN) &&
+	    buffer_size >= ETH_ZLEN) {
+		net_send_packet(buffer, buffer_size);
+	} else {
+		memcpy(transmit_buffer, buffer, buffer_size);
+		net_send_packet(transmit_buffer, buffer_size);
+	}
 
 	new_tx_packet = buffer;
 	this->int_status |= EFI_SIMPLE_NETWORK_TRANSMIT_INTERRUPT;
@@ -560,6 +571,60 @@ out:
 	return EFI_EXIT(ret);
 }
 
+/**
+ * efi_net_push() - callback for received network packet
+ *
+ * This function is called when a network packet is received by eth_rx().
+ *
+ * @pkt:	network packet
+ * @len:	length
+ */
+static void efi_net_push(void *pkt, int len)
+{
+	int rx_packet_next;
+
+	/* Check that we at least received an Ethernet header */
+	if (len < sizeof(struct ethernet_hdr))
+		return;
+
+	/* Check that the buffer won't overflow */
+	if (len > PKTSIZE_ALIGN)
+		return;
+
+	/* Can't store more than pre-alloced buffer */
+	if (rx_packet_num >= rx_ring_size)
+		return;
+
+	rx_packet_next = (rx_packet_idx + rx_packet_num) % rx_ring_size;
+	memcpy(receive_buffer[rx_packet_next], pkt, len);
+	receive_lengths[rx_packet_next] = len;
+
+	rx_packet_num++;
+}
+
+/**
+ * efi_net_poll() - receive packets from the network device into the ring
+ *
+ * A single eth_rx() may deliver a batch of up to ETH_PACKETS_BATCH_RECV
+ * packets, so the device is only polled when there is room for a whole batch.
+ * This leaves packets in the device rather than dropping them.
+ *
+ * @this:	the instance of the Simple Network Protocol
+ */
+static void efi_net_poll(struct efi_simple_network *this)
+{
+	if (rx_ring_size - rx_packet_num < ETH_PACKETS_BATCH_RECV)
+		return;
+
+	push_packet = efi_net_push;
+	eth_rx();
+	push_packet = NULL;
+	if (rx_packet_num) {
+		this->int_status |= EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT;
+		wait_for_packet->is_signaled = true;
+	}
+}
+
 /**
  * efi_net_receive() - receive a packet from a network interface
  *
@@ -609,6 +674,9 @@ static efi_status_t EFIAPI efi_net_receive
 		break;
 	}
 
+	/* Fetch the next batch of packets if the ring is empty */
+	if (!rx_packet_num)
+		efi_net_poll(this);
 	if (!rx_packet_num) {
 		ret = EFI_NOT_READY;
 		goto out;
@@ -638,7 +706,7 @@ static efi_status_t EFIAPI efi_net_receive
 	memcpy(buffer, receive_buffer[rx_packet_idx],
 	       receive_lengths[rx_packet_idx]);
 	*buffer_size = receive_lengths[rx_packet_idx];
-	rx_packet_idx = (rx_packet_idx + 1) % ETH_PACKETS_BATCH_RECV;
+	rx_packet_idx = (rx_packet_idx + 1) % rx_ring_size;
 	rx_packet_num--;
 	if (rx_packet_num)
 		wait_for_packet->is_signaled = true;
@@ -666,38 +734,6 @@ void efi_net_set_dhcp_ack(void *pkt, int len)
 	memcpy(dhcp_ack, pkt, min(len, maxsize));
 }
 
-/**
- * efi_net_push() - callback for received network packet
- *
- * This function is called when a network packet is received by eth_rx().
- *
- * @pkt:	network packet
- * @len:	length
- */
-static void efi_net_push(void *pkt, int len)
-{
-	int rx_packet_next;
-
-	/* Check that we at least received an Ethernet header */
-	if (len < sizeof(struct ethernet_hdr))
-		return;
-
-	/* Check that the buffer won't overflow */
-	if (len > PKTSIZE_ALIGN)
-		return;
-
-	/* Can't store more than pre-alloced buffer */
-	if (rx_packet_num >= ETH_PACKETS_BATCH_RECV)
-		return;
-
-	rx_packet_next = (rx_packet_idx + rx_packet_num) %
-	    ETH_PACKETS_BATCH_RECV;
-	memcpy(receive_buffer[rx_packet_next], pkt, len);
-	receive_lengths[rx_packet_next] = len;
-
-	rx_packet_num++;
-}
-
 /**
  * efi_network_timer_notify() - check if a new network packet has been received
  *
@@ -720,16 +756,7 @@ static void EFIAPI efi_network_timer_notify(struct efi_event *event,
 	if (!this || this->mode->state != EFI_NETWORK_INITIALIZED)
 		goto out;
 
-	if (!rx_packet_num) {
-		push_packet = efi_net_push;
-		eth_rx();
-		push_packet = NULL;
-		if (rx_packet_num) {
-			this->int_status |=
-				EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT;
-			wait_for_packet->is_signaled = true;
-		}
-	}
+	efi_net_poll(this);
 out:
 	EFI_EXIT(EFI_SUCCESS);
 }
@@ -873,18 +900,21 @@ efi_status_t efi_net_register(void)
 		goto out_of_resources;
 	transmit_buffer = (void *)ALIGN((uintptr_t)transmit_buffer, PKTALIGN);
 
-	/* Allocate a number of receive buffers */
-	receive_buffer = calloc(ETH_PACKETS_BATCH_RECV,
-				sizeof(*receive_buffer));
+	/*
+	 * Allocate a number of receive buffers: enough for the driver's own
+	 * receive buffers, and for a whole batch from eth_rx() while the
+	 * payload is still reading the previous one.
+	 */
+	rx_ring_size = 2 * max(PKTBUFSRX, ETH_PACKETS_BATCH_RECV);
+	receive_buffer = calloc(rx_ring_size, sizeof(*receive_buffer));
 	if (!receive_buffer)
 		goto out_of_resources;
-	for (i = 0; i < ETH_PACKETS_BATCH_RECV; i++) {
+	for (i = 0; i < rx_ring_size; i++) {
 		receive_buffer[i] = malloc(PKTSIZE_ALIGN);
 		if (!receive_buffer[i])
 			goto out_of_resources;
 	}
-	receive_lengths = calloc(ETH_PACKETS_BATCH_RECV,
-				 sizeof(*receive_lengths));
+	receive_lengths = calloc(rx_ring_size, sizeof(*receive_lengths));
 	if (!receive_lengths)
 		goto out_of_resources;
 
@@ -984,7 +1014,7 @@ out_of_resources:
 	free(netobj);
 	free(transmit_buffer);
 	if (receive_buffer)
-		for (i = 0; i < ETH_PACKETS_BATCH_RECV; i++)
+		for (i = 0; i < rx_ring_size; i++)
 			free(receive_buffer[i]);
 	free(receive_buffer);
 	free(receive_lengths);
@@ -11,6 +11,8 @@
  * ConnectController is used to setup partitions and to install the simple
  * file protocol.
  * A known file is read from the file system and verified.
+ * The block IO 2 protocol of the partition is checked against the block IO
+ * protocol.
  */
 
 #include <efi_selftest.h>
@@ -26,6 +28,7 @@
 static struct efi_boot_services *boottime;
 
 static const efi_guid_t block_io_protocol_guid = EFI_BLOCK_IO_PROTOCOL_GUID;
+static const efi_guid_t block_io2_protocol_guid = EFI_BLOCK_IO2_PROTOCOL_GUID;
 static const efi_guid_t guid_device_path = EFI_DEVICE_PATH_PROTOCOL_GUID;
 static const efi_guid_t guid_simple_file_system_protocol =
 					EFI_SIMPLE_FILE_SYSTEM_PROTOCOL_GUID;
@@ -289,6 +292,88 @@ static efi_uintn_t dp_size(struct efi_device_path *dp)
 	return (char *)pos - (char *)dp;
 }
 
+/*
+ * Check the block IO 2 protocol of a partition.
+ *
+ * A block is read with a blocking and with a non-blocking request and
+ * compared to the same block read with the block IO protocol.
+ *
+ * @handle:	partition handle
+ * @block_io:	block IO protocol of the partition
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int check_block_io2(efi_handle_t handle, struct efi_block_io *block_io)
+{
+	struct efi_block_io2 *block_io2;
+	struct efi_block_io2_token token;
+	u8 expect[1 << LB_BLOCK_SIZE] __aligned(ARCH_DMA_MINALIGN);
+	u8 buf[1 << LB_BLOCK_SIZE] __aligned(ARCH_DMA_MINALIGN);
+	efi_status_t ret;
+
+	ret = boottime->open_protocol(handle, &block_io2_protocol_guid,
+				      (void **)&block_io2, NULL, NULL,
+				      EFI_OPEN_PROTOCOL_GET_PROTOCOL);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Failed to open block IO 2 protocol\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = block_io->read_blocks(block_io, block_io->media->media_id, 0,
+				    sizeof(expect), expect);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("ReadBlocks failed\n");
+		return EFI_ST_FAILURE;
+	}
+
+	/* Blocking request */
+	ret = block_io2->read_blocks_ex(block_io2, block_io2->media->media_id,
+					0, NULL, sizeof(buf), buf);
+	if (ret != EFI_SUCCESS || memcmp(buf, expect, sizeof(buf))) {
+		efi_st_error("Blocking ReadBlocksEx failed\n");
+		return EFI_ST_FAILURE;
+	}
+
+	/* Non-blocking request */
+	boottime->set_mem(buf, sizeof(buf), 0);
+	ret = boottime->create_event(0, TPL_CALLBACK, NULL, NULL,
+				     &token.event);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Failed to create event\n");
+		return EFI_ST_FAILURE;
+	}
+	token.transaction_status = EFI_NOT_READY;
+	ret = block_io2->read_blocks_ex(block_io2, block_io2->media->media_id,
+					0, &token, sizeof(buf), buf);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Non-blocking ReadBlocksEx failed\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->check_event(token.event);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Event not signaled\n");
+		return EFI_ST_FAILURE;
+	}
+	if (token.transaction_status != EFI_SUCCESS ||
+	    memcmp(buf, expect, sizeof(buf))) {
+		efi_st_error("Non-blocking ReadBlocksEx read wrong data\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->close_event(token.event);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Failed to close event\n");
+		return EFI_ST_FAILURE;
+	}
+
+	/* Only whole blocks can be read */
+	ret = block_io2->read_blocks_ex(block_io2, block_io2->media->media_id,
+					0, NULL, sizeof(buf) - 1, buf);
+	if (ret != EFI_BAD_BUFFER_SIZE) {
+		efi_st_error("ReadBlocksEx accepted a partial block\n");
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
 /*
  * Execute unit test.
  *
@@ -372,6 +457,9 @@ static int execute(void)
 			     part1_size - 1);
 		return EFI_ST_FAILURE;
 	}
+	if (check_block_io2(handle_partition, block_io_protocol) !=
+	    EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
 	/* Open the simple file system protocol */
 	ret = boottime->open_protocol(handle_partition,
 				      &guid_simple_file_system_protocol,
@@ -5,7 +5,7 @@
  * Copyright (c) 2018 Heinrich Schuchardt <xypron.glpk@gmx.de>
  *
  * This unit test checks the following boottime services:
- * AllocatePages, FreePages, GetMemoryMap
+ * AllocatePages, FreePages, GetMemoryMap, AllocatePool, FreePool
  *
  * The memory type used for the device tree is checked.
  */
@@ -14,6 +14,10 @@
 
 #define EFI_ST_NUM_PAGES 8
 
+/* Number and size of small pool allocations */
+#define EFI_ST_NUM_POOLS 100
+#define EFI_ST_POOL_SIZE 24
+
 static const efi_guid_t fdt_guid = EFI_FDT_GUID;
 static struct efi_boot_services *boottime;
 static u64 fdt_addr;
@@ -184,9 +188,132 @@ static int execute(void)
 	return EFI_ST_SUCCESS;
 }
 
+/**
+ * setup_pool() - setup unit test for small pool allocations
+ *
+ * @handle:	handle of the loaded image
+ * @systable:	system table
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int setup_pool(const efi_handle_t handle,
+		      const struct efi_system_table *systable)
+{
+	boottime = systable->boottime;
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * get_map_entries() - get the number of entries in the memory map
+ *
+ * @count:	receives the number of entries
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int get_map_entries(efi_uintn_t *count)
+{
+	efi_uintn_t map_size = 0, map_key, desc_size;
+	u32 desc_version;
+	efi_status_t ret;
+
+	ret = boottime->get_memory_map(&map_size, NULL, &map_key, &desc_size,
+				       &desc_version);
+	if (ret != EFI_BUFFER_TOO_SMALL) {
+		efi_st_error
+			("GetMemoryMap did not return EFI_BUFFER_TOO_SMALL\n");
+		return EFI_ST_FAILURE;
+	}
+	*count = map_size / desc_size;
+
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * execute_pool() - execute unit test for small pool allocations
+ *
+ * Small pool allocations must not each take a memory map entry.
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int execute_pool(void)
+{
+	u8 *pools[EFI_ST_NUM_POOLS];
+	efi_uintn_t before, after;
+	efi_status_t ret;
+	int i, j;
+
+	if (get_map_entries(&before) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	for (i = 0; i < EFI_ST_NUM_POOLS; ++i) {
+		ret = boottime->allocate_pool(EFI_LOADER_DATA,
+					      EFI_ST_POOL_SIZE,
+					      (void **)&pools[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("AllocatePool did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+		if ((uintptr_t)pools[i] & 7) {
+			efi_st_error("Pool memory is not 8 byte aligned\n");
+			return EFI_ST_FAILURE;
+		}
+		boottime->set_mem(pools[i], EFI_ST_POOL_SIZE, i);
+	}
+	if (get_map_entries(&after) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	if (after > before + 4) {
+		efi_st_error("Memory map grew from %u to %u entries\n",
+			     (unsigned int)before, (unsigned int)after);
+		return EFI_ST_FAILURE;
+	}
+
+	/* Check that no allocations overlap */
+	for (i = 0; i < EFI_ST_NUM_POOLS; ++i) {
+		for (j = 0; j < EFI_ST_POOL_SIZE; ++j) {
+			if (pools[i][j] != (u8)i) {
+				efi_st_error("Pool allocations overlap\n");
+				return EFI_ST_FAILURE;
+			}
+		}
+	}
+
+	ret = boottime->free_pool(pools[0]);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("FreePool did not return EFI_SUCCESS\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->free_pool(pools[0]);
+	if (ret == EFI_SUCCESS) {
+		efi_st_error("FreePool accepted a duplicate free\n");
+		return EFI_ST_FAILURE;
+	}
+	for (i = 1; i < EFI_ST_NUM_POOLS; ++i) {
+		ret = boottime->free_pool(pools[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("FreePool did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	if (get_map_entries(&after) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	/* One empty page may stay cached for the size class */
+	if (after > before + 1) {
+		efi_st_error("Memory map has %u entries, expected %u\n",
+			     (unsigned int)after, (unsigned int)before);
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
 EFI_UNIT_TEST(memory) = {
 	.name = "memory",
 	.phase = EFI_EXECUTE_BEFORE_BOOTTIME_EXIT,
 	.setup = setup,
 	.execute = execute,
 };
+
+EFI_UNIT_TEST(memory_pool) = {
+	.name = "memory pool",
+	.phase = EFI_EXECUTE_BEFORE_BOOTTIME_EXIT,
+	.setup = setup_pool,
+	.execute = execute_pool,
+};
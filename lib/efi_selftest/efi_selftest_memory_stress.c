@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * efi_selftest_memory_stress
+ *
+ * This unit test stresses the memory map with many small allocations:
+ * AllocatePages, FreePages, GetMemoryMap
+ *
+ * Neighbouring allocations use different memory types, so each one adds an
+ * entry to the memory map.
+ */
+
+#include <efi_selftest.h>
+
+/* Number of allocations */
+#define EFI_ST_NUM_ALLOCS 10000
+
+/* Spare entries in the memory map buffer */
+#define EFI_ST_SPARE_DESCS 64
+
+static struct efi_boot_services *boottime;
+static u64 *addrs;
+static struct efi_mem_desc *memory_map;
+static efi_uintn_t map_buf_size;
+
+/**
+ * setup() - setup unit test
+ *
+ * @handle:	handle of the loaded image
+ * @systable:	system table
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int setup(const efi_handle_t handle,
+		 const struct efi_system_table *systable)
+{
+	efi_uintn_t map_size = 0, map_key, desc_size;
+	u32 desc_version;
+	efi_status_t ret;
+
+	boottime = systable->boottime;
+
+	ret = boottime->allocate_pool(EFI_LOADER_DATA,
+				      EFI_ST_NUM_ALLOCS * sizeof(*addrs),
+				      (void **)&addrs);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Failed to allocate pool\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->get_memory_map(&map_size, NULL, &map_key, &desc_size,
+				       &desc_version);
+	if (ret != EFI_BUFFER_TOO_SMALL) {
+		efi_st_error("GetMemoryMap did not return EFI_BUFFER_TOO_SMALL\n");
+		return EFI_ST_FAILURE;
+	}
+	map_buf_size = map_size + (EFI_ST_NUM_ALLOCS + EFI_ST_SPARE_DESCS) *
+		       desc_size;
+	ret = boottime->allocate_pool(EFI_LOADER_DATA, map_buf_size,
+				      (void **)&memory_map);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Failed to allocate pool\n");
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * teardown() - tear down unit test
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int teardown(void)
+{
+	int ret = EFI_ST_SUCCESS;
+
+	if (addrs && boottime->free_pool(addrs) != EFI_SUCCESS) {
+		efi_st_error("Failed to free pool\n");
+		ret = EFI_ST_FAILURE;
+	}
+	if (memory_map && boottime->free_pool(memory_map) != EFI_SUCCESS) {
+		efi_st_error("Failed to free pool\n");
+		ret = EFI_ST_FAILURE;
+	}
+
+	return ret;
+}
+
+/**
+ * check_memory_map() - check the memory map is sorted and get its size
+ *
+ * @count:	receives the number of entries
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int check_memory_map(efi_uintn_t *count)
+{
+	efi_uintn_t map_size = map_buf_size, map_key, desc_size, i;
+	struct efi_mem_desc *prev, *entry;
+	u32 desc_version;
+	efi_status_t ret;
+
+	ret = boottime->get_memory_map(&map_size, memory_map, &map_key,
+				       &desc_size, &desc_version);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("GetMemoryMap failed\n");
+		return EFI_ST_FAILURE;
+	}
+	*count = map_size / desc_size;
+	for (i = 1; i < *count; ++i) {
+		prev = (void *)memory_map + (i - 1) * desc_size;
+		entry = (void *)memory_map + i * desc_size;
+		if (prev->physical_start +
+		    (prev->num_pages << EFI_PAGE_SHIFT) >
+		    entry->physical_start) {
+			efi_st_error("Memory map entries overlap\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * execute() - execute unit test
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int execute(void)
+{
+	efi_uintn_t count, start_count;
+	efi_status_t ret;
+	int i, j;
+
+	if (check_memory_map(&start_count) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+
+	for (i = 0; i < EFI_ST_NUM_ALLOCS; ++i) {
+		ret = boottime->allocate_pages(EFI_ALLOCATE_ANY_PAGES,
+					       i & 1 ? EFI_LOADER_DATA :
+					       EFI_BOOT_SERVICES_DATA,
+					       1, &addrs[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("AllocatePages failed after %u pages\n",
+				     i);
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	if (check_memory_map(&count) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	if (count < EFI_ST_NUM_ALLOCS) {
+		efi_st_error("Memory map has %u entries, expected at least %u\n",
+			     (unsigned int)count, EFI_ST_NUM_ALLOCS);
+		return EFI_ST_FAILURE;
+	}
+
+	/* Free every other allocation first, then the rest */
+	for (j = 0; j < 2; ++j) {
+		for (i = j; i < EFI_ST_NUM_ALLOCS; i += 2) {
+			ret = boottime->free_pages(addrs[i], 1);
+			if (ret != EFI_SUCCESS) {
+				efi_st_error("FreePages failed\n");
+				return EFI_ST_FAILURE;
+			}
+		}
+	}
+
+	if (check_memory_map(&count) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	if (count != start_count) {
+		efi_st_error("Memory map has %u entries, expected %u\n",
+			     (unsigned int)count, (unsigned int)start_count);
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+EFI_UNIT_TEST(memstress) = {
+	.name = "memory map stress",
+	.phase = EFI_EXECUTE_BEFORE_BOOTTIME_EXIT,
+	.setup = setup,
+	.execute = execute,
+	.teardown = teardown,
+	.on_request = true,
+};
@@ -10,12 +10,16 @@
  * A DHCP discover message is sent. The test is successful if a
  * DHCP reply is received.
  *
+ * Then frames are sent to our own MAC address from a DMA-aligned buffer, to
+ * check that each transmit buffer is handed back by GetStatus.
+ *
  * TODO: Once ConnectController and DisconnectController are implemented
  *	 we should connect our code as controller.
  */
 
 #include <efi_selftest.h>
 #include <net.h>
+#include <asm/cache.h>
 
 /*
  * MAC address for broadcasts
@@ -45,6 +49,15 @@ struct dhcp_hdr {
 	u8 file[128];
 };
 
+/* IEEE 802 local experimental ethertype, used for loopback frames */
+#define PROT_LOCAL_EXP		0x88b5
+
+/* Size of a loopback frame, the minimum Ethernet frame */
+#define LOOPBACK_FRAME_SIZE	60
+
+/* Number of loopback frames to send */
+#define LOOPBACK_FRAMES		100
+
 /*
  * Message type option.
  */
@@ -167,6 +180,57 @@ static efi_status_t send_dhcp_discover(void)
 	return ret;
 }
 
+/*
+ * Send frames to our own MAC address.
+ *
+ * The frames are sent from a DMA-aligned buffer, which may be transmitted
+ * without a copy. GetStatus must hand back this buffer after each frame.
+ * Whatever arrives meanwhile is received and dropped.
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int send_loopback(void)
+{
+	static u8 frame[LOOPBACK_FRAME_SIZE] __aligned(ARCH_DMA_MINALIGN);
+	u8 buffer[PKTSIZE];
+	struct ethernet_hdr *hdr = (struct ethernet_hdr *)frame;
+	size_t buffer_size;
+	efi_status_t ret;
+	void *txbuf;
+	int i;
+
+	boottime->copy_mem(hdr->et_dest, &net->mode->current_address,
+			   ARP_HLEN);
+	boottime->copy_mem(hdr->et_src, &net->mode->current_address,
+			   ARP_HLEN);
+	hdr->et_protlen = htons(PROT_LOCAL_EXP);
+
+	for (i = 0; i < LOOPBACK_FRAMES; ++i) {
+		ret = net->transmit(net, 0, sizeof(frame), frame, NULL, NULL,
+				    NULL);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("Failed to transmit frame\n");
+			return EFI_ST_FAILURE;
+		}
+		ret = net->get_status(net, NULL, &txbuf);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("Failed to get status\n");
+			return EFI_ST_FAILURE;
+		}
+		if (txbuf != frame) {
+			efi_st_error("Transmit buffer not recycled\n");
+			return EFI_ST_FAILURE;
+		}
+		do {
+			buffer_size = sizeof(buffer);
+			ret = net->receive(net, NULL, &buffer_size, buffer,
+					   NULL, NULL, NULL);
+		} while (ret == EFI_SUCCESS);
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
 /*
  * Setup unit test.
  *
@@ -413,7 +477,7 @@ received:
 	else
 		efi_st_printf("as unicast message.\n");
 
-	return EFI_ST_SUCCESS;
+	return send_loopback();
 }
 
 /*
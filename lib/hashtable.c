@@ -63,12 +63,57 @@
 
 struct env_entry_node {
 	int used;
+	bool dirty;	/* changed since the last hclear_dirty_r() */
 	struct env_entry entry;
 };
 
 
 static void _hdelete(const char *key, struct hsearch_data *htab,
-		     struct env_entry *ep, int idx);
+		     struct env_entry *ep, int idx, bool record);
+
+/*
+ * Dirty tracking
+ */
+
+/* Forget the sorted list of keys, it is rebuilt on the next export */
+static void hdrop_sorted(struct hsearch_data *htab)
+{
+	free(htab->sorted);
+	htab->sorted = NULL;
+	htab->nsorted = 0;
+}
+
+/*
+ * Record that the entry in slot "idx" has been created, changed or deleted.
+ * If the set of keys changed, the sorted list used for exporting is dropped.
+ */
+static void hmark_dirty(struct hsearch_data *htab, int idx, bool keys_changed)
+{
+	if (!htab->table[idx].dirty) {
+		htab->table[idx].dirty = true;
+		++htab->dirty;
+	}
+	if (keys_changed)
+		hdrop_sorted(htab);
+}
+
+/*
+ * Clear the dirty state of slot "idx". Deleted entries keep their key until
+ * then, so that the deletion can still be reported by hwalk_dirty_r().
+ */
+static void hmark_clean(struct hsearch_data *htab, int idx)
+{
+	struct env_entry_node *node = &htab->table[idx];
+
+	if (node->used == USED_DELETED) {
+		free((void *)node->entry.key);
+		node->entry.key = NULL;
+	}
+	if (node->dirty) {
+		node->dirty = false;
+		--htab->dirty;
+	}
+}
 
 /*
  * hcreate()
@@ -162,12 +207,20 @@ void hdestroy_r(struct hsearch_data *htab)
 
 			free((void *)ep->key);
 			free(ep->data);
+		} else if (htab->table[i].used == USED_DELETED) {
+			/* name of a deletion not yet cleared */
+			free((void *)htab->table[i].entry.key);
 		}
 	}
 	free(htab->table);
+	hdrop_sorted(htab);
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
+
+	/* deletions are lost, whatever comes next must be written in full */
+	htab->dirty = 0;
+	htab->dirty_all = true;
 }
 
 /*
@@ -272,12 +325,18 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 				return 0;
 			}
 
-			free(htab->table[idx].entry.data);
-			htab->table[idx].entry.data = strdup(item.data);
-			if (!htab->table[idx].entry.data) {
-				__set_errno(ENOMEM);
-				*retval = NULL;
-				return 0;
+			/* Setting the same value again is not a change */
+			if (strcmp(htab->table[idx].entry.data, item.data)) {
+				char *data = strdup(item.data);
+
+				if (!data) {
+					__set_errno(ENOMEM);
+					*retval = NULL;
+					return 0;
+				}
+				free(htab->table[idx].entry.data);
+				htab->table[idx].entry.data = data;
+				hmark_dirty(htab, idx, false);
 			}
 		}
 		/* return found entry */
@@ -288,6 +347,31 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 	return -1;
 }
 
+/*
+ * Note a deleted slot passed while probing for "key", which may be reused for
+ * a new entry. A pending (dirty) deletion of the same key is the best choice,
+ * since the new entry supersedes it; otherwise the first clean slot is used.
+ * Pending deletions of other keys are only reused as a last resort.
+ */
+static void hpick_deleted(struct hsearch_data *htab, unsigned int idx,
+			  const char *key, unsigned int *reuse,
+			  unsigned int *reuse_dirty)
+{
+	struct env_entry_node *node = &htab->table[idx];
+
+	if (node->used != USED_DELETED)
+		return;
+
+	if (!node->dirty) {
+		if (!*reuse)
+			*reuse = idx;
+	} else if (!strcmp(node->entry.key, key)) {
+		*reuse = idx;
+	} else if (!*reuse_dirty) {
+		*reuse_dirty = idx;
+	}
+}
+
 int hsearch_r(struct env_entry item, enum env_action action,
 	      struct env_entry **retval, struct hsearch_data *htab, int flag)
 {
@@ -296,6 +380,8 @@ int hsearch_r(struct env_entry item, enum env_action action,
 	unsigned int len = strlen(item.key);
 	unsigned int idx;
 	unsigned int first_deleted = 0;
+	unsigned int first_dirty = 0;
+	bool was_pending = false;
 	int ret;
 
 	/* Compute an value for the given string. Perhaps use a better method. */
@@ -324,8 +410,8 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		 */
 		unsigned hval2;
 
-		if (htab->table[idx].used == USED_DELETED)
-			first_deleted = idx;
+		hpick_deleted(htab, idx, item.key, &first_deleted,
+			      &first_dirty);
 
 		ret = _compare_and_overwrite_entry(item, action, retval, htab,
 			flag, hval, idx);
@@ -355,9 +441,8 @@ int hsearch_r(struct env_entry item, enum env_action action,
 			if (idx == hval)
 				break;
 
-			if (htab->table[idx].used == USED_DELETED
-			    && !first_deleted)
-				first_deleted = idx;
+			hpick_deleted(htab, idx, item.key, &first_deleted,
+				      &first_dirty);
 
 			/* If entry is found use it. */
 			ret = _compare_and_overwrite_entry(item, action, retval,
@@ -380,12 +465,24 @@ int hsearch_r(struct env_entry item, enum env_action action,
 			return 0;
 		}
 
+		/*
+		 * Without a free slot we have to drop an unsaved deletion, so
+		 * the dirty set is no longer complete.
+		 */
+		if (!first_deleted && htab->table[idx].used != USED_FREE) {
+			first_deleted = first_dirty;
+			htab->dirty_all = true;
+		}
+
 		/*
 		 * Create new entry;
 		 * create copies of item.key and item.data
 		 */
-		if (first_deleted)
+		if (first_deleted) {
 			idx = first_deleted;
+			was_pending = htab->table[idx].dirty;
+			hmark_clean(htab, idx);
+		}
 
 		htab->table[idx].used = hval;
 		htab->table[idx].entry.key = strdup(item.key);
@@ -398,6 +495,7 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		}
 
 		++htab->filled;
+		hmark_dirty(htab, idx, true);
 
 		/* This is a new entry, so look up a possible callback */
 		env_callback_init(&htab->table[idx].entry);
@@ -409,7 +507,8 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		    &htab->table[idx].entry, item.data, env_op_create, flag)) {
 			debug("change_ok() rejected setting variable "
 				"%s, skipping it!\n", item.key);
-			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
+			_hdelete(item.key, htab, &htab->table[idx].entry, idx,
+				 was_pending);
 			__set_errno(EPERM);
 			*retval = NULL;
 			return 0;
@@ -420,7 +519,8 @@ int hsearch_r(struct env_entry item, enum env_action action,
 				env_op_create, flag)) {
 			debug("callback() rejected setting variable "
 				"%s, skipping it!\n", item.key);
-			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
+			_hdelete(item.key, htab, &htab->table[idx].entry, idx,
+				 was_pending);
 			__set_errno(EINVAL);
 			*retval = NULL;
 			return 0;
@@ -448,15 +548,27 @@ int hsearch_r(struct env_entry item, enum env_action action,
  */
 
 static void _hdelete(const char *key, struct hsearch_data *htab,
-		     struct env_entry *ep, int idx)
+		     struct env_entry *ep, int idx, bool record)
 {
 	/* free used entry */
 	debug("hdelete: DELETING key \"%s\"\n", key);
-	free((void *)ep->key);
 	free(ep->data);
+	ep->data = NULL;
 	ep->flags = 0;
 	htab->table[idx].used = USED_DELETED;
 
+	/*
+	 * A recorded deletion keeps the key until hclear_dirty_r(), otherwise
+	 * (e.g. a rejected new entry) the slot is simply released. A rejected
+	 * new entry which replaced a pending deletion keeps recording it.
+	 */
+	if (record) {
+		hmark_dirty(htab, idx, true);
+	} else {
+		hmark_clean(htab, idx);
+		hdrop_sorted(htab);
+	}
+
 	--htab->filled;
 }
 
@@ -493,7 +605,7 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 		return -EINVAL;
 	}
 
-	_hdelete(key, htab, ep, idx);
+	_hdelete(key, htab, ep, idx, true);
 
 	return 0;
 }
@@ -549,6 +661,32 @@ static int cmpkey(const void *p1, const void *p2)
 	return (strcmp(e1->key, e2->key));
 }
 
+/*
+ * Return the list of all used entries sorted by key. The list is kept until
+ * an entry is added or deleted, so that exporting an environment where only
+ * values changed (the common case for "saveenv") does not sort again.
+ */
+static struct env_entry **hsort_entries(struct hsearch_data *htab)
+{
+	unsigned int i, n;
+
+	if (htab->sorted)
+		return htab->sorted;
+
+	htab->sorted = malloc(sizeof(*htab->sorted) * (htab->filled + 1));
+	if (!htab->sorted)
+		return NULL;
+
+	for (i = 1, n = 0; i <= htab->size; ++i) {
+		if (htab->table[i].used > 0)
+			htab->sorted[n++] = &htab->table[i].entry;
+	}
+	qsort(htab->sorted, n, sizeof(*htab->sorted), cmpkey);
+	htab->nsorted = n;
+
+	return htab->sorted;
+}
+
 static int match_string(int flag, const char *str, const char *pat, void *priv)
 {
 	switch (flag & H_MATCH_METHOD) {
@@ -612,6 +750,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		 int argc, char *const argv[])
 {
 	struct env_entry *list[htab->size];
+	struct env_entry **sorted;
 	char *res, *p;
 	size_t totlen;
 	int i, n;
@@ -624,56 +763,48 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 
 	debug("EXPORT  table = %p, htab.size = %d, htab.filled = %d, size = %lu\n",
 	      htab, htab->size, htab->filled, (ulong)size);
+	/* Get the entries sorted by keys */
+	sorted = hsort_entries(htab);
+	if (!sorted) {
+		__set_errno(ENOMEM);
+		return (-1);
+	}
+
 	/*
 	 * Pass 1:
-	 * search used entries,
+	 * select used entries,
 	 * save addresses and compute total length
 	 */
-	for (i = 1, n = 0, totlen = 0; i <= htab->size; ++i) {
-
-		if (htab->table[i].used > 0) {
-			struct env_entry *ep = &htab->table[i].entry;
-			int found = match_entry(ep, flag, argc, argv);
+	for (i = 0, n = 0, totlen = 0; i < htab->nsorted; ++i) {
+		struct env_entry *ep = sorted[i];
+		int found = match_entry(ep, flag, argc, argv);
 
-			if ((argc > 0) && (found == 0))
-				continue;
+		if ((argc > 0) && (found == 0))
+			continue;
 
-			if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
-				continue;
+		if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
+			continue;
 
-			list[n++] = ep;
+		list[n++] = ep;
 
-			totlen += strlen(ep->key);
+		totlen += strlen(ep->key);
 
-			if (sep == '\0') {
-				totlen += strlen(ep->data);
-			} else {	/* check if escapes are needed */
-				char *s = ep->data;
+		if (sep == '\0') {
+			totlen += strlen(ep->data);
+		} else {	/* check if escapes are needed */
+			char *s = ep->data;
 
-				while (*s) {
+			while (*s) {
+				++totlen;
+				/* add room for needed escape chars */
+				if ((*s == sep) || (*s == '\\'))
 					++totlen;
-					/* add room for needed escape chars */
-					if ((*s == sep) || (*s == '\\'))
-						++totlen;
-					++s;
-				}
+				++s;
 			}
-			totlen += 2;	/* for '=' and 'sep' char */
 		}
+		totlen += 2;	/* for '=' and 'sep' char */
 	}
 
-#ifdef DEBUG
-	/* Pass 1a: print unsorted list */
-	printf("Unsorted: n=%d\n", n);
-	for (i = 0; i < n; ++i) {
-		printf("\t%3d: %p ==> %-10s => %s\n",
-		       i, list[i], list[i]->key, list[i]->data);
-	}
-#endif
-
-	/* Sort list by keys */
-	qsort(list, n, sizeof(struct env_entry *), cmpkey);
-
 	/* Check if the user supplied buffer size is sufficient */
 	if (size) {
 		if (size < totlen + 1) {	/* provided buffer too small */
@@ -1013,3 +1144,32 @@ int hwalk_r(struct hsearch_data *htab, int (*callback)(struct env_entry *entry))
 
 	return 0;
 }
+
+int hwalk_dirty_r(struct hsearch_data *htab,
+		  int (*callback)(struct env_entry *entry, void *priv),
+		  void *priv)
+{
+	int i;
+	int retval;
+
+	for (i = 1; i <= htab->size && htab->dirty; ++i) {
+		if (htab->table[i].dirty) {
+			retval = callback(&htab->table[i].entry, priv);
+			if (retval)
+				return retval;
+		}
+	}
+
+	return 0;
+}
+
+void hclear_dirty_r(struct hsearch_data *htab)
+{
+	int i;
+
+	for (i = 1; i <= htab->size && htab->dirty; ++i) {
+		if (htab->table[i].dirty)
+			hmark_clean(htab, i);
+	}
+	htab->dirty_all = false;
+}
@@ -6,6 +6,8 @@
 #include <common.h>
 #include <compiler.h>
 #include <image.h>
+#include <malloc.h>
+#include <parallel.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 #include <asm/unaligned.h>
@@ -16,12 +18,137 @@
 
 #define LZ4F_BLOCKUNCOMPRESSED_FLAG 0x80000000U
 
+/**
+ * struct ulz4_block - A block to be decompressed in parallel
+ *
+ * @in: Block data
+ * @in_size: Size of block data
+ * @out: Place to put the decompressed data
+ * @out_size: Space available at @out; on success, updated to the number of
+ *	bytes written
+ * @raw: true if the block is stored uncompressed
+ */
+struct ulz4_block {
+	const void *in;
+	u32 in_size;
+	void *out;
+	u32 out_size;
+	bool raw;
+};
+
+static int ulz4_decode_block(void *ctx, int idx)
+{
+	struct ulz4_block *blk = (struct ulz4_block *)ctx + idx;
+	int ret;
+
+	if (blk->raw) {
+		if (blk->in_size > blk->out_size)
+			return -ENOBUFS;
+		memcpy(blk->out, blk->in, blk->in_size);
+		blk->out_size = blk->in_size;
+		return 0;
+	}
+
+	/* constant folding essential, do not touch params! */
+	ret = LZ4_decompress_generic(blk->in, blk->out, blk->in_size,
+			blk->out_size, endOnInputSize,
+			decode_full_block, noDict, blk->out, NULL, 0);
+	if (ret < 0)
+		return -EPROTO;
+	blk->out_size = ret;
+
+	return 0;
+}
+
+/**
+ * ulz4fn_parallel() - Decompress independent blocks on several CPUs
+ *
+ * This finds all the blocks first, so that each one can be decompressed
+ * directly to its place in the output. This relies on every block except the
+ * last one decompressing to exactly the maximum block size, which is what the
+ * lz4 tool produces.
+ *
+ * @in: First block header
+ * @src: Start of LZ4 frame
+ * @srcn: Length of LZ4 frame
+ * @dst: Destination for uncompressed data
+ * @dstn: Size of destination buffer; updated to the length of uncompressed
+ *	data on success
+ * @block_max: Maximum size of a decompressed block
+ * @has_block_checksum: true if each block is followed by a checksum
+ * Return: 0 if OK, -EAGAIN if the frame must be decompressed serially. This
+ *	includes any error, so that the serial code can report it.
+ */
+static int ulz4fn_parallel(const void *in, const void *src, size_t srcn,
+			   void *dst, size_t *dstn, u32 block_max,
+			   int has_block_checksum)
+{
+	struct ulz4_block *blocks;
+	const void *start = in;
+	int count, i, ret;
+	size_t total;
+
+	/* Count the blocks, leaving any errors to the serial code */
+	for (count = 0; ; count++) {
+		u32 block_header, block_size;
+
+		if (in - src + sizeof(u32) > srcn)
+			return -EAGAIN;
+		block_header = get_unaligned_le32(in);
+		in += sizeof(u32);
+		block_size = block_header & ~LZ4F_BLOCKUNCOMPRESSED_FLAG;
+		if (!block_size)
+			break;
+		if (in - src + block_size > srcn || block_size > block_max)
+			return -EAGAIN;
+		in += block_size;
+		if (has_block_checksum)
+			in += sizeof(u32);
+	}
+	if (count < 2 || (size_t)(count - 1) * block_max >= *dstn)
+		return -EAGAIN;
+
+	blocks = malloc(count * sizeof(*blocks));
+	if (!blocks)
+		return -EAGAIN;
+	for (i = 0, in = start; i < count; i++) {
+		struct ulz4_block *blk = &blocks[i];
+		u32 block_header = get_unaligned_le32(in);
+
+		in += sizeof(u32);
+		blk->in = in;
+		blk->in_size = block_header & ~LZ4F_BLOCKUNCOMPRESSED_FLAG;
+		blk->raw = block_header & LZ4F_BLOCKUNCOMPRESSED_FLAG;
+		blk->out = dst + (size_t)i * block_max;
+		blk->out_size = min((size_t)block_max,
+				    *dstn - (size_t)i * block_max);
+		in += blk->in_size;
+		if (has_block_checksum)
+			in += sizeof(u32);
+	}
+
+	ret = parallel_run(ulz4_decode_block, blocks, count);
+	for (i = 0, total = 0; !ret && i < count; i++) {
+		/* a short block means the offsets of later blocks are wrong */
+		if (i < count - 1 && blocks[i].out_size != block_max)
+			ret = -EAGAIN;
+		total += blocks[i].out_size;
+	}
+	free(blocks);
+	if (ret)
+		return -EAGAIN;
+	*dstn = total;
+
+	return 0;
+}
+
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 {
 	const void *end = dst + *dstn;
 	const void *in = src;
 	void *out = dst;
 	int has_block_checksum;
+	u32 block_max;
 	int ret;
 	*dstn = 0;
 
@@ -60,6 +187,23 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		}
 		/* Header checksum byte */
 		in += sizeof(u8);
+
+		block_max = 1 << (8 + 2 * ((block_desc >> 4) & 7));
+	}
+
+	/*
+	 * Blocks can be decompressed in parallel, except in place, where the
+	 * output of one block may overwrite the input of a later one
+	 */
+	if (CONFIG_IS_ENABLED(PARALLEL) &&
+	    (src >= end || dst >= src + srcn)) {
+		size_t size = end - (void *)dst;
+
+		if (!ulz4fn_parallel(in, src, srcn, dst, &size, block_max,
+				     has_block_checksum)) {
+			*dstn = size;
+			return 0;
+		}
 	}
 
 	while (1) {
@@ -9,12 +9,29 @@
  */
 
 #include <common.h>
+#include <arena.h>
 #include <log.h>
 #include <linux/libfdt.h>
 #include <of_live.h>
 #include <malloc.h>
 #include <dm/of_access.h>
 #include <linux/err.h>
+#include <linux/sizes.h>
+
+/*
+ * The live tree is never freed, so it and the small objects added to it
+ * later, such as aliases and new properties, come from an arena. The tree is
+ * one large object, so has a block of its own.
+ */
+static struct arena of_live_arena;
+
+void *of_live_alloc(size_t size)
+{
+	if (!of_live_arena.blocks)
+		return NULL;
+
+	return arena_alloc(&of_live_arena, size);
+}
 
 static void *unflatten_dt_alloc(void **mem, unsigned long size,
 				unsigned long align)
@@ -294,8 +311,11 @@ static int unflatten_device_tree(const void *blob,
 	debug("  size is %lx, allocating...\n", size);
 
 	/* Allocate memory for the expanded device tree */
-	mem = malloc(size + 4);
-	memset(mem, '\0', size);
+	if (!of_live_arena.blocks && arena_init(&of_live_arena, SZ_4K, 0))
+		return -ENOMEM;
+	mem = arena_alloc(&of_live_arena, size + 4);
+	if (!mem)
+		return -ENOMEM;
 
 	*(__be32 *)(mem + size) = cpu_to_be32(0xdeadbeef);
 
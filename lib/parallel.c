@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Running independent pieces of work on several CPUs
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <parallel.h>
+
+int parallel_run(parallel_func_t func, void *ctx, int count)
+{
+	int ret = 0;
+	int i;
+
+	if (count > 1 && CONFIG_PARALLEL_CPUS > 1) {
+		ret = arch_parallel_run(func, ctx, count,
+					CONFIG_PARALLEL_CPUS);
+		if (ret != -ENOSYS)
+			return ret;
+		ret = 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		int err = func(ctx, i);
+
+		if (err && !ret)
+			ret = err;
+	}
+
+	return ret;
+}
@@ -0,0 +1,228 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Statistical sampling profiler
+ *
+ * A periodic timer interrupt calls sample_record(), which stores the
+ * interrupted program counter and the return addresses found by following
+ * the frame pointers into a ring buffer. Addresses are stored as offsets from
+ * the start of U-Boot's code, as with function tracing, so that proftool can
+ * look them up in System.map.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <sample.h>
+#include <trace.h>
+#include <asm/global_data.h>
+#include <asm/sections.h>
+#include <linux/compiler.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum {
+#if CONFIG_IS_ENABLED(SAMPLE_PROF_STACK)
+	SAMPLE_MAX_DEPTH	= CONFIG_SAMPLE_PROF_DEPTH,
+#else
+	SAMPLE_MAX_DEPTH	= 1,
+#endif
+	/* frame pointers further than this from the stack pointer are bogus */
+	SAMPLE_MAX_STACK	= 1 << 20,
+};
+
+/**
+ * struct sample_rec - A single sample
+ *
+ * @depth: Number of valid entries in @pc, 0 if outside U-Boot
+ * @pc: Program counter followed by the return addresses, innermost first
+ */
+struct sample_rec {
+	u32 depth;
+	u32 pc[SAMPLE_MAX_DEPTH];
+};
+
+/*
+ * A frame record, as pointed to by the frame pointer on x86 and ARMv8: the
+ * caller's frame pointer followed by the return address
+ */
+struct sample_frame {
+	ulong next;
+	ulong ret;
+};
+
+/**
+ * struct sample_info - State of the profiler
+ *
+ * @ring: Ring buffer of samples
+ * @size: Number of samples @ring can hold
+ * @count: Total number of samples taken, including any overwritten
+ * @outside: Number of samples taken outside U-Boot's code
+ * @hz: Sampling rate
+ * @running: true if samples are being taken. This is read from the timer
+ *	interrupt, so is accessed with READ_ONCE() / WRITE_ONCE(), with a
+ *	barrier to order it against changes to the other fields
+ */
+struct sample_info {
+	struct sample_rec *ring;
+	uint size;
+	ulong count;
+	ulong outside;
+	uint hz;
+	bool running;
+};
+
+static struct sample_info info;
+
+static ulong __attribute__((no_instrument_function)) sample_text_base(void)
+{
+#ifdef CONFIG_SANDBOX
+	return (ulong)_init;
+#else
+	if (gd->flags & GD_FLG_RELOC)
+		return gd->relocaddr;
+
+	return CONFIG_SYS_TEXT_BASE;
+#endif
+}
+
+void __attribute__((no_instrument_function)) sample_record(ulong pc, ulong fp,
+							   ulong sp)
+{
+	ulong base = sample_text_base();
+	ulong end = base + gd->mon_len;
+	struct sample_rec *rec;
+	uint depth;
+
+	if (!READ_ONCE(info.running))
+		return;
+	rec = &info.ring[info.count++ % info.size];
+	if (pc < base || pc >= end) {
+		rec->depth = 0;
+		info.outside++;
+		return;
+	}
+	rec->pc[0] = pc - base;
+
+	/*
+	 * Stop at anything which does not look like a frame on the stack.
+	 * Note that if the sample hits a leaf function which has no frame of
+	 * its own, its caller does not appear in the stack.
+	 */
+	depth = 1;
+	while (depth < SAMPLE_MAX_DEPTH) {
+		const struct sample_frame *frame = (void *)fp;
+
+		if (fp <= sp || fp - sp > SAMPLE_MAX_STACK ||
+		    fp % sizeof(ulong))
+			break;
+		if (frame->ret < base || frame->ret >= end)
+			break;
+		rec->pc[depth++] = frame->ret - base;
+		if (frame->next <= fp)
+			break;
+		fp = frame->next;
+	}
+	rec->depth = depth;
+}
+
+int sample_start(uint hz)
+{
+	int ret;
+
+	if (READ_ONCE(info.running))
+		return -EALREADY;
+	if (!info.ring) {
+		info.size = CONFIG_SAMPLE_PROF_BUF_SIZE / sizeof(*info.ring);
+		info.ring = malloc(info.size * sizeof(*info.ring));
+		if (!info.ring)
+			return -ENOMEM;
+	}
+	info.hz = hz ? hz : CONFIG_SAMPLE_PROF_HZ;
+	info.count = 0;
+	info.outside = 0;
+
+	barrier();
+	WRITE_ONCE(info.running, true);
+	ret = arch_sample_start(info.hz);
+	if (ret) {
+		WRITE_ONCE(info.running, false);
+		return ret;
+	}
+
+	return 0;
+}
+
+void sample_stop(void)
+{
+	if (!READ_ONCE(info.running))
+		return;
+	arch_sample_stop();
+	WRITE_ONCE(info.running, false);
+}
+
+void sample_print_stats(void)
+{
+	ulong kept = min(info.count, (ulong)info.size);
+
+	if (!info.ring) {
+		printf("No samples taken\n");
+		return;
+	}
+	printf("%s at %u Hz, %u samples max\n",
+	       READ_ONCE(info.running) ? "Running" : "Stopped", info.hz,
+	       info.size);
+	print_grouped_ull(info.count, 10);
+	puts(" samples taken\n");
+	print_grouped_ull(info.outside, 10);
+	puts(" samples outside U-Boot\n");
+	print_grouped_ull(info.count - kept, 10);
+	puts(" samples overwritten\n");
+}
+
+int sample_list(void *buff, size_t buff_size, size_t *needed)
+{
+	struct trace_output_hdr *output_hdr = NULL;
+	void *end, *ptr = buff;
+	bool running = READ_ONCE(info.running);
+	ulong first, i, upto;
+
+	end = buff ? buff + buff_size : NULL;
+
+	/* Place some header information */
+	if (ptr + sizeof(struct trace_output_hdr) < end)
+		output_hdr = ptr;
+	ptr += sizeof(struct trace_output_hdr);
+
+	/* Don't let the ring change underneath us */
+	WRITE_ONCE(info.running, false);
+	barrier();
+	first = info.count > info.size ? info.count - info.size : 0;
+	for (i = first, upto = 0; i < info.count; i++) {
+		const struct sample_rec *rec = &info.ring[i % info.size];
+		size_t size = (1 + rec->depth) * sizeof(u32);
+
+		if (ptr + size < end) {
+			u32 *out = ptr;
+
+			out[0] = rec->depth;
+			memcpy(out + 1, rec->pc, rec->depth * sizeof(u32));
+			upto++;
+		}
+		ptr += size;
+	}
+	barrier();
+	WRITE_ONCE(info.running, running);
+
+	/* Update the header */
+	if (output_hdr) {
+		output_hdr->rec_count = upto;
+		output_hdr->type = TRACE_CHUNK_SAMPLES;
+	}
+
+	/* Work out how much of the buffer we used */
+	*needed = ptr - buff;
+	if (ptr > end)
+		return -ENOSPC;
+
+	return 0;
+}
@@ -625,10 +625,21 @@ __used void * memmove(void * dest,const void *src,size_t count)
  */
 __used int memcmp(const void * cs,const void * ct,size_t count)
 {
+	const unsigned long *l1 = cs, *l2 = ct;
 	const unsigned char *su1, *su2;
 	int res = 0;
 
-	for( su1 = cs, su2 = ct; 0 < count; ++su1, ++su2, count--)
+	/* while all data is aligned (common case), skip equal words */
+	if ((((ulong)cs | (ulong)ct) & (sizeof(*l1) - 1)) == 0) {
+		while (count >= sizeof(*l1) && *l1 == *l2) {
+			l1++;
+			l2++;
+			count -= sizeof(*l1);
+		}
+	}
+	/* find the first difference one byte at a time */
+	for (su1 = (const unsigned char *)l1, su2 = (const unsigned char *)l2;
+	     0 < count; ++su1, ++su2, count--)
 		if ((res = *su1 - *su2) != 0)
 			break;
 	return res;
@@ -9,3 +9,11 @@
  */
 
 void inflate_fast OF((z_streamp strm, unsigned start));
+
+#if CONFIG_IS_ENABLED(ZLIB_INFLATE_FAST) && BITS_PER_LONG == 64
+#define INFLATE_FAST64
+#define INFLATE_FAST64_IN  8            /* input needed by inflate_fast64() */
+#define INFLATE_FAST64_OUT (258 + 7)    /* output space it needs */
+
+void inflate_fast64 OF((z_streamp strm, unsigned start));
+#endif
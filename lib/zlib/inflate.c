@@ -701,7 +701,12 @@ int ZEXPORT inflate(z_streamp strm, int flush)
             /* build code tables */
             state->next = state->codes;
             state->lencode = (code const FAR *)(state->next);
+#ifdef INFLATE_FAST64
+            /* a larger root table means fewer 2nd level lookups */
+            state->lenbits = 10;
+#else
             state->lenbits = 9;
+#endif
             ret = inflate_table(LENS, state->lens, state->nlen, &(state->next),
                                 &(state->lenbits), state->work);
             if (ret) {
@@ -724,6 +729,11 @@ int ZEXPORT inflate(z_streamp strm, int flush)
 	    WATCHDOG_RESET();
             if (have >= 6 && left >= 258) {
                 RESTORE();
+#ifdef INFLATE_FAST64
+                if (have >= INFLATE_FAST64_IN && left >= INFLATE_FAST64_OUT)
+                    inflate_fast64(strm, out);
+                else
+#endif
                 inflate_fast(strm, out);
                 LOAD();
                 break;
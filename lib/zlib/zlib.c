@@ -26,6 +26,7 @@
 #include "inffast.h"
 #include "inffixed.h"
 #include "inffast.c"
+#include "inffast64.c"
 #include "inftrees.c"
 #include "inflate.c"
 #include "zutil.c"
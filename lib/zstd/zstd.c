@@ -9,7 +9,152 @@
 #include <abuf.h>
 #include <log.h>
 #include <malloc.h>
+#include <parallel.h>
 #include <linux/zstd.h>
+#include <u-boot/zstd.h>
+
+#if CONFIG_IS_ENABLED(PARALLEL)
+/**
+ * struct zstd_frame - A frame to be decompressed in parallel
+ *
+ * @in: Compressed frame
+ * @in_size: Size of compressed frame
+ * @out: Place to put the decompressed data
+ * @out_size: Size of the decompressed data, from the frame header
+ */
+struct zstd_frame {
+	const void *in;
+	size_t in_size;
+	void *out;
+	size_t out_size;
+};
+
+/**
+ * struct zstd_worker - Decompresses a share of the frames on one CPU
+ *
+ * @dctx: Decompression context, only used by this worker
+ * @frames: All frames
+ * @count: Number of frames
+ * @step: Number of workers; this worker handles every @step'th frame
+ */
+struct zstd_worker {
+	ZSTD_DCtx *dctx;
+	struct zstd_frame *frames;
+	int count;
+	int step;
+};
+
+static int zstd_decompress_share(void *ctx, int idx)
+{
+	struct zstd_worker *wkr = (struct zstd_worker *)ctx + idx;
+	int i;
+
+	for (i = idx; i < wkr->count; i += wkr->step) {
+		struct zstd_frame *frm = &wkr->frames[i];
+		size_t res;
+
+		res = ZSTD_decompressDCtx(wkr->dctx, frm->out, frm->out_size,
+					  frm->in, frm->in_size);
+		if (ZSTD_isError(res) || res != frm->out_size)
+			return -EPROTO;
+	}
+
+	return 0;
+}
+
+/**
+ * zstd_find_frames() - Find the frames in the input and where they go
+ *
+ * Skippable frames are ignored, since they have no content.
+ *
+ * @in: Input buffer to decompress
+ * @out: Output buffer to hold the results
+ * @frames: Place to put frame information, or NULL to just count frames
+ * Return: number of frames, or -EAGAIN if any frame does not record its
+ *	decompressed size, or the input is invalid, or the output is too small
+ */
+static int zstd_find_frames(struct abuf *in, struct abuf *out,
+			    struct zstd_frame *frames)
+{
+	const void *ptr = abuf_data(in), *end = ptr + abuf_size(in);
+	size_t total = 0;
+	int count = 0;
+
+	while (ptr < end) {
+		unsigned long long size;
+		size_t csize;
+
+		csize = ZSTD_findFrameCompressedSize(ptr, end - ptr);
+		if (ZSTD_isError(csize) || csize > end - ptr)
+			return -EAGAIN;
+		size = ZSTD_getFrameContentSize(ptr, end - ptr);
+		if (size == ZSTD_CONTENTSIZE_UNKNOWN ||
+		    size == ZSTD_CONTENTSIZE_ERROR ||
+		    size > abuf_size(out) - total)
+			return -EAGAIN;
+		if (size) {
+			if (frames) {
+				frames[count].in = ptr;
+				frames[count].in_size = csize;
+				frames[count].out = abuf_data(out) + total;
+				frames[count].out_size = size;
+			}
+			count++;
+			total += size;
+		}
+		ptr += csize;
+	}
+
+	return count;
+}
+
+int zstd_decompress_frames(struct abuf *in, struct abuf *out)
+{
+	struct zstd_worker *workers = NULL;
+	struct zstd_frame *frames;
+	void *workspace = NULL;
+	int count, num_workers, i;
+	size_t total, wsize;
+	int ret = -EAGAIN;
+
+	count = zstd_find_frames(in, out, NULL);
+	if (count < 2)
+		return -EAGAIN;
+	frames = malloc(count * sizeof(*frames));
+	if (!frames)
+		return -EAGAIN;
+	zstd_find_frames(in, out, frames);
+
+	num_workers = min(count, CONFIG_PARALLEL_CPUS);
+	wsize = ZSTD_DCtxWorkspaceBound();
+	workers = malloc(num_workers * sizeof(*workers));
+	workspace = malloc(num_workers * wsize);
+	if (!workers || !workspace)
+		goto err;
+	for (i = 0; i < num_workers; i++) {
+		struct zstd_worker *wkr = &workers[i];
+
+		wkr->dctx = ZSTD_initDCtx(workspace + i * wsize, wsize);
+		if (!wkr->dctx)
+			goto err;
+		wkr->frames = frames;
+		wkr->count = count;
+		wkr->step = num_workers;
+	}
+
+	if (!parallel_run(zstd_decompress_share, workers, num_workers)) {
+		for (i = 0, total = 0; i < count; i++)
+			total += frames[i].out_size;
+		ret = total;
+	}
+err:
+	free(workspace);
+	free(workers);
+	free(frames);
+
+	return ret;
+}
+#endif
 
 int zstd_decompress(struct abuf *in, struct abuf *out)
 {
@@ -20,6 +165,19 @@ int zstd_decompress(struct abuf *in, struct abuf *out)
 	size_t wsize;
 	int ret;
 
+#if CONFIG_IS_ENABLED(PARALLEL)
+	/*
+	 * Frames can be decompressed in parallel, except in place, where the
+	 * output of one frame may overwrite the input of a later one
+	 */
+	if (abuf_data(in) >= abuf_data(out) + abuf_size(out) ||
+	    abuf_data(out) >= abuf_data(in) + abuf_size(in)) {
+		ret = zstd_decompress_frames(in, out);
+		if (ret != -EAGAIN)
+			return ret;
+	}
+#endif
+
 	wsize = ZSTD_DStreamWorkspaceBound(abuf_size(in));
 	workspace = malloc(wsize);
 	if (!workspace) {
@@ -44,6 +202,7 @@ int zstd_decompress(struct abuf *in, struct abuf *out)
 	out_buf.size = abuf_size(out);
 
 	while (1) {
+		size_t in_pos = in_buf.pos, out_pos = out_buf.pos;
 		size_t res;
 
 		res = ZSTD_decompressStream(dstream, &out_buf, &in_buf);
@@ -53,7 +212,18 @@ int zstd_decompress(struct abuf *in, struct abuf *out)
 			goto do_free;
 		}
 
-		if (in_buf.pos >= abuf_size(in) || !res)
+		/* No progress means that the output buffer is full */
+		if (in_buf.pos == in_pos && out_buf.pos == out_pos) {
+			ret = -ENOSPC;
+			goto do_free;
+		}
+
+		if (in_buf.pos >= abuf_size(in))
+			break;
+
+		/* At the end of a frame, carry on only if another one follows */
+		if (!res && !ZSTD_isFrame(in_buf.src + in_buf.pos,
+					  in_buf.size - in_buf.pos))
 			break;
 	}
 
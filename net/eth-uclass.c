@@ -27,10 +27,14 @@ DECLARE_GLOBAL_DATA_PTR;
  * struct eth_device_priv - private structure for each Ethernet device
  *
  * @state: The state of the Ethernet MAC driver (defined by enum eth_state_t)
+ * @mtu: The MTU in use since the device was last started
+ * @stats: Packet counts kept by the uclass
  */
 struct eth_device_priv {
 	enum eth_state_t state;
 	bool running;
+	int mtu;
+	struct eth_stats stats;
 };
 
 /**
@@ -262,6 +266,64 @@ static int on_ethaddr(const char *name, const char *value, enum env_op op,
 }
 U_BOOT_ENV_CALLBACK(ethaddr, on_ethaddr);
 
+int eth_get_mtu(void)
+{
+	struct udevice *current = eth_get_dev();
+	struct eth_device_priv *priv;
+
+	if (!current || !device_active(current))
+		return ETH_DATA_LEN;
+	priv = dev_get_uclass_priv(current);
+
+	return priv->mtu ? priv->mtu : ETH_DATA_LEN;
+}
+
+/**
+ * eth_set_mtu() - Set up the MTU of a device before starting it
+ *
+ * The 'eth<n>mtu' environment variable takes precedence over the device
+ * tree. If the MTU cannot be used, the standard MTU is used instead. Only a
+ * value chosen by the user is reported, since the device tree describes what
+ * the hardware can do, which may be more than U-Boot is built to use.
+ *
+ * @dev: Ethernet device
+ */
+static void eth_set_mtu(struct udevice *dev)
+{
+	struct eth_device_priv *priv = dev_get_uclass_priv(dev);
+	struct eth_pdata *pdata = dev_get_plat(dev);
+	char name[16];
+	int mtu, ret, level;
+
+	if (dev_seq(dev))
+		sprintf(name, "eth%dmtu", dev_seq(dev));
+	else
+		strcpy(name, "ethmtu");
+	level = env_get(name) ? LOGL_WARNING : LOGL_DEBUG;
+	mtu = env_get_ulong(name, 10, pdata->mtu ? pdata->mtu : ETH_DATA_LEN);
+
+	if (mtu < ETH_MIN_MTU || mtu > NET_MTU_MAX) {
+		log(LOG_CATEGORY, level, "%s: MTU %d out of range, using %d\n",
+		    dev->name, mtu, ETH_DATA_LEN);
+		mtu = ETH_DATA_LEN;
+	}
+	if (eth_get_ops(dev)->set_mtu) {
+		ret = eth_get_ops(dev)->set_mtu(dev, mtu);
+		if (ret && mtu != ETH_DATA_LEN) {
+			log(LOG_CATEGORY, level,
+			    "%s: MTU %d not supported, using %d\n", dev->name,
+			    mtu, ETH_DATA_LEN);
+			mtu = ETH_DATA_LEN;
+			eth_get_ops(dev)->set_mtu(dev, mtu);
+		}
+	} else if (mtu > ETH_DATA_LEN) {
+		log(LOG_CATEGORY, level, "%s: MTU %d not supported, using %d\n",
+		    dev->name, mtu, ETH_DATA_LEN);
+		mtu = ETH_DATA_LEN;
+	}
+	priv->mtu = mtu;
+}
+
 int eth_init(void)
 {
 	char *ethact = env_get("ethact");
@@ -296,6 +358,7 @@ int eth_init(void)
 			debug("Trying %s\n", current->name);
 
 			if (device_active(current)) {
+				eth_set_mtu(current);
 				ret = eth_get_ops(current)->start(current);
 				if (ret >= 0) {
 					struct eth_device_priv *priv =
@@ -355,9 +418,25 @@ int eth_is_active(struct udevice *dev)
 	return priv->state == ETH_STATE_ACTIVE;
 }
 
+int eth_get_stats(struct udevice *dev, struct eth_stats *stats)
+{
+	struct eth_device_priv *priv;
+
+	if (!device_active(dev))
+		return -ENODEV;
+
+	priv = dev_get_uclass_priv(dev);
+	*stats = priv->stats;
+	if (eth_get_ops(dev)->get_stats)
+		return eth_get_ops(dev)->get_stats(dev, stats);
+
+	return 0;
+}
+
 int eth_send(void *packet, int length)
 {
 	struct udevice *current;
+	struct eth_device_priv *priv;
 	int ret;
 
 	current = eth_get_dev();
@@ -367,10 +446,14 @@ int eth_send(void *packet, int length)
 	if (!eth_is_active(current))
 		return -EINVAL;
 
+	priv = dev_get_uclass_priv(current);
 	ret = eth_get_ops(current)->send(current, packet, length);
 	if (ret < 0) {
 		/* We cannot completely return the error at present */
 		debug("%s: send() returned error %d\n", __func__, ret);
+		priv->stats.tx_errors++;
+	} else {
+		priv->stats.tx_packets++;
 	}
 #if defined(CONFIG_CMD_PCAP)
 	if (ret >= 0)
@@ -379,9 +462,50 @@ int eth_send(void *packet, int length)
 	return ret;
 }
 
+/**
+ * eth_rx_batch() - Receive packets using the driver's recv_batch() method
+ *
+ * The driver is asked for packets until it has no more or the budget of
+ * ETH_PACKETS_BATCH_RECV is used up. Each batch is processed and then handed
+ * back in one go, so the driver can refill its ring in bulk.
+ *
+ * @dev: Ethernet device
+ * @priv: Its uclass-private data
+ * Return: 0 if OK, -ve on error
+ */
+static int eth_rx_batch(struct udevice *dev, struct eth_device_priv *priv)
+{
+	struct eth_ops *ops = eth_get_ops(dev);
+	uchar *packets[ETH_PACKETS_BATCH_RECV];
+	int lengths[ETH_PACKETS_BATCH_RECV];
+	int flags = ETH_RECV_CHECK_DEVICE;
+	int budget = ETH_PACKETS_BATCH_RECV;
+	int ret, i;
+
+	do {
+		ret = ops->recv_batch(dev, flags, packets, lengths, budget);
+		flags = 0;
+		if (ret <= 0)
+			break;
+		for (i = 0; i < ret; i++)
+			net_process_received_packet(packets[i], lengths[i]);
+		ops->free_batch(dev, packets, ret);
+		priv->stats.rx_packets += ret;
+		budget -= ret;
+	} while (budget);
+
+	if (!budget)
+		priv->stats.rx_budget_full++;
+	if (ret < 0 && ret != -EAGAIN)
+		return ret;
+
+	return 0;
+}
+
 int eth_rx(void)
 {
 	struct udevice *current;
+	struct eth_device_priv *priv;
 	uchar *packet;
 	int flags;
 	int ret;
@@ -394,23 +518,39 @@ int eth_rx(void)
 	if (!eth_is_active(current))
 		return -EINVAL;
 
+	priv = dev_get_uclass_priv(current);
+	if (eth_get_ops(current)->recv_batch) {
+		ret = eth_rx_batch(current, priv);
+		if (ret < 0) {
+			debug("%s: recv_batch() returned error %d\n", __func__,
+			      ret);
+			priv->stats.rx_errors++;
+		}
+		return ret;
+	}
+
 	/* Process up to 32 packets at one time */
 	flags = ETH_RECV_CHECK_DEVICE;
 	for (i = 0; i < ETH_PACKETS_BATCH_RECV; i++) {
 		ret = eth_get_ops(current)->recv(current, flags, &packet);
 		flags = 0;
-		if (ret > 0)
+		if (ret > 0) {
 			net_process_received_packet(packet, ret);
+			priv->stats.rx_packets++;
+		}
 		if (ret >= 0 && eth_get_ops(current)->free_pkt)
 			eth_get_ops(current)->free_pkt(current, packet, ret);
 		if (ret <= 0)
 			break;
 	}
+	if (i == ETH_PACKETS_BATCH_RECV)
+		priv->stats.rx_budget_full++;
 	if (ret == -EAGAIN)
 		ret = 0;
 	if (ret < 0) {
 		/* We cannot completely return the error at present */
 		debug("%s: recv() returned error %d\n", __func__, ret);
+		priv->stats.rx_errors++;
 	}
 	return ret;
 }
@@ -551,6 +691,14 @@ static int eth_post_probe(struct udevice *dev)
 			ops->write_hwaddr += gd->reloc_off;
 		if (ops->read_rom_hwaddr)
 			ops->read_rom_hwaddr += gd->reloc_off;
+		if (ops->set_mtu)
+			ops->set_mtu += gd->reloc_off;
+		if (ops->recv_batch)
+			ops->recv_batch += gd->reloc_off;
+		if (ops->free_batch)
+			ops->free_batch += gd->reloc_off;
+		if (ops->get_stats)
+			ops->get_stats += gd->reloc_off;
 
 		reloc_done++;
 	}
@@ -559,6 +707,10 @@ static int eth_post_probe(struct udevice *dev)
 	priv->state = ETH_STATE_INIT;
 	priv->running = false;
 
+	/* The MTU the device should use, if not the standard one */
+	if (!pdata->mtu)
+		pdata->mtu = dev_read_u32_default(dev, "max-frame-size", 0);
+
 	/* Check if the device has a valid MAC address in device tree */
 	if (!eth_dev_get_mac_address(dev, pdata->enetaddr) ||
 	    !is_valid_ethaddr(pdata->enetaddr)) {
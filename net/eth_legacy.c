@@ -104,6 +104,12 @@ int eth_get_dev_index(void)
 	return eth_current->index;
 }
 
+int eth_get_mtu(void)
+{
+	/* Legacy drivers only handle standard frames */
+	return ETH_DATA_LEN;
+}
+
 static int on_ethaddr(const char *name, const char *value, enum env_op op,
 	int flags)
 {
@@ -400,6 +400,7 @@ int net_loop(enum proto_t protocol)
 {
 	int ret = -EINVAL;
 	enum net_loop_state prev_net_state = net_state;
+	ulong start_us = bootstage_span_start();
 
 #if defined(CONFIG_CMD_PING)
 	if (protocol != PING)
@@ -418,7 +419,7 @@ int net_loop(enum proto_t protocol)
 		ret = eth_init();
 		if (ret < 0) {
 			eth_halt();
-			return ret;
+			goto done;
 		}
 	} else {
 		eth_init_state_only();
@@ -441,8 +442,8 @@ restart:
 	case 1:
 		/* network not configured */
 		eth_halt();
-		net_set_state(prev_net_state);
-		return -ENODEV;
+		ret = -ENODEV;
+		goto done;
 
 	case 2:
 		/* network device not configured */
@@ -466,6 +467,16 @@ restart:
 			tftp_start_server();
 			break;
 #endif
+#ifdef CONFIG_TFTP_PROBE
+		case TFTPPROBE:
+			tftp_probe_start();
+			break;
+#endif
+#ifdef CONFIG_TFTP_MULTI
+		case TFTPMULTI:
+			tftp_multi_start();
+			break;
+#endif
 #ifdef CONFIG_UDP_FUNCTION_FASTBOOT
 		case FASTBOOT:
 			fastboot_start_server();
@@ -676,6 +687,9 @@ done:
 	if (pcap_active())
 		pcap_print_status();
 #endif
+	bootstage_span_end(BOOTSTAGE_SPAN_NET, eth_get_name(), start_us,
+			   ret > 0 ? ret : 0);
+
 	return ret;
 }
 
@@ -1357,6 +1371,8 @@ static int net_check_prereq(enum proto_t protocol)
 		/* Fall through */
 	case TFTPGET:
 	case TFTPPUT:
+	case TFTPPROBE:
+	case TFTPMULTI:
 		if (net_server_ip.s_addr == 0 && !is_serverip_in_cmd()) {
 			puts("*** ERROR: `serverip' not set\n");
 			return 1;
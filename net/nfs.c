@@ -356,6 +356,18 @@ static void nfs_lookup_req(char *fname)
 /**************************************************************************
 NFS_READ - Read File on NFS Server
 **************************************************************************/
+/* Largest read size whose reply fits a frame on the current interface */
+static int nfs_get_read_size(void)
+{
+	int size = NFS_READ_SIZE;
+
+	while (size > NFS_READ_SIZE_MIN &&
+	       size + NFS_READ_OVERHEAD > eth_get_mtu())
+		size /= 2;
+
+	return size;
+}
+
 static void nfs_read_req(int offset, int readlen)
 {
 	uint32_t data[1024];
@@ -686,9 +698,9 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 	}
 
 	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
+			(nfs_len / 2 * 10 * HASHES_PER_LINE)))
 		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
+	if (!(nfs_offset % ((nfs_len / 2) * 10)))
 		putc('#');
 
 	if (supported_nfs_versions & NFSV2_FLAG) {
@@ -810,7 +822,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		} else {
 			nfs_state = STATE_READ_REQ;
 			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
+			nfs_len = nfs_get_read_size();
 			nfs_send();
 		}
 		break;
@@ -40,9 +40,20 @@
  * headers) must fit within a single Ethernet frame to avoid fragmentation.
  * However, if CONFIG_IP_DEFRAG is set, a bigger value could be used.  In any
  * case, most NFS servers are optimized for a power of 2.
+ *
+ * NFS_READ_SIZE is the largest size which fits a frame of NET_MTU_MAX, up to
+ * the NFSv2 limit of 8 KiB; a smaller size is used if the interface MTU is
+ * lower.
  */
-#define NFS_READ_SIZE	1024	/* biggest power of two that fits Ether frame */
 #define NFS_MAX_ATTRS	26
+/* Bytes in a read reply other than the data */
+#define NFS_READ_OVERHEAD	(IP_UDP_HDR_SIZE + \
+				 (6 + NFS_MAX_ATTRS) * sizeof(uint32_t))
+#define NFS_READ_SIZE_MIN	1024	/* fits a standard Ether frame */
+#define NFS_READ_SIZE	(NET_MTU_MAX >= 8192 + NFS_READ_OVERHEAD ? 8192 : \
+			 NET_MTU_MAX >= 4096 + NFS_READ_OVERHEAD ? 4096 : \
+			 NET_MTU_MAX >= 2048 + NFS_READ_OVERHEAD ? 2048 : \
+			 NFS_READ_SIZE_MIN)
 
 /* Values for Accept State flag on RPC answers (See: rfc1831) */
 enum rpc_accept_stat {
@@ -40,6 +40,9 @@ DECLARE_GLOBAL_DATA_PTR;
 #define TFTP_ERROR	5
 #define TFTP_OACK	6
 
+/* Size of the opcode and block number at the start of a data packet */
+#define TFTP_HDR_SIZE	4
+
 static ulong timeout_ms = TIMEOUT;
 static int timeout_count_max = (CONFIG_NET_RETRY_COUNT * 2);
 static ulong time_start;   /* Record time we started tftp */
@@ -733,10 +736,30 @@ static int tftp_init_load_addr(void)
 	return 0;
 }
 
-void tftp_start(enum proto_t protocol)
+/* Pick up the TFTP settings from the environment */
+static void tftp_get_vars(void)
 {
+	int mtu = eth_get_mtu();
+	int max_block = mtu - IP_UDP_HDR_SIZE - TFTP_HDR_SIZE;
 #if CONFIG_NET_TFTP_VARS
 	char *ep;             /* Environment pointer */
+#endif
+
+	/*
+	 * Fill a frame if the interface takes jumbo frames. If its MTU is
+	 * smaller than standard and replies cannot be reassembled, do not ask
+	 * for more than fits in one. At the standard MTU the configured size
+	 * is used as is, since it may rely on CONFIG_IP_DEFRAG.
+	 */
+	tftp_block_size_option = CONFIG_TFTP_BLOCKSIZE;
+	if (mtu > ETH_DATA_LEN)
+		tftp_block_size_option = max_t(int, tftp_block_size_option,
+					       max_block);
+	else if (mtu < ETH_DATA_LEN && !IS_ENABLED(CONFIG_IP_DEFRAG))
+		tftp_block_size_option = min_t(int, tftp_block_size_option,
+					       max_block);
+
+#if CONFIG_NET_TFTP_VARS
 
 	/*
 	 * Allow the user to choose TFTP blocksize and timeout.
@@ -774,6 +797,11 @@ void tftp_start(enum proto_t protocol)
 
 	debug("TFTP blocksize = %i, TFTP windowsize = %d timeout = %ld ms\n",
 	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
+}
+
+void tftp_start(enum proto_t protocol)
+{
+	tftp_get_vars();
 
 	tftp_remote_ip = net_server_ip;
 	if (!net_parse_bootfile(&tftp_remote_ip, tftp_filename, MAX_LEN)) {
@@ -921,3 +949,617 @@ void tftp_start_server(void)
 	memset(net_server_ethaddr, 0, 6);
 }
 #endif /* CONFIG_CMD_TFTPSRV */
+
+#ifdef CONFIG_TFTP_PROBE
+/* Files being looked for by tftp_probe(), highest priority first */
+static const char *const *tftp_probe_names;
+static int tftp_probe_count;
+/* Number of files for which a read request has been sent */
+static int tftp_probe_sent;
+/* Our UDP port for the first file; each file uses the next port up */
+static int tftp_probe_port;
+/* 1 if each file exists, -ENOENT if it does not, 0 if not known yet */
+static int tftp_probe_status[TFTP_PROBE_MAX];
+/* Index of the file found, or -ve error */
+static int tftp_probe_result;
+
+/**
+ * tftp_probe_send_rrq() - Send a read request for a file being probed
+ *
+ * No options are requested, so the server replies with the first data block,
+ * or an error if the file does not exist
+ *
+ * @i: Index of the file in tftp_probe_names
+ * Return: 0 if sent, 1 if waiting for ARP, -ve on error
+ */
+static int tftp_probe_send_rrq(int i)
+{
+	uchar *pkt, *xp;
+	ushort *s;
+
+	pkt = net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
+	xp = pkt;
+	s = (ushort *)pkt;
+	*s++ = htons(TFTP_RRQ);
+	pkt = (uchar *)s;
+	strcpy((char *)pkt, tftp_probe_names[i]);
+	pkt += strlen(tftp_probe_names[i]) + 1;
+	strcpy((char *)pkt, "octet");
+	pkt += 5 /*strlen("octet")*/ + 1;
+
+	return net_send_udp_packet(net_server_ethaddr, tftp_remote_ip,
+				   tftp_remote_port, tftp_probe_port + i,
+				   pkt - xp);
+}
+
+/**
+ * tftp_probe_send() - Send read requests for files not known about yet
+ *
+ * Only one packet can wait for ARP to complete, so if that happens the rest
+ * are sent when the first reply arrives, or on timeout.
+ *
+ * @resend: true to also resend requests which got no reply
+ */
+static void tftp_probe_send(bool resend)
+{
+	int ret, i;
+
+	for (i = resend ? 0 : tftp_probe_sent; i < tftp_probe_count; i++) {
+		if (tftp_probe_status[i])
+			continue;
+		ret = tftp_probe_send_rrq(i);
+		tftp_probe_sent = max(tftp_probe_sent, i + 1);
+		if (ret)
+			break;
+	}
+}
+
+/**
+ * tftp_probe_check() - Finish the probe if the result is known
+ *
+ * @give_up: true to treat files with no reply as missing
+ * Return: true if the probe is finished
+ */
+static bool tftp_probe_check(bool give_up)
+{
+	bool unknown = false;
+	int i;
+
+	for (i = 0; i < tftp_probe_count; i++) {
+		if (tftp_probe_status[i] > 0)
+			break;
+		if (!tftp_probe_status[i]) {
+			if (!give_up)
+				return false;
+			unknown = true;
+		}
+	}
+	if (i < tftp_probe_count)
+		tftp_probe_result = i;
+	else
+		tftp_probe_result = unknown ? -ETIMEDOUT : -ENOENT;
+
+	/* the probe itself worked, even if nothing was found */
+	net_set_state(NETLOOP_SUCCESS);
+
+	return true;
+}
+
+static void tftp_probe_handler(uchar *pkt, unsigned dest, struct in_addr sip,
+			       unsigned src, unsigned len)
+{
+	int i = dest - tftp_probe_port;
+	__be16 *s = (__be16 *)pkt;
+
+	if (i < 0 || i >= tftp_probe_sent || tftp_probe_status[i] || len < 2)
+		return;
+
+	switch (ntohs(*s)) {
+	case TFTP_DATA:
+	case TFTP_OACK:
+		tftp_probe_status[i] = 1;
+
+		/* Only the presence of the file matters, so stop the transfer */
+		pkt = net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
+		s = (__be16 *)pkt;
+		*s++ = htons(TFTP_ERROR);
+		*s++ = htons(TFTP_ERR_UNDEFINED);
+		strcpy((char *)s, "Probe done");
+		net_send_udp_packet(net_server_ethaddr, sip, src, dest,
+				    4 + 10 /*strlen("Probe done")*/ + 1);
+		break;
+	case TFTP_ERROR:
+		debug("Probe '%s': error %d\n", tftp_probe_names[i],
+		      len >= 4 ? ntohs(s[1]) : -1);
+		tftp_probe_status[i] = -ENOENT;
+		break;
+	default:
+		return;
+	}
+
+	/* The server's MAC address is now known, so send any other requests */
+	if (!tftp_probe_check(false))
+		tftp_probe_send(false);
+}
+
+static void tftp_probe_timeout_handler(void)
+{
+	if (++timeout_count > timeout_count_max) {
+		tftp_probe_check(true);
+		return;
+	}
+	net_set_timeout_handler(timeout_ms, tftp_probe_timeout_handler);
+	tftp_probe_send(true);
+}
+
+void tftp_probe_start(void)
+{
+	tftp_remote_ip = net_server_ip;
+	tftp_remote_port = WELL_KNOWN_PORT;
+	tftp_probe_port = 1024 + (get_timer(0) % 3072);
+	tftp_probe_sent = 0;
+	tftp_probe_result = -ETIMEDOUT;
+	memset(tftp_probe_status, '\0', sizeof(tftp_probe_status));
+
+	timeout_count = 0;
+	timeout_count_max = tftp_timeout_count_max;
+	net_set_timeout_handler(timeout_ms, tftp_probe_timeout_handler);
+	net_set_udp_handler(tftp_probe_handler);
+
+	/* zero out server ether in case the server ip has changed */
+	memset(net_server_ethaddr, 0, 6);
+
+	tftp_probe_send(false);
+}
+
+int tftp_probe(const char *const names[], int count)
+{
+	int ret, i;
+
+	if (count > TFTP_PROBE_MAX)
+		return -E2BIG;
+	for (i = 0; i < count; i++) {
+		if (strlen(names[i]) >= MAX_LEN)
+			return -ENAMETOOLONG;
+	}
+
+	tftp_probe_names = names;
+	tftp_probe_count = count;
+	tftp_probe_result = -ENETUNREACH;
+	ret = net_loop(TFTPPROBE);
+	if (ret < 0)
+		return ret;
+
+	return tftp_probe_result;
+}
+#endif /* CONFIG_TFTP_PROBE */
+
+#ifdef CONFIG_TFTP_MULTI
+enum tftp_xfer_state {
+	XFER_RRQ,	/* read request sent, waiting for OACK or data */
+	XFER_DATA,	/* receiving data */
+	XFER_DONE,	/* final block received */
+};
+
+/**
+ * struct tftp_xfer - State of one transfer started by tftp_multi()
+ *
+ * @state: Current state of the transfer
+ * @remote_port: UDP port at the server's end, once known
+ * @max_size: Number of bytes which may be written at the load address
+ * @blocks: Number of blocks received so far (not wrapped)
+ * @progress: Value of @blocks at the last timeout
+ * @retries: Number of timeouts without progress
+ * @block_size: Negotiated block size
+ * @window_size: Negotiated window size
+ * @next_ack: Block number at which the next ACK is sent
+ * @last_nack: Block number last acknowledged due to a lost block
+ */
+struct tftp_xfer {
+	enum tftp_xfer_state state;
+	int remote_port;
+	ulong max_size;
+	ulong blocks;
+	ulong progress;
+	int retries;
+	ushort block_size;
+	ushort window_size;
+	ulong next_ack;
+	ulong last_nack;
+};
+
+static struct tftp_file *tftp_multi_files;
+static int tftp_multi_count;
+static struct tftp_xfer tftp_xfers[TFTP_MULTI_MAX];
+/* Number of files for which a read request has been sent */
+static int tftp_multi_sent;
+/* Our UDP port for the first file; each file uses the next port up */
+static int tftp_multi_port;
+/* Total number of blocks received, for the progress display */
+static ulong tftp_multi_blocks;
+
+/**
+ * tftp_multi_send_rrq() - Send a read request for a file
+ *
+ * The block-size option is always requested, along with the window-size
+ * option if a window is in use.
+ *
+ * @i: Index of the file in tftp_multi_files
+ * Return: 0 if sent, 1 if waiting for ARP, -ve on error
+ */
+static int tftp_multi_send_rrq(int i)
+{
+	const char *name = tftp_multi_files[i].name;
+	uchar *pkt, *xp;
+	ushort *s;
+
+	pkt = net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
+	xp = pkt;
+	s = (ushort *)pkt;
+	*s++ = htons(TFTP_RRQ);
+	pkt = (uchar *)s;
+	strcpy((char *)pkt, name);
+	pkt += strlen(name) + 1;
+	strcpy((char *)pkt, "octet");
+	pkt += 5 /*strlen("octet")*/ + 1;
+	pkt += sprintf((char *)pkt, "blksize%c%d%c", 0,
+		       tftp_block_size_option, 0);
+	if (tftp_window_size_option > 1)
+		pkt += sprintf((char *)pkt, "windowsize%c%d%c", 0,
+			       tftp_window_size_option, 0);
+
+	return net_send_udp_packet(net_server_ethaddr, tftp_remote_ip,
+				   tftp_remote_port, tftp_multi_port + i,
+				   pkt - xp);
+}
+
+/**
+ * tftp_multi_send_ack() - Acknowledge the blocks received for a file
+ *
+ * @i: Index of the file in tftp_multi_files
+ */
+static void tftp_multi_send_ack(int i)
+{
+	struct tftp_xfer *xfer = &tftp_xfers[i];
+	__be16 *s;
+
+	s = (__be16 *)(net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE);
+	s[0] = htons(TFTP_ACK);
+	s[1] = htons((ushort)xfer->blocks);
+	net_send_udp_packet(net_server_ethaddr, tftp_remote_ip,
+			    xfer->remote_port, tftp_multi_port + i, 4);
+}
+
+/**
+ * tftp_multi_send() - Send read requests which have not been sent yet
+ *
+ * Only one packet can wait for ARP to complete, so if that happens the rest
+ * are sent when the first reply arrives, or on timeout.
+ */
+static void tftp_multi_send(void)
+{
+	while (tftp_multi_sent < tftp_multi_count) {
+		if (tftp_multi_send_rrq(tftp_multi_sent++))
+			break;
+	}
+}
+
+/**
+ * tftp_multi_oack() - Process the options acknowledged by the server
+ *
+ * @xfer: Transfer the OACK is for
+ * @pkt: Options, as pairs of nul-terminated strings
+ * @len: Length of @pkt in bytes
+ * Return: 0 if OK, -EINVAL if the server chose an unusable block size
+ */
+static int tftp_multi_oack(struct tftp_xfer *xfer, uchar *pkt, unsigned len)
+{
+	char *opt = (char *)pkt, *end = (char *)pkt + len, *val;
+
+	while (opt < end) {
+		val = opt + strnlen(opt, end - opt) + 1;
+		if (val >= end || val + strnlen(val, end - val) >= end)
+			break;
+		if (!strcasecmp(opt, "blksize"))
+			xfer->block_size = dectoul(val, NULL);
+		else if (!strcasecmp(opt, "windowsize"))
+			xfer->window_size = dectoul(val, NULL);
+		opt = val + strlen(val) + 1;
+	}
+	if (!xfer->block_size || xfer->block_size > tftp_block_size_option) {
+		printf("Invalid blk size(=%d)\n", xfer->block_size);
+		return -EINVAL;
+	}
+	if (!xfer->window_size)
+		xfer->window_size = 1;
+
+	return 0;
+}
+
+static void tftp_multi_complete(void)
+{
+	ulong total = 0;
+	int i;
+
+	for (i = 0; i < tftp_multi_count; i++) {
+		if (tftp_xfers[i].state != XFER_DONE)
+			return;
+		total += tftp_multi_files[i].size;
+	}
+
+	time_start = get_timer(time_start);
+	puts("  ");
+	print_size(total, "");
+	printf(" in %d files", tftp_multi_count);
+	if (time_start > 0) {
+		puts("\n\t ");	/* Line up with "Loading: " */
+		print_size(total / time_start * 1000, "/s");
+	}
+	puts("\ndone\n");
+	net_set_state(NETLOOP_SUCCESS);
+}
+
+/**
+ * tftp_multi_store() - Store a data block for a file
+ *
+ * @i: Index of the file in tftp_multi_files
+ * @src: Data to store
+ * @len: Length of @src in bytes
+ * Return: 0 if OK, -ENOSPC if the file does not fit
+ */
+static int tftp_multi_store(int i, uchar *src, unsigned int len)
+{
+	struct tftp_file *file = &tftp_multi_files[i];
+	struct tftp_xfer *xfer = &tftp_xfers[i];
+	ulong offset = xfer->blocks * xfer->block_size;
+	void *ptr;
+
+	if (offset + len > xfer->max_size) {
+		printf("\nTFTP error: '%s' does not fit at %08lx\n",
+		       file->name, file->addr);
+		return -ENOSPC;
+	}
+	ptr = map_sysmem(file->addr + offset, len);
+	memcpy(ptr, src, len);
+	unmap_sysmem(ptr);
+	file->size = offset + len;
+
+	return 0;
+}
+
+static void tftp_multi_handler(uchar *pkt, unsigned dest, struct in_addr sip,
+			       unsigned src, unsigned len)
+{
+	int i = dest - tftp_multi_port;
+	struct tftp_xfer *xfer;
+	ushort opcode, block;
+
+	if (i < 0 || i >= tftp_multi_sent || len < 2)
+		return;
+	xfer = &tftp_xfers[i];
+	if (xfer->state != XFER_RRQ && src != xfer->remote_port)
+		return;
+	opcode = ntohs(*(__be16 *)pkt);
+	pkt += 2;
+	len -= 2;
+
+	switch (opcode) {
+	case TFTP_OACK:
+		if (xfer->state != XFER_RRQ)
+			break;
+		xfer->remote_port = src;
+		if (tftp_multi_oack(xfer, pkt, len)) {
+			eth_halt();
+			net_set_state(NETLOOP_FAIL);
+			return;
+		}
+		xfer->state = XFER_DATA;
+		xfer->next_ack = xfer->window_size;
+		tftp_multi_send_ack(i);
+		break;
+	case TFTP_DATA:
+		if (len < 2)
+			return;
+		block = ntohs(*(__be16 *)pkt);
+		pkt += 2;
+		len -= 2;
+
+		if (xfer->state == XFER_RRQ) {
+			debug("Server did not acknowledge any options!\n");
+			xfer->remote_port = src;
+			xfer->block_size = TFTP_BLOCK_SIZE;
+			xfer->window_size = 1;
+			xfer->next_ack = 1;
+			xfer->state = XFER_DATA;
+		}
+		if (xfer->state == XFER_DONE) {
+			/* our final ACK was lost */
+			if (block == (ushort)xfer->blocks)
+				tftp_multi_send_ack(i);
+			break;
+		}
+		if (block != (ushort)(xfer->blocks + 1)) {
+			/* ask for the rest of the window again, just once */
+			if (xfer->last_nack != xfer->blocks) {
+				tftp_multi_send_ack(i);
+				xfer->last_nack = xfer->blocks;
+				xfer->next_ack = xfer->blocks +
+					xfer->window_size;
+			}
+			break;
+		}
+
+		if (tftp_multi_store(i, pkt, len)) {
+			eth_halt();
+			net_set_state(NETLOOP_FAIL);
+			return;
+		}
+		xfer->blocks++;
+		if (!(++tftp_multi_blocks % 10)) {
+			putc('#');
+			if (!(tftp_multi_blocks % (10 * HASHES_PER_LINE)))
+				puts("\n\t ");
+		}
+
+		if (len < xfer->block_size) {
+			tftp_multi_send_ack(i);
+			xfer->state = XFER_DONE;
+			tftp_multi_complete();
+		} else if (xfer->blocks == xfer->next_ack) {
+			tftp_multi_send_ack(i);
+			xfer->next_ack += xfer->window_size;
+		}
+		break;
+	case TFTP_ERROR:
+		if (len < 2)
+			return;
+		printf("\nTFTP error: '%s' (%d) for '%s'\n", pkt + 2,
+		       ntohs(*(__be16 *)pkt), tftp_multi_files[i].name);
+		eth_halt();
+		net_set_state(NETLOOP_FAIL);
+		return;
+	default:
+		return;
+	}
+
+	/* The server's MAC address is now known, so send any other requests */
+	tftp_multi_send();
+}
+
+static void tftp_multi_timeout_handler(void)
+{
+	struct tftp_xfer *xfer;
+	int i;
+
+	for (i = 0; i < tftp_multi_sent; i++) {
+		xfer = &tftp_xfers[i];
+		if (xfer->state == XFER_DONE)
+			continue;
+		if (xfer->blocks != xfer->progress) {
+			xfer->progress = xfer->blocks;
+			xfer->retries = 0;
+			continue;
+		}
+		if (++xfer->retries > tftp_timeout_count_max) {
+			printf("\nTFTP timeout for '%s'\n",
+			       tftp_multi_files[i].name);
+			eth_halt();
+			net_set_state(NETLOOP_FAIL);
+			return;
+		}
+		puts("T ");
+		if (xfer->state == XFER_RRQ)
+			tftp_multi_send_rrq(i);
+		else
+			tftp_multi_send_ack(i);
+	}
+	net_set_timeout_handler(timeout_ms, tftp_multi_timeout_handler);
+	tftp_multi_send();
+}
+
+/**
+ * tftp_multi_init_sizes() - Work out how much space each file may use
+ *
+ * A file may not run into reserved memory, nor into the next file up.
+ *
+ * Return: 0 if OK, -EINVAL if two files share a load address, -EFAULT if a
+ *	load address is in reserved memory
+ */
+static int tftp_multi_init_sizes(void)
+{
+	ulong addr, max_size;
+	int i, j;
+#ifdef CONFIG_LMB
+	struct lmb lmb;
+
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+#endif
+
+	for (i = 0; i < tftp_multi_count; i++) {
+		addr = tftp_multi_files[i].addr;
+#ifdef CONFIG_LMB
+		max_size = lmb_get_free_size(&lmb, addr);
+		if (!max_size)
+			return -EFAULT;
+#else
+		max_size = ULONG_MAX - addr;
+#endif
+		for (j = 0; j < tftp_multi_count; j++) {
+			ulong other = tftp_multi_files[j].addr;
+
+			if (j == i)
+				continue;
+			if (other == addr)
+				return -EINVAL;
+			if (other > addr)
+				max_size = min(max_size, other - addr);
+		}
+		tftp_xfers[i].max_size = max_size;
+	}
+
+	return 0;
+}
+
+void tftp_multi_start(void)
+{
+	int ret, i;
+
+	tftp_get_vars();
+	tftp_remote_ip = net_server_ip;
+	tftp_remote_port = WELL_KNOWN_PORT;
+	tftp_multi_port = 1024 + (get_timer(0) % 3072);
+	tftp_multi_sent = 0;
+	tftp_multi_blocks = 0;
+	memset(tftp_xfers, '\0', sizeof(tftp_xfers));
+	for (i = 0; i < tftp_multi_count; i++)
+		tftp_multi_files[i].size = 0;
+
+	ret = tftp_multi_init_sizes();
+	if (ret) {
+		printf("TFTP error: %s\n", ret == -EINVAL ?
+		       "files must be loaded at different addresses" :
+		       "trying to overwrite reserved memory");
+		net_set_state(NETLOOP_FAIL);
+		return;
+	}
+
+	printf("Using %s device\n", eth_get_name());
+	printf("TFTP from server %pI4; our IP address is %pI4\n",
+	       &tftp_remote_ip, &net_ip);
+	for (i = 0; i < tftp_multi_count; i++)
+		printf("Filename '%s' at 0x%lx\n", tftp_multi_files[i].name,
+		       tftp_multi_files[i].addr);
+	puts("Loading: *\b");
+
+	time_start = get_timer(0);
+	net_set_timeout_handler(timeout_ms, tftp_multi_timeout_handler);
+	net_set_udp_handler(tftp_multi_handler);
+
+	/* zero out server ether in case the server ip has changed */
+	memset(net_server_ethaddr, 0, 6);
+
+	tftp_multi_send();
+}
+
+int tftp_multi(struct tftp_file *files, int count)
+{
+	int ret, i;
+
+	if (!count)
+		return -EINVAL;
+	if (count > TFTP_MULTI_MAX)
+		return -E2BIG;
+	for (i = 0; i < count; i++) {
+		if (strlen(files[i].name) >= MAX_LEN)
+			return -ENAMETOOLONG;
+	}
+
+	tftp_multi_files = files;
+	tftp_multi_count = count;
+	ret = net_loop(TFTPMULTI);
+	if (ret < 0)
+		return ret;
+
+	return 0;
+}
+#endif /* CONFIG_TFTP_MULTI */
@@ -11,6 +11,9 @@
 #include <bootflow.h>
 #include <bootstd.h>
 #include <dm.h>
+#include <env.h>
+#include <fs.h>
+#include <malloc.h>
 #include <dm/lists.h>
 #include <test/suites.h>
 #include <test/ut.h>
@@ -302,6 +305,154 @@ static int bootflow_iter(struct unit_test_state *uts)
 }
 BOOTSTD_TEST(bootflow_iter, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
 
+/* Check starting all bootdevs before scanning */
+static int bootflow_iter_parallel(struct unit_test_state *uts)
+{
+	struct bootflow_iter iter;
+	struct bootflow bflow;
+	int i;
+
+	ut_assertok(bootstd_test_drop_bootdev_order(uts));
+	bootstd_clear_glob();
+
+	/* the first bootflow is the same as with a normal scan */
+	ut_assertok(bootflow_scan_first(&iter, BOOTFLOWF_PARALLEL, &bflow));
+	ut_asserteq_str("mmc1.bootdev", bflow.dev->name);
+	ut_asserteq(1, bflow.part);
+	ut_asserteq(BOOTFLOWST_READY, bflow.state);
+	bootflow_free(&bflow);
+
+	/* all bootdevs were started, even those not scanned yet */
+	ut_assert(iter.num_devs > 1);
+	for (i = 0; i < iter.num_devs; i++)
+		ut_assert(device_active(iter.dev_order[i]));
+	bootflow_iter_uninit(&iter);
+
+	ut_assert_console_end();
+
+	return 0;
+}
+BOOTSTD_TEST(bootflow_iter_parallel, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
+
+/* Check trying the cached bootflow before scanning */
+static int bootflow_iter_cache(struct unit_test_state *uts)
+{
+	struct bootflow_iter iter;
+	struct bootflow bflow;
+	const char *val;
+
+	ut_assertok(bootstd_test_drop_bootdev_order(uts));
+	bootstd_clear_glob();
+
+	/* with nothing cached, a normal scan is done */
+	ut_assertok(env_set("bootflow_cache", NULL));
+	ut_assertok(bootflow_scan_first(&iter, BOOTFLOWF_CACHE, &bflow));
+	ut_asserteq_str("mmc1.bootdev", bflow.dev->name);
+	ut_asserteq(1, bflow.part);
+	ut_asserteq(1, iter.cur_dev);
+	ut_asserteq(false, iter.pending);
+	ut_assertnull(iter.cache_dev);
+
+	ut_asserteq(1, bootflow_cache_set(&bflow));
+	ut_asserteq(0, bootflow_cache_set(&bflow));
+	val = env_get("bootflow_cache");
+	ut_assertnonnull(val);
+	ut_asserteq_strn("mmc1.bootdev 1 syslinux ", val);
+	ut_assert(strstr(val, " /extlinux/extlinux.conf"));
+	bootflow_free(&bflow);
+	bootflow_iter_uninit(&iter);
+
+	/* now the cached bootflow is returned without scanning mmc2 */
+	ut_assertok(bootflow_scan_first(&iter, BOOTFLOWF_CACHE, &bflow));
+	ut_asserteq_str("mmc1.bootdev", bflow.dev->name);
+	ut_asserteq(1, bflow.part);
+	ut_asserteq_str("syslinux", bflow.method->name);
+	ut_asserteq(BOOTFLOWST_READY, bflow.state);
+	ut_asserteq(0, iter.cur_dev);
+	ut_asserteq(true, iter.pending);
+	bootflow_free(&bflow);
+
+	/* the rest of the scan does not return it again */
+	ut_asserteq(-ENODEV, bootflow_scan_next(&iter, &bflow));
+	bootflow_iter_uninit(&iter);
+
+	/* a cached bootflow which has changed is ignored */
+	ut_assertok(env_set("bootflow_cache",
+			    "mmc1.bootdev 1 syslinux - /extlinux/other.conf"));
+	ut_assertok(bootflow_scan_first(&iter, BOOTFLOWF_CACHE, &bflow));
+	ut_asserteq_str("mmc1.bootdev", bflow.dev->name);
+	ut_asserteq(1, iter.cur_dev);
+	ut_assertnull(iter.cache_dev);
+	bootflow_free(&bflow);
+	bootflow_iter_uninit(&iter);
+
+	ut_assertok(env_set("bootflow_cache", NULL));
+	ut_assert_console_end();
+
+	return 0;
+}
+BOOTSTD_TEST(bootflow_iter_cache, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_ENV_IS_IN_FAT
+/* Check that the cache is saved, but not along with the user's changes */
+static int bootflow_iter_cache_save(struct unit_test_state *uts)
+{
+	struct bootflow_iter iter;
+	struct bootflow bflow;
+	char *val;
+
+	ut_assertok(bootstd_test_drop_bootdev_order(uts));
+	bootstd_clear_glob();
+	ut_assertok(bootflow_scan_first(&iter, 0, &bflow));
+	ut_asserteq(BOOTFLOWST_READY, bflow.state);
+
+	/* store the environment on mmc1 so it can be saved and read back */
+	ut_assertok(env_select("FAT"));
+	ut_assertok(env_set("bootflow_cache", NULL));
+	ut_assertok(env_save());
+
+	/* another variable has changed, so only the cache is updated */
+	ut_assertok(env_set("bootflow_test", "1"));
+	ut_asserteq(-EBUSY, bootflow_cache_save(&bflow));
+	ut_assertnonnull(env_get("bootflow_cache"));
+
+	/* deleting a variable is a change too */
+	ut_assertok(env_save());
+	ut_assertok(env_set("bootflow_cache", NULL));
+	ut_assertok(env_set("bootflow_test", NULL));
+	ut_asserteq(-EBUSY, bootflow_cache_save(&bflow));
+	ut_assertok(env_reload());
+	ut_asserteq_str("1", env_get("bootflow_test"));
+
+	/* loading a file does not stop the cache being saved */
+	ut_assertok(env_set("bootflow_cache", NULL));
+	ut_assertok(env_set("filesize", "123"));
+	ut_assertok(bootflow_cache_save(&bflow));
+	val = strdup(env_get("bootflow_cache"));
+	ut_assertnonnull(val);
+	ut_assertok(env_set("bootflow_cache", NULL));
+	ut_assertok(env_reload());
+	ut_asserteq_str(val, env_get("bootflow_cache"));
+	free(val);
+
+	/* nothing needs saving if the cache already holds this bootflow */
+	ut_assertok(env_set("bootflow_test", "2"));
+	ut_assertok(bootflow_cache_save(&bflow));
+
+	/* put things back as they were */
+	bootflow_free(&bflow);
+	bootflow_iter_uninit(&iter);
+	ut_assertok(env_set("bootflow_cache", NULL));
+	ut_assertok(env_set("bootflow_test", NULL));
+	ut_assertok(fs_set_blk_dev("mmc", "1:1", FS_TYPE_ANY));
+	ut_assertok(fs_unlink(CONFIG_ENV_FAT_FILE));
+	ut_assertok(env_select("nowhere"));
+
+	return 0;
+}
+BOOTSTD_TEST(bootflow_iter_cache_save, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
+#endif
+
 /* Check using the system bootdev */
 static int bootflow_system(struct unit_test_state *uts)
 {
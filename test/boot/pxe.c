@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for finding and parsing PXE / extlinux config files
+ */
+
+#include <common.h>
+#include <command.h>
+#include <dm.h>
+#include <env.h>
+#include <mapmem.h>
+#include <net.h>
+#include <pxe_utils.h>
+#include <asm/eth.h>
+#include <linux/list.h>
+#include <net/tftp.h>
+#include <test/suites.h>
+#include <test/ut.h>
+#include "bootstd_common.h"
+
+/* Where the test config file is put in memory */
+#define PXE_TEST_ADDR	0x10000
+
+/* TFTP port and opcodes, from RFC 1350 */
+#define TFTP_PORT	69
+#define TFTP_RRQ	1
+#define TFTP_DATA	3
+#define TFTP_ERROR	5
+
+#ifdef CONFIG_TFTP_PROBE
+/* Files which the fake TFTP server has */
+static const char *const pxe_test_server_files[] = {
+	"pxelinux.cfg/default",
+	"other",
+	NULL,
+};
+
+/*
+ * Act as a TFTP server which replies to a read request with the first block
+ * of the file, or an error if it does not have the file
+ */
+static int pxe_test_tftp_handler(struct udevice *dev, void *packet,
+				 unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+	const char *name;
+	__be16 *s;
+	int i, size;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP ||
+	    ntohs(ip->udp_dst) != TFTP_PORT)
+		return 0;
+	s = (__be16 *)(ip + 1);
+	if (ntohs(*s) != TFTP_RRQ || priv->recv_packets >= PKTBUFSRX)
+		return 0;
+	name = (const char *)(s + 1);
+	for (i = 0; pxe_test_server_files[i]; i++) {
+		if (!strcmp(name, pxe_test_server_files[i]))
+			break;
+	}
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	s = (__be16 *)(ipr + 1);
+	if (pxe_test_server_files[i]) {
+		*s++ = htons(TFTP_DATA);
+		*s++ = htons(1);
+		strcpy((char *)s, "data");
+		size = 4 + 5;
+	} else {
+		*s++ = htons(TFTP_ERROR);
+		*s++ = htons(1);	/* file not found */
+		strcpy((char *)s, "Not found");
+		size = 4 + 10;
+	}
+	net_set_udp_header((uchar *)ipr, ip->ip_src, ntohs(ip->udp_src),
+			   TFTP_PORT, size);
+
+	/* the reply comes from the server */
+	net_copy_ip((void *)&ipr->ip_src, &ip->ip_dst);
+	ipr->ip_sum = 0;
+	ipr->ip_sum = compute_ip_checksum(ipr, IP_HDR_SIZE);
+
+	priv->recv_packet_length[priv->recv_packets] = ETHER_HDR_SIZE +
+		IP_UDP_HDR_SIZE + size;
+	++priv->recv_packets;
+
+	return 0;
+}
+
+/* Check looking for several files on a TFTP server at once */
+static int pxe_test_tftp_probe(struct unit_test_state *uts)
+{
+	static const char *const names[] = {
+		"missing", "other", "pxelinux.cfg/default",
+	};
+	static const char *const missing[] = {
+		"missing", "pxelinux.cfg/C0000201", "pxelinux.cfg/C0",
+	};
+
+	sandbox_eth_set_tx_handler(0, pxe_test_tftp_handler);
+	env_set("ethact", "eth@10002000");
+	env_set("serverip", "1.1.2.2");
+
+	/* the first file which exists is found, whichever reply comes first */
+	ut_asserteq(1, tftp_probe(names, ARRAY_SIZE(names)));
+	ut_asserteq(0, tftp_probe(names + 2, 1));
+	ut_asserteq(-ENOENT, tftp_probe(missing, ARRAY_SIZE(missing)));
+	ut_asserteq(-E2BIG, tftp_probe(names, TFTP_PROBE_MAX + 1));
+
+	sandbox_eth_set_tx_handler(0, NULL);
+	env_set("serverip", NULL);
+
+	return 0;
+}
+BOOTSTD_TEST(pxe_test_tftp_probe, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
+#endif /* CONFIG_TFTP_PROBE */
+
+/* Number of files read by pxe_test_getfile() */
+static int pxe_test_reads;
+
+/* Supply the file included by the test config file */
+static int pxe_test_getfile(struct pxe_context *ctx, const char *file_path,
+			    char *file_addr, ulong *sizep)
+{
+	static const char inc[] = "label other\n\tkernel /vmlinuz-other\n";
+	ulong addr = simple_strtoul(file_addr, NULL, 16);
+	char *buf;
+
+	pxe_test_reads++;
+	buf = map_sysmem(addr, sizeof(inc));
+	strcpy(buf, inc);
+	unmap_sysmem(buf);
+	*sizep = strlen(inc);
+
+	return 0;
+}
+
+/* Parse the config file at PXE_TEST_ADDR and check the result */
+static int pxe_test_parse(struct unit_test_state *uts,
+			  struct pxe_context *ctx)
+{
+	struct pxe_label *label;
+	struct pxe_menu *cfg;
+	int count = 0;
+
+	cfg = parse_pxefile(ctx, PXE_TEST_ADDR);
+	ut_assertnonnull(cfg);
+	ut_asserteq_str("linux", cfg->default_label);
+	list_for_each_entry(label, &cfg->labels, list)
+		count++;
+	ut_asserteq(2, count);
+	destroy_pxe_menu(cfg);
+
+	return 0;
+}
+
+/* Check that a parsed config file is only reused if it is the same file */
+static int pxe_test_cache(struct unit_test_state *uts)
+{
+	static const char conf[] = "default linux\ninclude other.conf\n"
+		"label linux\n\tkernel /vmlinuz\n";
+	struct cmd_tbl cmdtp = {};
+	struct pxe_context ctx;
+	struct pxe_menu *cfg;
+	char *buf;
+
+	if (!IS_ENABLED(CONFIG_PXE_CACHE))
+		return -EAGAIN;
+
+	buf = map_sysmem(PXE_TEST_ADDR, sizeof(conf));
+	strcpy(buf, conf);
+	ut_assertok(pxe_setup_ctx(&ctx, &cmdtp, pxe_test_getfile, NULL, true,
+				  "/boot/extlinux.conf"));
+	pxe_test_reads = 0;
+
+	/* nothing is cached if the source of the files is not known */
+	ut_assertok(pxe_test_parse(uts, &ctx));
+	ut_assertok(pxe_test_parse(uts, &ctx));
+	ut_asserteq(2, pxe_test_reads);
+
+	/* the second time, the include file is not read */
+	ut_assertok(pxe_set_source(&ctx, "mmc 1:1"));
+	ut_assertok(pxe_test_parse(uts, &ctx));
+	ut_asserteq(3, pxe_test_reads);
+	ut_assertok(pxe_test_parse(uts, &ctx));
+	ut_asserteq(3, pxe_test_reads);
+
+	/* the same file on another device may include different files */
+	ut_assertok(pxe_set_source(&ctx, "mmc 2:1"));
+	ut_assertok(pxe_test_parse(uts, &ctx));
+	ut_asserteq(4, pxe_test_reads);
+	ut_assertok(pxe_test_parse(uts, &ctx));
+	ut_asserteq(4, pxe_test_reads);
+
+	/* a change to the file itself is seen */
+	buf[strlen("default linu")] = 'X';
+	cfg = parse_pxefile(&ctx, PXE_TEST_ADDR);
+	ut_assertnonnull(cfg);
+	ut_asserteq_str("linuX", cfg->default_label);
+	destroy_pxe_menu(cfg);
+	ut_asserteq(5, pxe_test_reads);
+
+	pxe_destroy_ctx(&ctx);
+	unmap_sysmem(buf);
+
+	return 0;
+}
+BOOTSTD_TEST(pxe_test_cache, 0);
@@ -7,10 +7,14 @@
 
 #include <common.h>
 #include <bootm.h>
+#include <fdt_support.h>
+#include <image.h>
+#include <malloc.h>
 #include <asm/global_data.h>
 #include <test/suites.h>
 #include <test/test.h>
 #include <test/ut.h>
+#include <linux/libfdt.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -238,6 +242,105 @@ static int bootm_test_subst_both(struct unit_test_state *uts)
 }
 BOOTM_TEST(bootm_test_subst_both, 0);
 
+/* Compressed and decompressed size of each frame in the ramdisk */
+#define FRAME_CSIZE	0x100
+#define FRAME_DSIZE	0x400
+
+#define FIT_SIZE	0x8000
+#define INITRD_ADDR	0x1000000
+
+/* Space for a small FDT once boot_relocate_fdt() has padded it */
+#define FDT_ROOM	0x3000
+
+/**
+ * setup_fdt() - Set up an FDT for booting a ramdisk made of zstd frames
+ *
+ * @uts: Test state
+ * @fit: Buffer of FIT_SIZE bytes to hold a FIT with the ramdisk
+ * @blob: Buffer of FDT_ROOM bytes to hold the FDT
+ * @count: Number of frames in the ramdisk
+ * Return: 0 if OK, 1 on failure
+ */
+static int setup_fdt(struct unit_test_state *uts, void *fit, void *blob,
+		     int count)
+{
+	bootm_headers_t images;
+	fdt32_t *index;
+	int node, i;
+
+	ut_assertok(fdt_create_empty_tree(fit, FIT_SIZE));
+	node = fdt_add_subnode(fit, 0, "images");
+	ut_assert(node >= 0);
+	node = fdt_add_subnode(fit, node, "ramdisk-1");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_string(fit, node, FIT_COMP_PROP, "zstd"));
+	ut_assertok(fdt_setprop_placeholder(fit, node, FIT_FRAME_INDEX_PROP,
+					    count * 2 * sizeof(fdt32_t),
+					    (void **)&index));
+	for (i = 0; i < count; i++) {
+		index[i * 2] = cpu_to_fdt32(FRAME_CSIZE);
+		index[i * 2 + 1] = cpu_to_fdt32(FRAME_DSIZE);
+	}
+
+	memset(&images, '\0', sizeof(images));
+	images.fit_hdr_rd = fit;
+	images.fit_noffset_rd = node;
+	images.initrd_start = INITRD_ADDR;
+	images.initrd_end = INITRD_ADDR + count * FRAME_CSIZE;
+
+	ut_assertok(fdt_create_empty_tree(blob, FDT_ROOM));
+	ut_assertok(image_setup_libfdt(&images, blob, FDT_ROOM, NULL));
+	ut_assert(fdt_totalsize(blob) <= FDT_ROOM);
+
+	return 0;
+}
+
+/* Test passing the frame index of a ramdisk to the OS in /chosen */
+static int bootm_test_initrd_frame_index(struct unit_test_state *uts)
+{
+	const fdt32_t *index;
+	void *fit, *blob;
+	int chosen, len, i;
+
+	if (!IS_ENABLED(CONFIG_FIT_RAMDISK_FRAME_INDEX))
+		return -EAGAIN;
+
+	fit = malloc(FIT_SIZE);
+	ut_assertnonnull(fit);
+	blob = memalign(0x1000, FDT_ROOM);
+	ut_assertnonnull(blob);
+
+	ut_assertok(setup_fdt(uts, fit, blob, 4));
+	chosen = fdt_path_offset(blob, "/chosen");
+	ut_assert(chosen >= 0);
+	ut_assertnonnull(fdt_getprop(blob, chosen, "linux,initrd-start", NULL));
+	ut_asserteq_str("zstd", fdt_getprop(blob, chosen,
+					    "u-boot,initrd-compression", NULL));
+	index = fdt_getprop(blob, chosen, "u-boot,initrd-frame-index", &len);
+	ut_assertnonnull(index);
+	ut_asserteq(4 * 2 * sizeof(fdt32_t), len);
+	for (i = 0; i < 4; i++) {
+		ut_asserteq(FRAME_CSIZE, fdt32_to_cpu(index[i * 2]));
+		ut_asserteq(FRAME_DSIZE, fdt32_to_cpu(index[i * 2 + 1]));
+	}
+
+	/* an index which does not fit in the padding is left out */
+	console_record_reset_enable();
+	ut_assertok(setup_fdt(uts, fit, blob, FDT_ROOM / sizeof(fdt32_t)));
+	ut_assert_skip_to_line("WARNING: no room for ramdisk frame index, increase CONFIG_SYS_FDT_PAD");
+	chosen = fdt_path_offset(blob, "/chosen");
+	ut_assert(chosen >= 0);
+	ut_assertnonnull(fdt_getprop(blob, chosen, "linux,initrd-start", NULL));
+	ut_assertnull(fdt_getprop(blob, chosen, "u-boot,initrd-frame-index",
+				  NULL));
+
+	free(blob);
+	free(fit);
+
+	return 0;
+}
+BOOTM_TEST(bootm_test_initrd_frame_index, UT_TESTF_CONSOLE_REC);
+
 int do_ut_bootm(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 {
 	struct unit_test *tests = UNIT_TEST_SUITE_START(bootm_test);
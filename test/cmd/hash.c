@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the cmp and hash commands over larger ranges
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <command.h>
+#include <console.h>
+#include <env.h>
+#include <hash.h>
+#include <mapmem.h>
+#include <part.h>
+#include <dm/test.h>
+#include <test/ut.h>
+#include <u-boot/sha256.h>
+
+/* Declare a new mem test */
+#define MEM_TEST(_name, _flags)	UNIT_TEST(_name, _flags, mem_test)
+
+#define CMP_SIZE	0x20000
+#define TREE_SIZE	0x1100
+#define TREE_LEAF	0x400
+
+/* Test 'cmp' across several chunks, with a difference near the end */
+static int mem_test_cmp_chunks(struct unit_test_state *uts)
+{
+	u8 *buf;
+
+	buf = map_sysmem(0, CMP_SIZE * 2);
+	memset(buf, '\xa5', CMP_SIZE * 2);
+	ut_assertok(console_record_reset_enable());
+	ut_assertok(run_command("cmp.b 0 20000 20000", 0));
+	ut_assert_nextline("Total of 131072 byte(s) were the same");
+	ut_assert_console_end();
+
+	*(u32 *)(buf + 0x1a004) = 0x11;
+	*(u32 *)(buf + CMP_SIZE + 0x1a004) = 0x22;
+	ut_asserteq(1, run_command("cmp.l 0 20000 8000", 0));
+	ut_assert_nextline("word at 0x0001a004 (0x11) != word at 0x0003a004 (0x22)");
+	ut_assert_nextline("Total of 26625 word(s) were the same");
+	ut_assert_console_end();
+
+	unmap_sysmem(buf);
+
+	return 0;
+}
+MEM_TEST(mem_test_cmp_chunks, UT_TESTF_CONSOLE_REC);
+
+/* Test 'hash -t' gives the hash of the concatenated leaf hashes */
+static int mem_test_hash_tree(struct unit_test_state *uts)
+{
+	u8 digests[DIV_ROUND_UP(TREE_SIZE, TREE_LEAF) * SHA256_SUM_LEN];
+	u8 expect[SHA256_SUM_LEN], sum[SHA256_SUM_LEN];
+	ulong ofs;
+	u8 *buf;
+	int i;
+
+	buf = map_sysmem(0, TREE_SIZE);
+	for (i = 0; i < TREE_SIZE; i++)
+		buf[i] = i * 7;
+	for (ofs = 0, i = 0; ofs < TREE_SIZE; ofs += TREE_LEAF, i++) {
+		ut_assertok(hash_block("sha256", buf + ofs,
+				       min(TREE_LEAF, TREE_SIZE - (int)ofs),
+				       digests + i * SHA256_SUM_LEN, NULL));
+	}
+	ut_assertok(hash_block("sha256", digests, sizeof(digests), expect,
+			       NULL));
+
+	ut_assertok(run_command("hash -t 400 sha256 0 1100 treesum", 0));
+	ut_assertok(hash_parse_string("sha256", env_get("treesum"), sum));
+	ut_asserteq_mem(expect, sum, SHA256_SUM_LEN);
+
+	/* leaves which are too small are rejected */
+	ut_assert(run_command("hash -t 100 sha256 0 1100 treesum", 0));
+
+	unmap_sysmem(buf);
+
+	return 0;
+}
+MEM_TEST(mem_test_hash_tree, 0);
+
+/* Test 'hash -d' gives the same result as hashing the data in memory */
+static int dm_test_cmd_hash_blk(struct unit_test_state *uts)
+{
+	struct blk_desc *desc;
+	u8 *buf;
+	int i;
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &desc));
+	buf = map_sysmem(0, 8 * desc->blksz);
+	for (i = 0; i < 8 * desc->blksz; i++)
+		buf[i] = i * 3;
+	ut_asserteq(8, blk_dwrite(desc, 0x10, 8, buf));
+
+	ut_assertok(run_command("hash -d mmc 0 sha256 10 8 blksum", 0));
+	ut_assertok(run_command("hash sha256 0 1000 memsum", 0));
+	ut_asserteq_str(env_get("memsum"), env_get("blksum"));
+
+	ut_assertok(run_command("hash -t 400 -d mmc 0 sha256 10 8 blksum", 0));
+	ut_assertok(run_command("hash -t 400 sha256 0 1000 memsum", 0));
+	ut_asserteq_str(env_get("memsum"), env_get("blksum"));
+
+	/* the range must be within the device */
+	ut_assert(run_command("hash -d mmc 0 sha256 7ff 2 blksum", 0));
+
+	unmap_sysmem(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_cmd_hash_blk, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
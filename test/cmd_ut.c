@@ -66,6 +66,8 @@ static struct cmd_tbl cmd_ut_sub[] = {
 #ifdef CONFIG_SANDBOX
 	U_BOOT_CMD_MKENT(compression, CONFIG_SYS_MAXARGS, 1, do_ut_compression,
 			 "", ""),
+	U_BOOT_CMD_MKENT(compression_bench, CONFIG_SYS_MAXARGS, 1,
+			 do_ut_compression_bench, "", ""),
 	U_BOOT_CMD_MKENT(bloblist, CONFIG_SYS_MAXARGS, 1, do_ut_bloblist,
 			 "", ""),
 	U_BOOT_CMD_MKENT(bootm, CONFIG_SYS_MAXARGS, 1, do_ut_bootm, "", ""),
@@ -118,6 +120,7 @@ static char ut_help_text[] =
 #ifdef CONFIG_SANDBOX
 	"ut bloblist - Test bloblist implementation\n"
 	"ut compression - Test compressors and bootm decompression\n"
+	"ut compression_bench - Benchmark decompression (compbench command)\n"
 #endif
 #ifdef CONFIG_BOOTSTD
 	"ut bootstd - Test standard boot implementation\n"
@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for bootstage spans
+ */
+
+#include <common.h>
+#include <bootstage.h>
+#include <malloc.h>
+#include <net.h>
+#include <asm/global_data.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Space for the stash, enough for a full span table */
+#define STASH_SIZE	(sizeof(struct bootstage_hdr) + \
+			 sizeof(struct bootstage_span_tail) + \
+			 (CONFIG_BOOTSTAGE_SPAN_COUNT + 1) * \
+			 sizeof(struct bootstage_span))
+
+/* Number of spans recorded by the stash-overflow test */
+#define OVERFLOW_SPANS	20
+
+/* Number of spans which fit in the small stash in the stash-overflow test */
+#define OVERFLOW_FIT	5
+
+/*
+ * Stash the bootstage data recorded by a test, then free it and put back the
+ * data which was there before the test
+ */
+static int bootstage_test_stash(struct bootstage_data *old, void *stash,
+				int size)
+{
+	int ret;
+
+	ret = bootstage_stash(stash, size);
+	bootstage_uninit();
+	gd->bootstage = old;
+
+	return ret;
+}
+
+/*
+ * Find the spans at the end of stashed data, returning the number of spans,
+ * or -ENOENT if there are none
+ */
+static int bootstage_test_get_spans(const void *stash,
+				    const struct bootstage_span **spansp)
+{
+	const struct bootstage_hdr *hdr = stash;
+	const struct bootstage_span_tail *tail;
+
+	tail = stash + hdr->size - sizeof(*tail);
+	if (tail->magic != BOOTSTAGE_SPAN_MAGIC)
+		return -ENOENT;
+	*spansp = (const void *)tail - tail->count * sizeof(**spansp);
+
+	return tail->count;
+}
+
+/* Check that a span inside another is recorded first and lies within it */
+static int common_test_bootstage_span_nest(struct unit_test_state *uts)
+{
+	struct bootstage_data *old = gd->bootstage;
+	const struct bootstage_span *span;
+	ulong outer, inner;
+	char *stash;
+
+	stash = malloc(STASH_SIZE);
+	ut_assertnonnull(stash);
+	ut_assertok(bootstage_init(false));
+
+	outer = bootstage_span_start();
+	inner = bootstage_span_start();
+	bootstage_span_end(BOOTSTAGE_SPAN_BLK_READ, "inner", inner, 512);
+	bootstage_span_end(BOOTSTAGE_SPAN_PROBE, "outer", outer, 0);
+	ut_assertok(bootstage_test_stash(old, stash, STASH_SIZE));
+
+	ut_asserteq(2, bootstage_test_get_spans(stash, &span));
+	ut_asserteq_str("inner", span[0].name);
+	ut_asserteq(BOOTSTAGE_SPAN_BLK_READ, span[0].type);
+	ut_asserteq(512, span[0].bytes);
+	ut_asserteq_str("outer", span[1].name);
+	ut_asserteq(BOOTSTAGE_SPAN_PROBE, span[1].type);
+	ut_assert(span[1].start_us <= span[0].start_us);
+	ut_assert(span[0].start_us + span[0].duration_us <=
+		  span[1].start_us + span[1].duration_us);
+	free(stash);
+
+	return 0;
+}
+COMMON_TEST(common_test_bootstage_span_nest, 0);
+
+/* Check that net_loop() records a span even if it gives up early */
+static int common_test_bootstage_span_net(struct unit_test_state *uts)
+{
+	struct bootstage_data *old = gd->bootstage;
+	const struct bootstage_span *span;
+	int count, found, i, ret;
+	char *stash;
+
+	if (!IS_ENABLED(CONFIG_CMD_PING))
+		return -EAGAIN;
+	stash = malloc(STASH_SIZE);
+	ut_assertnonnull(stash);
+	ut_assertok(bootstage_init(false));
+
+	/* there is no address to ping, so this fails the prerequisites */
+	net_ping_ip.s_addr = 0;
+	ret = net_loop(PING);
+	ut_assertok(bootstage_test_stash(old, stash, STASH_SIZE));
+	ut_asserteq(-ENODEV, ret);
+	ut_assert_nextline("*** ERROR: ping address not given");
+	ut_assert_console_end();
+
+	/* there is also a mark for the start of the network operation */
+	count = bootstage_test_get_spans(stash, &span);
+	ut_assert(count > 0);
+	for (i = 0, found = 0; i < count; i++) {
+		if (span[i].type == BOOTSTAGE_SPAN_NET)
+			found++;
+	}
+	ut_asserteq(1, found);
+	free(stash);
+
+	return 0;
+}
+COMMON_TEST(common_test_bootstage_span_net, UT_TESTF_CONSOLE_REC);
+
+/* Check that spans which do not fit are dropped, without failing the stash */
+static int common_test_bootstage_span_overflow(struct unit_test_state *uts)
+{
+	struct bootstage_data *old = gd->bootstage;
+	const struct bootstage_span *span;
+	char name[BOOTSTAGE_SPAN_NAME_LEN];
+	int i, size;
+	char *stash;
+
+	stash = malloc(STASH_SIZE);
+	ut_assertnonnull(stash);
+
+	/* the stash only has space for the first few spans */
+	ut_assertok(bootstage_init(false));
+	for (i = 0; i < OVERFLOW_SPANS; i++) {
+		snprintf(name, sizeof(name), "span%d", i);
+		bootstage_span_end(BOOTSTAGE_SPAN_PROBE, name,
+				   bootstage_span_start(), i);
+	}
+	size = sizeof(struct bootstage_hdr) +
+		sizeof(struct bootstage_span_tail) +
+		OVERFLOW_FIT * sizeof(struct bootstage_span);
+	ut_assertok(bootstage_test_stash(old, stash, size));
+
+	ut_asserteq(OVERFLOW_FIT, bootstage_test_get_spans(stash, &span));
+	for (i = 0; i < OVERFLOW_FIT; i++) {
+		snprintf(name, sizeof(name), "span%d", i);
+		ut_asserteq_str(name, span[i].name);
+		ut_asserteq(i, span[i].bytes);
+	}
+
+	/* the span table itself only holds so many */
+	ut_assertok(bootstage_init(false));
+	for (i = 0; i < CONFIG_BOOTSTAGE_SPAN_COUNT + 2; i++)
+		bootstage_span_end(BOOTSTAGE_SPAN_PROBE, "dev",
+				   bootstage_span_start(), 0);
+	ut_assertok(bootstage_test_stash(old, stash, STASH_SIZE));
+	ut_asserteq(CONFIG_BOOTSTAGE_SPAN_COUNT,
+		    bootstage_test_get_spans(stash, &span));
+	free(stash);
+
+	return 0;
+}
+COMMON_TEST(common_test_bootstage_span_overflow, 0);
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for reading files through a filesystem mount
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <env.h>
+#include <fs.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/*
+ * This needs a filesystem image bound to host device 0. The test in
+ * test/py/tests/test_fs/test_basic.py sets this up and puts the name of a
+ * file in it in the 'fs_test_file' environment variable. The test does
+ * nothing if the variable is not set.
+ */
+static int common_test_fs_file(struct unit_test_state *uts)
+{
+	struct fs_mount *mnt, *mnt2;
+	struct fs_file *file;
+	struct blk_desc *desc;
+	loff_t size, actread, pos;
+	const char *fname;
+	char *expect, *buf;
+
+	fname = env_get("fs_test_file");
+	if (!fname)
+		return -EAGAIN;
+	desc = blk_get_devnum_by_type(IF_TYPE_HOST, 0);
+	ut_assertnonnull(desc);
+
+	/* read the whole file by path, for comparison */
+	ut_assertok(fs_set_blk_dev_with_part(desc, 0));
+	ut_assertok(fs_size(fname, &size));
+	expect = malloc(size);
+	ut_assertnonnull(expect);
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+	ut_assertok(fs_set_blk_dev_with_part(desc, 0));
+	ut_assertok(fs_read(fname, map_to_sysmem(expect), 0, 0, &actread));
+	ut_asserteq(size, actread);
+
+	ut_assertok(fs_mount(desc, 0, &mnt));
+	ut_assertok(fs_file_open(mnt, fname, &file));
+	ut_assertok(fs_file_size(file, &actread));
+	ut_asserteq(size, actread);
+
+	/* read in pieces which do not line up with the filesystem blocks */
+	for (pos = 0; pos < size; pos += actread) {
+		ut_assertok(fs_file_pread(file, buf + pos, pos, 1000,
+					  &actread));
+		ut_assert(actread > 0);
+	}
+	ut_asserteq_mem(expect, buf, size);
+	ut_assertok(fs_file_pread(file, buf, size, 10, &actread));
+	ut_asserteq(0, actread);
+
+	/* using the filesystem by path means the mount must probe it again */
+	ut_assertok(fs_set_blk_dev_with_part(desc, 0));
+	ut_assertok(fs_size(fname, &actread));
+	memset(buf, '\0', size);
+	ut_assertok(fs_file_pread(file, buf + 12345, 12345, 4321, &actread));
+	ut_asserteq(4321, actread);
+	ut_asserteq_mem(expect + 12345, buf + 12345, 4321);
+
+	/* a second mount shares the first, which stays until both go */
+	ut_assertok(fs_mount(desc, 0, &mnt2));
+	ut_asserteq_ptr(mnt, mnt2);
+	fs_umount(mnt2);
+	ut_assertok(fs_file_pread(file, buf, size - 10, 100, &actread));
+	ut_asserteq(10, actread);
+	ut_asserteq_mem(expect + size - 10, buf, 10);
+
+	/* releasing the last user closes the filesystem */
+	fs_file_close(file);
+	fs_umount(mnt);
+	ut_asserteq(FS_TYPE_ANY, fs_get_type());
+
+	/* mounting again probes it afresh */
+	ut_assertok(fs_mount(desc, 0, &mnt));
+	ut_assert(fs_get_type() != FS_TYPE_ANY);
+	ut_assertok(fs_file_open(mnt, fname, &file));
+	ut_assertok(fs_file_pread(file, buf, 1, size - 1, &actread));
+	ut_asserteq(size - 1, actread);
+	ut_asserteq_mem(expect + 1, buf, size - 1);
+	fs_file_close(file);
+	fs_umount(mnt);
+
+	free(buf);
+	free(expect);
+
+	return 0;
+}
+COMMON_TEST(common_test_fs_file, 0);
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the slab front end of malloc()
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Size class used for a 40-byte allocation */
+#define TEST_CLASS	2
+
+static int common_test_malloc_slab(struct unit_test_state *uts)
+{
+	struct slab_stats before, stats;
+	char *ptr, *big;
+	int i;
+
+	if (!CONFIG_IS_ENABLED(SYS_MALLOC_SLAB))
+		return -EAGAIN;
+
+	ut_assertok(slab_get_stats(TEST_CLASS, &before));
+	ut_asserteq(48, before.size);
+	ut_asserteq(-ENOENT, slab_get_stats(SLAB_CLASS_COUNT, &stats));
+
+	ptr = malloc(40);
+	ut_assertnonnull(ptr);
+	ut_assert(slab_owns(ptr));
+	ut_asserteq(48, malloc_usable_size(ptr));
+	ut_assertok(slab_get_stats(TEST_CLASS, &stats));
+	ut_asserteq(before.in_use + 1, stats.in_use);
+	ut_asserteq(before.allocs + 1, stats.allocs);
+
+	/* growing within the object keeps it, growing beyond moves it */
+	for (i = 0; i < 40; i++)
+		ptr[i] = i;
+	ut_asserteq_ptr(ptr, realloc(ptr, 48));
+	big = realloc(ptr, SLAB_MAX_SIZE + 1);
+	ut_assertnonnull(big);
+	ut_assert(!slab_owns(big));
+	for (i = 0; i < 40; i++)
+		ut_asserteq(i, big[i]);
+	ut_assertok(slab_get_stats(TEST_CLASS, &stats));
+	ut_asserteq(before.in_use, stats.in_use);
+	free(big);
+
+	/* a reused object must be cleared by calloc() */
+	ptr = malloc(40);
+	memset(ptr, '\xff', 40);
+	free(ptr);
+	ptr = calloc(1, 40);
+	ut_assert(slab_owns(ptr));
+	for (i = 0; i < 40; i++)
+		ut_asserteq(0, ptr[i]);
+	free(ptr);
+
+	ut_assertok(slab_get_stats(TEST_CLASS, &stats));
+	ut_asserteq(before.in_use, stats.in_use);
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_slab, 0);
+
+static int common_test_malloc_info(struct unit_test_state *uts)
+{
+	struct slab_stats stats;
+	int cls;
+
+	if (!IS_ENABLED(CONFIG_CMD_MALLOC))
+		return -EAGAIN;
+
+	ut_assertok(run_command("malloc info", 0));
+	ut_assert_nextlinen("heap start  : ");
+	ut_assert_nextlinen("heap size   : ");
+	ut_assert_nextlinen("high water  : ");
+	ut_assert_nextlinen("in use      : ");
+	if (CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)) {
+		ut_assert_nextlinen("slab start  : ");
+		ut_assert_nextlinen("slab size   : ");
+		ut_assert_nextlinen("slab in use : ");
+		ut_assert_nextline("%s", "");
+		ut_assert_nextline(" Size  Pages   In use     Peak     Allocs Fallbacks");
+		for (cls = 0; cls < SLAB_CLASS_COUNT; cls++) {
+			ut_assertok(slab_get_stats(cls, &stats));
+			ut_assert_nextlinen("%5u ", stats.size);
+		}
+	}
+	ut_assert_console_end();
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_info, UT_TESTF_CONSOLE_REC);
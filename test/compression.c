@@ -4,6 +4,7 @@
  */
 
 #include <common.h>
+#include <abuf.h>
 #include <bootm.h>
 #include <command.h>
 #include <gzip.h>
@@ -11,7 +12,11 @@
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <asm/global_data.h>
 #include <asm/io.h>
+#include <asm/sections.h>
+#include <asm/unaligned.h>
+#include <linux/sizes.h>
 
 #include <u-boot/lz4.h>
 #include <u-boot/zlib.h>
@@ -22,10 +27,14 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <linux/zstd.h>
+#include <u-boot/zstd.h>
 #include <test/compression.h>
 #include <test/suites.h>
 #include <test/ut.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static const char plain[] =
 	"I am a highly compressable bit of text.\n"
 	"I am a highly compressable bit of text.\n"
@@ -121,6 +130,28 @@ static const char lz4_compressed[] =
 	"\x9d\x12\x8c\x9d";
 static const unsigned long lz4_compressed_size = 276;
 
+/* zstd -z --content-size /tmp/plain.txt > /tmp/plain.zst */
+static const char zstd_compressed[] =
+	"\x28\xb5\x2f\xfd\x64\x5e\x00\xc5\x05\x00\x92\x0d\x25\x1a\x90\x17"
+	"\x36\x07\x84\x8d\x9a\xd8\x30\x5a\x8a\x8c\x88\xb5\x7c\x52\x5a\x07"
+	"\x34\xeb\x5b\xc6\x5d\x6f\xc7\x12\x65\xd0\x1b\xa9\xfc\x5c\x43\x6c"
+	"\xad\xc3\x2f\x38\xbc\xf1\x5a\x2b\xbb\x1f\xc7\x19\x4f\x62\x52\x84"
+	"\x76\x49\x53\x67\x61\x1d\x20\xe3\x66\xe2\xd5\x3b\xf2\x06\x78\xf8"
+	"\x39\x74\x78\x95\x65\xe1\x64\x43\x65\x51\xe9\xab\xba\x1a\x0f\x92"
+	"\x7c\xe3\x05\x50\x03\x08\x59\xc9\x5a\x60\x5f\xb6\x50\xdd\x54\x62"
+	"\xc2\x05\x51\x86\xab\x4c\xd6\xf4\xd5\xb2\x26\xae\x17\x31\x16\x9e"
+	"\x7c\x82\x44\x6e\xea\x92\xcf\xce\x67\x47\x81\x32\xac\xc1\xd7\xc5"
+	"\xf2\xa6\xf1\x91\x39\xd5\xb3\x23\xad\xe3\x86\xd0\x48\xf4\x39\x9d"
+	"\x89\x0b\x00\x45\x1b\x08\xb3\x17\x18\x6b\xa0\xb2\x6b\x8e\x28\xa8"
+	"\x55\x65\xb6\xc6\x6a\xa5\x4f\x23\x12\xee\x53\x55\x2d\x44\x2f\x54"
+	"\x95\x01\xe4\xf4\x6e\xfa";
+static const unsigned long zstd_compressed_size = 198;
+
+/* a frame holding "abc" in a raw block, with no content size in its header */
+static const u8 zstd_no_size[] = {
+	0x28, 0xb5, 0x2f, 0xfd, 0x00, 0x00, 0x19, 0x00, 0x00, 'a', 'b', 'c',
+};
+
 
 #define TEST_BUFFER_SIZE	512
 
@@ -440,6 +471,222 @@ static int compression_test_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lz4, 0);
 
+#define LZ4_BLOCK_MAX	SZ_64K
+
+/*
+ * Write an LZ4 block which decompresses to @size copies of @val: one literal,
+ * a long match at offset 1, then the five literals which must end a block
+ */
+static int lz4_fill_block(u8 *out, u8 val, uint size)
+{
+	uint len = size - 6 - 4;	/* match length, less the minimum */
+	u8 *p = out;
+
+	*p++ = 1 << 4 | 15;
+	*p++ = val;
+	*p++ = 1;
+	*p++ = 0;
+	for (len -= 15; len >= 255; len -= 255)
+		*p++ = 255;
+	*p++ = len;
+	*p++ = 5 << 4;
+	memset(p, val, 5);
+	p += 5;
+
+	return p - out;
+}
+
+/*
+ * Write an LZ4 frame with @count independent 64KB blocks, alternately
+ * compressed and stored. Block n holds 'a' + n; the last block has
+ * @last_size bytes and block @short_blk (if not -1) has half the usual size.
+ */
+static ulong lz4_make_frame(u8 *buf, int count, uint last_size, int short_blk)
+{
+	u8 *p = buf;
+	int i;
+
+	put_unaligned_le32(LZ4F_MAGIC, p);
+	p += 4;
+	*p++ = 0x60;			/* version 1, independent blocks */
+	*p++ = 0x40;			/* 64KB blocks */
+	*p++ = 0;			/* header checksum (not checked) */
+	for (i = 0; i < count; i++) {
+		uint size = LZ4_BLOCK_MAX;
+
+		if (i == count - 1)
+			size = last_size;
+		else if (i == short_blk)
+			size /= 2;
+		if (i & 1) {
+			put_unaligned_le32(size | 0x80000000, p);
+			memset(p + 4, 'a' + i, size);
+		} else {
+			size = lz4_fill_block(p + 4, 'a' + i, size);
+			put_unaligned_le32(size, p);
+		}
+		p += 4 + size;
+	}
+	put_unaligned_le32(0, p);
+	p += 4;
+
+	return p - buf;
+}
+
+static int lz4_check_frame(struct unit_test_state *uts, int count,
+			   uint last_size, int short_blk)
+{
+	const uint max = count * LZ4_BLOCK_MAX;
+	size_t out_size = max;
+	u8 *in, *out, *p;
+	ulong in_size;
+	int i;
+
+	in = malloc(max + SZ_4K);
+	out = malloc(max);
+	ut_assertnonnull(in);
+	ut_assertnonnull(out);
+
+	in_size = lz4_make_frame(in, count, last_size, short_blk);
+	ut_asserteq(0, ulz4fn(in, in_size, out, &out_size));
+	for (i = 0, p = out; i < count; i++) {
+		uint size = LZ4_BLOCK_MAX;
+		uint j;
+
+		if (i == count - 1)
+			size = last_size;
+		else if (i == short_blk)
+			size /= 2;
+		for (j = 0; j < size; j++)
+			ut_asserteq('a' + i, p[j]);
+		p += size;
+	}
+	ut_asserteq(p - out, out_size);
+
+	/* too little space */
+	out_size = p - out - 1;
+	ut_assert(ulz4fn(in, in_size, out, &out_size) < 0);
+
+	free(in);
+	free(out);
+
+	return 0;
+}
+
+/* Check decompressing a frame made of many independent blocks */
+static int compression_test_lz4_blocks(struct unit_test_state *uts)
+{
+	ut_assertok(lz4_check_frame(uts, 7, 1000, -1));
+	ut_assertok(lz4_check_frame(uts, 6, LZ4_BLOCK_MAX, -1));
+
+	/* a short block in the middle cannot be decompressed in parallel */
+	ut_assertok(lz4_check_frame(uts, 5, 1000, 2));
+	ut_assertok(lz4_check_frame(uts, 5, 1000, 3));
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lz4_blocks, 0);
+
+/* Check decompressing a series of zstd frames, with a skippable one */
+static int compression_test_zstd_frames(struct unit_test_state *uts)
+{
+	const uint count = 5, plain_len = strlen(plain);
+	const u8 skippable[8] = { 0x50, 0x2a, 0x4d, 0x18 };
+	struct abuf in, out;
+	u8 *ptr, *buf;
+	uint i;
+
+	if (!IS_ENABLED(CONFIG_ZSTD))
+		return -EAGAIN;
+	abuf_init(&in);
+	ut_assert(abuf_realloc(&in, count * zstd_compressed_size +
+			       sizeof(skippable)));
+	for (i = 0, ptr = abuf_data(&in); i < count; i++) {
+		memcpy(ptr, zstd_compressed, zstd_compressed_size);
+		ptr += zstd_compressed_size;
+		if (i == 1) {
+			memcpy(ptr, skippable, sizeof(skippable));
+			ptr += sizeof(skippable);
+		}
+	}
+
+	buf = malloc(count * plain_len);
+	ut_assertnonnull(buf);
+	abuf_init_set(&out, buf, count * plain_len);
+	ut_asserteq(count * plain_len, zstd_decompress(&in, &out));
+	for (i = 0; i < count; i++)
+		ut_asserteq_mem(plain, buf + i * plain_len, plain_len);
+
+	/* every frame records its size, so the parallel path can be used */
+	if (CONFIG_IS_ENABLED(PARALLEL)) {
+		memset(buf, '\0', count * plain_len);
+		ut_asserteq(count * plain_len,
+			    zstd_decompress_frames(&in, &out));
+		for (i = 0; i < count; i++)
+			ut_asserteq_mem(plain, buf + i * plain_len, plain_len);
+	}
+
+	/* too little space, which means the frames are decompressed serially */
+	abuf_init_set(&out, buf, count * plain_len - 1);
+	ut_assert(zstd_decompress(&in, &out) < 0);
+
+	/* a frame without a size must also be decompressed serially */
+	memcpy(abuf_data(&in) + zstd_compressed_size, zstd_no_size,
+	       sizeof(zstd_no_size));
+	ut_assert(abuf_realloc(&in, zstd_compressed_size +
+			       sizeof(zstd_no_size)));
+	abuf_init_set(&out, buf, count * plain_len);
+	ut_asserteq(-EAGAIN, zstd_decompress_frames(&in, &out));
+	ut_asserteq(plain_len + 3, zstd_decompress(&in, &out));
+	ut_asserteq_mem(plain, buf, plain_len);
+	ut_asserteq_mem("abc", buf + plain_len, 3);
+
+	free(buf);
+	abuf_uninit(&in);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_zstd_frames, 0);
+
+/*
+ * Check inflate with a large input, using U-Boot's own code and data as a
+ * stand-in for a kernel image, so that the main inflate loop is used
+ */
+static int compression_test_gzip_large(struct unit_test_state *uts)
+{
+	void *base, *code, *in, *out;
+	ulong size, csize, len;
+
+#ifdef CONFIG_SANDBOX
+	base = _init;
+#else
+	base = (void *)gd->relocaddr;
+#endif
+	/* take a copy, since the data may change while the test runs */
+	size = min(gd->mon_len, (ulong)SZ_4M);
+	csize = size + SZ_64K;
+	code = malloc(size);
+	in = malloc(csize);
+	out = malloc(size);
+	ut_assertnonnull(code);
+	ut_assertnonnull(in);
+	ut_assertnonnull(out);
+	memcpy(code, base, size);
+	ut_assertok(gzip(in, &csize, code, size));
+
+	len = csize;
+	ut_assertok(gunzip(out, size, in, &len));
+	ut_asserteq(size, len);
+	ut_asserteq_mem(code, out, size);
+
+	free(code);
+	free(in);
+	free(out);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_gzip_large, 0);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
@@ -536,6 +783,65 @@ static int compression_test_bootm_none(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_bootm_none, 0);
 
+/* Check that the compbench command handles each algorithm */
+static int compression_bench_test_cmd(struct unit_test_state *uts)
+{
+	static const struct {
+		const char *name;
+		const char *data;
+		ulong size;
+	} payloads[] = {
+		{ "bzip2", bzip2_compressed, bzip2_compressed_size },
+		{ "lzma", lzma_compressed, lzma_compressed_size },
+		{ "lzo", lzo_compressed, lzo_compressed_size },
+		{ "lz4", lz4_compressed, lz4_compressed_size },
+		{ "zstd", zstd_compressed, zstd_compressed_size },
+	};
+	const ulong base = 0x10000, step = 0x1000;
+	ulong addr[ARRAY_SIZE(payloads) + 1], size[ARRAY_SIZE(payloads) + 1];
+	ulong plain_size = strlen(plain);
+	char cmd[256];
+	int len, i;
+
+	if (!IS_ENABLED(CONFIG_CMD_COMPBENCH))
+		return -EAGAIN;
+
+	/* gzip first, then the others, each in its own place in memory */
+	addr[0] = base;
+	size[0] = step;
+	ut_assertok(compress_using_gzip(uts, (void *)plain, plain_size,
+					map_sysmem(addr[0], step), step,
+					&size[0]));
+	len = snprintf(cmd, sizeof(cmd), "compbench -c -n 2 -o %lx %lx %lx",
+		       plain_size, addr[0], size[0]);
+	for (i = 0; i < ARRAY_SIZE(payloads); i++) {
+		addr[i + 1] = base + (i + 1) * step;
+		size[i + 1] = payloads[i].size;
+		memcpy(map_sysmem(addr[i + 1], step), payloads[i].data,
+		       payloads[i].size);
+		len += snprintf(cmd + len, sizeof(cmd) - len, " %lx %lx",
+				addr[i + 1], size[i + 1]);
+	}
+
+	ut_assertok(run_command(cmd, 0));
+	ut_assert_nextline("comp,payload,in_bytes,out_bytes,us,ticks,tbclk,peak_heap");
+	ut_assert_nextlinen("gzip,%lx,%lu,%lu,", addr[0], size[0], plain_size);
+	for (i = 0; i < ARRAY_SIZE(payloads); i++) {
+		ut_assert_nextlinen("%s,%lx,%lu,%lu,", payloads[i].name,
+				    addr[i + 1], size[i + 1], plain_size);
+	}
+	ut_assert_console_end();
+
+	/* an output buffer which is too small should be reported */
+	snprintf(cmd, sizeof(cmd), "compbench -o %lx %lx %lx", plain_size - 1,
+		 addr[0], size[0]);
+	ut_asserteq(1, run_command(cmd, 0));
+	console_record_reset();
+
+	return 0;
+}
+COMPRESSION_BENCH_TEST(compression_bench_test_cmd, UT_TESTF_CONSOLE_REC);
+
 int do_ut_compression(struct cmd_tbl *cmdtp, int flag, int argc,
 		      char *const argv[])
 {
@@ -545,3 +851,13 @@ int do_ut_compression(struct cmd_tbl *cmdtp, int flag, int argc,
 	return cmd_ut_category("compression", "compression_test_",
 			       tests, n_ents, argc, argv);
 }
+
+int do_ut_compression_bench(struct cmd_tbl *cmdtp, int flag, int argc,
+			    char *const argv[])
+{
+	struct unit_test *tests = UNIT_TEST_SUITE_START(compression_bench_test);
+	const int n_ents = UNIT_TEST_SUITE_COUNT(compression_bench_test);
+
+	return cmd_ut_category("compression_bench", "compression_bench_test_",
+			       tests, n_ents, argc, argv);
+}
@@ -13,6 +13,7 @@
 #include <malloc.h>
 #include <asm/global_data.h>
 #include <dm/device-internal.h>
+#include <dm/lists.h>
 #include <dm/root.h>
 #include <dm/util.h>
 #include <dm/test.h>
@@ -537,6 +538,59 @@ static int dm_test_leak(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_leak, 0);
 
+/* Bind, probe and unbind a device from the devicetree */
+static int dm_test_arena_cycle(struct unit_test_state *uts, ofnode node)
+{
+	struct udevice *dev;
+
+	ut_assertok(lists_bind_fdt(uts->root, node, &dev, NULL, false));
+	ut_assertok(device_probe(dev));
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+
+/* Check that devices which are bound again do not use up the arena */
+static int dm_test_arena(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	ulong used, mem;
+	ofnode node;
+	int i;
+
+	if (!CONFIG_IS_ENABLED(DM_ARENA))
+		return -EAGAIN;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_TEST_FDT, "a-test",
+					      &dev));
+	node = dev_ofnode(dev);
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(device_unbind(dev));
+
+	/* devices bound at start-up use the arena */
+	used = dm_arena_used();
+	dm_arena_enable(true);
+	ut_assertok(lists_bind_fdt(uts->root, node, &dev, NULL, false));
+	ut_assertok(device_probe(dev));
+	dm_arena_enable(false);
+	ut_assert(dm_arena_used() > used);
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(device_unbind(dev));
+
+	/* devices bound later use malloc() and give the memory back */
+	used = dm_arena_used();
+	ut_assertok(dm_test_arena_cycle(uts, node));
+	mem = ut_check_delta(0);
+	for (i = 0; i < 3; i++)
+		ut_assertok(dm_test_arena_cycle(uts, node));
+	ut_asserteq(0, ut_check_delta(mem));
+	ut_asserteq(used, dm_arena_used());
+
+	return 0;
+}
+DM_TEST(dm_test_arena, UT_TESTF_SCAN_FDT | UT_TESTF_LIVE_TREE);
+
 /* Test uclass init/destroy methods */
 static int dm_test_uclass(struct unit_test_state *uts)
 {
@@ -7,11 +7,14 @@
  */
 
 #include <common.h>
+#include <command.h>
+#include <console.h>
 #include <dm.h>
 #include <env.h>
 #include <fdtdec.h>
 #include <log.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <net.h>
 #include <asm/eth.h>
 #include <dm/test.h>
@@ -86,6 +89,260 @@ static int dm_test_eth_prime(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_eth_prime, UT_TESTF_SCAN_FDT);
 
+/* TFTP port and opcodes, from RFC 1350 */
+#define TFTP_PORT	69
+#define TFTP_RRQ	1
+#define TFTP_DATA	3
+#define TFTP_ACK	4
+#define TFTP_ERROR	5
+#define TFTP_BLOCK_SIZE	512
+
+/* Block size asked for by the last TFTP read request */
+static int sb_tftp_blksize;
+
+/*
+ * Act as a TFTP server which notes the block size asked for in a read request
+ * and replies that it does not have the file
+ */
+static int sb_tftp_blksize_handler(struct udevice *dev, void *packet,
+				   unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+	const char *opt, *end;
+	__be16 *s;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP ||
+	    ntohs(ip->udp_dst) != TFTP_PORT)
+		return 0;
+	s = (__be16 *)(ip + 1);
+	if (ntohs(*s) != TFTP_RRQ || priv->recv_packets >= PKTBUFSRX)
+		return 0;
+
+	/* skip the filename and mode, then look through the options */
+	end = (void *)ip + IP_HDR_SIZE + ntohs(ip->udp_len);
+	opt = (const char *)(s + 1);
+	opt += strlen(opt) + 1;
+	opt += strlen(opt) + 1;
+	for (; opt < end; opt += strlen(opt) + 1) {
+		if (!strcmp(opt, "blksize")) {
+			opt += strlen(opt) + 1;
+			sb_tftp_blksize = simple_strtol(opt, NULL, 10);
+		}
+	}
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	s = (__be16 *)(ipr + 1);
+	*s++ = htons(TFTP_ERROR);
+	*s++ = htons(1);	/* file not found */
+	strcpy((char *)s, "Not found");
+	net_set_udp_header((uchar *)ipr, ip->ip_src, ntohs(ip->udp_src),
+			   TFTP_PORT, 4 + 10);
+
+	/* the reply comes from the server */
+	net_copy_ip((void *)&ipr->ip_src, &ip->ip_dst);
+	ipr->ip_sum = 0;
+	ipr->ip_sum = compute_ip_checksum(ipr, IP_HDR_SIZE);
+
+	priv->recv_packet_length[priv->recv_packets] = ETHER_HDR_SIZE +
+		IP_UDP_HDR_SIZE + 4 + 10;
+	++priv->recv_packets;
+
+	return 0;
+}
+
+/* Return the TFTP block size asked for with the current MTU */
+static int sb_tftp_get_blksize(void)
+{
+	sb_tftp_blksize = 0;
+	run_command("tftpboot 100000 missing", 0);
+
+	return sb_tftp_blksize;
+}
+
+/* Check that the MTU is taken from the environment if the driver allows */
+static int dm_test_eth_mtu(struct unit_test_state *uts)
+{
+	int jumbo = SANDBOX_ETH_MTU_MAX - IP_UDP_HDR_SIZE - 4;
+	int small = 1000 - IP_UDP_HDR_SIZE - 4;
+
+	sandbox_eth_set_tx_handler(0, sb_tftp_blksize_handler);
+	env_set("ethact", "eth@10002000");
+	env_set("serverip", "1.1.2.2");
+	ut_assertok(eth_init());
+	ut_asserteq(ETH_DATA_LEN, eth_get_mtu());
+	eth_halt();
+
+	/* The configured block size is used as is at the standard MTU */
+	ut_asserteq(CONFIG_TFTP_BLOCKSIZE, sb_tftp_get_blksize());
+
+	/* A smaller MTU needs no help from the driver */
+	env_set("ethmtu", "1000");
+	ut_assertok(eth_init());
+	ut_asserteq(1000, eth_get_mtu());
+	eth_halt();
+
+	/* Blocks must fit in a frame unless they can be reassembled */
+	ut_asserteq(IS_ENABLED(CONFIG_IP_DEFRAG) ? CONFIG_TFTP_BLOCKSIZE :
+		    min(CONFIG_TFTP_BLOCKSIZE, small),
+		    sb_tftp_get_blksize());
+
+	/* A jumbo frame is accepted by the driver and filled by TFTP */
+	if (NET_MTU_MAX >= SANDBOX_ETH_MTU_MAX) {
+		env_set_ulong("ethmtu", SANDBOX_ETH_MTU_MAX);
+		ut_assertok(eth_init());
+		ut_asserteq(SANDBOX_ETH_MTU_MAX, eth_get_mtu());
+		eth_halt();
+		ut_asserteq(max(CONFIG_TFTP_BLOCKSIZE, jumbo),
+			    sb_tftp_get_blksize());
+	}
+
+	/* If the driver refuses the MTU, the standard one is used */
+	env_set("ethmtu", "9000");
+	ut_assertok(eth_init());
+	ut_asserteq(ETH_DATA_LEN, eth_get_mtu());
+	eth_halt();
+
+	/* Larger than any frame */
+	env_set("ethmtu", "9001");
+	ut_assertok(eth_init());
+	ut_asserteq(ETH_DATA_LEN, eth_get_mtu());
+	eth_halt();
+
+	sandbox_eth_set_tx_handler(0, NULL);
+	env_set("ethmtu", NULL);
+	env_set("serverip", NULL);
+	env_set("ethact", NULL);
+
+	return 0;
+}
+DM_TEST(dm_test_eth_mtu, UT_TESTF_SCAN_FDT);
+
+/* Check that sent and received packets are counted */
+static int dm_test_eth_stats(struct unit_test_state *uts)
+{
+	struct eth_stats before, after;
+	struct udevice *dev;
+
+	net_ping_ip = string_to_ip("1.1.2.2");
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_ETH, "eth@10002000",
+					      &dev));
+	ut_assertok(eth_get_stats(dev, &before));
+
+	env_set("ethact", "eth@10002000");
+	ut_assertok(net_loop(PING));
+
+	ut_assertok(eth_get_stats(dev, &after));
+	/* ARP request and ping request out, ARP reply and ping reply in */
+	ut_asserteq(before.tx_packets + 2, after.tx_packets);
+	ut_asserteq(before.rx_packets + 2, after.rx_packets);
+	ut_asserteq(before.tx_errors, after.tx_errors);
+	ut_asserteq(before.rx_errors, after.rx_errors);
+
+	env_set("ethact", NULL);
+
+	return 0;
+}
+DM_TEST(dm_test_eth_stats, UT_TESTF_SCAN_FDT);
+
+/* Number of further ARP requests for sb_batch_handler() to inject */
+static int sb_batch_inject;
+
+/* Answer each ARP reply from U-Boot with another ARP request, while wanted */
+static int sb_batch_handler(struct udevice *dev, void *packet,
+			    unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+	struct arp_hdr *arp = packet + ETHER_HDR_SIZE;
+
+	if (ntohs(eth->et_protlen) != PROT_ARP ||
+	    ntohs(arp->ar_op) != ARPOP_REPLY || !sb_batch_inject)
+		return 0;
+	sb_batch_inject--;
+
+	return sandbox_eth_recv_arp_req(dev);
+}
+
+/* Check receiving packets in batches and the receive budget */
+static int dm_test_eth_rx_batch(struct unit_test_state *uts)
+{
+	struct eth_stats before, after;
+	struct eth_sandbox_priv *priv;
+	struct udevice *dev;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_ETH, "eth@10002000",
+					      &dev));
+	priv = dev_get_priv(dev);
+	env_set("ethact", "eth@10002000");
+	ut_assertok(eth_init());
+	ut_assertok(eth_get_stats(dev, &before));
+	sandbox_eth_set_tx_handler(0, sb_batch_handler);
+	/* Make sure sandbox_eth_recv_arp_req() knows who is asking */
+	priv->fake_host_ipaddr = string_to_ip("1.1.2.4");
+
+	/* packets waiting are taken in one batch and all handed back */
+	sb_batch_inject = 0;
+	ut_assertok(sandbox_eth_recv_arp_req(dev));
+	ut_assertok(sandbox_eth_recv_arp_req(dev));
+	ut_assertok(sandbox_eth_recv_arp_req(dev));
+	ut_assertok(eth_rx());
+	ut_asserteq(0, priv->recv_packets);
+	ut_asserteq(0, priv->batch_count);
+	ut_assertok(eth_get_stats(dev, &after));
+	ut_asserteq(before.rx_packets + 3, after.rx_packets);
+	ut_asserteq(before.tx_packets + 3, after.tx_packets);
+	ut_asserteq(before.rx_budget_full, after.rx_budget_full);
+
+	/*
+	 * Each reply brings another request, so eth_rx() stops once the budget
+	 * is used up, leaving the last request waiting
+	 */
+	sb_batch_inject = ETH_PACKETS_BATCH_RECV * 2;
+	ut_assertok(sandbox_eth_recv_arp_req(dev));
+	ut_assertok(eth_rx());
+	ut_asserteq(ETH_PACKETS_BATCH_RECV, sb_batch_inject);
+	ut_asserteq(1, priv->recv_packets);
+	ut_asserteq(0, priv->batch_count);
+	ut_assertok(eth_get_stats(dev, &after));
+	ut_asserteq(before.rx_packets + 3 + ETH_PACKETS_BATCH_RECV,
+		    after.rx_packets);
+	ut_asserteq(before.rx_budget_full + 1, after.rx_budget_full);
+
+	/* the next call picks up where the last one stopped */
+	sb_batch_inject = 0;
+	ut_assertok(eth_rx());
+	ut_asserteq(0, priv->recv_packets);
+	ut_assertok(eth_get_stats(dev, &after));
+	ut_asserteq(before.rx_packets + 4 + ETH_PACKETS_BATCH_RECV,
+		    after.rx_packets);
+	ut_asserteq(before.rx_budget_full + 1, after.rx_budget_full);
+	ut_asserteq(before.rx_errors, after.rx_errors);
+
+	/* a batch which is not handed back stops further receiving */
+	priv->batch_count = 1;
+	ut_asserteq(-EBUSY, eth_rx());
+	ut_assertok(eth_get_stats(dev, &after));
+	ut_asserteq(before.rx_errors + 1, after.rx_errors);
+	priv->batch_count = 0;
+
+	sandbox_eth_set_tx_handler(0, NULL);
+	eth_halt();
+	env_set("ethact", NULL);
+
+	return 0;
+}
+DM_TEST(dm_test_eth_rx_batch, UT_TESTF_SCAN_FDT);
+
 /**
  * This test case is trying to test the following scenario:
  *	- All ethernet devices are not probed
@@ -431,3 +688,163 @@ static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_eth_async_ping_reply, UT_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_TFTP_MULTI
+/**
+ * struct sb_tftp_file - A file on the fake TFTP server
+ *
+ * Byte n of the file is (n + @name[0]) & 0xff
+ *
+ * @name: Filename
+ * @size: Size of the file in bytes
+ * @port: UDP port of the client reading the file
+ */
+struct sb_tftp_file {
+	const char *name;
+	int size;
+	int port;
+};
+
+static struct sb_tftp_file sb_tftp_files[] = {
+	{ "kernel", 3000 },
+	{ "initrd", 2 * TFTP_BLOCK_SIZE },	/* ends with an empty block */
+	{ "fdt", 100 },
+};
+
+/*
+ * Act as a TFTP server which ignores any options, so that files are sent in
+ * 512-byte blocks, one block per acknowledgement
+ */
+static int sb_tftp_handler(struct udevice *dev, void *packet,
+			   unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct sb_tftp_file *file = NULL;
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+	int i, block, offset, size;
+	uchar *data;
+	__be16 *s;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP ||
+	    ntohs(ip->udp_dst) != TFTP_PORT)
+		return 0;
+	s = (__be16 *)(ip + 1);
+	switch (ntohs(s[0])) {
+	case TFTP_RRQ:
+		for (i = 0; i < ARRAY_SIZE(sb_tftp_files); i++) {
+			if (!strcmp((char *)(s + 1), sb_tftp_files[i].name)) {
+				file = &sb_tftp_files[i];
+				file->port = ntohs(ip->udp_src);
+			}
+		}
+		block = 1;
+		break;
+	case TFTP_ACK:
+		for (i = 0; i < ARRAY_SIZE(sb_tftp_files); i++) {
+			if (sb_tftp_files[i].port == ntohs(ip->udp_src))
+				file = &sb_tftp_files[i];
+		}
+		block = ntohs(s[1]) + 1;
+		/* nothing more to send once the final block is acknowledged */
+		if (!file || (block - 1) * TFTP_BLOCK_SIZE > file->size)
+			return 0;
+		break;
+	default:
+		return 0;
+	}
+	if (priv->recv_packets >= PKTBUFSRX)
+		return 0;
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	s = (__be16 *)(ipr + 1);
+	if (file) {
+		*s++ = htons(TFTP_DATA);
+		*s++ = htons(block);
+		data = (uchar *)s;
+		offset = (block - 1) * TFTP_BLOCK_SIZE;
+		size = min(file->size - offset, TFTP_BLOCK_SIZE);
+		for (i = 0; i < size; i++)
+			data[i] = offset + i + file->name[0];
+		size += 4;
+	} else {
+		*s++ = htons(TFTP_ERROR);
+		*s++ = htons(1);	/* file not found */
+		strcpy((char *)s, "Not found");
+		size = 4 + 10;
+	}
+	net_set_udp_header((uchar *)ipr, ip->ip_src, ntohs(ip->udp_src),
+			   TFTP_PORT, size);
+
+	/* the reply comes from the server */
+	net_copy_ip((void *)&ipr->ip_src, &ip->ip_dst);
+	ipr->ip_sum = 0;
+	ipr->ip_sum = compute_ip_checksum(ipr, IP_HDR_SIZE);
+
+	priv->recv_packet_length[priv->recv_packets] = ETHER_HDR_SIZE +
+		IP_UDP_HDR_SIZE + size;
+	++priv->recv_packets;
+
+	return 0;
+}
+
+/* Check loading several files at once with 'tftpboot -m' */
+static int dm_test_eth_tftp_multi(struct unit_test_state *uts)
+{
+	const struct sb_tftp_file *file;
+	ulong addr;
+	u8 *buf;
+	int i, j;
+
+	sandbox_eth_set_tx_handler(0, sb_tftp_handler);
+	env_set("ethact", "eth@10002000");
+	env_set("serverip", "1.1.2.2");
+
+	console_record_reset_enable();
+	ut_assertok(run_command("tftpboot -m 100000:kernel 200000:initrd 300000:fdt", 0));
+	ut_assert_skip_to_line("Bytes transferred = 3000 (bb8 hex) to 100000 for 'kernel'");
+	ut_assert_nextline("Bytes transferred = 1024 (400 hex) to 200000 for 'initrd'");
+	ut_assert_nextline("Bytes transferred = 100 (64 hex) to 300000 for 'fdt'");
+	ut_assert_console_end();
+	ut_asserteq(100, env_get_hex("filesize", 0));
+	ut_asserteq(0x300000, env_get_hex("fileaddr", 0));
+
+	for (i = 0; i < ARRAY_SIZE(sb_tftp_files); i++) {
+		file = &sb_tftp_files[i];
+		addr = 0x100000 * (i + 1);
+		buf = map_sysmem(addr, file->size);
+		for (j = 0; j < file->size; j++)
+			ut_asserteq((u8)(j + file->name[0]), buf[j]);
+		unmap_sysmem(buf);
+	}
+
+	/* files cannot share a load address */
+	ut_asserteq(1, run_command("tftpboot -m 100000:kernel 100000:fdt", 0));
+	ut_assert_skip_to_line("TFTP error: files must be loaded at different addresses");
+
+	/* nor may one file run into the next */
+	console_record_reset();
+	ut_asserteq(1, run_command("tftpboot -m 100000:kernel 100800:fdt", 0));
+	ut_assert_skip_to_line("TFTP error: 'kernel' does not fit at 00100000");
+
+	/* a missing file fails the whole transfer */
+	console_record_reset();
+	ut_asserteq(1, run_command("tftpboot -m 100000:kernel 200000:missing", 0));
+	ut_assert_skip_to_line("TFTP error: 'Not found' (1) for 'missing'");
+
+	sandbox_eth_set_tx_handler(0, NULL);
+	env_set("serverip", NULL);
+	env_set("ethact", NULL);
+
+	return 0;
+}
+DM_TEST(dm_test_eth_tftp_multi, UT_TESTF_SCAN_FDT);
+#endif /* CONFIG_TFTP_MULTI */
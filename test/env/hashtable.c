@@ -7,6 +7,7 @@
 #include <common.h>
 #include <command.h>
 #include <log.h>
+#include <malloc.h>
 #include <search.h>
 #include <stdio.h>
 #include <test/env.h>
@@ -124,3 +125,137 @@ static int env_test_htab_deletes(struct unit_test_state *uts)
 }
 
 ENV_TEST(env_test_htab_deletes, 0);
+
+static int htab_count_dirty(struct env_entry *entry, void *priv)
+{
+	int *count = priv;
+
+	if (entry->data)
+		count[0]++;
+	else
+		count[1]++;
+
+	return 0;
+}
+
+/* Check that creating, changing and deleting entries marks them dirty */
+static int env_test_htab_dirty(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	struct env_entry item;
+	struct env_entry *ritem;
+	int count[2];
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	ut_assertok(htab_fill(uts, &htab, SIZE / 2));
+	ut_asserteq(SIZE / 2, htab.dirty);
+	hclear_dirty_r(&htab);
+	ut_asserteq(0, htab.dirty);
+
+	/* setting the same value again is not a change */
+	item.callback = NULL;
+	item.flags = 0;
+	item.key = "1";
+	item.data = "1";
+	ut_assert(hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	ut_asserteq(0, htab.dirty);
+
+	item.data = "changed";
+	ut_assert(hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	ut_asserteq(1, htab.dirty);
+
+	ut_assertok(hdelete_r("2", &htab, 0));
+	ut_asserteq(2, htab.dirty);
+
+	memset(count, '\0', sizeof(count));
+	ut_assertok(hwalk_dirty_r(&htab, htab_count_dirty, count));
+	ut_asserteq(1, count[0]);
+	ut_asserteq(1, count[1]);
+
+	/* re-creating a deleted entry supersedes the deletion */
+	item.key = "2";
+	item.data = "again";
+	ut_assert(hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	ut_asserteq(2, htab.dirty);
+	memset(count, '\0', sizeof(count));
+	ut_assertok(hwalk_dirty_r(&htab, htab_count_dirty, count));
+	ut_asserteq(2, count[0]);
+	ut_asserteq(0, count[1]);
+
+	hclear_dirty_r(&htab);
+	ut_asserteq(0, htab.dirty);
+	ut_assert(!htab.dirty_all);
+
+	hdestroy_r(&htab);
+	ut_assert(htab.dirty_all);
+
+	return 0;
+}
+
+ENV_TEST(env_test_htab_dirty, 0);
+
+#define EXPORT_VARS	800
+
+/*
+ * Check that export gives the same result whether or not the sorted list of
+ * entries is reused, and that importing the same data changes nothing
+ */
+static int env_test_htab_export(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	struct env_entry item;
+	struct env_entry *ritem;
+	char key[20], data[60];
+	char *buf = NULL, *copy, *p;
+	ssize_t len;
+	int i;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(EXPORT_VARS * 2, &htab));
+
+	item.callback = NULL;
+	item.flags = 0;
+	for (i = 0; i < EXPORT_VARS; i++) {
+		snprintf(key, sizeof(key), "var_%d", i * 7919 % EXPORT_VARS);
+		snprintf(data, sizeof(data), "value-%08x-%08x-%08x-%08x", i, ~i,
+			 i * 3, i * 5);
+		item.key = key;
+		item.data = data;
+		ut_assert(hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	}
+
+	len = hexport_r(&htab, '\0', 0, &buf, 0, 0, NULL);
+	ut_assert(len > 0);
+	copy = malloc(len);
+	ut_assertnonnull(copy);
+	memcpy(copy, buf, len);
+
+	/* nothing changed: the sorted list is reused */
+	ut_asserteq(len, hexport_r(&htab, '\0', 0, &buf, len, 0, NULL));
+	ut_asserteq_mem(copy, buf, len);
+
+	/* a value changed, as with a boot counter */
+	item.key = "var_1";
+	item.data = "changed";
+	ut_assert(hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	ut_asserteq(len, hexport_r(&htab, '\0', 0, &buf, len, 0, NULL));
+	for (p = buf; *p && strcmp(p, "var_1=changed"); p += strlen(p) + 1)
+		;
+	ut_asserteq_str("var_1=changed", p);
+
+	/* re-importing the same data does not touch any entry */
+	hclear_dirty_r(&htab);
+	ut_asserteq(1, himport_r(&htab, buf, len, '\0', H_NOCLEAR, 0, 0,
+				 NULL));
+	ut_asserteq(0, htab.dirty);
+
+	free(copy);
+	free(buf);
+	hdestroy_r(&htab);
+
+	return 0;
+}
+
+ENV_TEST(env_test_htab_export, 0);
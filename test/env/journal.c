@@ -0,0 +1,323 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the environment journal, using a RAM-backed flash emulation and
+ * the sandbox SPI flash
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <env_journal.h>
+#include <mapmem.h>
+#include <os.h>
+#include <search.h>
+#include <spi_flash.h>
+#include <asm/state.h>
+#include <asm/test.h>
+#include <test/env.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define AREA_SIZE	1024
+
+/* Size of each journal area on the sandbox SPI flash */
+#define SF_AREA_SIZE	0x10000
+
+static u8 flash[2 * AREA_SIZE];
+
+static int ram_read(struct env_journal *jnl, ulong offset, size_t len,
+		    void *buf)
+{
+	memcpy(buf, flash + offset, len);
+
+	return 0;
+}
+
+/* Like NOR flash, programming can only clear bits */
+static int ram_write(struct env_journal *jnl, ulong offset, size_t len,
+		     const void *buf)
+{
+	const u8 *src = buf;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		flash[offset + i] &= src[i];
+
+	return 0;
+}
+
+static int ram_erase(struct env_journal *jnl, ulong offset, size_t len)
+{
+	memset(flash + offset, 0xff, len);
+
+	return 0;
+}
+
+static const struct env_journal_ops ram_ops = {
+	.read	= ram_read,
+	.write	= ram_write,
+	.erase	= ram_erase,
+};
+
+/* Set up a journal with two areas of @size bytes, one after the other */
+static void journal_init(struct env_journal *jnl,
+			 const struct env_journal_ops *ops, void *priv,
+			 ulong size)
+{
+	memset(jnl, '\0', sizeof(*jnl));
+	jnl->ops = ops;
+	jnl->priv = priv;
+	jnl->offset[0] = 0;
+	jnl->offset[1] = size;
+	jnl->size = size;
+	jnl->align = 4;
+	jnl->cur = -1;
+}
+
+static int set_var(struct unit_test_state *uts, struct hsearch_data *htab,
+		   const char *name, const char *value)
+{
+	struct env_entry item = { .key = name, .data = (char *)value };
+	struct env_entry *ep;
+
+	if (value) {
+		ut_assert(hsearch_r(item, ENV_ENTER, &ep, htab, 0));
+	} else {
+		ut_assertok(hdelete_r(name, htab, 0));
+	}
+
+	return 0;
+}
+
+static int check_var(struct unit_test_state *uts, struct hsearch_data *htab,
+		     const char *name, const char *value)
+{
+	struct env_entry item = { .key = name };
+	struct env_entry *ep;
+
+	hsearch_r(item, ENV_FIND, &ep, htab, 0);
+	if (value) {
+		ut_assertnonnull(ep);
+		ut_asserteq_str(value, ep->data);
+	} else {
+		ut_assertnull(ep);
+	}
+
+	return 0;
+}
+
+/* Load the journal into a fresh table */
+static int reload(struct unit_test_state *uts, struct env_journal *jnl,
+		  struct hsearch_data *htab)
+{
+	hdestroy_r(htab);
+	memset(htab, '\0', sizeof(*htab));
+	ut_assertok(env_journal_load(jnl, htab, 0));
+	ut_asserteq(0, htab->dirty);
+
+	return 0;
+}
+
+/* Check that small changes are appended without erasing */
+static int env_test_journal_append(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	struct env_journal jnl;
+	ulong pos;
+
+	memset(flash, 0xff, sizeof(flash));
+	memset(&htab, '\0', sizeof(htab));
+	ut_asserteq(1, hcreate_r(32, &htab));
+	journal_init(&jnl, &ram_ops, NULL, AREA_SIZE);
+	ut_asserteq(-ENOMSG, env_journal_load(&jnl, &htab, 0));
+
+	ut_assertok(set_var(uts, &htab, "bootcmd", "run distro_bootcmd"));
+	ut_assertok(set_var(uts, &htab, "bootcount", "0"));
+	ut_assertok(set_var(uts, &htab, "old", "gone soon"));
+	ut_assertok(env_journal_save(&jnl, &htab));
+	ut_asserteq(0, jnl.cur);
+	hclear_dirty_r(&htab);
+
+	/* change and delete a variable, only a delta is written */
+	pos = jnl.pos;
+	ut_assertok(set_var(uts, &htab, "bootcount", "1"));
+	ut_assertok(set_var(uts, &htab, "old", NULL));
+	ut_assertok(env_journal_save(&jnl, &htab));
+	ut_asserteq(0, jnl.cur);
+	ut_assert(jnl.pos > pos);
+	ut_assert(jnl.pos - pos <= 32);
+	ut_asserteq(0xff, flash[AREA_SIZE]);
+
+	ut_assertok(reload(uts, &jnl, &htab));
+	ut_assertok(check_var(uts, &htab, "bootcmd", "run distro_bootcmd"));
+	ut_assertok(check_var(uts, &htab, "bootcount", "1"));
+	ut_assertok(check_var(uts, &htab, "old", NULL));
+
+	hdestroy_r(&htab);
+
+	return 0;
+}
+
+ENV_TEST(env_test_journal_append, 0);
+
+/* Check that a full area is compacted into the other one */
+static int env_test_journal_compact(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	struct env_journal jnl;
+	char value[16];
+	int i;
+
+	memset(flash, 0xff, sizeof(flash));
+	memset(&htab, '\0', sizeof(htab));
+	ut_asserteq(1, hcreate_r(32, &htab));
+	journal_init(&jnl, &ram_ops, NULL, AREA_SIZE);
+
+	ut_assertok(set_var(uts, &htab, "bootcount", "0"));
+	ut_assertok(env_journal_save(&jnl, &htab));
+	hclear_dirty_r(&htab);
+	ut_asserteq(0, jnl.cur);
+
+	for (i = 1; jnl.cur == 0; i++) {
+		ut_assert(i < AREA_SIZE);
+		snprintf(value, sizeof(value), "%d", i);
+		ut_assertok(set_var(uts, &htab, "bootcount", value));
+		ut_assertok(env_journal_save(&jnl, &htab));
+		hclear_dirty_r(&htab);
+	}
+	ut_asserteq(1, jnl.cur);
+	ut_asserteq(2, jnl.seq);
+
+	/* the newer area wins */
+	ut_assertok(reload(uts, &jnl, &htab));
+	ut_asserteq(1, jnl.cur);
+	ut_assertok(check_var(uts, &htab, "bootcount", value));
+
+	hdestroy_r(&htab);
+
+	return 0;
+}
+
+ENV_TEST(env_test_journal_compact, 0);
+
+/* Check that a torn write is ignored and not appended to */
+static int env_test_journal_torn(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	struct env_journal jnl;
+
+	memset(flash, 0xff, sizeof(flash));
+	memset(&htab, '\0', sizeof(htab));
+	ut_asserteq(1, hcreate_r(32, &htab));
+	journal_init(&jnl, &ram_ops, NULL, AREA_SIZE);
+
+	ut_assertok(set_var(uts, &htab, "bootcount", "0"));
+	ut_assertok(env_journal_save(&jnl, &htab));
+	hclear_dirty_r(&htab);
+
+	ut_assertok(set_var(uts, &htab, "bootcount", "1"));
+	ut_assertok(env_journal_save(&jnl, &htab));
+
+	/* pretend the power failed before the end of the record was written */
+	memset(flash + jnl.pos - 4, 0xff, 4);
+
+	ut_assertok(reload(uts, &jnl, &htab));
+	ut_assertok(check_var(uts, &htab, "bootcount", "0"));
+	ut_asserteq(0, jnl.cur);
+	ut_asserteq(AREA_SIZE, jnl.pos);
+
+	/* the next save goes to the other area */
+	ut_assertok(set_var(uts, &htab, "bootcount", "2"));
+	ut_assertok(env_journal_save(&jnl, &htab));
+	ut_asserteq(1, jnl.cur);
+
+	ut_assertok(reload(uts, &jnl, &htab));
+	ut_assertok(check_var(uts, &htab, "bootcount", "2"));
+
+	hdestroy_r(&htab);
+
+	return 0;
+}
+
+ENV_TEST(env_test_journal_torn, 0);
+
+#ifdef CONFIG_SANDBOX
+static int sf_read(struct env_journal *jnl, ulong offset, size_t len,
+		   void *buf)
+{
+	return spi_flash_read_dm(jnl->priv, offset, len, buf);
+}
+
+static int sf_write(struct env_journal *jnl, ulong offset, size_t len,
+		    const void *buf)
+{
+	return spi_flash_write_dm(jnl->priv, offset, len, buf);
+}
+
+static int sf_erase(struct env_journal *jnl, ulong offset, size_t len)
+{
+	return spi_flash_erase_dm(jnl->priv, offset, len);
+}
+
+static const struct env_journal_ops sf_ops = {
+	.read	= sf_read,
+	.write	= sf_write,
+	.erase	= sf_erase,
+};
+
+/* Check the journal on the sandbox SPI flash */
+static int env_test_journal_sf(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	struct env_journal jnl;
+	struct udevice *dev;
+	int full_size = 0x200000;
+	ulong pos, end;
+	u32 word;
+	u8 *buf;
+
+	/* start with erased flash */
+	buf = map_sysmem(0x20000, full_size);
+	memset(buf, 0xff, full_size);
+	ut_assertok(os_write_file("spi.bin", buf, full_size));
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+
+	memset(&htab, '\0', sizeof(htab));
+	ut_asserteq(1, hcreate_r(16, &htab));
+	journal_init(&jnl, &sf_ops, dev, SF_AREA_SIZE);
+	ut_asserteq(-ENOMSG, env_journal_load(&jnl, &htab, 0));
+
+	ut_assertok(set_var(uts, &htab, "bootcmd", "run distro_bootcmd"));
+	ut_assertok(set_var(uts, &htab, "bootcount", "0"));
+	ut_assertok(env_journal_save(&jnl, &htab));
+	ut_asserteq(0, jnl.cur);
+	hclear_dirty_r(&htab);
+
+	/* a change is appended, the other area is not touched */
+	pos = jnl.pos;
+	ut_assertok(set_var(uts, &htab, "bootcount", "1"));
+	ut_assertok(env_journal_save(&jnl, &htab));
+	ut_asserteq(0, jnl.cur);
+	ut_assert(jnl.pos > pos);
+	end = jnl.pos;
+	ut_assertok(spi_flash_read_dm(dev, SF_AREA_SIZE, sizeof(word), &word));
+	ut_asserteq(~0U, word);
+
+	/* replay from the flash into a fresh table */
+	ut_assertok(reload(uts, &jnl, &htab));
+	ut_asserteq(0, jnl.cur);
+	ut_asserteq(end, jnl.pos);
+	ut_assertok(check_var(uts, &htab, "bootcount", "1"));
+	hdestroy_r(&htab);
+
+	/*
+	 * Since we are about to destroy all devices, we must tell sandbox
+	 * to forget the emulation device
+	 */
+	sandbox_sf_unbind_emul(state_get_current(), 0, 0);
+
+	return 0;
+}
+
+ENV_TEST(env_test_journal_sf, UT_TESTF_DM | UT_TESTF_SCAN_PDATA |
+	 UT_TESTF_SCAN_FDT);
+#endif /* CONFIG_SANDBOX */
@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the arena allocator
+ */
+
+#include <common.h>
+#include <arena.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Test allocating small and large objects */
+static int lib_test_arena_alloc(struct unit_test_state *uts)
+{
+	struct arena arena;
+	char *ptr, *big, *next;
+	ulong start;
+	int i;
+
+	start = ut_check_free();
+	ut_assertok(arena_init(&arena, 256, 0));
+	ut_asserteq(256, arena.total);
+
+	ptr = arena_alloc(&arena, 1);
+	ut_assertnonnull(ptr);
+	ut_asserteq(0, (ulong)ptr % ARENA_ALIGN);
+	ut_assert(arena_owns(&arena, ptr));
+	ut_assert(!arena_owns(&arena, &arena));
+
+	/* objects follow each other, zeroed */
+	next = arena_alloc(&arena, 10);
+	ut_asserteq_ptr(ptr + ARENA_ALIGN, next);
+	for (i = 0; i < 10; i++)
+		ut_asserteq(0, next[i]);
+
+	/* a large object has its own block, leaving the current one */
+	big = arena_alloc(&arena, 1000);
+	ut_assertnonnull(big);
+	ut_assert(arena_owns(&arena, big + 999));
+	ptr = arena_alloc(&arena, 1);
+	ut_asserteq_ptr(next + ARENA_ALIGN, ptr);
+
+	/* filling the block starts another */
+	for (i = 0; i < 20; i++)
+		ut_assert(arena_owns(&arena, arena_alloc(&arena, 32)));
+	ut_asserteq(24, arena.count);
+
+	arena_uninit(&arena);
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_alloc, 0);
+
+/* Test the limit on the memory used */
+static int lib_test_arena_limit(struct unit_test_state *uts)
+{
+	struct arena arena;
+	int i;
+
+	ut_asserteq(-ENOMEM, arena_init(&arena, 256, 128));
+	arena_uninit(&arena);
+
+	ut_assertok(arena_init(&arena, 256, 512));
+	for (i = 0; arena_alloc(&arena, 100); i++)
+		;
+	ut_assert(i >= 2);
+	ut_assert(arena.total <= 512);
+	ut_assertnull(arena_alloc(&arena, 1000));
+	arena_uninit(&arena);
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_limit, 0);
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for CRC32 and CRC32C
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <time.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+#include <linux/sizes.h>
+
+#define CRC32_POLY	0xedb88320
+#define CRC32C_POLY	0x82f63b78
+
+/* Bit-at-a-time reference implementation, with no ones-complement */
+static u32 crc_ref(u32 poly, u32 crc, const u8 *p, uint len)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *p++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ ((crc & 1) ? poly : 0);
+	}
+
+	return crc;
+}
+
+/* Check the CRCs against known values and the reference implementation */
+static int lib_test_crc32(struct unit_test_state *uts)
+{
+	const u8 check[] = "123456789";
+	uint start, len, i;
+	u8 buf[128];
+
+	ut_asserteq(0xcbf43926, crc32(0, check, 9));
+	if (IS_ENABLED(CONFIG_CRC32C))
+		ut_asserteq(0xe3069283, ~crc32c_no_comp(~0, check, 9));
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 37 + 11;
+
+	/* try each alignment and length, to cover the head and tail loops */
+	for (start = 0; start < 8; start++) {
+		for (len = 0; len <= sizeof(buf) - start; len++) {
+			const u8 *p = buf + start;
+
+			ut_asserteq(crc_ref(CRC32_POLY, 0x12345678, p, len),
+				    crc32_no_comp(0x12345678, p, len));
+			if (!IS_ENABLED(CONFIG_CRC32C))
+				continue;
+			ut_asserteq(crc_ref(CRC32C_POLY, 0x12345678, p, len),
+				    crc32c_no_comp(0x12345678, p, len));
+		}
+	}
+
+	/* a CRC calculated in pieces should match */
+	ut_asserteq(crc32(0, buf, sizeof(buf)),
+		    crc32(crc32(0, buf, 13), buf + 13, sizeof(buf) - 13));
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32, 0);
+
+/* Show the speed of each implementation, in MB/s */
+static void crc_bench(const char *name, u32 (*func)(u32 crc, const u8 *p,
+						    uint len),
+		      const u8 *buf, uint size)
+{
+	ulong start, us;
+
+	start = timer_get_us();
+	func(0, buf, size);
+	us = max(timer_get_us() - start, 1UL);
+	printf("%-10s %6lu MB/s\n", name, (ulong)size / us);
+}
+
+static u32 bench_crc32(u32 crc, const u8 *p, uint len)
+{
+	return crc32_no_comp(crc, p, len);
+}
+
+static u32 bench_crc32c(u32 crc, const u8 *p, uint len)
+{
+	return crc32c_no_comp(crc, p, len);
+}
+
+static u32 bench_ref(u32 crc, const u8 *p, uint len)
+{
+	return crc_ref(CRC32_POLY, crc, p, len);
+}
+
+static int lib_test_crc32_bench(struct unit_test_state *uts)
+{
+	const uint size = SZ_4M;
+	u8 *buf;
+	uint i;
+
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+	for (i = 0; i < size; i++)
+		buf[i] = i * 37 + 11;
+
+	crc_bench("crc32", bench_crc32, buf, size);
+	if (IS_ENABLED(CONFIG_CRC32C))
+		crc_bench("crc32c", bench_crc32c, buf, size);
+	crc_bench("bitwise", bench_ref, buf, size / 16);
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32_bench, 0);
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the sampling profiler
+ */
+
+#include <common.h>
+#include <sample.h>
+#include <trace.h>
+#include <asm/sections.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Check that samples and their call stacks are recorded and listed */
+static int lib_test_sample(struct unit_test_state *uts)
+{
+	ulong base = (ulong)_init;
+	struct trace_output_hdr *hdr;
+	ulong frame[6];
+	size_t needed;
+	u32 buf[32];
+	u32 *out;
+
+	/* a chain of three frames, the last one ending the stack */
+	frame[0] = (ulong)&frame[2];
+	frame[1] = base + 0x200;
+	frame[2] = (ulong)&frame[4];
+	frame[3] = base + 0x300;
+	frame[4] = 0;
+	frame[5] = base + 0x400;
+
+	/* use a low rate so that the timer does not add its own samples */
+	ut_assertok(sample_start(1));
+	sample_record(base + 0x100, (ulong)frame, (ulong)frame - 16);
+	sample_record(0, 0, 0);
+	sample_stop();
+
+	ut_assertok(sample_list(buf, sizeof(buf), &needed));
+	hdr = (void *)buf;
+	ut_asserteq(TRACE_CHUNK_SAMPLES, hdr->type);
+	ut_asserteq(2, hdr->rec_count);
+
+	out = (void *)(hdr + 1);
+	if (IS_ENABLED(CONFIG_SAMPLE_PROF_STACK)) {
+		ut_asserteq(4, out[0]);
+		ut_asserteq(0x100, out[1]);
+		ut_asserteq(0x200, out[2]);
+		ut_asserteq(0x300, out[3]);
+		ut_asserteq(0x400, out[4]);
+		out += 5;
+	} else {
+		ut_asserteq(1, out[0]);
+		ut_asserteq(0x100, out[1]);
+		out += 2;
+	}
+
+	/* the second sample is outside U-Boot */
+	ut_asserteq(0, out[0]);
+	ut_asserteq((char *)(out + 1) - (char *)buf, needed);
+
+	return 0;
+}
+LIB_TEST(lib_test_sample, 0);
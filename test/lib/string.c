@@ -12,6 +12,8 @@
 #include <common.h>
 #include <command.h>
 #include <log.h>
+#include <malloc.h>
+#include <linux/sizes.h>
 #include <test/lib.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -196,6 +198,65 @@ static int lib_memmove(struct unit_test_state *uts)
 
 LIB_TEST(lib_memmove, 0);
 
+/**
+ * lib_memcpy_large() - unit test for copying and setting larger regions
+ *
+ * Architecture-specific implementations switch to other methods as the size
+ * grows, e.g. string instructions or non-temporal stores. Test sizes around
+ * these changes, with misaligned regions.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_memcpy_large(struct unit_test_state *uts)
+{
+	static const ulong sizes[] = {255, 256, 257, 4099, SZ_1M + 13};
+	const ulong buflen = SZ_1M + 64;
+	ulong i, j;
+	u8 *src, *dst;
+
+	src = malloc(buflen);
+	dst = malloc(buflen);
+	if (!src || !dst) {
+		free(src);
+		free(dst);
+		return -EAGAIN;
+	}
+	for (j = 0; j < buflen; j++)
+		src[j] = (j ^ (j >> 8)) ^ MASK;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		ulong len = sizes[i];
+
+		memset(dst, '\0', buflen);
+		ut_asserteq_ptr(dst + 3, memcpy(dst + 3, src + 5, len));
+		ut_asserteq_mem(src + 5, dst + 3, len);
+		ut_asserteq(0, dst[2]);
+		ut_asserteq(0, dst[len + 3]);
+
+		ut_asserteq_ptr(dst + 1, memset(dst + 1, MASK, len));
+		for (j = 1; j <= len && dst[j] == MASK; j++)
+			;
+		ut_asserteq(len + 1, j);
+		ut_asserteq(0, dst[0]);
+		ut_asserteq(src[len + 3], dst[len + 1]);
+
+		/* overlapping regions, copied backwards then forwards */
+		memcpy(dst, src, buflen);
+		ut_asserteq_ptr(dst + 7, memmove(dst + 7, dst + 2, len));
+		ut_asserteq_mem(src + 2, dst + 7, len);
+		memcpy(dst, src, buflen);
+		ut_asserteq_ptr(dst + 2, memmove(dst + 2, dst + 7, len));
+		ut_asserteq_mem(src + 7, dst + 2, len);
+	}
+	free(dst);
+	free(src);
+
+	return 0;
+}
+
+LIB_TEST(lib_memcpy_large, 0);
+
 /** lib_memdup() - unit test for memdup() */
 static int lib_memdup(struct unit_test_state *uts)
 {
@@ -0,0 +1,129 @@
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# Check the frame index which mkimage adds to zstd-compressed images
+
+"""
+Check that mkimage fills in the frame-index property of an image made up of
+independently compressed zstd frames, both by walking the frames and from a
+seek table in the zstd seekable format.
+
+This test doesn't run the sandbox. It only checks the host tool 'mkimage'
+"""
+
+import os
+import struct
+import pytest
+import u_boot_utils as util
+
+ZSTD_FRAME_MAGIC = 0xfd2fb528
+ZSTD_SEEK_TABLE_MAGIC = 0x184d2a5e
+ZSTD_SEEKABLE_MAGIC = 0x8f92eab1
+
+base_its = '''
+/dts-v1/;
+
+/ {
+        description = "Ramdisk with a frame index";
+        #address-cells = <1>;
+
+        images {
+                ramdisk-1 {
+                        description = "ramdisk";
+                        data = /incbin/("%(ramdisk)s");
+                        type = "ramdisk";
+                        arch = "sandbox";
+                        os = "linux";
+                        compression = "zstd";
+                        load = <0x40000>;
+                        frame-index;
+                };
+        };
+        configurations {
+                default = "conf-1";
+                conf-1 {
+                        ramdisk = "ramdisk-1";
+                };
+        };
+};
+'''
+
+def make_frame(data):
+    """Make a zstd frame holding data in a single raw block
+
+    The frame header records the content size, as the zstd tool does.
+
+    Args:
+        data (bytes): Data to put in the frame, less than 64KB
+
+    Returns:
+        bytes: zstd frame
+    """
+    # single segment, two-byte content size which is stored less 256
+    hdr = struct.pack('<IBH', ZSTD_FRAME_MAGIC, 0x60, len(data) - 256)
+    block = struct.pack('<I', len(data) << 3 | 1)[:3]
+    return hdr + block + data
+
+def make_seek_table(frames):
+    """Make a skippable frame holding a seek table for some frames
+
+    Args:
+        frames (list of tuple): compressed and decompressed size of each frame
+
+    Returns:
+        bytes: seek table frame
+    """
+    body = b''.join(struct.pack('<II', csize, dsize) for csize, dsize in frames)
+    body += struct.pack('<IBI', len(frames), 0, ZSTD_SEEKABLE_MAGIC)
+    return struct.pack('<II', ZSTD_SEEK_TABLE_MAGIC, len(body)) + body
+
+@pytest.mark.buildconfigspec('fit')
+@pytest.mark.requiredtool('dtc')
+@pytest.mark.requiredtool('fdtget')
+def test_fit_frame_index(u_boot_console):
+    """Test that mkimage adds a frame index to a zstd ramdisk"""
+    cons = u_boot_console
+    mkimage = os.path.join(cons.config.build_dir, 'tools', 'mkimage')
+    tempdir = cons.config.result_dir
+
+    def make_fit(name, ramdisk_data):
+        ramdisk = os.path.join(tempdir, f'{name}.zst')
+        with open(ramdisk, 'wb') as fd:
+            fd.write(ramdisk_data)
+        its = os.path.join(tempdir, f'{name}.its')
+        with open(its, 'w') as fd:
+            fd.write(base_its % {'ramdisk': ramdisk})
+        fit = os.path.join(tempdir, f'{name}.fit')
+        util.run_and_log(cons, [mkimage, '-f', its, fit])
+        return fit
+
+    def get_index(fit):
+        out = util.run_and_log(cons, ['fdtget', '-tu', fit,
+                                      '/images/ramdisk-1', 'frame-index'])
+        vals = [int(val) for val in out.split()]
+        return list(zip(vals[::2], vals[1::2]))
+
+    contents = [bytes([i + 1]) * (300 + i * 100) for i in range(3)]
+    frames = [make_frame(data) for data in contents]
+    sizes = [(len(frame), len(data)) for frame, data in zip(frames, contents)]
+
+    # Frames which record their size
+    fit = make_fit('frame-index', b''.join(frames))
+    assert get_index(fit) == sizes
+    out = util.run_and_log(cons, [mkimage, '-l', fit])
+    assert 'Frame index:  3 frames' in out
+
+    # A seek table is used as is, with an entry for itself
+    table = make_seek_table(sizes)
+    fit = make_fit('frame-index-seekable', b''.join(frames) + table)
+    assert get_index(fit) == sizes + [(len(table), 0)]
+
+    # Truncated data is rejected
+    ramdisk = os.path.join(tempdir, 'frame-index-bad.zst')
+    with open(ramdisk, 'wb') as fd:
+        fd.write(b''.join(frames)[:-1])
+    its = os.path.join(tempdir, 'frame-index-bad.its')
+    with open(its, 'w') as fd:
+        fd.write(base_its % {'ramdisk': ramdisk})
+    fit = os.path.join(tempdir, 'frame-index-bad.fit')
+    util.run_and_log_expect_exception(cons, [mkimage, '-f', its, fit], 1,
+                                      'cannot index zstd frames')
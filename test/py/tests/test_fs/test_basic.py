@@ -290,3 +290,20 @@ class TestFsBasic(object):
                 'setenv filesize'])
             assert(md5val[0] in ''.join(output))
             assert_fs_integrity(fs_type, fs_img)
+
+    @pytest.mark.buildconfigspec('unit_test')
+    def test_fs14(self, u_boot_console, fs_obj_basic):
+        """
+        Test Case 14 - read a file through a mount, in pieces
+        """
+        fs_type,fs_img,md5val = fs_obj_basic
+        with u_boot_console.log.section('Test Case 14 - fs_file_pread()'):
+            # The unit test compares reads through a mount, with and without
+            # the filesystem being probed again in between, against a read
+            # by path
+            output = u_boot_console.run_command_list([
+                'host bind 0 %s' % fs_img,
+                'setenv fs_test_file /%s' % SMALL_FILE,
+                'ut common common_test_fs_file',
+                'setenv fs_test_file'])
+            assert('Failures: 0' in ''.join(output))
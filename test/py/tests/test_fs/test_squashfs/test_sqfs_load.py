@@ -2,14 +2,16 @@
 # Copyright (C) 2020 Bootlin
 # Author: Joao Marcos Costa <joaomarcos.costa@bootlin.com>
 
+import hashlib
 import os
+import shutil
 import subprocess
 import pytest
 
 from sqfs_common import SQFS_SRC_DIR, STANDARD_TABLE
 from sqfs_common import generate_sqfs_src_dir, make_all_images
 from sqfs_common import clean_sqfs_src_dir, clean_all_images
-from sqfs_common import check_mksquashfs_version
+from sqfs_common import check_mksquashfs_version, mksquashfs
 
 @pytest.mark.requiredtool('md5sum')
 def original_md5sum(path):
@@ -152,3 +154,64 @@ def test_sqfs_load(u_boot_console):
     # clean test environment
     clean_all_images(build_dir)
     clean_sqfs_src_dir(build_dir)
+
+# mksquashfs options for the images used to check loading at an offset
+OFFSET_IMAGES = {
+        'offset_gzip' : '-comp gzip',
+        'offset_gzip_no_frag' : '-comp gzip -no-fragments',
+        'offset_zstd' : '-comp zstd',
+        'offset_lzo' : '-comp lzo',
+        'offset_uncomp' : '-noD -noF',
+}
+
+# offset and length of each load; a length of 0 loads to the end of the file
+OFFSET_LOADS = [(0, 0), (100, 50), (4000, 200), (8192, 4096), (12000, 1000),
+                (12298, 500), (5000, 0), (13287, 1)]
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+@pytest.mark.buildconfigspec('cmd_squashfs')
+@pytest.mark.buildconfigspec('fs_squashfs')
+@pytest.mark.requiredtool('mksquashfs')
+def test_sqfs_load_offset(u_boot_console):
+    """ Checks loading part of a file, starting at an offset.
+
+    The file has three 4KB data blocks and a tail of 1000 bytes, which is a
+    fragment unless fragments are disabled. The loads start within a block,
+    at a block boundary and within the tail, and some of them span blocks.
+
+    Args:
+        u_boot_console: provides the means to interact with U-Boot's console.
+    """
+    build_dir = u_boot_console.config.build_dir
+    src_dir = os.path.join(build_dir, 'sqfs_offset_src')
+    size = 3 * 4096 + 1000
+    data = bytes((i * 7 + i // 251) & 0xff for i in range(size))
+
+    check_mksquashfs_version()
+    os.makedirs(src_dir, exist_ok=True)
+    with open(os.path.join(src_dir, 'data'), 'wb') as fd:
+        fd.write(data)
+
+    try:
+        for image, opts in OFFSET_IMAGES.items():
+            image_path = os.path.join(build_dir, image)
+            mksquashfs(' '.join([src_dir, image_path, '-noappend -b 4096',
+                                 opts]))
+            u_boot_console.run_command('host bind 0 {}'.format(image_path))
+            for offset, length in OFFSET_LOADS:
+                expect = data[offset:offset + length if length else size]
+                out = u_boot_console.run_command(
+                    'sqfsload host 0 $kernel_addr_r data {:x} {:x}'.format(
+                        length, offset))
+                assert '{} bytes read'.format(len(expect)) in out
+                checksum = uboot_md5sum(u_boot_console, '$kernel_addr_r',
+                                        hex(len(expect)))
+                assert checksum == hashlib.md5(expect).hexdigest()
+            os.remove(image_path)
+    finally:
+        for image in OFFSET_IMAGES:
+            image_path = os.path.join(build_dir, image)
+            if os.path.exists(image_path):
+                os.remove(image_path)
+        shutil.rmtree(src_dir)
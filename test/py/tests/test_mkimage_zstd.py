@@ -0,0 +1,88 @@
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# Check the zstd frames which mkimage -Z writes
+
+"""
+Check that 'mkimage -Z' compresses the data file as a series of zstd frames,
+each of which records its decompressed size, so that U-Boot can decompress
+them in parallel.
+
+This test doesn't run the sandbox. It only checks the host tool 'mkimage'
+"""
+
+import os
+import struct
+import pytest
+import u_boot_utils as util
+
+ZSTD_FRAME_MAGIC = 0xfd2fb528
+LEGACY_HEADER_SIZE = 64
+
+def get_frames(data):
+    """Walk through a series of zstd frames
+
+    Args:
+        data (bytes): zstd frames, one after the other
+
+    Returns:
+        list of tuple: for each frame:
+            int: compressed size
+            int: decompressed size from the frame header, or None if none
+    """
+    frames = []
+    pos = 0
+    while pos < len(data):
+        magic, fhd = struct.unpack_from('<IB', data, pos)
+        assert magic == ZSTD_FRAME_MAGIC
+        start = pos
+        single = fhd & 0x20
+        fcs_size = [1 if single else 0, 2, 4, 8][fhd >> 6]
+        pos += 5 + (0 if single else 1) + [0, 1, 2, 4][fhd & 3]
+        size = None
+        if fcs_size:
+            size = int.from_bytes(data[pos:pos + fcs_size], 'little')
+            if fcs_size == 2:
+                size += 256
+        pos += fcs_size
+
+        last = False
+        while not last:
+            hdr = int.from_bytes(data[pos:pos + 3], 'little')
+            last = hdr & 1
+            pos += 3 + (1 if (hdr >> 1) & 3 == 1 else hdr >> 3)
+        if fhd & 4:
+            pos += 4
+        frames.append((pos - start, size))
+
+    return frames
+
+@pytest.mark.requiredtool('zstd')
+def test_mkimage_zstd_frames(u_boot_console):
+    """Test that mkimage -Z writes frames which can be decompressed in parallel"""
+    cons = u_boot_console
+    mkimage = os.path.join(cons.config.build_dir, 'tools', 'mkimage')
+    tempdir = cons.config.result_dir
+    frame_size = 0x1000
+
+    data = b''.join(bytes([i]) * 300 + os.urandom(200) for i in range(30))
+    fname = os.path.join(tempdir, 'zstd-frames.bin')
+    with open(fname, 'wb') as fd:
+        fd.write(data)
+    image = os.path.join(tempdir, 'zstd-frames.img')
+    util.run_and_log(cons, [mkimage, '-A', 'sandbox', '-O', 'linux',
+                            '-T', 'ramdisk', '-C', 'zstd',
+                            '-Z', '%x' % frame_size, '-d', fname, image])
+
+    with open(image, 'rb') as fd:
+        compressed = fd.read()[LEGACY_HEADER_SIZE:]
+    frames = get_frames(compressed)
+    sizes = [min(frame_size, len(data) - pos)
+             for pos in range(0, len(data), frame_size)]
+    assert [size for _, size in frames] == sizes
+
+    out = os.path.join(tempdir, 'zstd-frames.zst')
+    with open(out, 'wb') as fd:
+        fd.write(compressed)
+    util.run_and_log(cons, ['zstd', '-d', '-f', out])
+    with open(os.path.join(tempdir, 'zstd-frames'), 'rb') as fd:
+        assert fd.read() == data
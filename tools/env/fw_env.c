@@ -13,6 +13,7 @@
 #include <env.h>
 #include <errno.h>
 #include <env_flags.h>
+#include <env_journal.h>
 #include <fcntl.h>
 #include <libgen.h>
 #include <linux/fs.h>
@@ -62,6 +63,7 @@ struct envdev_s {
 	ulong env_size;			/* environment size */
 	ulong erase_size;		/* device erase size */
 	ulong env_sectors;		/* number of environment sectors */
+	ulong write_size;		/* device write size, 0 if unknown */
 	uint8_t mtd_type;		/* type of the MTD device */
 	int is_ubi;			/* set if we use UBI volume */
 };
@@ -81,6 +83,7 @@ static int dev_current;
 #define ENVSIZE(i)    envdevices[(i)].env_size
 #define DEVESIZE(i)   envdevices[(i)].erase_size
 #define ENVSECTORS(i) envdevices[(i)].env_sectors
+#define DEVWSIZE(i)   envdevices[(i)].write_size
 #define DEVTYPE(i)    envdevices[(i)].mtd_type
 #define IS_UBI(i)     envdevices[(i)].is_ubi
 
@@ -113,6 +116,8 @@ struct environment {
 	char *data;
 	enum flag_scheme flag_scheme;
 	int dirty;
+	int journal;		/* set if stored as a journal */
+	uint32_t journal_seq;	/* sequence number of the journal area read */
 };
 
 static struct environment environment = {
@@ -347,6 +352,7 @@ static int ubi_write(int fd, const void *buf, size_t count)
 }
 
 static int flash_io(int mode, void *buf, size_t count);
+static int journal_flush(void);
 static int parse_config(struct env_opts *opts);
 
 #if defined(CONFIG_FILE)
@@ -510,6 +516,9 @@ int fw_env_flush(struct env_opts *opts)
 	if (!environment.dirty)
 		return 0;
 
+	if (environment.journal)
+		return journal_flush();
+
 	/*
 	 * Update CRC
 	 */
@@ -525,11 +534,10 @@ int fw_env_flush(struct env_opts *opts)
 }
 
 /*
- * Set/Clear a single variable in the environment.
- * This is called in sequence to update the environment
- * in RAM without updating the copy in flash after each set
+ * Set/Clear a single variable in the environment, skipping the access checks
+ * of the variable's flags if @force is set
  */
-int fw_env_write(char *name, char *value)
+static int env_write(char *name, char *value, int force)
 {
 	int len;
 	char *env, *nxt;
@@ -560,19 +568,19 @@ int fw_env_write(char *name, char *value)
 
 	/* check for permission */
 	if (deleting) {
-		if (env_flags_validate_varaccess(name,
+		if (!force && env_flags_validate_varaccess(name,
 		    ENV_FLAGS_VARACCESS_PREVENT_DELETE)) {
 			printf("Can't delete \"%s\"\n", name);
 			errno = EROFS;
 			return -1;
 		}
 	} else if (overwriting) {
-		if (env_flags_validate_varaccess(name,
+		if (!force && env_flags_validate_varaccess(name,
 		    ENV_FLAGS_VARACCESS_PREVENT_OVERWR)) {
 			printf("Can't overwrite \"%s\"\n", name);
 			errno = EROFS;
 			return -1;
-		} else if (env_flags_validate_varaccess(name,
+		} else if (!force && env_flags_validate_varaccess(name,
 			   ENV_FLAGS_VARACCESS_PREVENT_NONDEF_OVERWR)) {
 			const char *defval = fw_getdefenv(name);
 
@@ -586,7 +594,7 @@ int fw_env_write(char *name, char *value)
 			}
 		}
 	} else if (creating) {
-		if (env_flags_validate_varaccess(name,
+		if (!force && env_flags_validate_varaccess(name,
 		    ENV_FLAGS_VARACCESS_PREVENT_CREATE)) {
 			printf("Can't create \"%s\"\n", name);
 			errno = EROFS;
@@ -648,6 +656,16 @@ int fw_env_write(char *name, char *value)
 	return 0;
 }
 
+/*
+ * Set/Clear a single variable in the environment.
+ * This is called in sequence to update the environment
+ * in RAM without updating the copy in flash after each set
+ */
+int fw_env_write(char *name, char *value)
+{
+	return env_write(name, value, 0);
+}
+
 /*
  * Deletes or sets environment variables. Returns -1 and sets errno error codes:
  * 0	  - OK
@@ -1188,9 +1206,14 @@ static int flash_flag_obsolete(int dev, int fd, off_t offset)
 static int flash_write(int fd_current, int fd_target, int dev_target, void *buf,
 		       size_t count)
 {
+	enum flag_scheme flag_scheme = environment.flag_scheme;
 	int rc;
 
-	switch (environment.flag_scheme) {
+	/* A journal area has a sequence number in its header instead */
+	if (environment.journal)
+		flag_scheme = FLAG_NONE;
+
+	switch (flag_scheme) {
 	case FLAG_NONE:
 		break;
 	case FLAG_INCREMENTAL:
@@ -1220,7 +1243,7 @@ static int flash_write(int fd_current, int fd_target, int dev_target, void *buf,
 	if (rc < 0)
 		return rc;
 
-	if (environment.flag_scheme == FLAG_BOOLEAN) {
+	if (flag_scheme == FLAG_BOOLEAN) {
 		/* Have to set obsolete flag */
 		off_t offset = DEVOFFSET(dev_current) +
 		    offsetof(struct env_image_redundant, flags);
@@ -1406,6 +1429,205 @@ static int flash_io(int mode, void *buf, size_t count)
 	return rc;
 }
 
+/*
+ * The environment may be stored as a journal by U-Boot's CONFIG_ENV_JOURNAL,
+ * see include/env_journal.h. It is read by replaying the newer area. Saving
+ * writes a snapshot of the whole environment to the other area, as U-Boot
+ * does when an area is full.
+ */
+
+/* Write alignment of the records, as chosen by U-Boot */
+static ulong journal_align(int dev)
+{
+	return DEVWSIZE(dev) > 4 ? DEVWSIZE(dev) : 4;
+}
+
+static ulong journal_round(int dev, size_t len)
+{
+	return DIV_ROUND_UP(len, journal_align(dev)) * journal_align(dev);
+}
+
+/* Offset of the first record in an area */
+static ulong journal_start(int dev)
+{
+	return journal_round(dev, sizeof(struct env_journal_hdr));
+}
+
+static uint32_t journal_rec_crc(const struct env_journal_rec *rec)
+{
+	return crc32(crc32(0, (uint8_t *)rec,
+			   offsetof(struct env_journal_rec, crc)),
+		     (uint8_t *)(rec + 1), rec->len);
+}
+
+/* Get the record at @pos in an area, NULL if erased or damaged */
+static struct env_journal_rec *journal_rec(int dev, void *buf, ulong pos)
+{
+	struct env_journal_rec *rec = buf + pos;
+
+	if (pos + sizeof(*rec) > ENVSIZE(dev) || rec->type == ~0U)
+		return NULL;
+	if (rec->len > ENVSIZE(dev) - pos - sizeof(*rec) ||
+	    journal_rec_crc(rec) != rec->crc)
+		return NULL;
+
+	return rec;
+}
+
+/* Check that @buf holds a valid area and get its sequence number */
+static int journal_check(int dev, void *buf, uint32_t *seqp)
+{
+	struct env_journal_hdr *hdr = buf;
+	struct env_journal_rec *rec;
+
+	if (hdr->magic != ENV_JOURNAL_MAGIC ||
+	    hdr->crc != crc32(0, (uint8_t *)hdr,
+			      offsetof(struct env_journal_hdr, crc)))
+		return -1;
+
+	rec = journal_rec(dev, buf, journal_start(dev));
+	if (!rec || rec->type != ENV_JOURNAL_SNAPSHOT)
+		return -1;
+	*seqp = hdr->seq;
+
+	return 0;
+}
+
+/* Replay the area in @buf into environment.data */
+static int journal_replay(int dev, void *buf)
+{
+	struct env_journal_rec *rec;
+	ulong pos = journal_start(dev);
+	char *p, *end, *next, *value;
+
+	/* the snapshot */
+	rec = journal_rec(dev, buf, pos);
+	if (rec->len > ENV_SIZE - 2) {
+		fprintf(stderr, "Environment journal snapshot too large\n");
+		return -1;
+	}
+	memset(environment.data, '\0', ENV_SIZE);
+	memcpy(environment.data, rec + 1, rec->len);
+	pos += journal_round(dev, sizeof(*rec) + rec->len);
+
+	/* the changes, stopping at the end or at a torn record */
+	while ((rec = journal_rec(dev, buf, pos))) {
+		p = (char *)(rec + 1);
+		end = p + rec->len;
+		if (rec->type != ENV_JOURNAL_DELTA || !rec->len ||
+		    end[-1] != '\0')
+			break;
+		for (; p < end && *p; p = next) {
+			next = p + strlen(p) + 1;
+			/* "name=value", or "name" if deleted */
+			value = strchr(p, '=');
+			if (value)
+				*value++ = '\0';
+			/* the changes were checked when they were saved */
+			if (env_write(p, value, 1))
+				return -1;
+		}
+		pos += journal_round(dev, sizeof(*rec) + rec->len);
+	}
+
+	return 0;
+}
+
+/*
+ * Load the environment if at least one of the areas read into @addr0 and
+ * @addr1 holds a journal. The environment is kept in the buffer of the other
+ * area, which is the one written by the next save.
+ *
+ * Return: 0 if OK, 1 if there is no journal, -1 on error
+ */
+static int journal_open(void *addr0, void *addr1)
+{
+	struct env_image_redundant *redundant;
+	void *addr[2] = { addr0, addr1 };
+	uint32_t seq[2];
+	int valid[2];
+	int i, cur;
+
+	for (i = 0; i < 2; i++)
+		valid[i] = !journal_check(i, addr[i], &seq[i]);
+	if (!valid[0] && !valid[1])
+		return 1;
+	if (valid[0] && valid[1])
+		cur = (int32_t)(seq[1] - seq[0]) > 0;
+	else
+		cur = valid[1];
+
+	redundant = addr[!cur];
+	environment.data = redundant->data;
+	if (journal_replay(cur, addr[cur]))
+		return -1;
+
+	environment.image = redundant;
+	environment.crc = &redundant->crc;
+	environment.flags = &redundant->flags;
+	environment.journal = 1;
+	environment.journal_seq = seq[cur];
+	environment.dirty = 0;
+	dev_current = cur;
+#ifdef DEBUG
+	fprintf(stderr, "Selected env journal in %s, seq %u\n",
+		DEVNAME(dev_current), seq[cur]);
+#endif
+
+	return 0;
+}
+
+/* Write a snapshot of the environment to the other area */
+static int journal_flush(void)
+{
+	struct env_journal_hdr *hdr;
+	struct env_journal_rec *rec;
+	size_t len;
+	char *end;
+	void *buf;
+	int rc;
+
+	/* up to and including the double '\0' */
+	for (end = environment.data; *end || *(end + 1); ++end)
+		;
+	len = end + 2 - environment.data;
+	if (journal_start(!dev_current) +
+	    journal_round(!dev_current, sizeof(*rec) + len) > CUR_ENVSIZE) {
+		fprintf(stderr, "Error: environment too large for journal\n");
+		return -1;
+	}
+
+	buf = malloc(CUR_ENVSIZE);
+	if (!buf) {
+		fprintf(stderr,
+			"Not enough memory for environment (%ld bytes)\n",
+			CUR_ENVSIZE);
+		return -1;
+	}
+	memset(buf, 0xff, CUR_ENVSIZE);
+
+	hdr = buf;
+	hdr->magic = ENV_JOURNAL_MAGIC;
+	hdr->seq = environment.journal_seq + 1;
+	hdr->crc = crc32(0, (uint8_t *)hdr,
+			 offsetof(struct env_journal_hdr, crc));
+
+	rec = buf + journal_start(!dev_current);
+	rec->type = ENV_JOURNAL_SNAPSHOT;
+	rec->len = len;
+	memcpy(rec + 1, environment.data, len);
+	rec->crc = journal_rec_crc(rec);
+
+	rc = flash_io(O_RDWR, buf, CUR_ENVSIZE);
+	free(buf);
+	if (rc) {
+		fprintf(stderr, "Error: can't write fw_env to flash\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * Prevent confusion if running from erased flash memory
  */
@@ -1507,6 +1729,17 @@ int fw_env_open(struct env_opts *opts)
 			goto open_cleanup;
 		}
 
+		/* An environment stored as a journal by U-Boot */
+		ret = journal_open(addr0, addr1);
+		if (ret < 0) {
+			ret = -EIO;
+			goto open_cleanup;
+		}
+		if (!ret) {
+			free(dev_current ? addr1 : addr0);
+			return 0;
+		}
+
 		crc1 = crc32(0, (uint8_t *)redundant1->data, ENV_SIZE);
 
 		crc1_ok = (crc1 == redundant1->crc);
@@ -1655,6 +1888,7 @@ static int check_device_config(int dev)
 			goto err;
 		}
 		DEVTYPE(dev) = mtdinfo.type;
+		DEVWSIZE(dev) = mtdinfo.writesize;
 		if (DEVESIZE(dev) == 0 && ENVSECTORS(dev) == 0 &&
 		    mtdinfo.type == MTD_NORFLASH)
 			DEVESIZE(dev) = mtdinfo.erasesize;
@@ -24,6 +24,257 @@
 
 static image_header_t header;
 
+/* zstd frame magic numbers, from RFC 8878 and the zstd seekable format */
+#define ZSTD_FRAME_MAGIC	0xfd2fb528
+#define ZSTD_SKIP_MAGIC		0x184d2a50
+#define ZSTD_SKIP_MAGIC_MASK	0xfffffff0
+#define ZSTD_SEEK_TABLE_MAGIC	0x184d2a5e
+#define ZSTD_SEEKABLE_MAGIC	0x8f92eab1
+#define ZSTD_SEEK_FOOTER_SIZE	9
+
+static uint32_t get_le32(const uint8_t *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/**
+ * zstd_get_frame() - Get the compressed and decompressed size of a frame
+ *
+ * @buf: Start of frame
+ * @size: Number of bytes available from @buf
+ * @csizep: Returns the compressed size of the frame
+ * @dsizep: Returns the decompressed size of the frame, 0 if skippable
+ * Return: 0 if OK, -ENOENT if the frame does not record its decompressed
+ *	size, -EINVAL if the frame is invalid, -E2BIG if it is too large
+ */
+static int zstd_get_frame(const uint8_t *buf, size_t size, uint32_t *csizep,
+			  uint32_t *dsizep)
+{
+	static const int did_len[] = {0, 1, 2, 4};
+	const uint8_t *ptr = buf, *end = buf + size;
+	uint64_t dsize = 0;
+	int fcs_len, i;
+	uint8_t fhd;
+	bool last;
+
+	if (size < 8)
+		return -EINVAL;
+	if ((get_le32(buf) & ZSTD_SKIP_MAGIC_MASK) == ZSTD_SKIP_MAGIC) {
+		uint64_t len = 8 + (uint64_t)get_le32(buf + 4);
+
+		if (len > size)
+			return -EINVAL;
+		*csizep = len;
+		*dsizep = 0;
+		return 0;
+	}
+	if (get_le32(buf) != ZSTD_FRAME_MAGIC)
+		return -EINVAL;
+
+	/* frame header: descriptor, window, dictionary ID, content size */
+	fhd = buf[4];
+	ptr += 5 + !(fhd & 0x20) + did_len[fhd & 3];
+	fcs_len = fhd >> 6 ? 1 << (fhd >> 6) : (fhd & 0x20) ? 1 : 0;
+	if (!fcs_len)
+		return -ENOENT;
+	if (end - ptr < fcs_len)
+		return -EINVAL;
+	for (i = fcs_len - 1; i >= 0; i--)
+		dsize = dsize << 8 | ptr[i];
+	if (fcs_len == 2)
+		dsize += 256;
+	ptr += fcs_len;
+
+	/* blocks, each with a three-byte header */
+	do {
+		uint32_t hdr;
+		size_t len;
+
+		if (end - ptr < 3)
+			return -EINVAL;
+		hdr = ptr[0] | ptr[1] << 8 | ptr[2] << 16;
+		ptr += 3;
+		last = hdr & 1;
+		switch ((hdr >> 1) & 3) {
+		case 1:		/* RLE block */
+			len = 1;
+			break;
+		case 3:		/* reserved */
+			return -EINVAL;
+		default:	/* raw or compressed block */
+			len = hdr >> 3;
+			break;
+		}
+		if (end - ptr < len)
+			return -EINVAL;
+		ptr += len;
+	} while (!last);
+
+	/* content checksum */
+	if (fhd & 4) {
+		if (end - ptr < 4)
+			return -EINVAL;
+		ptr += 4;
+	}
+	if (ptr - buf > UINT32_MAX || dsize > UINT32_MAX)
+		return -E2BIG;
+	*csizep = ptr - buf;
+	*dsizep = dsize;
+
+	return 0;
+}
+
+/**
+ * zstd_get_seek_table() - Read the frame index from a zstd seek table
+ *
+ * Data written in the zstd seekable format ends with a skippable frame holding
+ * the size of each frame. If present, this is used as the frame index, with an
+ * extra entry for the seek table itself, so that the frames cover the data.
+ *
+ * @data: zstd data
+ * @size: Size of data in bytes
+ * @index: Place to put the frame index, or NULL to just count the frames
+ * Return: number of frames, or -ENOENT if there is no seek table, or -EINVAL
+ *	if it is invalid
+ */
+static int zstd_get_seek_table(const uint8_t *data, size_t size,
+			       fdt32_t *index)
+{
+	const uint8_t *footer, *entry;
+	uint64_t total = 0, table_size;
+	uint32_t count, esize, i;
+
+	if (size < 8 + ZSTD_SEEK_FOOTER_SIZE)
+		return -ENOENT;
+	footer = data + size - ZSTD_SEEK_FOOTER_SIZE;
+	if (get_le32(footer + 5) != ZSTD_SEEKABLE_MAGIC)
+		return -ENOENT;
+	count = get_le32(footer);
+	esize = footer[4] & 0x80 ? 12 : 8;
+	table_size = 8 + (uint64_t)count * esize + ZSTD_SEEK_FOOTER_SIZE;
+	if (count >= INT_MAX / 2 || table_size > size)
+		return -EINVAL;
+	entry = data + size - table_size;
+	if (get_le32(entry) != ZSTD_SEEK_TABLE_MAGIC ||
+	    get_le32(entry + 4) != table_size - 8)
+		return -EINVAL;
+
+	for (i = 0, entry += 8; i < count; i++, entry += esize) {
+		total += get_le32(entry);
+		if (index) {
+			index[i * 2] = cpu_to_fdt32(get_le32(entry));
+			index[i * 2 + 1] = cpu_to_fdt32(get_le32(entry + 4));
+		}
+	}
+	if (total != size - table_size)
+		return -EINVAL;
+	if (index) {
+		index[i * 2] = cpu_to_fdt32(table_size);
+		index[i * 2 + 1] = 0;
+	}
+
+	return count + 1;
+}
+
+/**
+ * zstd_get_frame_index() - Work out the frame index for zstd data
+ *
+ * The index has a compressed and a decompressed size for each frame, so that
+ * a frame can be found and decompressed without reading those before it.
+ *
+ * @data: zstd data
+ * @size: Size of data in bytes
+ * @index: Place to put the frame index, or NULL to just count the frames
+ * Return: number of frames, or -ve on error
+ */
+static int zstd_get_frame_index(const uint8_t *data, size_t size,
+				fdt32_t *index)
+{
+	uint32_t csize, dsize;
+	size_t pos;
+	int count, ret;
+
+	count = zstd_get_seek_table(data, size, index);
+	if (count != -ENOENT)
+		return count;
+
+	for (pos = 0, count = 0; pos < size; pos += csize, count++) {
+		ret = zstd_get_frame(data + pos, size - pos, &csize, &dsize);
+		if (ret)
+			return ret;
+		if (index) {
+			index[count * 2] = cpu_to_fdt32(csize);
+			index[count * 2 + 1] = cpu_to_fdt32(dsize);
+		}
+	}
+
+	return count;
+}
+
+/**
+ * fit_add_frame_index() - Fill in the frame index of compressed images
+ *
+ * An image node with a 'frame-index' property, normally empty in the source
+ * file, has it set to the index of the zstd frames in the image data. This
+ * allows U-Boot to pass a compressed ramdisk to the OS without decompressing
+ * it.
+ *
+ * @fit: FIT to update
+ * @cmdname: Name of the command, for error messages
+ * Return: 0 if OK, -ENOSPC if the FIT needs more space, other -ve on error
+ */
+static int fit_add_frame_index(void *fit, const char *cmdname)
+{
+	int images_noffset, noffset;
+
+	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	if (images_noffset < 0)
+		return 0;
+
+	fdt_for_each_subnode(noffset, fit, images_noffset) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+		fdt32_t *index;
+		const void *data;
+		size_t size;
+		uint8_t comp;
+		int count, ret;
+
+		if (!fdt_getprop(fit, noffset, FIT_FRAME_INDEX_PROP, NULL))
+			continue;
+		if (fit_image_get_comp(fit, noffset, &comp) ||
+		    comp != IH_COMP_ZSTD) {
+			fprintf(stderr, "%s: Image '%s': frame index needs zstd compression\n",
+				cmdname, name);
+			return -EINVAL;
+		}
+		if (fit_image_get_data(fit, noffset, &data, &size)) {
+			fprintf(stderr, "%s: Image '%s': cannot get data\n",
+				cmdname, name);
+			return -EINVAL;
+		}
+		count = zstd_get_frame_index(data, size, NULL);
+		if (count <= 0) {
+			fprintf(stderr, "%s: Image '%s': cannot index zstd frames: %s\n",
+				cmdname, name,
+				count == -ENOENT ?
+				"frame size not recorded" : strerror(-count));
+			return -EINVAL;
+		}
+		index = malloc(count * 2 * sizeof(fdt32_t));
+		if (!index)
+			return -ENOMEM;
+		zstd_get_frame_index(data, size, index);
+		ret = fdt_setprop(fit, noffset, FIT_FRAME_INDEX_PROP, index,
+				  count * 2 * sizeof(fdt32_t));
+		free(index);
+		if (ret)
+			return ret == -FDT_ERR_NOSPACE ? -ENOSPC : -EIO;
+		debug("Image '%s': %d frames\n", name, count);
+	}
+
+	return 0;
+}
+
 static int fit_add_file_data(struct image_tool_params *params, size_t size_inc,
 			     const char *tmpfile)
 {
@@ -59,6 +310,9 @@ static int fit_add_file_data(struct image_tool_params *params, size_t size_inc,
 		ret = fit_set_timestamp(ptr, 0, time);
 	}
 
+	if (!ret)
+		ret = fit_add_frame_index(ptr, params->cmdname);
+
 	if (!ret)
 		ret = fit_pre_load_data(params->keydir, dest_blob, ptr);
 
@@ -87,6 +87,8 @@ struct image_tool_params {
 	bool quiet;		/* Don't output text in normal operation */
 	unsigned int external_offset;	/* Add padding to external data */
 	int bl_len;		/* Block length in byte for external data */
+	unsigned int zstd_frame_size;	/* Split zstd data into frames this big */
+	char *zstd_file;	/* Temporary file holding the zstd frames */
 	const char *engine_id;	/* Engine to use for signing */
 	bool reset_timestamp;	/* Reset the timestamp on an existing image */
 	struct image_summary summary;	/* results of signing process */
@@ -14,7 +14,9 @@
 #include <image.h>
 #include <version.h>
 #ifdef __linux__
+#include <signal.h>
 #include <sys/ioctl.h>
+#include <sys/wait.h>
 #endif
 
 static void copy_file(int, const char *, int);
@@ -99,6 +101,7 @@ static void usage(const char *msg)
 		"          -R ==> set second image name to 'name'\n"
 		"          -d ==> use image data from 'datafile'\n"
 		"          -x ==> set XIP (execute in place)\n"
+		"          -Z ==> compress 'datafile' with zstd in frames of 'size' (hex)\n"
 		"          -s ==> create an image with no data\n"
 		"          -v ==> verbose\n",
 		params.cmdname);
@@ -163,7 +166,7 @@ static void process_args(int argc, char **argv)
 	int opt;
 
 	while ((opt = getopt(argc, argv,
-		   "a:A:b:B:c:C:d:D:e:Ef:FG:k:i:K:ln:N:p:o:O:rR:qstT:vVx")) != -1) {
+		   "a:A:b:B:c:C:d:D:e:Ef:FG:k:i:K:ln:N:p:o:O:rR:qstT:vVxZ:")) != -1) {
 		switch (opt) {
 		case 'a':
 			params.addr = strtoull(optarg, &ptr, 16);
@@ -317,6 +320,14 @@ static void process_args(int argc, char **argv)
 		case 'x':
 			params.xflag++;
 			break;
+		case 'Z':
+			params.zstd_frame_size = strtoul(optarg, &ptr, 16);
+			if (*ptr || !params.zstd_frame_size) {
+				fprintf(stderr, "%s: invalid frame size %s\n",
+					params.cmdname, optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
 		default:
 			usage("Invalid option");
 		}
@@ -346,6 +357,162 @@ static void process_args(int argc, char **argv)
 
 	if (!params.imagefile)
 		usage("Missing output filename");
+
+	if (params.zstd_frame_size) {
+		if (params.comp != IH_COMP_ZSTD)
+			usage("Frame size needs zstd compression (use -C zstd)");
+		if ((params.fflag && !params.auto_its) || !params.datafile ||
+		    strchr(params.datafile, ':'))
+			usage("Frame size needs a single data file (use -d)");
+	}
+}
+
+static void remove_zstd_file(void)
+{
+	unlink(params.zstd_file);
+}
+
+/**
+ * zstd_compress_chunk() - Compress a chunk of data into a zstd frame
+ *
+ * This runs the zstd tool directly rather than through the shell, so that
+ * nothing in the filename is interpreted by it.
+ *
+ * @buf: Data to compress
+ * @len: Number of bytes to compress
+ * @ofd: File descriptor to append the frame to
+ * Return: 0 if OK, -1 on error
+ */
+static int zstd_compress_chunk(const char *buf, size_t len, int ofd)
+{
+	char size_arg[40];
+	char *const argv[] = { "zstd", "-q", "-c", size_arg, NULL };
+	size_t done = 0;
+	int fds[2], status;
+	ssize_t ret;
+	pid_t pid;
+
+	/*
+	 * zstd cannot tell the size of a pipe, so pass it in, so that it is
+	 * recorded in the frame header. Without it, U-Boot must decompress the
+	 * frames serially.
+	 */
+	snprintf(size_arg, sizeof(size_arg), "--stream-size=%zu", len);
+	debug("Trying to execute \"zstd -q -c %s\"\n", size_arg);
+	if (pipe(fds) < 0) {
+		fprintf(stderr, "%s: pipe failed: %s\n", params.cmdname,
+			strerror(errno));
+		return -1;
+	}
+	pid = fork();
+	if (pid < 0) {
+		fprintf(stderr, "%s: fork failed: %s\n", params.cmdname,
+			strerror(errno));
+		close(fds[0]);
+		close(fds[1]);
+		return -1;
+	}
+	if (!pid) {
+		if (dup2(fds[0], STDIN_FILENO) < 0 ||
+		    dup2(ofd, STDOUT_FILENO) < 0)
+			_exit(127);
+		close(fds[0]);
+		close(fds[1]);
+		execvp(argv[0], argv);
+		fprintf(stderr, "%s: Can't run zstd: %s\n", params.cmdname,
+			strerror(errno));
+		_exit(127);
+	}
+	close(fds[0]);
+
+	while (done < len) {
+		ret = write(fds[1], buf + done, len - done);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		done += ret;
+	}
+	close(fds[1]);
+
+	if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+	    WEXITSTATUS(status) || done != len) {
+		fprintf(stderr, "%s: zstd failed\n", params.cmdname);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * zstd_split_file() - Compress the data file as a series of zstd frames
+ *
+ * Each chunk of the data file is compressed into its own frame, using the
+ * zstd tool. U-Boot can decompress the frames in parallel, since they are
+ * independent. The resulting file is used in place of the data file.
+ *
+ * Return: 0 if OK, -1 on error
+ */
+static int zstd_split_file(void)
+{
+	char *tmpfile, *buf;
+	struct stat sbuf;
+	int dfd, cfd;
+	off_t pos;
+	int ret = -1;
+
+	tmpfile = malloc(strlen(params.imagefile) + 10);
+	buf = malloc(params.zstd_frame_size);
+	if (!tmpfile || !buf) {
+		fprintf(stderr, "%s: Out of memory\n", params.cmdname);
+		return -1;
+	}
+	dfd = open(params.datafile, O_RDONLY | O_BINARY);
+	if (dfd < 0 || fstat(dfd, &sbuf) < 0) {
+		fprintf(stderr, "%s: Can't open %s: %s\n", params.cmdname,
+			params.datafile, strerror(errno));
+		goto err_buf;
+	}
+
+	/* The zstd tool writes each frame to the end of this file */
+	sprintf(tmpfile, "%s.zst", params.imagefile);
+	params.zstd_file = tmpfile;
+	atexit(remove_zstd_file);
+	cfd = open(tmpfile, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_BINARY,
+		   0666);
+	if (cfd < 0) {
+		fprintf(stderr, "%s: Can't create %s: %s\n", params.cmdname,
+			tmpfile, strerror(errno));
+		goto err_dfd;
+	}
+
+	/* Report a failure to run zstd as an error, not a signal */
+	signal(SIGPIPE, SIG_IGN);
+	for (pos = 0; pos < sbuf.st_size; pos += params.zstd_frame_size) {
+		size_t len = sbuf.st_size - pos;
+
+		if (len > params.zstd_frame_size)
+			len = params.zstd_frame_size;
+		if (read(dfd, buf, len) != (ssize_t)len) {
+			fprintf(stderr, "%s: Can't read %s: %s\n",
+				params.cmdname, params.datafile,
+				strerror(errno));
+			goto err_cfd;
+		}
+		if (zstd_compress_chunk(buf, len, cfd))
+			goto err_cfd;
+	}
+	params.datafile = tmpfile;
+	ret = 0;
+err_cfd:
+	close(cfd);
+err_dfd:
+	close(dfd);
+err_buf:
+	free(buf);
+
+	return ret;
 }
 
 static void verify_image(const struct image_type_params *tparams)
@@ -403,6 +570,9 @@ int main(int argc, char **argv)
 
 	process_args(argc, argv);
 
+	if (params.zstd_frame_size && zstd_split_file())
+		exit(EXIT_FAILURE);
+
 	/* set tparams as per input type_id */
 	tparams = imagetool_get_type(params.type);
 	if (tparams == NULL && !params.lflag) {
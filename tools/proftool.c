@@ -18,6 +18,7 @@
 #include <sys/types.h>
 
 #include <compiler.h>
+#include <bootstage.h>
 #include <trace.h>
 
 #define MAX_LINE_LEN 500
@@ -55,6 +56,16 @@ struct func_info *func_list;
 int func_count;
 struct trace_call *call_list;
 int call_count;
+/* A sample from the sampling profiler, see sample_list() in U-Boot */
+struct prof_sample {
+	uint32_t depth;		/* 0 if the sample was taken outside U-Boot */
+	uint32_t *pc;		/* code offsets, innermost first */
+};
+
+struct prof_sample *sample_list;
+int sample_count;
+struct bootstage_span *span_list;	/* bootstage marks and spans */
+int span_count;
 int verbose;	/* Verbosity level 0=none, 1=warn, 2=notice, 3=info, 4=debug */
 unsigned long text_offset;		/* text address of first function */
 
@@ -85,8 +96,11 @@ static void usage(void)
 		"\n"
 		"Commands\n"
 		"   dump-ftrace\t\tDump out textual data in ftrace format\n"
+		"   dump-chrome\t\tDump out trace-event JSON for Perfetto / chrome://tracing\n"
+		"   dump-folded\t\tDump out samples as folded stacks for flame graphs\n"
 		"\n"
 		"Options:\n"
+		"   -b <stash>\tSpecify bootstage stash file (from 'bootstage stash')\n"
 		"   -m <map>\tSpecify Systen.map file\n"
 		"   -t <trace>\tSpecific trace data file (from U-Boot)\n"
 		"   -v <0-4>\tSpecify verbosity\n");
@@ -226,6 +240,39 @@ static int read_calls(FILE *fin, size_t count)
 	return 0;
 }
 
+static int read_samples(FILE *fin, size_t count)
+{
+	struct prof_sample *sample;
+	int i;
+
+	notice("sample count: %zu\n", count);
+	sample_list = calloc(count, sizeof(*sample));
+	if (!sample_list) {
+		error("Cannot allocate sample_list\n");
+		return -1;
+	}
+	sample_count = count;
+
+	for (i = 0, sample = sample_list; i < count; i++, sample++) {
+		if (read_data(fin, &sample->depth, sizeof(sample->depth)))
+			return 1;
+		if (sample->depth > MAX_LINE_LEN) {
+			error("Invalid sample depth %u\n", sample->depth);
+			return 1;
+		}
+		sample->pc = calloc(sample->depth, sizeof(*sample->pc));
+		if (!sample->pc) {
+			error("Cannot allocate sample\n");
+			return -1;
+		}
+		if (sample->depth &&
+		    read_data(fin, sample->pc,
+			      sample->depth * sizeof(*sample->pc)))
+			return 1;
+	}
+	return 0;
+}
+
 static int read_profile(FILE *fin, int *not_found)
 {
 	struct trace_output_hdr hdr;
@@ -249,6 +296,11 @@ static int read_profile(FILE *fin, int *not_found)
 			if (read_calls(fin, hdr.rec_count))
 				return 1;
 			break;
+
+		case TRACE_CHUNK_SAMPLES:
+			if (read_samples(fin, hdr.rec_count))
+				return 1;
+			break;
 		}
 	}
 	return 0;
@@ -297,6 +349,79 @@ static int read_profile_file(const char *fname)
 	return 0;
 }
 
+/*
+ * Read the bootstage marks and spans from the end of a bootstage stash. See
+ * struct bootstage_hdr for the format.
+ */
+static int read_bootstage(const char *buf, long size)
+{
+	struct bootstage_span_tail tail;
+	struct bootstage_hdr hdr;
+	long spans;
+
+	if (size < sizeof(hdr)) {
+		error("Bootstage stash is too small\n");
+		return 1;
+	}
+	memcpy(&hdr, buf, sizeof(hdr));
+	if (hdr.magic != BOOTSTAGE_MAGIC || hdr.size > size ||
+	    hdr.size < sizeof(hdr) + sizeof(tail)) {
+		error("Invalid bootstage stash\n");
+		return 1;
+	}
+	memcpy(&tail, buf + hdr.size - sizeof(tail), sizeof(tail));
+	if (tail.magic != BOOTSTAGE_SPAN_MAGIC) {
+		error("Bootstage stash has no spans - is CONFIG_BOOTSTAGE_SPANS enabled?\n");
+		return 1;
+	}
+	spans = hdr.size - sizeof(tail) - sizeof(hdr);
+	if (tail.count > spans / sizeof(struct bootstage_span)) {
+		error("Invalid bootstage span count %u\n", tail.count);
+		return 1;
+	}
+
+	span_count = tail.count;
+	span_list = calloc(span_count, sizeof(struct bootstage_span));
+	if (!span_list) {
+		error("Cannot allocate span_list\n");
+		return 1;
+	}
+	memcpy(span_list, buf + hdr.size - sizeof(tail) -
+	       span_count * sizeof(struct bootstage_span),
+	       span_count * sizeof(struct bootstage_span));
+	notice("span count: %d\n", span_count);
+
+	return 0;
+}
+
+static int read_bootstage_file(const char *fname)
+{
+	FILE *fin;
+	char *buf;
+	long size;
+	int err;
+
+	fin = fopen(fname, "rb");
+	if (!fin) {
+		error("Cannot open bootstage file '%s'\n", fname);
+		return 1;
+	}
+	fseek(fin, 0, SEEK_END);
+	size = ftell(fin);
+	fseek(fin, 0, SEEK_SET);
+	buf = malloc(size);
+	if (!buf) {
+		error("Cannot allocate bootstage buffer\n");
+		fclose(fin);
+		return 1;
+	}
+	err = read_data(fin, buf, size) ? 1 : read_bootstage(buf, size);
+	free(buf);
+	fclose(fin);
+
+	return err;
+}
+
 static int regex_report_error(regex_t *regex, int err, const char *op,
 			      const char *name)
 {
@@ -532,9 +657,216 @@ static int make_ftrace(void)
 	return 0;
 }
 
+/* Output a string in JSON format, including the quotes */
+static void out_json_str(const char *str)
+{
+	putchar('"');
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			printf("\\%c", *str);
+		else if ((unsigned char)*str < ' ')
+			printf("\\u%04x", *str);
+		else
+			putchar(*str);
+	}
+	putchar('"');
+}
+
+/* Thread IDs used to put each kind of event on its own track */
+enum {
+	CHROME_TID_FUNCS	= 1,
+	CHROME_TID_SPANS,	/* plus enum bootstage_span_type */
+};
+
+static const char *const span_type_name[BOOTSTAGE_SPAN_TYPE_COUNT] = {
+	[BOOTSTAGE_SPAN_MARK]		= "bootstage",
+	[BOOTSTAGE_SPAN_PROBE]		= "probe",
+	[BOOTSTAGE_SPAN_BLK_READ]	= "blk_read",
+	[BOOTSTAGE_SPAN_NET]		= "net",
+	[BOOTSTAGE_SPAN_PROBE_FAIL]	= "probe_fail",
+};
+
+/* Start a new event, with a separator if needed since JSON is strict */
+static void out_chrome_event(void)
+{
+	static bool first = true;
+
+	printf("%s{", first ? "" : ",\n");
+	first = false;
+}
+
+static void out_chrome_thread_name(int tid, const char *name)
+{
+	out_chrome_event();
+	printf("\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+	       tid, name);
+}
+
+/*
+ * Write out the trace-event format used by chrome://tracing and Perfetto:
+ *
+ * {"traceEvents": [
+ * {"name": "board_init_r", "cat": "func", "ph": "B", "ts": 1234, ...},
+ * {"name": "mmc@7e202000", "cat": "probe", "ph": "X", "ts": 1250,
+ *	"dur": 75, ..., "args": {"bytes": 0}},
+ * ...
+ * ]}
+ *
+ * Function calls become begin/end events, bootstage marks become instant
+ * events and bootstage spans become complete events, each on its own track.
+ */
+static int make_chrome(void)
+{
+	struct bootstage_span *span;
+	struct trace_call *call;
+	int missing_count = 0, skip_count = 0;
+	int i;
+
+	printf("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	out_chrome_thread_name(CHROME_TID_FUNCS, "functions");
+	for (i = 0; i < BOOTSTAGE_SPAN_TYPE_COUNT; i++)
+		out_chrome_thread_name(CHROME_TID_SPANS + i, span_type_name[i]);
+
+	for (i = 0, call = call_list; i < call_count; i++, call++) {
+		struct func_info *func = find_func_by_offset(call->func);
+		ulong time = call->flags & FUNCF_TIMESTAMP_MASK;
+
+		if (TRACE_CALL_TYPE(call) != FUNCF_ENTRY &&
+		    TRACE_CALL_TYPE(call) != FUNCF_EXIT)
+			continue;
+		if (!func) {
+			warn("Cannot find function at %lx\n",
+			     text_offset + call->func);
+			missing_count++;
+			continue;
+		}
+		if (!(func->flags & FUNCF_TRACE)) {
+			skip_count++;
+			continue;
+		}
+
+		out_chrome_event();
+		printf("\"name\": ");
+		out_json_str(func->name);
+		printf(", \"cat\": \"func\", \"ph\": \"%c\", \"ts\": %lu, \"pid\": 1, \"tid\": %d}",
+		       TRACE_CALL_TYPE(call) == FUNCF_ENTRY ? 'B' : 'E', time,
+		       CHROME_TID_FUNCS);
+	}
+
+	for (i = 0, span = span_list; i < span_count; i++, span++) {
+		span->name[sizeof(span->name) - 1] = '\0';
+		if (span->type >= BOOTSTAGE_SPAN_TYPE_COUNT) {
+			warn("Unknown span type %u\n", span->type);
+			continue;
+		}
+		out_chrome_event();
+		printf("\"name\": ");
+		out_json_str(span->name);
+		printf(", \"cat\": \"%s\", ", span_type_name[span->type]);
+		if (span->type == BOOTSTAGE_SPAN_MARK)
+			printf("\"ph\": \"i\", \"s\": \"g\", ");
+		else
+			printf("\"ph\": \"X\", \"dur\": %u, ",
+			       span->duration_us);
+		printf("\"ts\": %u, \"pid\": 1, \"tid\": %d, \"args\": {\"bytes\": %u}}",
+		       span->start_us, CHROME_TID_SPANS + span->type,
+		       span->bytes);
+	}
+
+	printf("\n]}\n");
+	info("chrome: %d functions not found, %d excluded\n", missing_count,
+	     skip_count);
+
+	return 0;
+}
+
+static int h_cmp_str(const void *v1, const void *v2)
+{
+	return strcmp(*(const char **)v1, *(const char **)v2);
+}
+
+/* Get the name of the function containing a code offset, for folded output */
+static const char *sample_func_name(uint32_t offset, char *buf, int size)
+{
+	struct func_info *func = find_caller_by_offset(offset);
+
+	if (func && func_count && offset < func_list[func_count - 1].offset +
+	    MAX(func_list[func_count - 1].code_size, FUNC_SITE_SIZE))
+		return func->name;
+	snprintf(buf, size, "%x", offset);
+
+	return buf;
+}
+
+/*
+ * Write out the samples as folded stacks, one line for each distinct stack,
+ * with the functions separated by semicolons, outermost first, followed by
+ * the number of samples:
+ *
+ * board_init_r;initr_dm;dm_init_and_scan;device_probe 12
+ *
+ * This is the input format of flamegraph.pl and similar tools.
+ */
+static int make_folded(void)
+{
+	struct prof_sample *sample;
+	char **stacks;
+	char buf[20];
+	int i, j;
+
+	stacks = calloc(sample_count, sizeof(*stacks));
+	if (!stacks) {
+		error("Cannot allocate stacks\n");
+		return -1;
+	}
+	for (i = 0, sample = sample_list; i < sample_count; i++, sample++) {
+		size_t len = 0;
+		char *str;
+
+		if (!sample->depth) {
+			stacks[i] = strdup("[outside]");
+			if (!stacks[i])
+				return -1;
+			continue;
+		}
+
+		/* return addresses point after the call, so subtract 1 */
+		for (j = 0; j < sample->depth; j++)
+			len += strlen(sample_func_name(sample->pc[j] - !!j, buf,
+						       sizeof(buf))) + 1;
+		str = malloc(len);
+		if (!str) {
+			error("Cannot allocate stack\n");
+			return -1;
+		}
+		for (j = sample->depth - 1, len = 0; j >= 0; j--)
+			len += sprintf(str + len, "%s%s",
+				       sample_func_name(sample->pc[j] - !!j,
+							buf, sizeof(buf)),
+				       j ? ";" : "");
+		stacks[i] = str;
+	}
+
+	qsort(stacks, sample_count, sizeof(*stacks), h_cmp_str);
+	for (i = 0; i < sample_count; i = j) {
+		for (j = i + 1; j < sample_count; j++) {
+			if (strcmp(stacks[i], stacks[j]))
+				break;
+		}
+		printf("%s %d\n", stacks[i], j - i);
+	}
+	for (i = 0; i < sample_count; i++)
+		free(stacks[i]);
+	free(stacks);
+	info("folded: %d samples\n", sample_count);
+
+	return 0;
+}
+
 static int prof_tool(int argc, char *const argv[],
 		     const char *prof_fname, const char *map_fname,
-		     const char *trace_config_fname)
+		     const char *trace_config_fname,
+		     const char *bootstage_fname)
 {
 	int err = 0;
 
@@ -542,6 +874,8 @@ static int prof_tool(int argc, char *const argv[],
 		return -1;
 	if (prof_fname && read_profile_file(prof_fname))
 		return -1;
+	if (bootstage_fname && read_bootstage_file(bootstage_fname))
+		return -1;
 	if (trace_config_fname && read_trace_config_file(trace_config_fname))
 		return -1;
 
@@ -552,6 +886,10 @@ static int prof_tool(int argc, char *const argv[],
 
 		if (0 == strcmp(cmd, "dump-ftrace"))
 			err = make_ftrace();
+		else if (0 == strcmp(cmd, "dump-chrome"))
+			err = make_chrome();
+		else if (0 == strcmp(cmd, "dump-folded"))
+			err = make_folded();
 		else
 			warn("Unknown command '%s'\n", cmd);
 	}
@@ -564,11 +902,16 @@ int main(int argc, char *argv[])
 	const char *map_fname = "System.map";
 	const char *prof_fname = NULL;
 	const char *trace_config_fname = NULL;
+	const char *bootstage_fname = NULL;
 	int opt;
 
 	verbose = 2;
-	while ((opt = getopt(argc, argv, "m:p:t:v:")) != -1) {
+	while ((opt = getopt(argc, argv, "b:m:p:t:v:")) != -1) {
 		switch (opt) {
+		case 'b':
+			bootstage_fname = optarg;
+			break;
+
 		case 'm':
 			map_fname = optarg;
 			break;
@@ -595,5 +938,5 @@ int main(int argc, char *argv[])
 
 	debug("Debug enabled\n");
 	return prof_tool(argc, argv, prof_fname, map_fname,
-			 trace_config_fname);
+			 trace_config_fname, bootstage_fname);
 }